@@ -1,29 +1,243 @@
 #include "allocators.hpp"
 
-#include "Windows.h"
 #include "../math/scalars.hpp"
+#include "../utility/allocation_tracker.hpp"
+
+#ifdef _WIN32
+#include "Windows.h"
+typedef SRWLOCK Pool_Lock;
+#define POOL_LOCK_INIT SRWLOCK_INIT
+#define pool_lock_exclusive(lock) AcquireSRWLockExclusive(lock)
+#define pool_unlock_exclusive(lock) ReleaseSRWLockExclusive(lock)
+#define pool_lock_shared(lock) AcquireSRWLockShared(lock)
+#define pool_unlock_shared(lock) ReleaseSRWLockShared(lock)
+#else
+#include <pthread.h>
+#include <sys/mman.h>
+typedef pthread_rwlock_t Pool_Lock;
+#define POOL_LOCK_INIT PTHREAD_RWLOCK_INITIALIZER
+#define pool_lock_exclusive(lock) pthread_rwlock_wrlock(lock)
+#define pool_unlock_exclusive(lock) pthread_rwlock_unlock(lock)
+#define pool_lock_shared(lock) pthread_rwlock_rdlock(lock)
+#define pool_unlock_shared(lock) pthread_rwlock_unlock(lock)
+#endif
+
+
+// ARENA BLOCK POOL
+#define ARENA_POOL_SIZE_CLASS_COUNT 48
+
+struct Arena_Block_Pool
+{
+	Pool_Lock lock;
+	void* free_blocks[ARENA_POOL_SIZE_CLASS_COUNT]; // Per power of 2, the first bytes of a cached block point to the next one
+	u64 cached_bytes;
+	u64 max_cached_bytes;
+	u64 blocks_allocated;
+	u64 blocks_reused;
+	bool use_large_pages;
+	uint large_page_size;
+};
+
+static Arena_Block_Pool arena_block_pool = { POOL_LOCK_INIT, {}, 0, 256ull * 1024 * 1024, 0, 0, false, 0 };
+
+static void* arena_block_map(uint size, bool large_pages)
+{
+#ifdef _WIN32
+	DWORD flags = MEM_RESERVE | MEM_COMMIT | (large_pages ? MEM_LARGE_PAGES : 0);
+	return VirtualAlloc(nullptr, size, flags, PAGE_READWRITE);
+#else
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | (large_pages ? MAP_HUGETLB : 0);
+	void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	return block == MAP_FAILED ? nullptr : block;
+#endif
+}
+
+static void arena_block_unmap(void* block, uint size)
+{
+#ifdef _WIN32
+	VirtualFree(block, 0, MEM_RELEASE);
+#else
+	munmap(block, size);
+#endif
+}
+
+static int arena_block_size_class(uint size)
+{
+	int size_class = 0;
+	while (((uint)1 << size_class) < size) {
+		size_class += 1;
+	}
+	assert(((uint)1 << size_class) == size && size_class < ARENA_POOL_SIZE_CLASS_COUNT, "Arena buffers are always powers of 2");
+	return size_class;
+}
+
+static void* arena_block_allocate(uint size)
+{
+	if (size < ARENA_POOL_MIN_BLOCK_SIZE) {
+		return malloc(size);
+	}
+
+	auto& pool = arena_block_pool;
+	int size_class = arena_block_size_class(size);
+	void* block = nullptr;
+	bool use_large_pages = false;
+	pool_lock_exclusive(&pool.lock);
+	{
+		block = pool.free_blocks[size_class];
+		if (block != nullptr) {
+			pool.free_blocks[size_class] = *(void**)block;
+			pool.cached_bytes -= size;
+			pool.blocks_reused += 1;
+		}
+		else {
+			pool.blocks_allocated += 1;
+		}
+		use_large_pages = pool.use_large_pages && size % pool.large_page_size == 0;
+	}
+	pool_unlock_exclusive(&pool.lock);
+	if (block != nullptr) {
+		return block;
+	}
+
+	if (use_large_pages) {
+		block = arena_block_map(size, true);
+		if (block != nullptr) {
+			return block;
+		}
+	}
+	block = arena_block_map(size, false);
+	assert(block != nullptr, "Out of memory");
+	return block;
+}
+
+static void arena_block_free(void* block, uint size)
+{
+	if (size < ARENA_POOL_MIN_BLOCK_SIZE) {
+		free(block);
+		return;
+	}
+
+	auto& pool = arena_block_pool;
+	bool cached = false;
+	pool_lock_exclusive(&pool.lock);
+	if (pool.cached_bytes + size <= pool.max_cached_bytes) {
+		int size_class = arena_block_size_class(size);
+		*(void**)block = pool.free_blocks[size_class];
+		pool.free_blocks[size_class] = block;
+		pool.cached_bytes += size;
+		cached = true;
+	}
+	pool_unlock_exclusive(&pool.lock);
+
+	if (!cached) {
+		arena_block_unmap(block, size);
+	}
+}
+
+void arena_block_pool_set_max_cached_bytes(u64 max_cached_bytes)
+{
+	pool_lock_exclusive(&arena_block_pool.lock);
+	arena_block_pool.max_cached_bytes = max_cached_bytes;
+	pool_unlock_exclusive(&arena_block_pool.lock);
+}
+
+bool arena_block_pool_enable_large_pages()
+{
+#ifndef _WIN32
+	// Only succeeds if huge pages were reserved (vm.nr_hugepages)
+	uint large_page_size = 2 * 1024 * 1024;
+	void* probe = arena_block_map(large_page_size, true);
+	if (probe == nullptr) return false;
+	arena_block_unmap(probe, large_page_size);
+#else
+	uint large_page_size = (uint)GetLargePageMinimum();
+	if (large_page_size == 0) return false;
+
+	// Large pages need the lock-memory privilege to be enabled in the process token
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+		return false;
+	}
+	SCOPE_EXIT(CloseHandle(token));
+	TOKEN_PRIVILEGES privileges;
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	if (!LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)) {
+		return false;
+	}
+	if (!AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) || GetLastError() != ERROR_SUCCESS) {
+		return false;
+	}
+#endif
+
+	pool_lock_exclusive(&arena_block_pool.lock);
+	arena_block_pool.use_large_pages = true;
+	arena_block_pool.large_page_size = large_page_size;
+	pool_unlock_exclusive(&arena_block_pool.lock);
+	return true;
+}
+
+void arena_block_pool_trim()
+{
+	auto& pool = arena_block_pool;
+	pool_lock_exclusive(&pool.lock);
+	for (int i = 0; i < ARENA_POOL_SIZE_CLASS_COUNT; i++)
+	{
+		void* block = pool.free_blocks[i];
+		while (block != nullptr) {
+			void* next = *(void**)block;
+			arena_block_unmap(block, (uint)1 << i);
+			block = next;
+		}
+		pool.free_blocks[i] = nullptr;
+	}
+	pool.cached_bytes = 0;
+	pool_unlock_exclusive(&pool.lock);
+}
+
+Arena_Block_Pool_Stats arena_block_pool_stats()
+{
+	auto& pool = arena_block_pool;
+	Arena_Block_Pool_Stats stats;
+	pool_lock_shared(&pool.lock);
+	stats.blocks_allocated = pool.blocks_allocated;
+	stats.blocks_reused = pool.blocks_reused;
+	stats.cached_bytes = pool.cached_bytes;
+	stats.large_pages_active = pool.use_large_pages;
+	pool_unlock_shared(&pool.lock);
+	return stats;
+}
+
 
 
+// ARENA
 // Makes sure that the current buffer has a capacity of at least new_capacity.
 // if not, a new buffer is allocated
 // returns true if a new buffer was allocated
 static bool arena_reserve_buffer_capacity(Arena* arena, uint new_capacity)
 {
 	if (new_capacity <= arena->buffer.capacity) return false;
-	new_capacity = math_maximum(128ull, integer_next_power_of_2(new_capacity));
+	new_capacity = math_maximum((uint)128, integer_next_power_of_2(new_capacity));
 
 	// Allocate new buffer
 	Arena_Buffer new_buffer;
-	new_buffer.data = malloc(new_capacity);
+	new_buffer.data = arena_block_allocate(new_capacity);
 	new_buffer.capacity = new_capacity;
+	new_buffer.used = 0;
+	new_buffer.allocation_tag = allocation_tracker_add(new_capacity);
 
 	// Store linked list to old buffers
 	Arena_Buffer* header = (Arena_Buffer*)new_buffer.data;
 	*header = arena->buffer;
+	if (header->data != nullptr) {
+		header->used = (uint)arena->next - (uint)header->data;
+		arena->previous_buffers_used += header->used;
+	}
 
 	// Store new buffer in arena
 	arena->buffer = new_buffer;
 	arena->next = (void*) (((uint)new_buffer.data) + sizeof(Arena_Buffer));
+	arena->free_blocks_end = nullptr;
 
 	return true;
 }
@@ -34,6 +248,14 @@ Arena Arena::create(uint capacity)
 	result.buffer.data = nullptr;
 	result.buffer.capacity = 0;
 	result.next = nullptr;
+	result.previous_buffers_used = 0;
+	result.peak_used = 0;
+	for (int i = 0; i < ARENA_FREE_SIZE_CLASS_COUNT; i++) {
+		result.free_blocks[i] = nullptr;
+	}
+	result.free_block_mask = 0;
+	result.released_size = 0;
+	result.free_blocks_end = nullptr;
 	arena_reserve_buffer_capacity(&result, capacity);
 	return result;
 }
@@ -42,9 +264,77 @@ void Arena::destroy() {
 	reset(false);
 }
 
+// Header of released memory, stored in the memory itself
+struct Arena_Free_Block
+{
+	Arena_Free_Block* next;
+	uint size;
+};
+
+static void arena_push_free_block(Arena* arena, uint address, uint size)
+{
+	// Keep the header aligned
+	uint aligned = math_round_next_multiple(address, (uint)alignof(Arena_Free_Block));
+	if (aligned - address + ARENA_MIN_RELEASE_SIZE > size) return;
+	size -= aligned - address;
+
+	int size_class = math_minimum((int)integer_highest_set_bit_index(size), ARENA_FREE_SIZE_CLASS_COUNT - 1);
+	Arena_Free_Block* block = (Arena_Free_Block*)aligned;
+	block->next = (Arena_Free_Block*)arena->free_blocks[size_class];
+	block->size = size;
+	arena->free_blocks[size_class] = block;
+	arena->free_block_mask |= (u64)1 << size_class;
+	arena->released_size += size;
+	bool in_current_buffer = aligned >= (uint)arena->buffer.data && aligned < (uint)arena->buffer.data + arena->buffer.capacity;
+	if (in_current_buffer && aligned + size > (uint)arena->free_blocks_end) {
+		arena->free_blocks_end = (void*)(aligned + size);
+	}
+}
+
+static Arena_Free_Block* arena_pop_free_block(Arena* arena, int size_class)
+{
+	Arena_Free_Block* block = (Arena_Free_Block*)arena->free_blocks[size_class];
+	arena->free_blocks[size_class] = block->next;
+	if (block->next == nullptr) {
+		arena->free_block_mask &= ~((u64)1 << size_class);
+	}
+	arena->released_size -= block->size;
+	return block;
+}
+
+// Returns nullptr if no released block fits
+static void* arena_allocate_from_free_blocks(Arena* arena, uint size, u32 alignment)
+{
+	// Every block in a class >= ceil(log2(size)) is large enough, apart from alignment padding
+	int min_class = (int)integer_highest_set_bit_index(size);
+	if (((uint)1 << min_class) < size) {
+		min_class += 1;
+	}
+	if (min_class >= ARENA_FREE_SIZE_CLASS_COUNT) return nullptr;
+	u64 candidates = arena->free_block_mask & ~(((u64)1 << min_class) - 1);
+	if (candidates == 0) return nullptr;
+
+	int size_class = (int)integer_lowest_set_bit_index(candidates);
+	Arena_Free_Block* block = (Arena_Free_Block*)arena->free_blocks[size_class];
+	uint block_start = (uint)block;
+	uint block_end = block_start + block->size;
+	uint result_address = math_round_next_multiple(block_start, (uint)alignment);
+	if (result_address + size > block_end) return nullptr;
+
+	arena_pop_free_block(arena, size_class);
+	arena_push_free_block(arena, result_address + size, block_end - (result_address + size));
+	return (void*)result_address;
+}
+
 void* Arena::allocate_raw(uint size, u32 alignment)
 {
 	assert(size != 0 && alignment != 0, "");
+	if (free_block_mask != 0) {
+		void* reused = arena_allocate_from_free_blocks(this, size, alignment);
+		if (reused != nullptr) {
+			return reused;
+		}
+	}
 	uint result_address = math_round_next_multiple((uint)next, (uint)alignment);
 	bool resized = arena_reserve_buffer_capacity(this, result_address - (uint)buffer.data + size + sizeof(Arena_Buffer));
 	if (resized) {
@@ -52,6 +342,10 @@ void* Arena::allocate_raw(uint size, u32 alignment)
 	}
 	next = (void*)(result_address + size);
 	assert(result_address + size <= (uint)buffer.data + buffer.capacity, "Otherwise we shoot out of our buffer!");
+	uint used = previous_buffers_used + ((uint)next - (uint)buffer.data);
+	if (used > peak_used) {
+		peak_used = used;
+	}
 	return (void*)result_address;
 }
 
@@ -66,14 +360,43 @@ bool Arena::resize(void* memory, uint old_size, uint new_size)
 	// Check if we have enough space for resize
 	if (address + new_size <= (uint)buffer.data + buffer.capacity) {
 		next = (void*)(address + new_size);
+		uint used = previous_buffers_used + ((uint)next - (uint)buffer.data);
+		if (used > peak_used) {
+			peak_used = used;
+		}
 		return true;
 	}
 
 	return false;
 }
 
+void Arena::release(void* memory, uint size)
+{
+	if (memory == nullptr || size == 0) return;
+	uint address = (uint)memory;
+
+	// The last allocation can simply be taken back
+	if (address + size == (uint)next) {
+		next = memory;
+		return;
+	}
+	if (size < ARENA_MIN_RELEASE_SIZE) return;
+	arena_push_free_block(this, address, size);
+}
+
+static void arena_clear_free_blocks(Arena* arena)
+{
+	for (int i = 0; i < ARENA_FREE_SIZE_CLASS_COUNT; i++) {
+		arena->free_blocks[i] = nullptr;
+	}
+	arena->free_block_mask = 0;
+	arena->released_size = 0;
+	arena->free_blocks_end = nullptr;
+}
+
 void Arena::reset(bool keep_largest_buffer)
 {
+	arena_clear_free_blocks(this);
 	Arena_Buffer curr = buffer;
 	if (curr.data == 0) return;
 
@@ -81,20 +404,60 @@ void Arena::reset(bool keep_largest_buffer)
 		curr = *(Arena_Buffer*)curr.data; // Skip deallocation of current
 		((Arena_Buffer*)buffer.data)->data = nullptr;
 		((Arena_Buffer*)buffer.data)->capacity = 0;
+		((Arena_Buffer*)buffer.data)->used = 0;
 	}
 	else {
 		buffer.data = nullptr;
 		buffer.capacity = 0;
 	}
+	previous_buffers_used = 0;
 
 	while (curr.data != nullptr)
 	{
 		Arena_Buffer next = *(Arena_Buffer*)curr.data;
-		free(curr.data);
+		allocation_tracker_remove(curr.allocation_tag, curr.capacity);
+		arena_block_free(curr.data, curr.capacity);
 		curr = next;
 	}
 }
 
+uint Arena::reserved_size()
+{
+	uint sum = 0;
+	Arena_Buffer curr = buffer;
+	while (curr.data != nullptr) {
+		sum += curr.capacity;
+		curr = *(Arena_Buffer*)curr.data;
+	}
+	return sum;
+}
+
+Arena_Stats Arena::stats()
+{
+	Arena_Stats stats;
+	stats.used = 0;
+	stats.peak_used = peak_used;
+	stats.reserved = 0;
+	stats.block_count = 0;
+	stats.waste = 0;
+	stats.released = released_size;
+	if (buffer.data == nullptr) return stats;
+
+	stats.used = previous_buffers_used + ((uint)next - (uint)buffer.data);
+	Arena_Buffer curr = buffer;
+	bool is_current = true;
+	while (curr.data != nullptr) {
+		stats.reserved += curr.capacity;
+		stats.block_count += 1;
+		if (!is_current) {
+			stats.waste += curr.capacity - curr.used;
+		}
+		is_current = false;
+		curr = *(Arena_Buffer*)curr.data;
+	}
+	return stats;
+}
+
 Arena_Checkpoint Arena::make_checkpoint()
 {
 	Arena_Checkpoint checkpoint;
@@ -114,6 +477,12 @@ void Arena::rewind_to_address(void* pointer)
 	else {
 		next = (void*)buffer_start;
 	}
+
+	// Released blocks in the rewound part are handed out again, so the free lists are dropped.
+	// Walking them instead gets slow, since blocks below the rewind point pile up in scratch arenas
+	if (free_block_mask != 0 && (uint)free_blocks_end > (uint)next) {
+		arena_clear_free_blocks(this);
+	}
 }
 
 void Arena::rewind_to_checkpoint(Arena_Checkpoint checkpoint) {
@@ -125,6 +494,31 @@ void Arena_Checkpoint::rewind() {
 }
 
 
+
+// SCRATCH ARENAS
+struct Scratch_Arenas
+{
+	Arena arenas[2];
+
+	// Thread exit, buffers go back to the block pool
+	~Scratch_Arenas() {
+		arenas[0].destroy();
+		arenas[1].destroy();
+	}
+};
+
+static thread_local Scratch_Arenas scratch_arenas; // Zero-initialized, which is the same as Arena::create(0)
+
+Arena_Checkpoint arena_scratch_begin(Arena* conflict)
+{
+	Arena* arena = &scratch_arenas.arenas[0];
+	if (arena == conflict) {
+		arena = &scratch_arenas.arenas[1];
+	}
+	return arena->make_checkpoint();
+}
+
+
 // FREE LIST
 Free_List Free_List::create(Arena* arena, uint element_size) 
 {
@@ -20,23 +20,49 @@ struct Arena_Buffer
 	//		to previously allocated buffers
 	void* data;
 	uint capacity;
+	uint used; // Only valid in buffer headers (Bytes used when the arena switched to the next buffer)
+	int allocation_tag; // See allocation_tracker.hpp
 };
 
+struct Arena_Stats
+{
+	uint used;      // Bytes in use now, including buffer headers
+	uint peak_used;
+	uint reserved;  // Sum of buffer capacities
+	int block_count;
+	uint waste;     // Unused tails of previous buffers, which are lost until reset
+	uint released;  // Bytes given back with release, waiting in the free lists to be reused
+};
+
+// Released memory is kept in free lists per power of 2 (Class k holds blocks of 2^k to 2^(k+1) - 1 bytes)
+#define ARENA_FREE_SIZE_CLASS_COUNT 40
+#define ARENA_MIN_RELEASE_SIZE 64 // Smaller releases are dropped, since they cannot hold many allocations
+
 struct Arena
 {
 	Arena_Buffer buffer;
 	void* next;
+	uint previous_buffers_used;
+	uint peak_used;
+	void* free_blocks[ARENA_FREE_SIZE_CLASS_COUNT]; // The first bytes of a free block are an Arena_Free_Block header
+	u64 free_block_mask; // Bit k is set if free_blocks[k] is not empty
+	uint released_size;
+	void* free_blocks_end; // Upper bound of released block ends in the current buffer, rewinding below it drops the free lists
 
 	static Arena create(uint capacity = 0); 
 	void destroy();
 
 	void* allocate_raw(uint size, u32 alignment);
 	bool resize(void* memory, uint old_size, uint new_size);
+	// Gives memory back for reuse (e.g. the old buffer of a grown array), the memory must not be used afterwards
+	void release(void* memory, uint size);
 	void reset(bool keep_largest_buffer = false);
+	uint reserved_size(); // Sum of all buffer capacities (Peak usage, since arenas only shrink on reset)
+	Arena_Stats stats();
 
 	Arena_Checkpoint make_checkpoint();
 	void rewind_to_checkpoint(Arena_Checkpoint checkpoint);
-	void Arena::rewind_to_address(void* pointer);
+	void rewind_to_address(void* pointer);
 
 	template<typename T> 
 	T* allocate() {	return (T*)allocate_raw(sizeof(T), alignof(T)); } 
@@ -53,6 +79,29 @@ struct Arena
 	} 
 };
 
+// Per-thread scratch arenas for short-lived data, usage:
+//     Arena_Checkpoint scratch = arena_scratch_begin();
+//     SCOPE_EXIT(scratch.rewind());
+// Checkpoints must be rewound in reverse order and must not be held over fiber switches, since all fibers of a thread share the arenas.
+// If the caller already allocates results into another arena, pass it as conflict so that the other scratch arena is used.
+Arena_Checkpoint arena_scratch_begin(Arena* conflict = nullptr);
+
+// Arena buffers of at least ARENA_POOL_MIN_BLOCK_SIZE come from a shared pool and are recycled between arenas
+// (e.g. across compiles) instead of being returned to the OS
+#define ARENA_POOL_MIN_BLOCK_SIZE (64 * 1024)
+struct Arena_Block_Pool_Stats
+{
+	u64 blocks_allocated; // Requested from the OS
+	u64 blocks_reused;
+	u64 cached_bytes;
+	bool large_pages_active;
+};
+
+void arena_block_pool_set_max_cached_bytes(u64 max_cached_bytes);
+bool arena_block_pool_enable_large_pages(); // Needs SeLockMemoryPrivilege, returns false (and keeps normal pages) otherwise
+void arena_block_pool_trim(); // Returns all cached blocks to the OS
+Arena_Block_Pool_Stats arena_block_pool_stats();
+
 // Note: Alignment of free-list is always alignof(uint), so this could cause problems for sse types...
 struct Free_List
 {
@@ -65,7 +114,7 @@ struct Free_List
 	void deallocate_raw(void* data);
 
 	template<typename T> 
-	T* allocate() {	return (T*)allocate_raw(sizeof(T), alignof(T)); } 
+	T* allocate() {	return (T*)allocate_raw(sizeof(T)); } 
 
 	template<typename T> 
 	void deallocate(T* data) { deallocate_raw((void*)data); }
@@ -114,6 +163,7 @@ struct DynArray
 		// Otherwise create new buffer and move data
 		Array<T> new_buffer = arena->allocate_array<T>((int) new_size);
 		memory_copy(new_buffer.data, buffer.data, size * sizeof(T));
+		arena->release(buffer.data, buffer.size * sizeof(T));
 		buffer = new_buffer;
 	}
 
@@ -256,12 +306,10 @@ struct DynSet
 			return;
 		}
 
-		Arena_Checkpoint checkpoint;
 		Array<DynSet_Entry<T>> old_entries;
 		if (arena->resize(entries.data, entries.size * sizeof(DynSet_Entry<T>), new_size * sizeof(DynSet_Entry<T>)))
 		{
 			// Resize is annoying, because we need a temporary copy of the old values need to copy over our old values
-			checkpoint = arena->make_checkpoint();
 			old_entries = arena->allocate_array<DynSet_Entry<T>>(entries.size);
 			memory_copy(old_entries.data, entries.data, entries.size * sizeof(DynSet_Entry<T>));
 			entries.size = (int)new_size;
@@ -271,7 +319,6 @@ struct DynSet
 			// Allocate new buffer
 			old_entries = entries;
 			entries = arena->allocate_array<DynSet_Entry<T>>((int)new_size);
-			checkpoint = arena->make_checkpoint();
 		}
 
 		// Reset current buffer/initialize new buffer
@@ -284,7 +331,8 @@ struct DynSet
 			if (old_entry.state != DynSet_Entry_State::OCCUPIED) continue;
 			insert_with_hash(old_entry.value, old_entry.hash);
 		}
-		arena->rewind_to_checkpoint(checkpoint);
+		// Old buffer or temporary copy is given back for reuse
+		arena->release(old_entries.data, old_entries.size * sizeof(DynSet_Entry<T>));
 	}
 
 	int hash_to_entry_index(u64 hash_value, int sonding_index)
@@ -479,12 +527,10 @@ struct DynTable
 		}
 
 		// Try to resize through arena, otherwise allocate new buffer
-		Arena_Checkpoint checkpoint;
 		Array<DynTable_Entry<K, V>> old_entries;
 		if (arena->resize(entries.data, entries.size * sizeof(DynTable_Entry<K, V>), new_size * sizeof(DynTable_Entry<K, V>)))
 		{
 			// Resize is annoying, because we need a temporary copy of the old values to copy over our old values
-			checkpoint = arena->make_checkpoint();
 			old_entries = arena->allocate_array<DynTable_Entry<K,V>>(entries.size);
 			memory_copy(old_entries.data, entries.data, entries.size * sizeof(DynTable_Entry<K,V>));
 			entries.size = (int)new_size;
@@ -494,7 +540,6 @@ struct DynTable
 			// Allocate new buffer
 			old_entries = entries;
 			entries = arena->allocate_array<DynTable_Entry<K,V>>((int)new_size);
-			checkpoint = arena->make_checkpoint();
 		}
 
 		// Reset current buffer/initialize new buffer
@@ -507,7 +552,8 @@ struct DynTable
 			if (old_entry.state != DynSet_Entry_State::OCCUPIED) continue;
 			insert_with_query(query_with_hash(old_entry.key, old_entry.hash), old_entry.key, old_entry.value);
 		}
-		arena->rewind_to_checkpoint(checkpoint);
+		// Old buffer or temporary copy is given back for reuse
+		arena->release(old_entries.data, old_entries.size * sizeof(DynTable_Entry<K, V>));
 	}
 
 	int hash_to_entry_index(u64 hash_value, int sonding_index)
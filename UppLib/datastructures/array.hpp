@@ -64,7 +64,8 @@ Array<T> array_create_static(T* data, int size) {
 
 template<typename T>
 Array<byte> array_create_static_as_bytes(T* data, int size) {
-    return array_as_bytes(&array_create_static(data, size));
+    Array<T> array = array_create_static(data, size);
+    return array_as_bytes(&array);
 }
 
 template<typename T>
@@ -46,7 +46,7 @@ String string_create(Arena* arena, int capacity) {
 String string_create(const char* content, Arena* arena) {
     int size = strlen(content);
     String result = string_create(size + 1, arena);
-    strcpy_s(result.characters, size+1, content);
+    memory_copy(result.characters, (void*)content, size + 1);
     result.size = size;
     return result;
 }
@@ -79,7 +79,8 @@ String string_create_substring(String* string, int start_index, int end_index)
 
 String string_create_from_string_with_extra_capacity(String* other, int extra_capacity) {
     String result = string_create(other->size + 1 + extra_capacity);
-    strcpy_s(result.characters, result.capacity, other->characters);
+    memory_copy(result.characters, other->characters, other->size);
+    result.characters[other->size] = 0;
     result.size = other->size;
     return result;
 }
@@ -192,6 +193,9 @@ void string_reserve(String* string, int new_capacity)
         if (string->arena == nullptr) {
             delete[] string->characters;
         }
+        else {
+            string->arena->release(string->characters, string->capacity);
+        }
         string->characters = buffer;
         string->capacity = new_capacity;
     }
@@ -221,7 +225,7 @@ void string_append(String* string, const char* appendix) {
     int appendix_length = (int)strlen(appendix);
     int required_capacity = string->size + appendix_length + 1;
     string_reserve(string, required_capacity);
-    strcpy_s(string->characters + string->size, appendix_length+1, appendix);
+    memory_copy(string->characters + string->size, (void*)appendix, appendix_length + 1);
     string->size += appendix_length;
 }
 
@@ -283,7 +287,10 @@ void string_append_formated(String* string, const char* format, ...)
 {
     va_list args;
     va_start(args, format);
-    int message_length = vsnprintf(0, 0, format, args);
+    va_list length_arguments; // va_list can't be consumed twice on every platform
+    va_copy(length_arguments, args);
+    int message_length = vsnprintf(0, 0, format, length_arguments);
+    va_end(length_arguments);
     string_reserve(string, string->size + message_length + 1);
     int ret_val = vsnprintf(string->characters + string->size, string->capacity - string->size, format, args);
     if (ret_val < 0) {
@@ -497,6 +504,79 @@ void string_append_character_array(String* string, Array<char> appendix)
     string->characters[string->size] = 0;
 }
 
+void string_reserve_append(String* string, int append_count) {
+    string_reserve(string, string->size + append_count + 1);
+}
+
+void string_append_characters(String* string, const char* characters, int length)
+{
+    string_reserve(string, string->size + length + 1);
+    memory_copy(string->characters + string->size, (void*)characters, length);
+    string->size += length;
+    string->characters[string->size] = 0;
+}
+
+void string_append_repeated(String* string, char c, int count)
+{
+    if (count <= 0) return;
+    string_reserve(string, string->size + count + 1);
+    memory_set_bytes(string->characters + string->size, count, (byte)c);
+    string->size += count;
+    string->characters[string->size] = 0;
+}
+
+// Digits are written backwards into the end of the buffer, returns start of the digits
+static char* string_u64_to_digits(u64 value, char* buffer_end, int base)
+{
+    const char* digits = "0123456789abcdef";
+    char* pos = buffer_end;
+    do {
+        pos -= 1;
+        *pos = digits[value % base];
+        value /= base;
+    } while (value != 0);
+    return pos;
+}
+
+void string_append_i64(String* string, i64 value)
+{
+    char buffer[24];
+    char* end = buffer + 24;
+    // Negate as unsigned, so that the minimum value doesn't overflow
+    char* start = string_u64_to_digits(value < 0 ? (u64)0 - (u64)value : (u64)value, end, 10);
+    if (value < 0) {
+        start -= 1;
+        *start = '-';
+    }
+    string_append_characters(string, start, (int)(end - start));
+}
+
+void string_append_u64(String* string, u64 value)
+{
+    char buffer[24];
+    char* end = buffer + 24;
+    char* start = string_u64_to_digits(value, end, 10);
+    string_append_characters(string, start, (int)(end - start));
+}
+
+void string_append_hex(String* string, u64 value)
+{
+    char buffer[24];
+    char* end = buffer + 24;
+    char* start = string_u64_to_digits(value, end, 16);
+    string_append_characters(string, start, (int)(end - start));
+}
+
+void string_append_f64(String* string, double value)
+{
+    // %f of the largest doubles has 309 integer digits, formating directly into the string avoids the sizing pass
+    const int max_length = 320;
+    string_reserve(string, string->size + max_length + 1);
+    int length = snprintf(string->characters + string->size, max_length + 1, "%f", value);
+    assert(length >= 0 && length <= max_length, "");
+    string->size += length;
+}
+
 bool string_contains_only_characters_in_set(String* string, String set, bool use_set_complement)
 {
     for (int i = 0; i < string->size; i++)
@@ -602,7 +682,10 @@ void String::append_formated(const char* format, ...)
 {
     va_list args;
     va_start(args, format);
-    int message_length = vsnprintf(0, 0, format, args);
+    va_list length_arguments; // va_list can't be consumed twice on every platform
+    va_copy(length_arguments, args);
+    int message_length = vsnprintf(0, 0, format, length_arguments);
+    va_end(length_arguments);
     string_reserve(this, size + message_length + 1);
     int ret_val = vsnprintf(characters + size, capacity - size, format, args);
     if (ret_val < 0) {
@@ -621,3 +704,52 @@ char String::at(int index, char backup) {
     if (index < 0 || index >= (int)size) return backup;
     return characters[index];
 }
+
+
+
+String_View string_view_make(char* characters, u32 size)
+{
+    String_View result;
+    result.characters = characters;
+    result.size = size;
+    return result;
+}
+
+String_View string_view_from_cstring(const char* str)
+{
+    return string_view_make((char*)str, (u32)strlen(str));
+}
+
+String_View string_view_from_string(String string)
+{
+    return string_view_make(string.characters, (u32)string.size);
+}
+
+String_View string_view_from_substring(String* string, int start_index, int end_index)
+{
+    start_index = math_clamp(start_index, 0, string->size);
+    end_index = math_clamp(end_index, start_index, string->size);
+    return string_view_make(string->characters + start_index, (u32)(end_index - start_index));
+}
+
+String string_view_to_string(String_View view)
+{
+    return string_create_static_with_size(view.characters, (int)view.size);
+}
+
+u64 hash_string_view(String_View* string_view)
+{
+    if (string_view->size == 0) return 0x2342343;
+    return hash_memory(array_create_static<byte>((byte*)string_view->characters, (int)string_view->size));
+}
+
+bool equals_string_view(String_View* a, String_View* b)
+{
+    if (a->size != b->size) return false;
+    return memory_compare(a->characters, b->characters, a->size);
+}
+
+void string_append_string_view(String* string, String_View view)
+{
+    string_append_characters(string, view.characters, (int)view.size);
+}
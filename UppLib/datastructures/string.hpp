@@ -58,6 +58,14 @@ void string_prepend_string(String* string, String* prepension);
 void string_append_formated(String* string, const char* format, ...);
 void string_append_character(String* string, char c);
 void string_append_character_array(String* string, Array<char> appendix); // Difference to append c_string is that appendix does not need to be 0 terminated
+// Typed appends, output matches the printf conversion in the comment but no format string is parsed
+void string_append_characters(String* string, const char* characters, int length); // No strlen, characters don't need to be 0 terminated
+void string_append_repeated(String* string, char c, int count);
+void string_append_i64(String* string, i64 value); // %lld
+void string_append_u64(String* string, u64 value); // %llu
+void string_append_hex(String* string, u64 value); // %llx
+void string_append_f64(String* string, double value); // %f
+void string_reserve_append(String* string, int append_count); // Batched reserve, so that the following appends of append_count characters don't grow the buffer
 void string_truncate(String* string, int vector_length);
 void string_replace_character(String* string, char to_replace, char replace_with);
 bool string_starts_with(String str, const char* start);
@@ -80,3 +88,19 @@ void string_split_destroy(Array<String> parts);
 bool string_fill_from_line(String* to_fill);
 String string_create_filename_from_path_static(String* filepath);
 void string_remove_trailing_whitespace(String* str);
+
+// Non-owning view into string data, temporaries that are only compared/hashed/looked up should use this instead of copies
+struct String_View
+{
+    char* characters; // Not 0 terminated
+    u32 size;
+};
+
+String_View string_view_make(char* characters, u32 size);
+String_View string_view_from_cstring(const char* str);
+String_View string_view_from_string(String string);
+String_View string_view_from_substring(String* string, int start_index, int end_index);
+String string_view_to_string(String_View view); // Static string, no allocation
+u64 hash_string_view(String_View* string_view);
+bool equals_string_view(String_View* a, String_View* b);
+void string_append_string_view(String* string, String_View view);
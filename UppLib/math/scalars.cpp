@@ -2,7 +2,9 @@
 
 #include <cmath>
 #include "../utility/utils.hpp"
+#ifdef _WIN32
 #include "intrin.h"
+#endif
 
 u64 math_round_previous_multiple(u64 x, u64 modulo) { 
     return x - x % modulo;
@@ -80,28 +82,40 @@ float math_degree_to_radians(float degree) {
 u32 integer_lowest_set_bit_index(u64 value)
 {
     if (value == 0) return 0;
+#ifdef _WIN32
 	unsigned long index;
 	unsigned char ret_val = _BitScanForward(&index, value);
 	assert(ret_val != 0, "Should be the case");
 	return (u32)index;
+#else
+	return (u32)__builtin_ctzll(value);
+#endif
 }
 
 u32 integer_highest_set_bit_index(u32 value)
 {
     if (value == 0) return 0;
+#ifdef _WIN32
 	unsigned long index;
 	unsigned char ret_val = _BitScanReverse(&index, value);
 	assert(ret_val != 0, "Should be the case");
 	return (u32)index;
+#else
+	return 31 - (u32)__builtin_clz(value);
+#endif
 }
 
 u32 integer_highest_set_bit_index(u64 value)
 {
     if (value == 0) return 0;
+#ifdef _WIN32
 	unsigned long index;
 	unsigned char ret_val = _BitScanReverse64(&index, value);
 	assert(ret_val != 0, "Should be the case");
 	return (u32)index;
+#else
+	return 63 - (u32)__builtin_clzll(value);
+#endif
 }
 
 u32 integer_next_power_of_2(u32 value)
@@ -110,7 +124,7 @@ u32 integer_next_power_of_2(u32 value)
 	i8 highest_bit = integer_highest_set_bit_index(value);
     u32 result = value;
     if ((1ul << highest_bit) != value) {
-        result = result << 1;
+        result = (u32)1ul << (highest_bit + 1);
     }
     assert(result >= value, "");
     return result;
@@ -122,7 +136,7 @@ u64 integer_next_power_of_2(u64 value)
 	i8 highest_bit = integer_highest_set_bit_index(value);
     u64 result = value;
     if ((1ull << highest_bit) != value) {
-        result = result << 1;
+        result = (u64)1ull << (highest_bit + 1);
     }
     assert(result >= value, "");
     return result;
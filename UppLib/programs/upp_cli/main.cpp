@@ -0,0 +1,7 @@
+#include "upp_cli.hpp"
+
+// Entry point of the standalone console target, the editor executable doesn't contain the driver
+int main(int argc, char** argv)
+{
+    return upp_cli_main(argc, argv);
+}
@@ -0,0 +1,1065 @@
+#include "upp_cli.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../win32/timing.hpp"
+#include "../../win32/process.hpp"
+#include "../../win32/fiber.hpp"
+#include "../../utility/file_io.hpp"
+#include "../../utility/directory_crawler.hpp"
+#include "../../datastructures/string.hpp"
+#include "../../datastructures/dynamic_array.hpp"
+#include "../../utility/rich_text.hpp"
+
+#include "../upp_lang/compilation_data.hpp"
+#include "../upp_lang/compiler_misc.hpp"
+#include "../upp_lang/ast.hpp"
+#include "../upp_lang/semantic_analyser.hpp"
+#include "../upp_lang/c_backend.hpp"
+
+enum class Cli_Phase
+{
+    RESET,
+    LEXING,
+    PARSING,
+    ANALYSIS,
+    COMPTIME_EXEC,
+    CODE_GEN,
+    RUN,
+    TEARDOWN, // compilation_data_destroy, not included in total
+    TOTAL,
+
+    MAX_ENUM_VALUE
+};
+
+static const char* cli_phase_to_string(Cli_Phase phase)
+{
+    switch (phase)
+    {
+    case Cli_Phase::RESET: return "reset";
+    case Cli_Phase::LEXING: return "lexing";
+    case Cli_Phase::PARSING: return "parsing";
+    case Cli_Phase::ANALYSIS: return "analysis";
+    case Cli_Phase::COMPTIME_EXEC: return "code_exec";
+    case Cli_Phase::CODE_GEN: return "code_gen";
+    case Cli_Phase::RUN: return "run";
+    case Cli_Phase::TEARDOWN: return "teardown";
+    case Cli_Phase::TOTAL: return "total";
+    default: panic("");
+    }
+    return "";
+}
+
+struct Cli_Timings
+{
+    double phases[(int)Cli_Phase::MAX_ENUM_VALUE];
+};
+
+// Node headers + range tables of all units, only measured with --memory
+struct Cli_Ast_Stats
+{
+    AST::Node_Memory_Stats memory;
+    int line_count;
+    double header_walk_time; // Traversal which only reads node headers
+    double range_walk_time;  // Traversal which also decodes the ranges of each node
+    double node_lookup_walk_time; // Same, but finds the range table of each node through its unit index
+};
+
+struct Cli_Compile_Result
+{
+    bool file_loaded;
+    Exit_Code exit_code;
+    Cli_Timings timings;
+    Arena_Stats arena_stats; // Compilation arena before teardown
+    Cli_Ast_Stats ast_stats;
+    u64 fiber_switch_count;
+    int comptime_memo_hits;
+    int comptime_memo_misses;
+};
+
+// Walks store their checksum here, so that the traversal cannot be optimized away
+static volatile i64 upp_cli_ast_walk_checksum = 0;
+
+static i64 upp_cli_walk_ast(AST::Node* node, AST::Node_Range_Table* range_table, Compilation_Data* compilation_data)
+{
+    i64 checksum = (i64)node->type;
+    if (range_table != nullptr) {
+        checksum += AST::node_range_table_get(range_table, node->index).bounding_range.end.line;
+    }
+    else if (compilation_data != nullptr) {
+        checksum += ast_node_get_ranges(compilation_data, node).bounding_range.end.line;
+    }
+    int child_index = 0;
+    AST::Node* child = AST::base_get_child(node, child_index);
+    while (child != nullptr) {
+        checksum += upp_cli_walk_ast(child, range_table, compilation_data);
+        child_index += 1;
+        child = AST::base_get_child(node, child_index);
+    }
+    return checksum;
+}
+
+static Cli_Ast_Stats upp_cli_measure_ast(Compilation_Data* compilation_data)
+{
+    Cli_Ast_Stats stats;
+    memory_set_bytes(&stats, sizeof(Cli_Ast_Stats), 0);
+    i64 checksum = 0;
+    for (int i = 0; i < compilation_data->compilation_units.size; i++)
+    {
+        Compilation_Unit* unit = compilation_data->compilation_units[i];
+        if (unit->root == nullptr) continue;
+
+        AST::Node_Memory_Stats memory = AST::root_get_memory_stats(unit->root);
+        stats.memory.node_count += memory.node_count;
+        stats.memory.overflow_count += memory.overflow_count;
+        stats.memory.header_bytes += memory.header_bytes;
+        stats.memory.range_table_bytes += memory.range_table_bytes;
+        stats.memory.inline_range_bytes += memory.inline_range_bytes;
+        stats.line_count += unit->code->line_count;
+
+        double start_time = timer_current_time_in_seconds();
+        checksum += upp_cli_walk_ast(AST::upcast(unit->root), nullptr, nullptr);
+        double header_end_time = timer_current_time_in_seconds();
+        checksum += upp_cli_walk_ast(AST::upcast(unit->root), &unit->root->range_table, nullptr);
+        double range_end_time = timer_current_time_in_seconds();
+        checksum += upp_cli_walk_ast(AST::upcast(unit->root), nullptr, compilation_data);
+        stats.header_walk_time += header_end_time - start_time;
+        stats.range_walk_time += range_end_time - header_end_time;
+        stats.node_lookup_walk_time += timer_current_time_in_seconds() - range_end_time;
+    }
+    upp_cli_ast_walk_checksum = checksum;
+    return stats;
+}
+
+// Compiles a single file with a fresh Compilation_Data, execution is optional
+static Cli_Compile_Result upp_cli_compile_file(Fiber_Pool* fiber_pool, String filepath, bool run, bool print_errors)
+{
+    Cli_Compile_Result result;
+    result.file_loaded = false;
+    result.exit_code = exit_code_make(Exit_Code_Type::COMPILATION_FAILED);
+    result.fiber_switch_count = 0;
+    result.comptime_memo_hits = 0;
+    result.comptime_memo_misses = 0;
+    memory_set_bytes(&result.arena_stats, sizeof(Arena_Stats), 0);
+    memory_set_bytes(&result.ast_stats, sizeof(Cli_Ast_Stats), 0);
+    for (int i = 0; i < (int)Cli_Phase::MAX_ENUM_VALUE; i++) {
+        result.timings.phases[i] = 0.0;
+    }
+
+    double start_time = timer_current_time_in_seconds();
+    Compilation_Data* compilation_data = compilation_data_create(fiber_pool);
+    Compilation_Unit* main_unit = compilation_data_add_compilation_unit_unique(compilation_data, filepath, true, false);
+    if (main_unit == nullptr) {
+        compilation_data_destroy(compilation_data);
+        return result;
+    }
+    result.file_loaded = true;
+
+    compilation_data_compile(compilation_data, main_unit, Compile_Type::BUILD_CODE);
+    double compile_end_time = timer_current_time_in_seconds();
+    if (run) {
+        result.exit_code = compiler_execute(compilation_data);
+    }
+    else if (!compilation_data_errors_occured(compilation_data)) {
+        result.exit_code = exit_code_make(Exit_Code_Type::SUCCESS);
+    }
+    double end_time = timer_current_time_in_seconds();
+
+    if (print_errors && compilation_data_errors_occured(compilation_data))
+    {
+        String errors = string_create(256);
+        SCOPE_EXIT(string_destroy(&errors));
+        compilation_data_append_code_errors_to_string(compilation_data, &errors, 1);
+        string_style_remove_codes(&errors);
+        logg("%s\n", errors.characters);
+    }
+
+    Cli_Timings& timings = result.timings;
+    timings.phases[(int)Cli_Phase::RESET] = compilation_data->time_reset;
+    timings.phases[(int)Cli_Phase::LEXING] = compilation_data->time_lexing;
+    timings.phases[(int)Cli_Phase::PARSING] = compilation_data->time_parsing;
+    timings.phases[(int)Cli_Phase::ANALYSIS] = compilation_data->time_analysing;
+    timings.phases[(int)Cli_Phase::COMPTIME_EXEC] = compilation_data->time_code_exec;
+    timings.phases[(int)Cli_Phase::CODE_GEN] = compilation_data->time_code_gen;
+    timings.phases[(int)Cli_Phase::RUN] = end_time - compile_end_time;
+    timings.phases[(int)Cli_Phase::TOTAL] = end_time - start_time;
+    result.fiber_switch_count = compilation_data->fiber_switch_count;
+    result.comptime_memo_hits = compilation_data->comptime_memo_hits;
+    result.comptime_memo_misses = compilation_data->comptime_memo_misses;
+
+    result.arena_stats = compilation_data->arena.stats();
+    if (allocation_tracker_is_enabled()) {
+        result.ast_stats = upp_cli_measure_ast(compilation_data);
+    }
+    double teardown_start_time = timer_current_time_in_seconds();
+    compilation_data_destroy(compilation_data);
+    timings.phases[(int)Cli_Phase::TEARDOWN] = timer_current_time_in_seconds() - teardown_start_time;
+    return result;
+}
+
+// Synthetic programs consist of many small structs + functions which call each other,
+// so that all compiler phases scale with function_count. Call chains are 8 functions long,
+// so that --run doesn't overflow the interpreter stack
+static bool upp_cli_write_synthetic_program(const char* filepath, int function_count)
+{
+    String code = string_create(function_count * 256);
+    SCOPE_EXIT(string_destroy(&code));
+    string_append_formated(&code, "// Generated by upp --bench, do not edit\n");
+    for (int i = 0; i < function_count; i++)
+    {
+        string_append_formated(&code, "\nSynth_Data_%d :: struct\n\ta: int\n\tb: int\n\n", i);
+        string_append_formated(&code, "synth_fn_%d :: fn (x: int) => int\n", i);
+        string_append_formated(&code, "\td: Synth_Data_%d\n\td.a = x + %d\n\td.b = d.a * 2\n", i, i);
+        string_append_formated(&code, "\tsum := 0\n\tloop i := 0; i < 4; i += 1\n");
+        string_append_formated(&code, "\t\tif sum > 100\n\t\t\tsum = sum - d.b\n\t\telse\n\t\t\tsum = sum + d.a\n");
+        if (i % 8 == 0) {
+            string_append_formated(&code, "\treturn sum\n");
+        }
+        else {
+            string_append_formated(&code, "\treturn sum + synth_fn_%d(x - 1)\n", i - 1);
+        }
+    }
+    string_append_formated(&code, "\nmain :: fn ()\n\tresult := 0\n");
+    for (int i = 0; i < function_count; i++) {
+        if (i % 8 == 7 || i == function_count - 1) {
+            string_append_formated(&code, "\tresult += synth_fn_%d(5)\n", i);
+        }
+    }
+    return file_io_write_file(filepath, array_create_static_as_bytes(code.characters, code.size));
+}
+
+static void upp_cli_print_timings(Cli_Timings* timings)
+{
+    logg("\n-------- TIMINGS ---------\n");
+    for (int i = 0; i < (int)Cli_Phase::MAX_ENUM_VALUE; i++) {
+        if (i == (int)Cli_Phase::TOTAL) {
+            logg("--------------------------\n");
+        }
+        logg("%-12s... %3.2fms\n", cli_phase_to_string((Cli_Phase)i), (float)(timings->phases[i] * 1000));
+    }
+    logg("--------------------------\n");
+}
+
+struct Cli_Bench_Program
+{
+    String name;
+    String path;
+    Dynamic_Array<Cli_Timings> samples;
+    u64 fiber_switch_count; // Per run, doesn't change between runs
+};
+
+static double cli_samples_percentile(Dynamic_Array<double>* sorted, float percentile)
+{
+    int index = (int)(percentile * sorted->size + 0.999f) - 1;
+    index = math_clamp(index, 0, sorted->size - 1);
+    return sorted->data[index];
+}
+
+static void upp_cli_print_bench_program(Cli_Bench_Program* program)
+{
+    Dynamic_Array<double> values = dynamic_array_create<double>(program->samples.size);
+    SCOPE_EXIT(dynamic_array_destroy(&values));
+
+    logg("\n%s (%d runs, %lld fiber switches per run)\n", program->name.characters, program->samples.size, (i64)program->fiber_switch_count);
+    logg("    %-12s %10s %10s %10s\n", "phase", "min", "median", "p95");
+    for (int phase = 0; phase < (int)Cli_Phase::MAX_ENUM_VALUE; phase++)
+    {
+        dynamic_array_reset(&values);
+        for (int i = 0; i < program->samples.size; i++) {
+            dynamic_array_push_back(&values, program->samples[i].phases[phase]);
+        }
+        dynamic_array_sort(&values, [](double a, double b) -> bool { return a < b; });
+        logg("    %-12s %8.2fms %8.2fms %8.2fms\n",
+            cli_phase_to_string((Cli_Phase)phase),
+            (float)(values[0] * 1000),
+            (float)(cli_samples_percentile(&values, 0.5f) * 1000),
+            (float)(cli_samples_percentile(&values, 0.95f) * 1000)
+        );
+    }
+}
+
+// Returns paths of all testcase files, error testcases are the ones that should fail compilation/execution
+static Dynamic_Array<String> upp_cli_collect_testcases(bool include_error_cases)
+{
+    Dynamic_Array<String> testcases = dynamic_array_create<String>();
+    Directory_Crawler* crawler = directory_crawler_create();
+    SCOPE_EXIT(directory_crawler_destroy(crawler));
+    directory_crawler_set_path(crawler, string_create_static("upp_code/testcases"));
+    auto files = directory_crawler_get_content(crawler);
+    for (int i = 0; i < files.size; i++)
+    {
+        const auto& file = files[i];
+        if (file.is_directory) continue;
+        if (!include_error_cases && string_contains_substring(file.name, 0, string_create_static("error")) != -1) continue;
+        if (string_contains_substring(file.name, 0, string_create_static("notest")) != -1) continue;
+        String path = string_create();
+        path.append_formated("upp_code/testcases/%s", file.name.characters);
+        dynamic_array_push_back(&testcases, path);
+    }
+    return testcases;
+}
+
+static int upp_cli_bench(Fiber_Pool* fiber_pool, int run_count, bool run)
+{
+    Dynamic_Array<Cli_Bench_Program> programs = dynamic_array_create<Cli_Bench_Program>();
+    SCOPE_EXIT(
+        for (int i = 0; i < programs.size; i++) {
+            string_destroy(&programs[i].name);
+            string_destroy(&programs[i].path);
+            dynamic_array_destroy(&programs[i].samples);
+        }
+        dynamic_array_destroy(&programs);
+    );
+
+    // All testcases are combined into a single suite sample per run
+    Cli_Bench_Program suite;
+    suite.name = string_create("upp_code/testcases (suite)");
+    suite.path = string_create("");
+    suite.samples = dynamic_array_create<Cli_Timings>();
+    suite.fiber_switch_count = 0;
+    dynamic_array_push_back(&programs, suite);
+
+    Dynamic_Array<String> testcases = upp_cli_collect_testcases(false);
+    SCOPE_EXIT(
+        for (int i = 0; i < testcases.size; i++) {
+            string_destroy(&testcases[i]);
+        }
+        dynamic_array_destroy(&testcases);
+    );
+
+    const int synthetic_sizes[] = { 100, 1000, 4000 };
+    for (int i = 0; i < 3; i++)
+    {
+        Cli_Bench_Program program;
+        program.name = string_create();
+        program.name.append_formated("synthetic (%d functions)", synthetic_sizes[i]);
+        program.path = string_create();
+        program.path.append_formated("upp_code/bench_synthetic_%d.upp", synthetic_sizes[i]);
+        program.samples = dynamic_array_create<Cli_Timings>();
+        program.fiber_switch_count = 0;
+        if (!upp_cli_write_synthetic_program(program.path.characters, synthetic_sizes[i])) {
+            logg("Could not write synthetic program %s\n", program.path.characters);
+            string_destroy(&program.name);
+            string_destroy(&program.path);
+            dynamic_array_destroy(&program.samples);
+            continue;
+        }
+        dynamic_array_push_back(&programs, program);
+    }
+
+    logg("Benchmarking %d testcases + %d synthetic programs, %d runs each\n", testcases.size, programs.size - 1, run_count);
+    bool failures_occured = false;
+    for (int run_index = 0; run_index < run_count; run_index++)
+    {
+        Cli_Timings suite_timings;
+        for (int i = 0; i < (int)Cli_Phase::MAX_ENUM_VALUE; i++) {
+            suite_timings.phases[i] = 0.0;
+        }
+        u64 suite_switch_count = 0;
+        for (int i = 0; i < testcases.size; i++)
+        {
+            Cli_Compile_Result result = upp_cli_compile_file(fiber_pool, testcases[i], run, false);
+            if (result.exit_code.type != Exit_Code_Type::SUCCESS && run_index == 0) {
+                logg("    Testcase failed: %s\n", testcases[i].characters);
+                failures_occured = true;
+            }
+            for (int j = 0; j < (int)Cli_Phase::MAX_ENUM_VALUE; j++) {
+                suite_timings.phases[j] += result.timings.phases[j];
+            }
+            suite_switch_count += result.fiber_switch_count;
+        }
+        dynamic_array_push_back(&programs[0].samples, suite_timings);
+        programs[0].fiber_switch_count = suite_switch_count;
+
+        for (int i = 1; i < programs.size; i++)
+        {
+            Cli_Bench_Program& program = programs[i];
+            Cli_Compile_Result result = upp_cli_compile_file(fiber_pool, program.path, run, run_index == 0);
+            if (result.exit_code.type != Exit_Code_Type::SUCCESS && run_index == 0) {
+                logg("    Synthetic program failed: %s\n", program.path.characters);
+                failures_occured = true;
+            }
+            dynamic_array_push_back(&program.samples, result.timings);
+            program.fiber_switch_count = result.fiber_switch_count;
+        }
+        logg("Run %d/%d finished\n", run_index + 1, run_count);
+    }
+
+    for (int i = 0; i < programs.size; i++) {
+        upp_cli_print_bench_program(&programs[i]);
+    }
+    logg("\nfiber switch micro-benchmark: %.1f ns per switch\n", fiber_benchmark_switch(1000000));
+    return failures_occured ? 1 : 0;
+}
+
+
+// TESTCASE RUNNER
+// Each testcase is compiled + executed in a separate child process (upp <file> --run --report), so
+// crashes and timeouts only affect a single testcase. The child prints a report line with its timings.
+// Testcases which should succeed also get --check-c-emission, then the report contains the emission result.
+// CLI_C_PROFILE_CHECK_FILE additionally gets --check-c-profile, a failed check is reported as a non-zero exit code.
+#define CLI_REPORT_PREFIX "UPP_REPORT"
+
+enum class Cli_Test_Status
+{
+    PENDING,
+    RUNNING,
+    PASSED,
+    FAILED,
+    CRASHED,
+    TIMEOUT,
+};
+
+static const char* cli_test_status_to_string(Cli_Test_Status status)
+{
+    switch (status)
+    {
+    case Cli_Test_Status::PENDING: return "PENDING";
+    case Cli_Test_Status::RUNNING: return "RUNNING";
+    case Cli_Test_Status::PASSED: return "PASSED";
+    case Cli_Test_Status::FAILED: return "FAILED";
+    case Cli_Test_Status::CRASHED: return "CRASHED";
+    case Cli_Test_Status::TIMEOUT: return "TIMEOUT";
+    default: panic("");
+    }
+    return "";
+}
+
+struct Cli_Test_Case
+{
+    String path;
+    String name; // Static substring of path
+    bool should_succeed;
+    Cli_Test_Status status;
+    double compile_ms;
+    double run_ms;
+    double baseline_ms; // Negative if not in baseline
+    bool c_emission_checked;
+    bool c_emission_identical;
+
+    Process_Handle process;
+    double start_time;
+    String output;
+};
+
+struct Cli_Test_Settings
+{
+    int job_count;
+    double timeout_seconds;
+    const char* results_filepath;
+    const char* baseline_filepath;
+    double regression_threshold_percent;
+};
+
+static void upp_cli_test_case_finish(Cli_Test_Case* test, int exit_code)
+{
+    // Parse report line, a missing report means the child crashed before finishing
+    int report_index = string_contains_substring(test->output, 0, string_create_static(CLI_REPORT_PREFIX " "));
+    if (report_index == -1) {
+        test->status = Cli_Test_Status::CRASHED;
+        return;
+    }
+
+    String report = string_create_substring_static(&test->output, report_index, test->output.size);
+    Optional<int> line_end = string_find_character_index(&report, '\n', 0);
+    if (line_end.available) {
+        report = string_create_substring_static(&report, 0, line_end.value);
+    }
+    string_remove_trailing_whitespace(&report);
+    Array<String> parts = string_split(report, ' ');
+    SCOPE_EXIT(string_split_destroy(parts));
+    if (parts.size >= 3) {
+        Optional<float> compile_ms = string_parse_float(&parts[1]);
+        Optional<float> run_ms = string_parse_float(&parts[2]);
+        test->compile_ms = compile_ms.available ? compile_ms.value : 0.0;
+        test->run_ms = run_ms.available ? run_ms.value : 0.0;
+    }
+    // Emission result is "-" if the child didn't check it (e.g. compile errors)
+    if (parts.size >= 4 && !string_equals_cstring(&parts[3], "-")) {
+        test->c_emission_checked = true;
+        test->c_emission_identical = string_equals_cstring(&parts[3], "identical");
+    }
+
+    bool succeeded = exit_code == 0;
+    test->status = succeeded == test->should_succeed ? Cli_Test_Status::PASSED : Cli_Test_Status::FAILED;
+    if (test->c_emission_checked && !test->c_emission_identical) {
+        test->status = Cli_Test_Status::FAILED;
+    }
+}
+
+// Baseline files have the same format as result files
+static void upp_cli_load_baseline(Dynamic_Array<Cli_Test_Case>* tests, const char* filepath)
+{
+    Optional<String> text = file_io_load_text_file(filepath);
+    SCOPE_EXIT(file_io_unload_text_file(&text););
+    if (!text.available) {
+        logg("Could not load baseline file %s\n", filepath);
+        return;
+    }
+
+    Array<String> lines = string_split(text.value, '\n');
+    SCOPE_EXIT(string_split_destroy(lines));
+    for (int i = 0; i < lines.size; i++)
+    {
+        String line = lines[i];
+        string_remove_trailing_whitespace(&line);
+        if (line.size == 0 || line.characters[0] == '#') continue;
+
+        Array<String> parts = string_split(line, ' ');
+        SCOPE_EXIT(string_split_destroy(parts));
+        if (parts.size < 4) continue;
+        for (int j = 0; j < tests->size; j++)
+        {
+            Cli_Test_Case& test = (*tests)[j];
+            if (!string_equals(&test.name, &parts[0])) continue;
+            Optional<float> compile_ms = string_parse_float(&parts[2]);
+            Optional<float> run_ms = string_parse_float(&parts[3]);
+            if (compile_ms.available && run_ms.available) {
+                test.baseline_ms = compile_ms.value + run_ms.value;
+            }
+            break;
+        }
+    }
+}
+
+// Generates C-code without compiling it, returns false if the program contains errors
+static bool upp_cli_emit_c_code(Fiber_Pool* fiber_pool, String filepath, int thread_count, bool use_function_cache, String* out_code)
+{
+    int i_thread_count = c_generation_thread_count;
+    bool i_use_function_cache = enable_c_function_cache;
+    SCOPE_EXIT(c_generation_thread_count = i_thread_count; enable_c_function_cache = i_use_function_cache;);
+    c_generation_thread_count = thread_count;
+    enable_c_function_cache = use_function_cache;
+
+    Compilation_Data* compilation_data = compilation_data_create(fiber_pool);
+    SCOPE_EXIT(compilation_data_destroy(compilation_data));
+    Compilation_Unit* main_unit = compilation_data_add_compilation_unit_unique(compilation_data, filepath, true, false);
+    if (main_unit == nullptr) {
+        return false;
+    }
+    compilation_data_compile(compilation_data, main_unit, Compile_Type::BUILD_CODE);
+    if (compilation_data_errors_occured(compilation_data)) {
+        return false;
+    }
+    string_reset(out_code);
+    string_append_string(out_code, &c_generator_get_translation(compilation_data->c_generator)->source_code);
+    return true;
+}
+
+// Parallel C generation relies on the output being identical for every thread count, so each passing testcase is emitted (in its child process)
+// with one thread, with C_EMISSION_CHECK_THREADS threads and once more from the filled function cache. Returns false on mismatches
+const int C_EMISSION_CHECK_THREADS = 8;
+static bool upp_cli_check_c_emission(Fiber_Pool* fiber_pool, String filepath)
+{
+    bool i_c_generation = compiler_enable_c_generation;
+    bool i_c_compilation = enable_c_compilation;
+    bool i_output_timing = output_timing;
+    SCOPE_EXIT(compiler_enable_c_generation = i_c_generation; enable_c_compilation = i_c_compilation; output_timing = i_output_timing;);
+    compiler_enable_c_generation = true;
+    enable_c_compilation = false;
+    output_timing = false;
+
+    String expected = string_create();
+    SCOPE_EXIT(string_destroy(&expected));
+    String code = string_create();
+    SCOPE_EXIT(string_destroy(&code));
+
+    // Checked without and with inlining, as inlined blocks are copied between functions
+    const int optimization_levels[] = { 0, 2 };
+    int i_optimization_level = compiler_optimization_level;
+    SCOPE_EXIT(compiler_optimization_level = i_optimization_level;);
+    bool identical = true;
+    for (int level_index = 0; level_index < 2; level_index++)
+    {
+        compiler_optimization_level = optimization_levels[level_index];
+        if (!upp_cli_emit_c_code(fiber_pool, filepath, 1, false, &expected)) continue;
+
+        const char* failed_run = nullptr;
+        if (!upp_cli_emit_c_code(fiber_pool, filepath, C_EMISSION_CHECK_THREADS, false, &code) || !string_equals(&code, &expected)) {
+            failed_run = "parallel";
+        }
+        else if (!upp_cli_emit_c_code(fiber_pool, filepath, C_EMISSION_CHECK_THREADS, true, &code) ||
+            !upp_cli_emit_c_code(fiber_pool, filepath, C_EMISSION_CHECK_THREADS, true, &code) || !string_equals(&code, &expected)) {
+            failed_run = "cached";
+        }
+        if (failed_run == nullptr) continue;
+
+        int difference_index = 0;
+        while (difference_index < code.size && difference_index < expected.size && code.characters[difference_index] == expected.characters[difference_index]) {
+            difference_index += 1;
+        }
+        logg("C-EMIT   (-O%d): %s output differs from single threaded output at character %d\n", 
+            compiler_optimization_level, failed_run, difference_index
+        );
+        identical = false;
+    }
+    return identical;
+}
+
+// The C-profile dump only contains slot indices, which the report maps back to functions and loops. The check testcase
+// is compiled with profiling (without running cl), then a hand-written dump is mapped through c_generator_write_profile_report
+// and the report must name the expected functions. The report is also read back like a --pgo compile does.
+#define CLI_C_PROFILE_CHECK_FILE "upp_code/testcases/060_c_profile_report.upp"
+static bool upp_cli_check_c_profile_report(Fiber_Pool* fiber_pool, String filepath)
+{
+    bool i_c_generation = compiler_enable_c_generation;
+    bool i_c_compilation = enable_c_compilation;
+    bool i_c_profiling = enable_c_profiling;
+    bool i_output_timing = output_timing;
+    int i_optimization_level = compiler_optimization_level;
+    SCOPE_EXIT(
+        compiler_enable_c_generation = i_c_generation; enable_c_compilation = i_c_compilation; enable_c_profiling = i_c_profiling;
+        output_timing = i_output_timing; compiler_optimization_level = i_optimization_level;
+    );
+    compiler_enable_c_generation = true;
+    enable_c_compilation = false;
+    enable_c_profiling = true;
+    output_timing = false;
+    compiler_optimization_level = 1; // leaf is inlined into sum_to, so one slot counts inlined calls
+
+    Compilation_Data* compilation_data = compilation_data_create(fiber_pool);
+    SCOPE_EXIT(compilation_data_destroy(compilation_data));
+    Compilation_Unit* main_unit = compilation_data_add_compilation_unit_unique(compilation_data, filepath, true, false);
+    if (main_unit == nullptr) {
+        return false;
+    }
+    compilation_data_compile(compilation_data, main_unit, Compile_Type::BUILD_CODE);
+    if (compilation_data_errors_occured(compilation_data)) {
+        return false;
+    }
+
+    // Slots in generation order: leaf, sum_to, the loop in sum_to, leaf inlined into sum_to, main,
+    // scale(2) + scale(3) inlined into main, scale(2), scale(3) and the entry function. Invalid lines are skipped
+    const char* dump_filepath = "c_profile_check_dump.txt";
+    const char* report_filepath = "c_profile_check_report.txt";
+    SCOPE_EXIT(remove(dump_filepath); remove(report_filepath););
+    const char* dump = 
+        "0 4000 400000\n"
+        "1 10 600000\n"
+        "2 40000 0\n"
+        "3 2000 0\n"
+        "4 1 900000\n"
+        "5 5 0\n"
+        "6 10 0\n"
+        "7 500 5000\n"
+        "8 995 9950\n"
+        "9 0 0\n"
+        "10 7 7\n"
+        "x 1 1\n";
+    // $ is replaced by the filepath of the unit
+    const char* expected_lines[] = {
+        "1 0 900000 900000 $ main#0",
+        "10 0 600000 60000 $ sum_to#0",
+        "4000 2000 400000 100 $ leaf#0",
+        "995 10 9950 10 $ scale#0(3)",
+        "500 5 5000 10 $ scale#0(2)",
+        "",
+        "# Loops: iterations file:line function",
+        "40000 $:12 $ sum_to#0",
+    };
+    if (!file_io_write_file(dump_filepath, array_create_static_as_bytes(dump, (int)strlen(dump)))) {
+        return false;
+    }
+    if (!c_generator_write_profile_report(compilation_data->c_generator, dump_filepath, report_filepath)) {
+        logg("C-PROFILE report could not be written\n");
+        return false;
+    }
+    Optional<String> report = file_io_load_text_file(report_filepath);
+    SCOPE_EXIT(file_io_unload_text_file(&report));
+    if (!report.available) {
+        return false;
+    }
+
+    String expected = string_create();
+    SCOPE_EXIT(string_destroy(&expected));
+    for (int i = 0; i < sizeof(expected_lines) / sizeof(expected_lines[0]); i++) {
+        for (const char* c = expected_lines[i]; *c != 0; c++) {
+            if (*c == '$') {
+                string_append_string(&expected, &main_unit->filepath);
+            }
+            else {
+                string_append_character(&expected, *c);
+            }
+        }
+        string_append_character(&expected, '\n');
+    }
+    // Skip the header line of the function section
+    Optional<int> header_end = string_find_character_index(&report.value, '\n', 0);
+    String functions_and_loops = string_create_substring_static(&report.value, header_end.available ? header_end.value + 1 : 0, report.value.size);
+    if (!string_equals(&functions_and_loops, &expected)) {
+        logg("C-PROFILE report doesn't name the expected functions, expected:\n%s\ngot:\n%s\n", expected.characters, report.value.characters);
+        return false;
+    }
+
+    // Only leaf and scale(3) pass the hot thresholds, scale(3) only because its inlined calls are counted
+    auto& slots = c_generator_get_translation(compilation_data->c_generator)->profile_slots;
+    if (slots.size != 10) {
+        logg("C-PROFILE expected 10 profile slots, got %d\n", slots.size);
+        return false;
+    }
+    c_profile_mark_hot_functions(compilation_data, report_filepath);
+    auto& functions = compilation_data->functions;
+    for (int i = 0; i < functions.size; i++)
+    {
+        Upp_Function* function = functions[i];
+        bool expected_hot = function == slots[0].function || function == slots[8].function;
+        if (function->is_profile_hot != expected_hot) {
+            logg("C-PROFILE function %s is%s marked hot\n", function->name->characters, function->is_profile_hot ? "" : " not");
+            return false;
+        }
+    }
+    return true;
+}
+
+static int upp_cli_run_testcases(const char* executable_path, Cli_Test_Settings settings)
+{
+    Dynamic_Array<Cli_Test_Case> tests = dynamic_array_create<Cli_Test_Case>();
+    SCOPE_EXIT(
+        for (int i = 0; i < tests.size; i++) {
+            string_destroy(&tests[i].path);
+            string_destroy(&tests[i].output);
+        }
+        dynamic_array_destroy(&tests);
+    );
+    {
+        Dynamic_Array<String> paths = upp_cli_collect_testcases(true);
+        SCOPE_EXIT(dynamic_array_destroy(&paths));
+        for (int i = 0; i < paths.size; i++)
+        {
+            Cli_Test_Case test;
+            test.path = paths[i];
+            test.name = string_create_filename_from_path_static(&test.path);
+            test.should_succeed = string_contains_substring(test.name, 0, string_create_static("error")) == -1;
+            test.status = Cli_Test_Status::PENDING;
+            test.compile_ms = 0.0;
+            test.run_ms = 0.0;
+            test.baseline_ms = -1.0;
+            test.c_emission_checked = false;
+            test.c_emission_identical = false;
+            test.start_time = 0.0;
+            test.output = string_create();
+            dynamic_array_push_back(&tests, test);
+        }
+    }
+    if (settings.baseline_filepath != nullptr) {
+        upp_cli_load_baseline(&tests, settings.baseline_filepath);
+    }
+
+    logg("Running %d testcases on %d worker processes\n", tests.size, settings.job_count);
+    double start_time = timer_current_time_in_seconds();
+    String command = string_create();
+    SCOPE_EXIT(string_destroy(&command));
+    int next_test = 0;
+    int running_count = 0;
+    int finished_count = 0;
+    while (finished_count < tests.size)
+    {
+        // Start new workers
+        while (running_count < settings.job_count && next_test < tests.size)
+        {
+            Cli_Test_Case& test = tests[next_test];
+            next_test += 1;
+            string_reset(&command);
+            command.append_formated("\"%s\" \"%s\" --run --report%s%s", executable_path, test.path.characters, 
+                test.should_succeed ? " --check-c-emission" : "", string_equals_cstring(&test.path, CLI_C_PROFILE_CHECK_FILE) ? " --check-c-profile" : ""
+            );
+            Optional<Process_Handle> process = process_start_async(command);
+            if (!process.available) {
+                test.status = Cli_Test_Status::CRASHED;
+                finished_count += 1;
+                continue;
+            }
+            test.process = process.value;
+            test.status = Cli_Test_Status::RUNNING;
+            test.start_time = timer_current_time_in_seconds();
+            running_count += 1;
+        }
+
+        // Poll running workers
+        for (int i = 0; i < tests.size; i++)
+        {
+            Cli_Test_Case& test = tests[i];
+            if (test.status != Cli_Test_Status::RUNNING) continue;
+
+            int exit_code = 0;
+            if (process_poll(&test.process, &test.output, &exit_code)) {
+                upp_cli_test_case_finish(&test, exit_code);
+            }
+            else if (timer_current_time_in_seconds() - test.start_time > settings.timeout_seconds) {
+                process_kill(&test.process);
+                test.status = Cli_Test_Status::TIMEOUT;
+            }
+            else {
+                continue;
+            }
+
+            process_handle_destroy(&test.process);
+            running_count -= 1;
+            finished_count += 1;
+            if (test.status != Cli_Test_Status::PASSED) {
+                logg("%-8s %s\n", cli_test_status_to_string(test.status), test.name.characters);
+            }
+        }
+        timer_sleep_for(0.001);
+    }
+
+    // Summary + regressions
+    int failed_count = 0;
+    int regression_count = 0;
+    int c_emission_checked_count = 0;
+    int c_emission_mismatch_count = 0;
+    String results = string_create(tests.size * 64);
+    SCOPE_EXIT(string_destroy(&results));
+    string_append(&results, "# upp testcase results: name status compile_ms run_ms\n");
+    for (int i = 0; i < tests.size; i++)
+    {
+        Cli_Test_Case& test = tests[i];
+        string_append_character_array(&results, array_create_static(test.name.characters, test.name.size));
+        string_append_formated(&results, " %s %.3f %.3f\n", cli_test_status_to_string(test.status), test.compile_ms, test.run_ms);
+        if (test.c_emission_checked) {
+            c_emission_checked_count += 1;
+            c_emission_mismatch_count += test.c_emission_identical ? 0 : 1;
+        }
+
+        if (test.status != Cli_Test_Status::PASSED) 
+        {
+            failed_count += 1;
+            string_style_remove_codes(&test.output);
+            logg("\n---- %s %s, output:\n%s\n", cli_test_status_to_string(test.status), test.path.characters, test.output.characters);
+            continue;
+        }
+
+        // Small testcases are dominated by noise, so regressions also require an absolute difference of 1ms
+        double total_ms = test.compile_ms + test.run_ms;
+        if (test.baseline_ms > 0.0 &&
+            total_ms > test.baseline_ms * (1.0 + settings.regression_threshold_percent / 100.0) &&
+            total_ms - test.baseline_ms > 1.0)
+        {
+            regression_count += 1;
+            logg("SLOWER   %s: %.2fms -> %.2fms (+%.1f%%)\n",
+                test.path.characters, test.baseline_ms, total_ms, (total_ms / test.baseline_ms - 1.0) * 100.0
+            );
+        }
+    }
+
+    logg("C emission: %d/%d programs identical with 1 and %d threads and from the function cache (-O0 and -O2)\n", 
+        c_emission_checked_count - c_emission_mismatch_count, c_emission_checked_count, C_EMISSION_CHECK_THREADS
+    );
+
+    if (settings.results_filepath != nullptr) {
+        if (!file_io_write_file(settings.results_filepath, array_create_static_as_bytes(results.characters, results.size))) {
+            logg("Could not write results file %s\n", settings.results_filepath);
+        }
+    }
+
+    logg("\n-------------------------------\n");
+    logg("%d/%d testcases passed, %d performance regressions (threshold %.1f%%), %.2fs\n",
+        tests.size - failed_count, tests.size, regression_count, settings.regression_threshold_percent,
+        timer_current_time_in_seconds() - start_time
+    );
+    logg("-------------------------------\n");
+    return failed_count > 0 || regression_count > 0 ? 1 : 0;
+}
+
+static void upp_cli_print_usage()
+{
+    logg("Usage:\n");
+    logg("    upp <file.upp> [--run] [-O<level>]   Compile file, optionally execute it, and print timings\n");
+    logg("                                         -O1 inlines small functions, -O2 larger ones (default -O0, no inlining)\n");
+    logg("                   [--trace]             Also write Chrome trace json of the compilation to %s\n", trace_output_filepath);
+    logg("                   [--profile]           Profile interpreter, writes %s.folded (flamegraph) and %s_lines.txt\n", bytecode_profile_filepath, bytecode_profile_filepath);
+    logg("                   [--c-profile]         Compile instrumented C-code and run it, writes function/loop counts to %s\n", c_profile_report_filepath);
+    logg("                   [--pgo]               Use larger inlining limits for hot functions in %s\n", c_profile_report_filepath);
+    logg("                   [--keep-dead-functions] Generate code for functions unreachable from main\n");
+    logg("                   [--memory]            Print allocation count/current/peak bytes per compiler subsystem and AST memory\n");
+    logg("                   [--fiber-stack KB]    Stack size of the analysis fibers (default %d KB)\n", FIBER_DEFAULT_STACK_SIZE / 1024);
+    logg("                   [--large-pages]       Back arena blocks with large pages if the OS allows it\n");
+    logg("                   [--pool-cache MB]     Maximum memory the arena block pool keeps for reuse\n");
+    logg("    upp --bench N [--run] [-O<level>]    Compile testcases + synthetic programs N times, print min/median/p95\n");
+    logg("    upp --test [--jobs N] [--timeout seconds] [--results file] [--baseline file] [--threshold percent]\n");
+    logg("                                         Run all testcases in separate processes, compare timings with baseline\n");
+}
+
+int upp_cli_main(int argc, char** argv)
+{
+    const char* filepath = nullptr;
+    bool run = false;
+    bool report = false;
+    bool check_c_emission = false;
+    bool check_c_profile = false;
+    int bench_count = 0;
+    u64 fiber_stack_size = FIBER_DEFAULT_STACK_SIZE;
+    bool run_testcases = false;
+    Cli_Test_Settings test_settings;
+    test_settings.job_count = 4;
+    test_settings.timeout_seconds = 30.0;
+    test_settings.results_filepath = "testcase_results.txt";
+    test_settings.baseline_filepath = nullptr;
+    test_settings.regression_threshold_percent = 10.0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--run") == 0) {
+            run = true;
+        }
+        else if (strcmp(arg, "--report") == 0) {
+            report = true;
+        }
+        else if (strcmp(arg, "--check-c-emission") == 0) {
+            check_c_emission = true;
+        }
+        else if (strcmp(arg, "--check-c-profile") == 0) {
+            check_c_profile = true;
+        }
+        else if (strcmp(arg, "--test") == 0) {
+            run_testcases = true;
+        }
+        else if (strcmp(arg, "--jobs") == 0 && has_value) {
+            test_settings.job_count = math_maximum(1, atoi(argv[i + 1]));
+            i += 1;
+        }
+        else if (strcmp(arg, "--timeout") == 0 && has_value) {
+            test_settings.timeout_seconds = atof(argv[i + 1]);
+            i += 1;
+        }
+        else if (strcmp(arg, "--results") == 0 && has_value) {
+            test_settings.results_filepath = argv[i + 1];
+            i += 1;
+        }
+        else if (strcmp(arg, "--baseline") == 0 && has_value) {
+            test_settings.baseline_filepath = argv[i + 1];
+            i += 1;
+        }
+        else if (strcmp(arg, "--threshold") == 0 && has_value) {
+            test_settings.regression_threshold_percent = atof(argv[i + 1]);
+            i += 1;
+        }
+        else if (strcmp(arg, "--bench") == 0 && i + 1 < argc) {
+            bench_count = atoi(argv[i + 1]);
+            i += 1;
+        }
+        else if (strcmp(arg, "--trace") == 0) {
+            enable_trace_recording = true;
+        }
+        else if (strcmp(arg, "--profile") == 0) {
+            enable_bytecode_profiling = true;
+        }
+        else if (strcmp(arg, "--c-profile") == 0) {
+            compiler_enable_c_generation = true;
+            compiler_execute_binary = true;
+            enable_c_profiling = true;
+        }
+        else if (strcmp(arg, "--pgo") == 0) {
+            enable_profile_guided_inlining = true;
+        }
+        else if (strcmp(arg, "--keep-dead-functions") == 0) {
+            enable_dead_function_elimination = false;
+        }
+        else if (strcmp(arg, "--memory") == 0) {
+            enable_allocation_tracking = true;
+        }
+        else if (strcmp(arg, "--fiber-stack") == 0 && has_value) {
+            fiber_stack_size = (u64)math_maximum(16, atoi(argv[i + 1])) * 1024;
+            i += 1;
+        }
+        else if (strcmp(arg, "--large-pages") == 0) {
+            if (!arena_block_pool_enable_large_pages()) {
+                logg("Large pages are not available, using normal pages\n");
+            }
+        }
+        else if (strcmp(arg, "--pool-cache") == 0 && has_value) {
+            arena_block_pool_set_max_cached_bytes((u64)math_maximum(0, atoi(argv[i + 1])) * 1024 * 1024);
+            i += 1;
+        }
+        else if (strncmp(arg, "-O", 2) == 0) {
+            compiler_optimization_level = atoi(arg + 2);
+        }
+        else if (arg[0] != '-' && filepath == nullptr) {
+            filepath = arg;
+        }
+        else {
+            upp_cli_print_usage();
+            return 1;
+        }
+    }
+    if (run_testcases) {
+        return upp_cli_run_testcases(argv[0], test_settings);
+    }
+    if (filepath == nullptr && bench_count <= 0) {
+        upp_cli_print_usage();
+        return 1;
+    }
+
+    // Timings are printed by the driver instead of compilation_data_compile
+    bool i_output_timing = output_timing;
+    SCOPE_EXIT(output_timing = i_output_timing;);
+    output_timing = false;
+
+    Fiber_Pool* fiber_pool = fiber_pool_create(fiber_stack_size);
+    SCOPE_EXIT(fiber_pool_destroy(fiber_pool));
+    SCOPE_EXIT(c_compiler_shutdown());
+
+    if (bench_count > 0) {
+        return upp_cli_bench(fiber_pool, bench_count, run);
+    }
+
+    Cli_Compile_Result result = upp_cli_compile_file(fiber_pool, string_create_static(filepath), run, true);
+    if (!result.file_loaded) {
+        logg("Could not load file \"%s\"\n", filepath);
+        return 1;
+    }
+
+    String exit_string = string_create();
+    SCOPE_EXIT(string_destroy(&exit_string));
+    exit_code_append_to_string(&exit_string, result.exit_code);
+    string_style_remove_codes(&exit_string);
+    logg("Exit code: %s\n", exit_string.characters);
+    upp_cli_print_timings(&result.timings);
+    logg("fiber switches: %lld\n", (i64)result.fiber_switch_count);
+    if (result.comptime_memo_hits + result.comptime_memo_misses > 0) {
+        logg("comptime memo: %d hits, %d misses\n", result.comptime_memo_hits, result.comptime_memo_misses);
+    }
+    Arena_Block_Pool_Stats pool_stats = arena_block_pool_stats();
+    logg("compilation arena: %d KB reserved, %d KB peak, %d blocks, %d KB waste, %d KB released for reuse\n",
+        (int)(result.arena_stats.reserved / 1024), (int)(result.arena_stats.peak_used / 1024), 
+        result.arena_stats.block_count, (int)(result.arena_stats.waste / 1024), (int)(result.arena_stats.released / 1024)
+    );
+    logg("arena block pool: %d allocated, %d reused, %d KB cached%s\n",
+        (int)pool_stats.blocks_allocated, (int)pool_stats.blocks_reused, (int)(pool_stats.cached_bytes / 1024),
+        pool_stats.large_pages_active ? ", large pages" : ""
+    );
+    if (allocation_tracker_is_enabled()) {
+        String memory_stats = string_create(512);
+        SCOPE_EXIT(string_destroy(&memory_stats));
+        allocation_tracker_append_stats_to_string(&memory_stats);
+        logg("\n-------- MEMORY (current = not freed after teardown) ---------\n%s", memory_stats.characters);
+
+        // Compares against the previous node layout, which stored both Text_Ranges inside each node
+        Cli_Ast_Stats& ast = result.ast_stats;
+        int line_count = math_maximum(1, ast.line_count);
+        logg("ast: %d nodes in %d lines, %d overflow ranges\n", ast.memory.node_count, ast.line_count, ast.memory.overflow_count);
+        logg("ast header + ranges: %.1f bytes/line (inline ranges: %.1f bytes/line)\n",
+            (double)(ast.memory.header_bytes + ast.memory.range_table_bytes) / line_count,
+            (double)ast.memory.inline_range_bytes / line_count
+        );
+        logg("ast walk: %.3f ms headers only, %.3f ms with range decoding, %.3f ms with per-node unit lookup\n", 
+            ast.header_walk_time * 1000, ast.range_walk_time * 1000, ast.node_lookup_walk_time * 1000
+        );
+    }
+    if (report) {
+        const char* c_emission = "-";
+        if (check_c_emission && result.exit_code.type == Exit_Code_Type::SUCCESS) {
+            c_emission = upp_cli_check_c_emission(fiber_pool, string_create_static(filepath)) ? "identical" : "differs";
+        }
+        double run_ms = result.timings.phases[(int)Cli_Phase::RUN] * 1000;
+        logg("%s %.3f %.3f %s\n", CLI_REPORT_PREFIX, result.timings.phases[(int)Cli_Phase::TOTAL] * 1000 - run_ms, run_ms, c_emission);
+    }
+    if (check_c_profile && !upp_cli_check_c_profile_report(fiber_pool, string_create_static(filepath))) {
+        logg("C-PROFILE report check failed\n");
+        return 1;
+    }
+    return result.exit_code.type == Exit_Code_Type::SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Headless compiler driver, usage:
+//   upp <file.upp> [--run]     Compile file (and execute it with the interpreter), print timings
+//                  [-O<level>] Inlining level, 0 = none (default), 1 = small functions, 2 = larger ones
+//                  [--trace]   Write Chrome trace json of the compilation (see trace_recorder.hpp)
+//                  [--profile] Profile bytecode execution per function/line (see Bytecode_Profile)
+//                  [--c-profile] Run instrumented C-backend build, report per function/loop (see enable_c_profiling)
+//                  [--pgo]     Inline hot functions of the last C-profile more aggressively
+//                  [--keep-dead-functions] Generate code for functions unreachable from main
+//                  [--memory]  Print allocations per compiler subsystem (see allocation_tracker.hpp) and AST memory
+//                  [--fiber-stack KB] Stack size of the workload fibers (see fiber.hpp)
+//                  [--large-pages] Back arena blocks with large pages if the OS allows it (see allocators.hpp)
+//                  [--pool-cache MB] Maximum memory the arena block pool keeps for reuse
+//   upp --bench N              Compile all testcases + synthetic programs N times, print min/median/p95 per phase
+//   upp --test [--jobs N] [--timeout seconds] [--results file] [--baseline file] [--threshold percent]
+//                              Run all testcases in separate child processes, compare timings with baseline
+//                              and check that C emission is identical for all thread counts
+int upp_cli_main(int argc, char** argv);
@@ -1,5 +1,7 @@
 #include "ast.hpp"
 
+#include <cstddef>
+
 #include "compilation_data.hpp"
 
 namespace AST
@@ -917,4 +919,92 @@ namespace AST
 		assert(parts.size > 0, "");
 		return parts[parts.size - 1];
 	}
+
+
+
+	// Node ranges
+	static bool node_ranges_can_be_packed(Node_Ranges& ranges)
+	{
+		Text_Range& range = ranges.range;
+		Text_Range& bounding = ranges.bounding_range;
+		int line_count = range.end.line - range.start.line;
+		int lines_before = range.start.line - bounding.start.line;
+		int lines_after = bounding.end.line - range.end.line;
+		return
+			line_count >= 0 && line_count < PACKED_RANGE_OVERFLOW &&
+			lines_before >= 0 && lines_before <= 0xFF &&
+			lines_after >= 0 && lines_after <= 0xFF &&
+			range.start.character >= 0 && range.start.character <= 0xFFFF &&
+			range.end.character >= 0 && range.end.character <= 0xFFFF &&
+			bounding.start.character >= 0 && bounding.start.character <= 0xFFFF &&
+			bounding.end.character >= 0 && bounding.end.character <= 0xFFFF;
+	}
+
+	Node_Range_Table node_range_table_create(Array<Node_Ranges> ranges, Arena* arena)
+	{
+		int overflow_count = 0;
+		for (int i = 0; i < ranges.size; i++) {
+			if (!node_ranges_can_be_packed(ranges[i])) {
+				overflow_count += 1;
+			}
+		}
+
+		Node_Range_Table table;
+		table.packed = arena->allocate_array<Packed_Node_Ranges>(ranges.size);
+		table.overflow = arena->allocate_array<Node_Ranges>(overflow_count);
+		int overflow_index = 0;
+		for (int i = 0; i < ranges.size; i++)
+		{
+			Node_Ranges& node_ranges = ranges[i];
+			Packed_Node_Ranges& packed = table.packed[i];
+			if (!node_ranges_can_be_packed(node_ranges)) {
+				table.overflow[overflow_index] = node_ranges;
+				packed.start_line = overflow_index;
+				packed.line_count = PACKED_RANGE_OVERFLOW;
+				overflow_index += 1;
+				continue;
+			}
+
+			Text_Range& range = node_ranges.range;
+			Text_Range& bounding = node_ranges.bounding_range;
+			packed.start_line = range.start.line;
+			packed.start_character = (u16)range.start.character;
+			packed.end_character = (u16)range.end.character;
+			packed.line_count = (u16)(range.end.line - range.start.line);
+			packed.bounding_start_character = (u16)bounding.start.character;
+			packed.bounding_end_character = (u16)bounding.end.character;
+			packed.bounding_lines_before = (u8)(range.start.line - bounding.start.line);
+			packed.bounding_lines_after = (u8)(bounding.end.line - range.end.line);
+		}
+		return table;
+	}
+
+	Node_Ranges node_range_table_get(Node_Range_Table* table, u32 node_index)
+	{
+		assert(node_index < (u32)table->packed.size, "Node was not part of the parsed tree");
+		Packed_Node_Ranges& packed = table->packed[(int)node_index];
+		if (packed.line_count == PACKED_RANGE_OVERFLOW) {
+			return table->overflow[packed.start_line];
+		}
+
+		Node_Ranges result;
+		int end_line = packed.start_line + packed.line_count;
+		result.range.start = text_index_make(packed.start_line, packed.start_character);
+		result.range.end = text_index_make(end_line, packed.end_character);
+		result.bounding_range.start = text_index_make(packed.start_line - packed.bounding_lines_before, packed.bounding_start_character);
+		result.bounding_range.end = text_index_make(end_line + packed.bounding_lines_after, packed.bounding_end_character);
+		return result;
+	}
+
+	Node_Memory_Stats root_get_memory_stats(Root_Node* root)
+	{
+		Node_Range_Table& table = root->range_table;
+		Node_Memory_Stats stats;
+		stats.node_count = table.packed.size;
+		stats.overflow_count = table.overflow.size;
+		stats.header_bytes = (i64)table.packed.size * sizeof(Node);
+		stats.range_table_bytes = (i64)table.packed.size * sizeof(Packed_Node_Ranges) + (i64)table.overflow.size * sizeof(Node_Ranges);
+		stats.inline_range_bytes = (i64)table.packed.size * (sizeof(Node) + sizeof(Node_Ranges));
+		return stats;
+	}
 }
@@ -79,7 +79,7 @@ namespace AST
         DEREFERENCE,          // -*
     };
 
-    enum class Node_Type
+    enum class Node_Type : u8
     {
         EXPRESSION,
         STATEMENT,
@@ -101,12 +101,40 @@ namespace AST
         MATCH_CASE,           // Expression 
     };
 
+    // Ranges are kept out of the node (see Node_Range_Table), so the header stays at 16 bytes.
+    // Children are still referenced by pointer, only ranges and annotations are addressed by index
     struct Node
     {
         Node_Type type;
+        u16 unit_index; // See Compilation_Unit::index
+        u32 index; // Allocation order inside the compilation unit, root is 0
         Node* parent; // parent of root is nullptr
+    };
+
+    struct Node_Ranges
+    {
         Text_Range range;
-        Text_Range bounding_range;
+        Text_Range bounding_range; // Range including all children
+    };
+
+    // Line deltas/16 bit columns, entries which don't fit are stored unpacked in overflow
+    struct Packed_Node_Ranges
+    {
+        int start_line; // Index into overflow if line_count == PACKED_RANGE_OVERFLOW
+        u16 start_character;
+        u16 end_character;
+        u16 line_count; // range.end.line - range.start.line
+        u16 bounding_start_character;
+        u16 bounding_end_character;
+        u8 bounding_lines_before; // range.start.line - bounding_range.start.line
+        u8 bounding_lines_after;  // bounding_range.end.line - range.end.line
+    };
+    #define PACKED_RANGE_OVERFLOW 0xFFFF
+
+    struct Node_Range_Table
+    {
+        Array<Packed_Node_Ranges> packed; // Indexed by Node::index
+        Array<Node_Ranges> overflow;
     };
 
     struct Root_Node
@@ -114,6 +142,7 @@ namespace AST
         Node base;
         Array<Definition*> definitions;
         Compilation_Unit* compilation_unit;
+        Node_Range_Table range_table;
     };
 
     // Note: #get_overload can also specify return_type, in which case the id is set appropriately (see parser.cpp)
@@ -612,5 +641,19 @@ namespace AST
     Definition* upcast_definition(Definition_Enum* node);
     Definition* upcast_definition(Definition_Fast_Call* node);
     Definition* upcast_definition(Definition_Import_Block* node);
+
+    // Node ranges
+    Node_Range_Table node_range_table_create(Array<Node_Ranges> ranges, Arena* arena);
+    Node_Ranges node_range_table_get(Node_Range_Table* table, u32 node_index); // See ast_node_get_ranges in compilation_data.hpp
+
+    struct Node_Memory_Stats
+    {
+        int node_count;
+        int overflow_count;
+        i64 header_bytes;      // sizeof(Node) per node
+        i64 range_table_bytes;
+        i64 inline_range_bytes; // Header bytes if both Text_Ranges were stored inside each node
+    };
+    Node_Memory_Stats root_get_memory_stats(Root_Node* root);
 }
 
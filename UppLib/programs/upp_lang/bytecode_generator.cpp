@@ -47,6 +47,7 @@ struct Bytecode_Generator
     Upp_Function* function;
     IR_Code_Block* current_block;
     int current_stack_offset;
+    AST::Statement* current_statement; // Stored for each generated instruction in bytecode_statements
 
     DynTable<Stack_Location, int> stack_locations; // For registers and parameters/return-value
     DynTable<IR_Code_Block*, int> continue_location;
@@ -114,6 +115,7 @@ Bytecode_Instruction instruction_make_4(Instruction_Type type, int src_1, int sr
 
 int bytecode_generator_add_instruction(Bytecode_Generator* generator, Bytecode_Instruction instruction) {
     generator->compilation_data->bytecode.push_back(instruction);
+    generator->compilation_data->bytecode_statements.push_back(generator->current_statement);
     return generator->compilation_data->bytecode.size - 1;
 }
 
@@ -596,7 +598,7 @@ void push_exit_instruction(Bytecode_Generator* generator, Exit_Code exit_code)
     assert(sizeof(Exit_Code) <= sizeof(int) * 4, "");
     Bytecode_Instruction instr = instruction_make_0(Instruction_Type::EXIT);
     memory_copy(&instr.op1, &exit_code, sizeof(Exit_Code));
-    generator->compilation_data->bytecode.push_back(instr);
+    bytecode_generator_add_instruction(generator, instr);
 }
 
 Exit_Code exit_code_from_exit_instruction(Bytecode_Instruction& exit_instr)
@@ -607,6 +609,57 @@ Exit_Code exit_code_from_exit_instruction(Bytecode_Instruction& exit_instr)
     return result;
 }
 
+// Switch dispatch
+#define SWITCH_JUMP_TABLE_MIN_CASES 4
+#define SWITCH_LINEAR_SEARCH_MAX_CASES 3
+
+struct Switch_Jump
+{
+    int instruction_index;
+    int case_index; // -1 for default block
+};
+
+Switch_Jump switch_jump_make(int instruction_index, int case_index) {
+    Switch_Jump result;
+    result.instruction_index = instruction_index;
+    result.case_index = case_index;
+    return result;
+}
+
+// Generates a binary search over the case values, jumps to cases/default are added to case_jumps
+void bytecode_generator_generate_switch_search(
+    Bytecode_Generator* generator, IR_Instruction_Switch* switch_instr, int condition_stack_offset, Array<int> sorted_cases, Dynamic_Array<Switch_Jump>* case_jumps)
+{
+    const int PLACEHOLDER = 0;
+    auto& instructions = generator->compilation_data->bytecode;
+    auto& cases = switch_instr->cases;
+
+    if (sorted_cases.size <= SWITCH_LINEAR_SEARCH_MAX_CASES)
+    {
+        for (int i = 0; i < sorted_cases.size; i++) {
+            int jump_index = bytecode_generator_add_instruction(generator,
+                instruction_make_3(Instruction_Type::JUMP_ON_INT_EQUAL, PLACEHOLDER, condition_stack_offset, cases[sorted_cases[i]].value)
+            );
+            dynamic_array_push_back(case_jumps, switch_jump_make(jump_index, sorted_cases[i]));
+        }
+        int default_jump_index = bytecode_generator_add_instruction(generator, instruction_make_1(Instruction_Type::JUMP, PLACEHOLDER));
+        dynamic_array_push_back(case_jumps, switch_jump_make(default_jump_index, -1));
+        return;
+    }
+
+    int mid = sorted_cases.size / 2;
+    int less_jump_index = bytecode_generator_add_instruction(generator,
+        instruction_make_3(Instruction_Type::JUMP_ON_INT_LESS, PLACEHOLDER, condition_stack_offset, cases[sorted_cases[mid]].value)
+    );
+    bytecode_generator_generate_switch_search(
+        generator, switch_instr, condition_stack_offset, array_create_static(sorted_cases.data + mid, sorted_cases.size - mid), case_jumps
+    );
+    instructions[less_jump_index].op1 = instructions.size;
+    bytecode_generator_generate_switch_search(
+        generator, switch_instr, condition_stack_offset, array_create_static(sorted_cases.data, mid), case_jumps
+    );
+}
+
 void bytecode_generator_generate_code_block(Bytecode_Generator* generator, IR_Code_Block* code_block)
 {
     auto compilation_data = generator->compilation_data;
@@ -615,11 +668,13 @@ void bytecode_generator_generate_code_block(Bytecode_Generator* generator, IR_Co
     int& stack_offset = generator->current_stack_offset;
 
     int rewind_stack_offset = generator->current_stack_offset;
+    AST::Statement* rewind_statement = generator->current_statement;
     SCOPE_EXIT(
         generator->function->bytecode_maximum_stack_offset = math_maximum(
             generator->function->bytecode_maximum_stack_offset, generator->current_stack_offset
         );
         generator->current_stack_offset = rewind_stack_offset;
+        generator->current_statement = rewind_statement;
     );
 
     // Generate Stack offsets for registers
@@ -635,6 +690,9 @@ void bytecode_generator_generate_code_block(Bytecode_Generator* generator, IR_Co
     for (int i = 0; i < code_block->instructions.size; i++)
     {
         IR_Instruction* instr = &code_block->instructions[i];
+        if (instr->associated_statement != nullptr) {
+            generator->current_statement = instr->associated_statement;
+        }
 
         // Not entirely sure if I can do this after every instruction, but I think so, 
         // as "communication" between instructions can only happen through data-accesses,
@@ -742,47 +800,84 @@ void bytecode_generator_generate_code_block(Bytecode_Generator* generator, IR_Co
         }
         case IR_Instruction_Type::MATCH:
         {
-            /*
-                Current switch implementation is just a linear search through the values.
-                Better Implementations would be to use a combination of:
-                    * Binary search
-                    * Jump table
-            */
+            // Switches use a jump-table if case values are dense, otherwise a binary search over the case values
             IR_Instruction_Switch* switch_instr = &instr->options.switch_instr;
+            auto& cases = switch_instr->cases;
             int condition_stack_offset = data_access_read_value(generator, switch_instr->condition_access);
 
-            Dynamic_Array<int> case_jump_indices = dynamic_array_create<int>(switch_instr->cases.size);
-            Dynamic_Array<int> jmp_to_switch_end_indices = dynamic_array_create<int>(switch_instr->cases.size + 1);
-            SCOPE_EXIT(dynamic_array_destroy(&case_jump_indices));
+            Dynamic_Array<Switch_Jump> case_jumps = dynamic_array_create<Switch_Jump>(cases.size + 1);
+            Dynamic_Array<int> case_start_indices = dynamic_array_create<int>(cases.size);
+            Dynamic_Array<int> jmp_to_switch_end_indices = dynamic_array_create<int>(cases.size + 1);
+            SCOPE_EXIT(dynamic_array_destroy(&case_jumps));
+            SCOPE_EXIT(dynamic_array_destroy(&case_start_indices));
             SCOPE_EXIT(dynamic_array_destroy(&jmp_to_switch_end_indices));
 
-            for (int i = 0; i < switch_instr->cases.size; i++)
+            // Generate dispatch
+            int jump_table_index = -1;
             {
-                IR_Switch_Case* switch_case = &switch_instr->cases[i];
-                dynamic_array_push_back(&case_jump_indices, 
-                    bytecode_generator_add_instruction(generator,
-                        instruction_make_3(Instruction_Type::JUMP_ON_INT_EQUAL, PLACEHOLDER, condition_stack_offset, switch_case->value)
-                    )
-                );
+                i64 min_value = 0;
+                i64 max_value = 0;
+                for (int i = 0; i < cases.size; i++) {
+                    if (i == 0 || cases[i].value < min_value) min_value = cases[i].value;
+                    if (i == 0 || cases[i].value > max_value) max_value = cases[i].value;
+                }
+                i64 range = max_value - min_value + 1;
+
+                if (cases.size >= SWITCH_JUMP_TABLE_MIN_CASES && range <= (i64)cases.size * 2)
+                {
+                    // Table entries are stored as jump instructions after the JUMP_TABLE instruction
+                    jump_table_index = bytecode_generator_add_instruction(generator,
+                        instruction_make_4(Instruction_Type::JUMP_TABLE, condition_stack_offset, (int)min_value, (int)range, PLACEHOLDER)
+                    );
+                    for (int i = 0; i < range; i++) {
+                        bytecode_generator_add_instruction(generator, instruction_make_1(Instruction_Type::JUMP, PLACEHOLDER));
+                        dynamic_array_push_back(&case_jumps, switch_jump_make(jump_table_index + 1 + i, -1));
+                    }
+                    for (int i = 0; i < cases.size; i++) {
+                        case_jumps[(int)(cases[i].value - min_value)].case_index = i;
+                    }
+                }
+                else
+                {
+                    Dynamic_Array<int> sorted_cases = dynamic_array_create<int>(cases.size);
+                    SCOPE_EXIT(dynamic_array_destroy(&sorted_cases));
+                    for (int i = 0; i < cases.size; i++) {
+                        dynamic_array_push_back(&sorted_cases, i);
+                    }
+                    dynamic_array_sort(&sorted_cases, [&](int a, int b) -> bool { return cases[a].value < cases[b].value; });
+                    bytecode_generator_generate_switch_search(
+                        generator, switch_instr, condition_stack_offset, dynamic_array_as_array(&sorted_cases), &case_jumps
+                    );
+                }
             }
 
             // Generate default block
+            int default_start_index = instructions.size;
             bytecode_generator_generate_code_block(generator, switch_instr->default_block);
             dynamic_array_push_back(&jmp_to_switch_end_indices, 
                 bytecode_generator_add_instruction(generator, instruction_make_1(Instruction_Type::JUMP, PLACEHOLDER))
             );
 
             // Generate switch cases
-            for (int i = 0; i < switch_instr->cases.size; i++)
+            for (int i = 0; i < cases.size; i++)
             {
-                IR_Switch_Case* switch_case = &switch_instr->cases[i];
-                instructions[case_jump_indices[i]].op1 = instructions.size;
+                IR_Switch_Case* switch_case = &cases[i];
+                dynamic_array_push_back(&case_start_indices, (int)instructions.size);
                 bytecode_generator_generate_code_block(generator, switch_case->block);
                 dynamic_array_push_back(&jmp_to_switch_end_indices,
                     bytecode_generator_add_instruction(generator, instruction_make_1(Instruction_Type::JUMP, PLACEHOLDER))
                 );
             }
 
+            // Set dispatch jumps
+            for (int i = 0; i < case_jumps.size; i++) {
+                Switch_Jump& jump = case_jumps[i];
+                instructions[jump.instruction_index].op1 = jump.case_index == -1 ? default_start_index : case_start_indices[jump.case_index];
+            }
+            if (jump_table_index != -1) {
+                instructions[jump_table_index].op4 = default_start_index;
+            }
+
             // Set jumps to end of switch
             for (int i = 0; i < jmp_to_switch_end_indices.size; i++) {
                 instructions[jmp_to_switch_end_indices[i]].op1 = instructions.size;
@@ -935,6 +1030,7 @@ void bytecode_generator_generate_code_block(Bytecode_Generator* generator, IR_Co
 void bytecode_generator_compile_function(Compilation_Data* compilation_data, Upp_Function* function)
 {
     if (function->bytecode_start_instruction != -1) return; // Function already generated
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::BYTECODE);
     assert(function->ir_block != nullptr, "ir-block must exist");
 
     Arena* tmp_arena = &compilation_data->tmp_arena;
@@ -946,6 +1042,7 @@ void bytecode_generator_compile_function(Compilation_Data* compilation_data, Upp
     generator.function = function;
     generator.current_block = nullptr;
     generator.current_stack_offset = 0;
+    generator.current_statement = nullptr;
     generator.stack_locations   = DynTable<Stack_Location, int>::create(tmp_arena, hash_stack_location, equals_stack_location);
     generator.continue_location = DynTable<IR_Code_Block*, int>::create_pointer(tmp_arena);
     generator.break_location    = DynTable<IR_Code_Block*, int>::create_pointer(tmp_arena);
@@ -958,17 +1055,20 @@ void bytecode_generator_compile_function(Compilation_Data* compilation_data, Upp
     // Generate parameter offsets
     {
         auto& function_parameters = function->signature->parameters;
+        function->bytecode_parameter_offsets = compilation_data->arena.allocate_array<int>(function_parameters.size);
         stack_offset = 16; // Stack starts with [Return_Address] [Old_Stack_Pointer], then parameters
         auto return_type_opt = function->signature->return_type();
         if (return_type_opt.available) {
             // Note: we don't store return-type in stack-locations, because we shouldn't be able to access it
-            bytecode_generator_create_temporary_stack_offset(&generator, return_type_opt.value);
+            int return_offset = bytecode_generator_create_temporary_stack_offset(&generator, return_type_opt.value);
+            function->bytecode_parameter_offsets[function->signature->return_type_index] = return_offset;
         }
         for (int i = 0; i < function_parameters.size; i++)
         {
             if (function->signature->return_type_index == i) continue;
             int param_offset = bytecode_generator_create_temporary_stack_offset(&generator, function_parameters[i].datatype);
             generator.stack_locations.insert(stack_location_make_parameter(function, i), param_offset);
+            function->bytecode_parameter_offsets[i] = param_offset;
         }
     }
 
@@ -989,81 +1089,134 @@ void bytecode_generator_compile_function(Compilation_Data* compilation_data, Upp
     }
 }
 
+// Rewrites calls to compiled functions into CALL_RESOLVED, so the interpreter can skip validation
+void bytecode_generator_link_function_calls(Compilation_Data* compilation_data, Upp_Function* function)
+{
+    if (function->bytecode_start_instruction == -1) return;
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::BYTECODE);
+
+    auto& instructions = compilation_data->bytecode;
+    for (int i = function->bytecode_start_instruction; i < function->bytecode_end_instruction; i++)
+    {
+        Bytecode_Instruction& instr = instructions[i];
+        if (instr.instruction_type != Instruction_Type::CALL_FUNCTION) continue;
+
+        Upp_Function* call_to = compilation_data->functions[instr.op1 - 1];
+        if (call_to->is_extern || call_to->contains_errors || call_to->bytecode_start_instruction == -1) continue;
+        if (call_to->poly_type == Poly_Type::BASE || call_to->poly_type == Poly_Type::PARTIAL) continue;
+
+        instr = instruction_make_4(
+            Instruction_Type::CALL_RESOLVED, call_to->bytecode_start_instruction, instr.op2, call_to->function_index, call_to->bytecode_maximum_stack_offset
+        );
+    }
+}
+
+// Appends the name padded to the operand column, then "label_1 op1, label_2 op2, ..." up to the last given label
+static void bytecode_append_instruction(
+    String* string, const char* name, Bytecode_Instruction& instruction,
+    const char* label_1, const char* label_2 = nullptr, const char* label_3 = nullptr, const char* label_4 = nullptr)
+{
+    const int operand_column = 29;
+    int name_start = string->size;
+    string_append(string, name);
+    string_append_repeated(string, ' ', operand_column - (string->size - name_start));
+
+    const char* labels[4] = { label_1, label_2, label_3, label_4 };
+    int operands[4] = { instruction.op1, instruction.op2, instruction.op3, instruction.op4 };
+    for (int i = 0; i < 4 && labels[i] != nullptr; i++) {
+        if (i != 0) {
+            string_append_characters(string, ", ", 2);
+        }
+        string_append(string, labels[i]);
+        string_append_i64(string, operands[i]);
+    }
+}
+
 void bytecode_instruction_append_to_string(String* string, Bytecode_Instruction instruction)
 {
     Bytecode_Instruction& i = instruction;
     switch (instruction.instruction_type)
     {
     case Instruction_Type::MOVE_STACK_DATA:
-        string_append_formated(string, "MOVE_STACK_DATA              dst: %d, src: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "MOVE_STACK_DATA", i, "dst: ", "src: ", "size: ");
         break;
     case Instruction_Type::WRITE_MEMORY:
-        string_append_formated(string, "WRITE_MEMORY                 addr_reg: %d, value_reg: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "WRITE_MEMORY", i, "addr_reg: ", "value_reg: ", "size: ");
         break;
     case Instruction_Type::READ_MEMORY:
-        string_append_formated(string, "READ_MEMORY                  dst: %d, addr_reg: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "READ_MEMORY", i, "dst: ", "addr_reg: ", "size: ");
         break;
     case Instruction_Type::MEMORY_COPY:
-        string_append_formated(string, "MEMORY_COPY                  dst_addr_reg: %d, src_addr_reg:%d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "MEMORY_COPY", i, "dst_addr_reg: ", "src_addr_reg:", "size: ");
         break;
     case Instruction_Type::READ_GLOBAL:
-        string_append_formated(string, "READ_GLOBAL                  dst: %d, global_index: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "READ_GLOBAL", i, "dst: ", "global_index: ", "size: ");
         break;
     case Instruction_Type::WRITE_GLOBAL:
-        string_append_formated(string, "WRITE_GLOBAL                 global_index: %d, src: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "WRITE_GLOBAL", i, "global_index: ", "src: ", "size: ");
         break;
     case Instruction_Type::READ_CONSTANT:
-        string_append_formated(string, "READ_CONSTANT                dst: %d, const_index: %d, size: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "READ_CONSTANT", i, "dst: ", "const_index: ", "size: ");
         break;
     case Instruction_Type::U64_ADD_CONSTANT_I32:
-        string_append_formated(string, "U64_ADD_CONSTANT_I32         dst: %d, base: %d, offset: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "U64_ADD_CONSTANT_I32", i, "dst: ", "base: ", "offset: ");
         break;
     case Instruction_Type::U64_MULTIPLY_ADD_I32:
-        string_append_formated(string, "U64_MULTIPLY_ADD_I32         dst: %d, base: %d, index_reg: %d, size: %d", i.op1, i.op2, i.op3, i.op4);
+        bytecode_append_instruction(string, "U64_MULTIPLY_ADD_I32", i, "dst: ", "base: ", "index_reg: ", "size: ");
         break;
     case Instruction_Type::JUMP:
-        string_append_formated(string, "JUMP                         instr-nr: %d", i.op1);
+        bytecode_append_instruction(string, "JUMP", i, "instr-nr: ");
         break;
     case Instruction_Type::JUMP_ON_TRUE:
-        string_append_formated(string, "JUMP_ON_TRUE                 instr-nr: %d, cond_reg: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "JUMP_ON_TRUE", i, "instr-nr: ", "cond_reg: ");
         break;
     case Instruction_Type::JUMP_ON_FALSE:
-        string_append_formated(string, "JUMP_ON_FALSE                instr-nr: %d, cond_reg: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "JUMP_ON_FALSE", i, "instr-nr: ", "cond_reg: ");
         break;
     case Instruction_Type::JUMP_ON_INT_EQUAL:
-        string_append_formated(string, "JUMP_ON_INT_EQUAL            instr-nr: %d, cond_reg: %d, equal_value: %d", i.op1, i.op2, i.op3);
+        bytecode_append_instruction(string, "JUMP_ON_INT_EQUAL", i, "instr-nr: ", "cond_reg: ", "equal_value: ");
+        break;
+    case Instruction_Type::JUMP_ON_INT_LESS:
+        bytecode_append_instruction(string, "JUMP_ON_INT_LESS", i, "instr-nr: ", "cond_reg: ", "less_than_value: ");
+        break;
+    case Instruction_Type::JUMP_TABLE:
+        bytecode_append_instruction(string, "JUMP_TABLE", i, "cond_reg: ", "base_value: ", "table_size: ", "default-instr-nr: ");
         break;
     case Instruction_Type::CALL_FUNCTION:
-        string_append_formated(string, "CALL_FUNCTION                function-start-instr: %d, new-frame-offset: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "CALL_FUNCTION", i, "function-start-instr: ", "new-frame-offset: ");
+        break;
+    case Instruction_Type::CALL_RESOLVED:
+        bytecode_append_instruction(string, "CALL_RESOLVED", i, "instr-nr: ", "new-frame-offset: ", "function-index: ", "max-stack-offset: ");
         break;
     case Instruction_Type::CALL_FUNCTION_POINTER:
-        string_append_formated(string, "CALL_FUNCTION_POINTER        pointer-reg: %d, new-frame-offset: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "CALL_FUNCTION_POINTER", i, "pointer-reg: ", "new-frame-offset: ");
         break;
     case Instruction_Type::CALL_BUILTIN_FUNCTION:
-        string_append_formated(string, "CALL_BUILTIN_FUNCTION      hardcoded_func_type:");
+        string_append(string, "CALL_BUILTIN_FUNCTION      hardcoded_func_type:");
         string->append(hardcoded_type_get_info((Hardcoded_Type)i.op1).symbol_name);
-        string_append_formated(string, ", new-frame-offset: %d", i.op2);
+        string_append(string, ", new-frame-offset: ");
+        string_append_i64(string, i.op2);
         break;
     case Instruction_Type::RETURN:
-        string_append_formated(string, "RETURN                       ");
+        string_append(string, "RETURN                       ");
         break;
     case Instruction_Type::EXIT: {
-        string_append_formated(string, "EXIT                         Code: ");
+        string_append(string, "EXIT                         Code: ");
         Exit_Code code = exit_code_from_exit_instruction(instruction);
         exit_code_append_to_string(string, code);
         break;
     }
     case Instruction_Type::LOAD_REGISTER_ADDRESS:
-        string_append_formated(string, "LOAD_REGISTER_ADDRESS        dst: %d, reg-to-load: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "LOAD_REGISTER_ADDRESS", i, "dst: ", "reg-to-load: ");
         break;
     case Instruction_Type::LOAD_GLOBAL_ADDRESS:
-        string_append_formated(string, "LOAD_GLOBAL_ADDRESS          dst: %d, global-index: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "LOAD_GLOBAL_ADDRESS", i, "dst: ", "global-index: ");
         break;
     case Instruction_Type::LOAD_CONSTANT_ADDRESS:
-        string_append_formated(string, "LOAD_CONSTANT_ADDRESS        dst: %d, constant-index: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "LOAD_CONSTANT_ADDRESS", i, "dst: ", "constant-index: ");
         break;
     case Instruction_Type::LOAD_FUNCTION_LOCATION:
-        string_append_formated(string, "LOAD_FUNCTION_LOCATION       dst: %d, function-index: %d", i.op1, i.op2);
+        bytecode_append_instruction(string, "LOAD_FUNCTION_LOCATION", i, "dst: ", "function-index: ");
         break;
     case Instruction_Type::IR_OPERATION:
     {
@@ -1072,17 +1225,22 @@ void bytecode_instruction_append_to_string(String* string, Bytecode_Instruction
         Bytecode_Type right_type;
         Bytecode_Type dst_type;
         bytecode_unpack_operation_and_types_from_int(i.op4, ir_op, left_type, right_type, dst_type);
-        string_append_formated(string, "IR_OPERATION                 dst: %d, src1: %d, src2: %d", i.op1, i.op2, i.op3);
-        string_append_formated(string, "\n       %s, left_type: %s", ir_operation_as_string(ir_op), bytecode_type_as_string(left_type));
+        bytecode_append_instruction(string, "IR_OPERATION", i, "dst: ", "src1: ", "src2: ");
+        string_append(string, "\n       ");
+        string_append(string, ir_operation_as_string(ir_op));
+        string_append(string, ", left_type: ");
+        string_append(string, bytecode_type_as_string(left_type));
         if (ir_operation_parameter_count(ir_op) == 2) {
-            string_append_formated(string, " right_type: %s", bytecode_type_as_string(right_type));
+            string_append(string, " right_type: ");
+            string_append(string, bytecode_type_as_string(right_type));
         }
-        string_append_formated(string, " dst_type: %s", bytecode_type_as_string(dst_type));
+        string_append(string, " dst_type: ");
+        string_append(string, bytecode_type_as_string(dst_type));
         break;
 
     }
     default:
-        string_append_formated(string, "FUCKING HELL\n");
+        string_append(string, "FUCKING HELL\n");
         break;
     }
 }
@@ -1092,20 +1250,33 @@ void bytecode_generator_append_bytecode_to_string(Compilation_Data* compilation_
     for (int i = 0; i < compilation_data->functions.size; i++)
     {
         Upp_Function* function = compilation_data->functions[i];
-        string_append_formated(string, "Function #%d: \"%s\" \n", i, function->name->characters);
+        string_append(string, "Function #");
+        string_append_i64(string, i);
+        string_append(string, ": \"");
+        string_append_string(string, function->name);
+        string_append(string, "\" \n");
         if (function->bytecode_start_instruction == -1) {
             string_append(string, "NO instructions generated!\n");
             continue;
         }
 
+        // Most instruction lines are shorter than 96 characters
+        string_reserve_append(string, (function->bytecode_end_instruction - function->bytecode_start_instruction) * 96);
         for (int i = function->bytecode_start_instruction; i < function->bytecode_end_instruction; i++)
         {
             Bytecode_Instruction& instruction = compilation_data->bytecode[i];
-            string_append_formated(string, "%4d: ", i);
+            // %4d
+            int digit_count = 1;
+            for (int value = i; value >= 10; value /= 10) {
+                digit_count += 1;
+            }
+            string_append_repeated(string, ' ', 4 - digit_count);
+            string_append_i64(string, i);
+            string_append(string, ": ");
             bytecode_instruction_append_to_string(string, instruction);
-            string_append_formated(string, "\n");
+            string_append(string, "\n");
         }
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
     }
 }
 
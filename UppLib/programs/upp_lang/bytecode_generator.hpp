@@ -51,8 +51,11 @@ enum class Instruction_Type
     JUMP_ON_TRUE, // op1 = instruction_index, op2 = cnd_reg
     JUMP_ON_FALSE, // op1 = instruction_index, op2 = cnd_reg
     JUMP_ON_INT_EQUAL, // op1 = instruction_index, op2 = cnd_reg, op3 = int_value
+    JUMP_ON_INT_LESS, // op1 = instruction_index, op2 = cnd_reg, op3 = int_value
+    JUMP_TABLE, // op1 = cnd_reg, op2 = base_value, op3 = table_size, op4 = default instruction_index, followed by table_size JUMP instructions
     CALL_FUNCTION, // Pushes return address, op1 = function_index+1, op2 = stack_offset for new frame
     CALL_FUNCTION_POINTER, // op1 = src_reg, op2 = stack_offset for new frame
+    CALL_RESOLVED, // Linked CALL_FUNCTION, op1 = start instruction, op2 = stack_offset for new frame, op3 = function_index, op4 = maximum stack offset of function
     CALL_BUILTIN_FUNCTION, // op1 = builtin_function, op2 = stack_offset for new frame (Parameter locations)
     RETURN, // Returns to previously called function, return-value should be stored on correct place on the stack by this point
     EXIT, // op1 = exit_code, op2 + op3 = Encoded pointer to error msg, see 
@@ -76,6 +79,7 @@ struct Bytecode_Instruction
 };
 
 void bytecode_generator_compile_function(Compilation_Data* compilation_data, Upp_Function* function);
+void bytecode_generator_link_function_calls(Compilation_Data* compilation_data, Upp_Function* function);
 void bytecode_instruction_append_to_string(String* string, Bytecode_Instruction instruction);
 void bytecode_generator_append_bytecode_to_string(Compilation_Data* compilation_data, String* string);
 Exit_Code exit_code_from_exit_instruction(Bytecode_Instruction& exit_instr);
@@ -1,11 +1,47 @@
 #include "bytecode_interpreter.hpp"
 
 #include <iostream>
+#include <cmath>
+#include <cstring>
 #include "../../utility/random.hpp"
 #include "compilation_data.hpp"
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <csetjmp>
+#include <csignal>
+#endif
 #include "ir_code.hpp"
 #include "compilation_data.hpp"
+#include "ast.hpp"
+#include "../../win32/timing.hpp"
+#include "../../utility/hash_functions.hpp"
+#include "../../utility/file_io.hpp"
+
+// Heap of bytecode threads, small allocations are rounded up to size-classes so freed blocks can be reused
+#define BYTECODE_HEAP_SIZE_CLASS_COUNT 9 // 16 bytes up to 4KB, larger allocations are handled seperately
+#define BYTECODE_HEAP_MIN_BLOCK_SIZE 16
+
+struct Heap_Block
+{
+    int capacity;
+    int size; // Requested size
+    bool is_free;
+};
+
+struct Bytecode_Heap
+{
+    DynTable<void*, Heap_Block> blocks; // All blocks ever handed out, used to detect double frees/foreign pointers
+    DynArray<void*> free_blocks[BYTECODE_HEAP_SIZE_CLASS_COUNT];
+    DynArray<void*> free_large_blocks;
+};
+
+struct Memo_Call
+{
+    byte* stack_frame;
+    Comptime_Memo_Key key;
+    int instruction_count_at_call;
+};
 
 struct Bytecode_Thread
 {
@@ -19,9 +55,16 @@ struct Bytecode_Thread
     int instruction_index;
     byte* stack_pointer;
     Array<byte> stack;
-    int heap_memory_consumption;
+    Bytecode_Heap heap;
+    int heap_memory_consumption; // Live bytes
     int executed_instruction_count;
 
+    // Memoization of pure function calls (Only for comptime threads)
+    bool memoize_pure_calls;
+    DynArray<Memo_Call> memo_calls;
+
+    Bytecode_Profile* profile; // nullptr if profiling is disabled
+
     // Result infos
     Exit_Code exit_code;
 };
@@ -39,6 +82,14 @@ Bytecode_Thread* bytecode_thread_create(
     result->max_instruction_executions = max_instruction_executions;
     result->max_heap_consumption = max_heap_consumption;
     result->allow_global_access = allow_global_access;
+    result->memoize_pure_calls = !allow_global_access; // Comptime threads cannot access globals, so results of pure functions are reusable
+    result->memo_calls = DynArray<Memo_Call>::create(arena);
+    result->heap.blocks = DynTable<void*, Heap_Block>::create_pointer(arena);
+    for (int i = 0; i < BYTECODE_HEAP_SIZE_CLASS_COUNT; i++) {
+        result->heap.free_blocks[i] = DynArray<void*>::create(arena);
+    }
+    result->heap.free_large_blocks = DynArray<void*>::create(arena);
+    result->profile = compilation_data->bytecode_profile;
     result->stack.size = stack_size;
     result->stack.data = (byte*) arena->allocate_raw(stack_size, 16); // Allocate raw instead of allocate_array so we can have 16 byte alignment
 
@@ -55,6 +106,196 @@ void interpreter_safe_memcopy(Bytecode_Thread* thread, void* dst, void* src, int
     }
 }
 
+// Copies where one side is compiler owned memory (Globals, constants), so only the stack side needs a bounds check
+// instead of memory_is_readable, which is a system call
+void interpreter_stack_memcopy(Bytecode_Thread* thread, byte* dst, byte* src, int size, bool dst_on_stack, bool src_on_stack)
+{
+    byte* stack_start = thread->stack.data;
+    byte* stack_end = thread->stack.data + thread->stack.size;
+    bool dst_valid = !dst_on_stack || (dst >= stack_start && dst + size <= stack_end);
+    bool src_valid = !src_on_stack || (src >= stack_start && src + size <= stack_end);
+    if (dst_valid && src_valid) {
+        memory_copy(dst, src, size);
+    }
+    else {
+        interpreter_safe_memcopy(thread, dst, src, size);
+    }
+}
+
+void* bytecode_heap_allocate(Bytecode_Thread* thread, upp_size size)
+{
+    if (size <= 0) {
+        thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Called malloc with size <= 0");
+        return nullptr;
+    }
+    if (thread->heap_memory_consumption + size > thread->max_heap_consumption) {
+        thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Reached maximum heap allocations");
+        return nullptr;
+    }
+
+    auto& heap = thread->heap;
+    void* result = nullptr;
+    int capacity = BYTECODE_HEAP_MIN_BLOCK_SIZE;
+    int size_class = 0;
+    while (capacity < size && size_class < BYTECODE_HEAP_SIZE_CLASS_COUNT) {
+        capacity = capacity * 2;
+        size_class += 1;
+    }
+
+    if (size_class < BYTECODE_HEAP_SIZE_CLASS_COUNT)
+    {
+        auto& free_blocks = heap.free_blocks[size_class];
+        if (free_blocks.size > 0) {
+            result = free_blocks.last();
+            free_blocks.rollback_to_size(free_blocks.size - 1);
+        }
+    }
+    else
+    {
+        // Large blocks: Use best fitting free block
+        capacity = (int)size;
+        int best_index = -1;
+        int best_capacity = 0;
+        for (int i = 0; i < heap.free_large_blocks.size; i++) {
+            Heap_Block* block = heap.blocks.find(heap.free_large_blocks[i]);
+            if (block->capacity >= size && (best_index == -1 || block->capacity < best_capacity)) {
+                best_index = i;
+                best_capacity = block->capacity;
+            }
+        }
+        if (best_index != -1) {
+            result = heap.free_large_blocks[best_index];
+            heap.free_large_blocks.swap_remove(best_index);
+            capacity = best_capacity;
+        }
+    }
+
+    if (result == nullptr) {
+        result = thread->arena->allocate_raw(capacity, 16);
+        Heap_Block block;
+        block.capacity = capacity;
+        block.size = (int)size;
+        block.is_free = false;
+        heap.blocks.insert(result, block);
+    }
+    else {
+        Heap_Block* block = heap.blocks.find(result);
+        block->size = (int)size;
+        block->is_free = false;
+    }
+
+    thread->heap_memory_consumption += (int)size;
+    return result;
+}
+
+void bytecode_heap_free(Bytecode_Thread* thread, void* data)
+{
+    if (data == nullptr) {
+        thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Free called on nullptr");
+        return;
+    }
+
+    auto& heap = thread->heap;
+    Heap_Block* block = heap.blocks.find(data);
+    if (block == nullptr) {
+        thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Free called on pointer which was not allocated");
+        return;
+    }
+    if (block->is_free) {
+        thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Double free detected");
+        return;
+    }
+
+    block->is_free = true;
+    thread->heap_memory_consumption -= block->size;
+    if (block->capacity > (BYTECODE_HEAP_MIN_BLOCK_SIZE << (BYTECODE_HEAP_SIZE_CLASS_COUNT - 1))) {
+        heap.free_large_blocks.push_back(data);
+        return;
+    }
+
+    int size_class = 0;
+    while ((BYTECODE_HEAP_MIN_BLOCK_SIZE << size_class) < block->capacity) {
+        size_class += 1;
+    }
+    heap.free_blocks[size_class].push_back(data);
+}
+
+// Size of the key buffer on the C-stack, larger argument lists are copied into the thread arena
+#define MEMO_KEY_STACK_BUFFER_SIZE 256
+
+// Returns false if arguments cannot be used as key (e.g. padding bytes), key bytes are written to buffer if they fit
+bool bytecode_thread_make_memo_key(Bytecode_Thread* thread, Upp_Function* function, byte* stack_frame, Comptime_Memo_Key* key, Array<byte> buffer)
+{
+    auto signature = function->signature;
+    int byte_count = 0;
+    for (int i = 0; i < signature->parameters.size; i++) {
+        if (i == signature->return_type_index) continue;
+        auto& memory_info = signature->parameters[i].datatype->memory_info.value;
+        if (memory_info.contains_padding_bytes) return false;
+        byte_count += memory_info.size;
+    }
+
+    key->function = function;
+    if (byte_count <= buffer.size) {
+        key->argument_bytes.data = buffer.data;
+        key->argument_bytes.size = byte_count;
+    }
+    else {
+        key->argument_bytes = thread->arena->allocate_array<byte>(byte_count);
+    }
+    int write_offset = 0;
+    for (int i = 0; i < signature->parameters.size; i++) {
+        if (i == signature->return_type_index) continue;
+        int size = signature->parameters[i].datatype->memory_info.value.size;
+        memory_copy(key->argument_bytes.data + write_offset, stack_frame + function->bytecode_parameter_offsets[i], size);
+        write_offset += size;
+    }
+    return true;
+}
+
+// Returns true if the result of the call was memoized, otherwise the call is recorded so the result is stored on return
+bool bytecode_thread_call_memoized(Bytecode_Thread* thread, Upp_Function* function, byte* stack_frame)
+{
+    auto compilation_data = thread->compilation_data;
+    if (!ir_function_is_pure(function)) {
+        return false;
+    }
+
+    byte key_buffer[MEMO_KEY_STACK_BUFFER_SIZE];
+    Memo_Call memo_call;
+    if (!bytecode_thread_make_memo_key(thread, function, stack_frame, &memo_call.key, array_create_static(key_buffer, MEMO_KEY_STACK_BUFFER_SIZE))) {
+        return false;
+    }
+
+    Comptime_Memo_Value* memo_value = compilation_data->comptime_memo.find(memo_call.key);
+    if (memo_value != nullptr) 
+    {
+        auto signature = function->signature;
+        if (signature->return_type_index != -1) {
+            memory_copy(stack_frame + function->bytecode_parameter_offsets[signature->return_type_index], 
+                memo_value->result_bytes.data, memo_value->result_bytes.size);
+        }
+        compilation_data->comptime_memo_hits += 1;
+        compilation_data->comptime_memo_instructions_saved += memo_value->instruction_count;
+        thread->instruction_index += 1;
+        return true;
+    }
+
+    // Only misses need the key until the call returns
+    compilation_data->comptime_memo_misses += 1;
+    if (memo_call.key.argument_bytes.data == key_buffer) {
+        Array<byte> argument_bytes = thread->arena->allocate_array<byte>(memo_call.key.argument_bytes.size);
+        if (argument_bytes.size > 0) {
+            memory_copy(argument_bytes.data, key_buffer, argument_bytes.size);
+        }
+        memo_call.key.argument_bytes = argument_bytes;
+    }
+    memo_call.stack_frame = stack_frame;
+    memo_call.instruction_count_at_call = thread->executed_instruction_count;
+    thread->memo_calls.push_back(memo_call);
+    return false;
+}
+
 // Returns true if we need to stop execution, e.g. on exit instruction
 void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
 {
@@ -67,7 +308,7 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
     switch (i->instruction_type)
     {
     case Instruction_Type::MOVE_STACK_DATA:
-        interpreter_safe_memcopy(thread, thread->stack_pointer + i->op1, thread->stack_pointer + i->op2, i->op3);
+        interpreter_stack_memcopy(thread, thread->stack_pointer + i->op1, thread->stack_pointer + i->op2, i->op3, true, true);
         break;
     case Instruction_Type::READ_GLOBAL: 
     {
@@ -81,7 +322,7 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Cannot read extern global");
             return;
         }
-        interpreter_safe_memcopy(thread, thread->stack_pointer + i->op1, globals[i->op2]->memory, i->op3);
+        interpreter_stack_memcopy(thread, thread->stack_pointer + i->op1, (byte*)globals[i->op2]->memory, i->op3, true, false);
         break;
     }
     case Instruction_Type::WRITE_GLOBAL: {
@@ -90,7 +331,7 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Cannot write to extern global");
             return;
         }
-        interpreter_safe_memcopy(thread, globals[i->op1]->memory, thread->stack_pointer + i->op2, i->op3);
+        interpreter_stack_memcopy(thread, (byte*)globals[i->op1]->memory, thread->stack_pointer + i->op2, i->op3, false, true);
         break;
     }
     case Instruction_Type::WRITE_MEMORY:
@@ -105,7 +346,7 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
         interpreter_safe_memcopy(thread, *(void**)(thread->stack_pointer + i->op1), *(void**)(thread->stack_pointer + i->op2), i->op3);
         break;
     case Instruction_Type::READ_CONSTANT:
-        interpreter_safe_memcopy(thread, thread->stack_pointer + i->op1, constant_pool->constants[i->op2].memory, i->op3);
+        interpreter_stack_memcopy(thread, thread->stack_pointer + i->op1, (byte*)constant_pool->constants[i->op2].memory, i->op3, true, false);
         break;
     case Instruction_Type::U64_ADD_CONSTANT_I32:
         *(u64*)(thread->stack_pointer + i->op1) = *(u64*)(thread->stack_pointer + i->op2) + (i->op3);
@@ -142,6 +383,24 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
         }
         break;
     }
+    case Instruction_Type::JUMP_ON_INT_LESS: {
+        int value = *(int*)(thread->stack_pointer + i->op2);
+        if (value < i->op3) {
+            thread->instruction_index = i->op1;
+            return;
+        }
+        break;
+    }
+    case Instruction_Type::JUMP_TABLE: {
+        i64 table_index = (i64)*(int*)(thread->stack_pointer + i->op1) - (i64)i->op2;
+        if (table_index >= 0 && table_index < i->op3) {
+            thread->instruction_index = instructions[thread->instruction_index + 1 + (int)table_index].op1;
+        }
+        else {
+            thread->instruction_index = i->op4;
+        }
+        return;
+    }
     case Instruction_Type::CALL_FUNCTION_POINTER: 
     case Instruction_Type::CALL_FUNCTION: 
     {
@@ -188,6 +447,10 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             return;
         }
 
+        if (thread->memoize_pure_calls && bytecode_thread_call_memoized(thread, function, thread->stack_pointer + i->op2)) {
+            return;
+        }
+
         byte* base_pointer = thread->stack_pointer;
         thread->stack_pointer = thread->stack_pointer + i->op2; 
         *((int*)thread->stack_pointer) = thread->instruction_index + 1; // Push return address
@@ -196,6 +459,26 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
 
         return;
     }
+    case Instruction_Type::CALL_RESOLVED:
+    {
+        // Call target was validated during linking, so only the stack needs to be checked
+        int remaining_stack_size = &thread->stack[thread->stack.size - 1] - thread->stack_pointer;
+        if (remaining_stack_size <= i->op4) {
+            thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Stack overflow on normal function call");
+            return;
+        }
+
+        if (thread->memoize_pure_calls && bytecode_thread_call_memoized(thread, compilation_data->functions[i->op3], thread->stack_pointer + i->op2)) {
+            return;
+        }
+
+        byte* base_pointer = thread->stack_pointer;
+        thread->stack_pointer = thread->stack_pointer + i->op2; 
+        *((int*)thread->stack_pointer) = thread->instruction_index + 1; // Push return address
+        *(byte**)(thread->stack_pointer + 8) = base_pointer; // Push current stack_pointer
+        thread->instruction_index = i->op1; // Jump to function
+        return;
+    }
     case Instruction_Type::RETURN: 
     {
         // Check if we finished execution
@@ -204,6 +487,38 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             return;
         }
 
+        // Store result of memoized call
+        if (thread->memo_calls.size > 0 && thread->memo_calls.last().stack_frame == thread->stack_pointer)
+        {
+            Memo_Call memo_call = thread->memo_calls.last();
+            thread->memo_calls.rollback_to_size(thread->memo_calls.size - 1);
+
+            Upp_Function* function = memo_call.key.function;
+            auto signature = function->signature;
+            Arena* memo_arena = &compilation_data->arena;
+            Comptime_Memo_Value value;
+            value.instruction_count = thread->executed_instruction_count - memo_call.instruction_count_at_call;
+            value.result_bytes.data = nullptr;
+            value.result_bytes.size = 0;
+            value.result_type = nullptr;
+            if (signature->return_type_index != -1) {
+                value.result_type = signature->parameters[signature->return_type_index].datatype;
+                int size = signature->parameters[signature->return_type_index].datatype->memory_info.value.size;
+                value.result_bytes = memo_arena->allocate_array<byte>(size);
+                memory_copy(value.result_bytes.data, thread->stack_pointer + function->bytecode_parameter_offsets[signature->return_type_index], size);
+            }
+
+            DynTable_Query_Result query = compilation_data->comptime_memo.query(memo_call.key);
+            if (!query.value_is_in_table) {
+                Array<byte> argument_bytes = memo_arena->allocate_array<byte>(memo_call.key.argument_bytes.size);
+                if (argument_bytes.size > 0) {
+                    memory_copy(argument_bytes.data, memo_call.key.argument_bytes.data, argument_bytes.size);
+                }
+                memo_call.key.argument_bytes = argument_bytes;
+                compilation_data->comptime_memo.insert_with_query(query, memo_call.key, value);
+            }
+        }
+
         // Restore stack and instruction pointer
         int return_address = *(int*)thread->stack_pointer;
         byte* stack_old_base = *(byte**)(thread->stack_pointer + 8);
@@ -228,17 +543,10 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             // System-alloc (u64 size) => address
             byte* argument_start = return_buffer + 8;
             upp_size size = *(upp_size*)argument_start;
-            if (size <= 0) {
-                thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Called malloc with size <= 0");
+            void* alloc_data = bytecode_heap_allocate(thread, size);
+            if (alloc_data == nullptr) {
                 return;
             }
-            if (thread->heap_memory_consumption + size > thread->max_heap_consumption) {
-                thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Reached maximum heap allocations");
-                return;
-            }
-
-            void* alloc_data = thread->arena->allocate_raw(size, 16);
-            thread->heap_memory_consumption += size;
 
             // logg("Allocated memory size: %5d, pointer: %p\n", size, alloc_data);
             memory_copy(return_buffer, &alloc_data, sizeof(void*));
@@ -250,12 +558,8 @@ void bytecode_thread_execute_current_instruction(Bytecode_Thread* thread)
             byte* argument_start = return_buffer;
             void* free_data = *(void**)argument_start;
 
-            if (free_data == nullptr) {
-                thread->exit_code = exit_code_make(Exit_Code_Type::EXECUTION_ERROR, "Free called on nullptr");
-                return;
-            }
-
             // logg("Interpreter Free pointer: %p\n", free_data);
+            bytecode_heap_free(thread, free_data);
             break;
         }
         case IR_Builtin_Function::MEMORY_COPY: 
@@ -486,26 +790,390 @@ void bytecode_thread_set_initial_state(Bytecode_Thread* thread, Upp_Function* en
     thread->heap_memory_consumption = 0;
 }
 
+
+
+// Profiling
+#define PROFILE_SAMPLE_INTERVAL 1009 // Prime, so samples don't align with loop lengths
+#define PROFILE_MAX_STACK_DEPTH 256
+
+Bytecode_Profile* bytecode_profile_create()
+{
+    Bytecode_Profile* profile = new Bytecode_Profile;
+    profile->instruction_counts = dynamic_array_create<i64>();
+    profile->instruction_to_function = dynamic_array_create<int>();
+    profile->folded_stacks = hashtable_create_empty<String, Profile_Stack_Entry>(64, hash_string, string_equals);
+    profile->statement_times = hashtable_create_pointer_empty<AST::Statement*, double>(64);
+    profile->stack_buffer = dynamic_array_create<int>();
+    profile->stack_string = string_create(256);
+    profile->last_sample_time = 0.0;
+    profile->instructions_until_sample = PROFILE_SAMPLE_INTERVAL;
+    return profile;
+}
+
+void bytecode_profile_destroy(Bytecode_Profile* profile)
+{
+    dynamic_array_destroy(&profile->instruction_counts);
+    dynamic_array_destroy(&profile->instruction_to_function);
+    auto iter = hashtable_iterator_create(&profile->folded_stacks);
+    while (hashtable_iterator_has_next(&iter)) {
+        string_destroy(iter.key);
+        hashtable_iterator_next(&iter);
+    }
+    hashtable_destroy(&profile->folded_stacks);
+    hashtable_destroy(&profile->statement_times);
+    dynamic_array_destroy(&profile->stack_buffer);
+    string_destroy(&profile->stack_string);
+    delete profile;
+}
+
+// Bytecode grows during analysis (bakes), so per-instruction data is extended lazily
+static void bytecode_profile_update_instruction_data(Bytecode_Profile* profile, Compilation_Data* compilation_data)
+{
+    int old_size = profile->instruction_to_function.size;
+    int new_size = compilation_data->bytecode.size;
+    if (new_size <= old_size) return;
+
+    dynamic_array_reserve(&profile->instruction_counts, new_size);
+    dynamic_array_reserve(&profile->instruction_to_function, new_size);
+    for (int i = old_size; i < new_size; i++) {
+        dynamic_array_push_back(&profile->instruction_counts, (i64)0);
+        dynamic_array_push_back(&profile->instruction_to_function, -1);
+    }
+    for (int i = 0; i < compilation_data->functions.size; i++)
+    {
+        Upp_Function* function = compilation_data->functions[i];
+        if (function->bytecode_start_instruction == -1) continue;
+        int start = math_maximum(old_size, function->bytecode_start_instruction);
+        for (int j = start; j < function->bytecode_end_instruction && j < new_size; j++) {
+            profile->instruction_to_function[j] = function->function_index;
+        }
+    }
+}
+
+// Attributes time since the last sample to the current call-stack (Recovered from the frame chain) and statement
+static void bytecode_thread_profile_sample(Bytecode_Thread* thread)
+{
+    Bytecode_Profile* profile = thread->profile;
+    Compilation_Data* compilation_data = thread->compilation_data;
+    double now = timer_current_time_in_seconds();
+    double time = now - profile->last_sample_time;
+    profile->last_sample_time = now;
+    profile->instructions_until_sample = PROFILE_SAMPLE_INTERVAL;
+
+    // Bytecode may have grown since the last instruction, e.g. by bakes of a running analysis
+    bytecode_profile_update_instruction_data(profile, compilation_data);
+
+    // Walk frame chain, each frame starts with [Return_Instruction][Old_Stack_Pointer]
+    auto& stack = profile->stack_buffer;
+    dynamic_array_reset(&stack);
+    dynamic_array_push_back(&stack, profile->instruction_to_function[thread->instruction_index]);
+    byte* frame = thread->stack_pointer;
+    while (frame != &thread->stack[0] && stack.size < PROFILE_MAX_STACK_DEPTH)
+    {
+        if (frame < &thread->stack[0] || frame >= &thread->stack[0] + thread->stack.size) break;
+        int return_instruction = *(int*)frame;
+        frame = *(byte**)(frame + 8);
+        int call_instruction = return_instruction - 1;
+        bool call_valid = call_instruction >= 0 && call_instruction < profile->instruction_to_function.size;
+        dynamic_array_push_back(&stack, call_valid ? profile->instruction_to_function[call_instruction] : -1);
+    }
+
+    // Stacks are keyed by function index, so overloads and instances with the same name stay seperate
+    String& stack_string = profile->stack_string;
+    string_reset(&stack_string);
+    for (int i = stack.size - 1; i >= 0; i--) {
+        string_append_i64(&stack_string, stack[i]);
+        if (i != 0) {
+            string_append_character(&stack_string, ';');
+        }
+    }
+
+    Profile_Stack_Entry* entry = hashtable_find_element(&profile->folded_stacks, stack_string);
+    if (entry == nullptr) {
+        Profile_Stack_Entry new_entry;
+        new_entry.time = 0.0;
+        new_entry.sample_count = 0;
+        hashtable_insert_element(&profile->folded_stacks, string_copy(stack_string), new_entry);
+        entry = hashtable_find_element(&profile->folded_stacks, stack_string);
+    }
+    entry->time += time;
+    entry->sample_count += 1;
+
+    AST::Statement* statement = compilation_data->bytecode_statements[thread->instruction_index];
+    if (statement != nullptr) {
+        double* statement_time = hashtable_find_element(&profile->statement_times, statement);
+        if (statement_time == nullptr) {
+            hashtable_insert_element(&profile->statement_times, statement, time);
+        }
+        else {
+            *statement_time += time;
+        }
+    }
+}
+
+static void bytecode_thread_profile_instruction(Bytecode_Thread* thread)
+{
+    Bytecode_Profile* profile = thread->profile;
+    if (thread->instruction_index >= profile->instruction_counts.size) {
+        bytecode_profile_update_instruction_data(profile, thread->compilation_data);
+    }
+    profile->instruction_counts.data[thread->instruction_index] += 1;
+    profile->instructions_until_sample -= 1;
+    if (profile->instructions_until_sample <= 0) {
+        bytecode_thread_profile_sample(thread);
+    }
+}
+
+// Labels are "name(signature)", frames which don't belong to a known function are "[unknown]"
+static void bytecode_profile_append_function_label(String* string, Compilation_Data* compilation_data, int function_index)
+{
+    if (function_index < 0 || function_index >= compilation_data->functions.size) {
+        string_append(string, "[unknown]");
+        return;
+    }
+
+    Upp_Function* function = compilation_data->functions[function_index];
+    String label = string_create();
+    SCOPE_EXIT(string_destroy(&label));
+    string_append(&label, function->name->characters);
+    if (function->signature != nullptr) {
+        call_signature_append_to_string(function->signature, &label, compilation_data->type_system, datatype_format_make_default());
+    }
+
+    // Style codes and folded-stack seperators are removed from labels
+    string_style_remove_codes(&label);
+    for (int i = 0; i < label.size; i++) {
+        char c = label.characters[i];
+        string_append_character(string, c == ';' ? ',' : c);
+    }
+}
+
+void bytecode_profile_append_folded_stacks(Bytecode_Profile* profile, Compilation_Data* compilation_data, String* string)
+{
+    auto iter = hashtable_iterator_create(&profile->folded_stacks);
+    while (hashtable_iterator_has_next(&iter)) 
+    {
+        // Keys are function indices seperated by ';', e.g. "0;12;-1"
+        String* key = iter.key;
+        int function_index = 0;
+        bool is_negative = false;
+        for (int i = 0; i <= key->size; i++)
+        {
+            char c = i < key->size ? key->characters[i] : ';';
+            if (c == '-') {
+                is_negative = true;
+            }
+            else if (c == ';') {
+                bytecode_profile_append_function_label(string, compilation_data, is_negative ? -function_index : function_index);
+                if (i != key->size) {
+                    string_append_character(string, ';');
+                }
+                function_index = 0;
+                is_negative = false;
+            }
+            else {
+                function_index = function_index * 10 + (c - '0');
+            }
+        }
+
+        i64 microseconds = math_maximum((i64)1, (i64)(iter.value->time * 1000000.0));
+        string_append_formated(string, " %lld\n", microseconds);
+        hashtable_iterator_next(&iter);
+    }
+}
+
+struct Profile_Function
+{
+    int function_index;
+    i64 instruction_count;
+};
+
+struct Profile_Line
+{
+    AST::Statement* statement;
+    i64 instruction_count;
+    double time;
+};
+
+void bytecode_profile_append_hot_lines(Bytecode_Profile* profile, Compilation_Data* compilation_data, String* string)
+{
+    // Per function
+    Dynamic_Array<Profile_Function> functions = dynamic_array_create<Profile_Function>();
+    SCOPE_EXIT(dynamic_array_destroy(&functions));
+    for (int i = 0; i < compilation_data->functions.size; i++) {
+        Profile_Function function;
+        function.function_index = i;
+        function.instruction_count = 0;
+        dynamic_array_push_back(&functions, function);
+    }
+    // Per statement
+    Hashtable<AST::Statement*, int> statement_to_line = hashtable_create_pointer_empty<AST::Statement*, int>(64);
+    SCOPE_EXIT(hashtable_destroy(&statement_to_line));
+    Dynamic_Array<Profile_Line> lines = dynamic_array_create<Profile_Line>();
+    SCOPE_EXIT(dynamic_array_destroy(&lines));
+
+    for (int i = 0; i < profile->instruction_counts.size; i++)
+    {
+        i64 count = profile->instruction_counts[i];
+        if (count == 0) continue;
+        int function_index = profile->instruction_to_function[i];
+        if (function_index != -1) {
+            functions[function_index].instruction_count += count;
+        }
+
+        AST::Statement* statement = compilation_data->bytecode_statements[i];
+        if (statement == nullptr) continue;
+        int* line_index = hashtable_find_element(&statement_to_line, statement);
+        if (line_index == nullptr) {
+            Profile_Line line;
+            line.statement = statement;
+            line.instruction_count = 0;
+            double* time = hashtable_find_element(&profile->statement_times, statement);
+            line.time = time == nullptr ? 0.0 : *time;
+            dynamic_array_push_back(&lines, line);
+            hashtable_insert_element(&statement_to_line, statement, lines.size - 1);
+            line_index = hashtable_find_element(&statement_to_line, statement);
+        }
+        lines[*line_index].instruction_count += count;
+    }
+
+    dynamic_array_sort(&functions, [](const Profile_Function& a, const Profile_Function& b) -> bool { return a.instruction_count > b.instruction_count; });
+    dynamic_array_sort(&lines, [](const Profile_Line& a, const Profile_Line& b) -> bool { return a.instruction_count > b.instruction_count; });
+
+    string_append_formated(string, "# Functions: instructions function\n");
+    for (int i = 0; i < functions.size; i++) {
+        Profile_Function& function = functions[i];
+        if (function.instruction_count == 0) break;
+        string_append_formated(string, "%12lld ", function.instruction_count);
+        bytecode_profile_append_function_label(string, compilation_data, function.function_index);
+        string_append_character(string, '\n');
+    }
+
+    // Lines are 1-based, so they can be used as file:line links
+    string_append_formated(string, "\n# Lines: instructions sampled_ms file:line\n");
+    for (int i = 0; i < lines.size; i++) {
+        Profile_Line& line = lines[i];
+        Compilation_Unit* unit = ast_node_to_compilation_unit(compilation_data, &line.statement->base);
+        int line_index = AST::node_range_table_get(&unit->root->range_table, line.statement->base.index).range.start.line;
+        string_append_formated(string, "%12lld %10.3f %s:%d\n", line.instruction_count, line.time * 1000.0, unit->filepath.characters, line_index + 1);
+    }
+}
+
+void bytecode_profile_get_line_counts(Bytecode_Profile* profile, Compilation_Data* compilation_data, Compilation_Unit* unit, Dynamic_Array<i64>* line_counts)
+{
+    dynamic_array_reset(line_counts);
+    AST::Statement* last_statement = nullptr;
+    int last_line = -1;
+    for (int i = 0; i < profile->instruction_counts.size; i++)
+    {
+        i64 count = profile->instruction_counts[i];
+        if (count == 0) continue;
+        AST::Statement* statement = compilation_data->bytecode_statements[i];
+        if (statement == nullptr) continue;
+
+        // Instructions of a statement are mostly consecutive, so the line lookup is cached
+        if (statement != last_statement) {
+            last_statement = statement;
+            last_line = -1;
+            if (ast_node_to_compilation_unit(compilation_data, &statement->base) == unit) {
+                last_line = AST::node_range_table_get(&unit->root->range_table, statement->base.index).range.start.line;
+            }
+        }
+        if (last_line == -1) continue;
+
+        while (line_counts->size <= last_line) {
+            dynamic_array_push_back(line_counts, (i64)0);
+        }
+        line_counts->data[last_line] += count;
+    }
+}
+
+bool bytecode_profile_write_files(Bytecode_Profile* profile, Compilation_Data* compilation_data, const char* filepath_prefix)
+{
+    String filepath = string_create();
+    SCOPE_EXIT(string_destroy(&filepath));
+    String content = string_create(4096);
+    SCOPE_EXIT(string_destroy(&content));
+
+    bytecode_profile_append_folded_stacks(profile, compilation_data, &content);
+    filepath.append_formated("%s.folded", filepath_prefix);
+    bool success = file_io_write_file(filepath.characters, array_create_static_as_bytes(content.characters, content.size));
+
+    string_reset(&filepath);
+    string_reset(&content);
+    bytecode_profile_append_hot_lines(profile, compilation_data, &content);
+    filepath.append_formated("%s_lines.txt", filepath_prefix);
+    success = file_io_write_file(filepath.characters, array_create_static_as_bytes(content.characters, content.size)) && success;
+    return success;
+}
+
+static void bytecode_thread_run(Bytecode_Thread* thread)
+{
+    while (true) 
+    {
+        //bytecode_thread_print_state(thread);
+        if (thread->profile != nullptr) {
+            bytecode_thread_profile_instruction(thread);
+        }
+        bytecode_thread_execute_current_instruction(thread);
+        if (thread->exit_code.type != Exit_Code_Type::RUNNING) {
+            break;
+        }
+        if (thread->max_instruction_executions > 0 && thread->executed_instruction_count >= thread->max_instruction_executions) {
+            thread->exit_code = exit_code_make(Exit_Code_Type::INSTRUCTION_LIMIT_REACHED);
+            break;
+        }
+        if ((thread->executed_instruction_count & 0xFFFF) == 0 && compilation_data_check_cancelled(thread->compilation_data)) {
+            thread->exit_code = exit_code_make(Exit_Code_Type::CANCELLED);
+            break;
+        }
+    }
+}
+
+#ifndef _WIN32
+// Replacement for structured exception handling, faults while executing bytecode jump back to bytecode_thread_execute
+static thread_local sigjmp_buf* bytecode_fault_jump_target = nullptr;
+
+static void bytecode_fault_handler(int signal_number)
+{
+    if (bytecode_fault_jump_target == nullptr) {
+        ::signal(signal_number, SIG_DFL);
+        raise(signal_number);
+        return;
+    }
+    siglongjmp(*bytecode_fault_jump_target, 1);
+}
+
+static void bytecode_install_fault_handlers()
+{
+    static bool installed = false;
+    if (installed) return;
+    installed = true;
+    struct sigaction action;
+    memory_set_bytes(&action, sizeof(action), 0);
+    action.sa_handler = bytecode_fault_handler;
+    action.sa_flags = SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, nullptr);
+    sigaction(SIGBUS, &action, nullptr);
+    sigaction(SIGFPE, &action, nullptr);
+    sigaction(SIGILL, &action, nullptr);
+}
+#endif
+
 Exit_Code bytecode_thread_execute(Bytecode_Thread* thread)
 {
     Timing_Task before_task = thread->compilation_data->task_current;
     compilation_data_switch_timing_task(thread->compilation_data, Timing_Task::CODE_EXEC);
 
     thread->exit_code = exit_code_make(Exit_Code_Type::RUNNING);
+    if (thread->profile != nullptr) {
+        thread->profile->last_sample_time = timer_current_time_in_seconds();
+    }
+#ifdef _WIN32
     __try
     {
-        while (true) 
-        {
-            //bytecode_thread_print_state(thread);
-            bytecode_thread_execute_current_instruction(thread);
-            if (thread->exit_code.type != Exit_Code_Type::RUNNING) {
-                break;
-            }
-            if (thread->max_instruction_executions > 0 && thread->executed_instruction_count >= thread->max_instruction_executions) {
-                thread->exit_code = exit_code_make(Exit_Code_Type::INSTRUCTION_LIMIT_REACHED);
-                break;
-            }
-        }
+        bytecode_thread_run(thread);
     }
     __except (GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION ||
         GetExceptionCode() == EXCEPTION_ARRAY_BOUNDS_EXCEEDED ||
@@ -519,6 +1187,24 @@ Exit_Code bytecode_thread_execute(Bytecode_Thread* thread)
     {
         thread->exit_code = exit_code_make(Exit_Code_Type::CODE_ERROR, "Internal exception occured (Division by 0, invalid memory access, ...)");
     }
+#else
+    bytecode_install_fault_handlers();
+    sigjmp_buf jump_target;
+    sigjmp_buf* previous_target = bytecode_fault_jump_target;
+    if (sigsetjmp(jump_target, 1) == 0) {
+        bytecode_fault_jump_target = &jump_target;
+        bytecode_thread_run(thread);
+    }
+    else {
+        thread->exit_code = exit_code_make(Exit_Code_Type::CODE_ERROR, "Internal exception occured (Division by 0, invalid memory access, ...)");
+    }
+    bytecode_fault_jump_target = previous_target;
+#endif
+
+    // Attribute remaining time since last sample
+    if (thread->profile != nullptr && thread->instruction_index < thread->profile->instruction_to_function.size) {
+        bytecode_thread_profile_sample(thread);
+    }
 
     compilation_data_switch_timing_task(thread->compilation_data, before_task);
     return thread->exit_code;
@@ -528,6 +1214,10 @@ void* bytecode_thread_get_return_value_ptr(Bytecode_Thread* thread) {
     return &thread->stack[16]; // Return value starts at offset 16 in stack frame
 }
 
+int bytecode_thread_get_executed_instruction_count(Bytecode_Thread* thread) {
+    return thread->executed_instruction_count;
+}
+
 
 
 // IR-Operation execute
@@ -1039,8 +1729,8 @@ bool bytecode_execute_ir_operation(
     {
         switch (src_type)
         {
-        case Bytecode_Type::FLOAT32: *(bool*)dst = isnan(*(f32*)src1); break;
-        case Bytecode_Type::FLOAT64: *(bool*)dst = isnan(*(f64*)src1); break;
+        case Bytecode_Type::FLOAT32: *(bool*)dst = std::isnan(*(f32*)src1); break;
+        case Bytecode_Type::FLOAT64: *(bool*)dst = std::isnan(*(f64*)src1); break;
         default: panic("");
         }
         break;
@@ -1049,8 +1739,8 @@ bool bytecode_execute_ir_operation(
     {
         switch (src_type)
         {
-        case Bytecode_Type::FLOAT32: *(bool*)dst = isfinite(*(f32*)src1); break;
-        case Bytecode_Type::FLOAT64: *(bool*)dst = isfinite(*(f64*)src1); break;
+        case Bytecode_Type::FLOAT32: *(bool*)dst = std::isfinite(*(f32*)src1); break;
+        case Bytecode_Type::FLOAT64: *(bool*)dst = std::isfinite(*(f64*)src1); break;
         default: panic("");
         }
         break;
@@ -1059,8 +1749,8 @@ bool bytecode_execute_ir_operation(
     {
         switch (src_type)
         {
-        case Bytecode_Type::FLOAT32: *(bool*)dst = isinf(*(f32*)src1); break;
-        case Bytecode_Type::FLOAT64: *(bool*)dst = isinf(*(f64*)src1); break;
+        case Bytecode_Type::FLOAT32: *(bool*)dst = std::isinf(*(f32*)src1); break;
+        case Bytecode_Type::FLOAT64: *(bool*)dst = std::isinf(*(f64*)src1); break;
         default: panic("");
         }
         break;
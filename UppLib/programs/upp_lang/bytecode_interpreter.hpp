@@ -10,6 +10,9 @@ struct Bytecode_Instruction;
 struct Compilation_Data;
 struct Bytecode_Thread;
 struct Upp_Function;
+namespace AST {
+    struct Statement;
+}
 
 Bytecode_Thread* bytecode_thread_create(
 	Compilation_Data* compilation_data, Arena* arena, int max_instruction_executions, int max_heap_consumption, int stack_size, bool allow_global_access
@@ -17,7 +20,35 @@ Bytecode_Thread* bytecode_thread_create(
 void bytecode_thread_set_initial_state(Bytecode_Thread* thread, Upp_Function* entry_function);
 Exit_Code bytecode_thread_execute(Bytecode_Thread* thread);
 void* bytecode_thread_get_return_value_ptr(Bytecode_Thread* thread);
+int bytecode_thread_get_executed_instruction_count(Bytecode_Thread* thread);
 void bytecode_thread_print_state(Bytecode_Thread* thread);
+// Profiling (enable_bytecode_profiling), executed instructions are counted per bytecode instruction,
+// and every PROFILE_SAMPLE_INTERVAL instructions the call-stack is sampled for wall time attribution
+struct Profile_Stack_Entry
+{
+    double time;
+    int sample_count;
+};
+
+struct Bytecode_Profile
+{
+    Dynamic_Array<i64> instruction_counts;      // Per bytecode instruction
+    Dynamic_Array<int> instruction_to_function; // Function index per bytecode instruction, -1 if not part of a function
+    Hashtable<String, Profile_Stack_Entry> folded_stacks; // Key is call stack of function indices, e.g. "0;12;7", -1 for unknown frames
+    Hashtable<AST::Statement*, double> statement_times;
+    Dynamic_Array<int> stack_buffer;
+    String stack_string;
+    double last_sample_time;
+    int instructions_until_sample;
+};
+
+Bytecode_Profile* bytecode_profile_create();
+void bytecode_profile_destroy(Bytecode_Profile* profile);
+void bytecode_profile_append_folded_stacks(Bytecode_Profile* profile, Compilation_Data* compilation_data, String* string); // Flamegraph input, values in microseconds
+void bytecode_profile_append_hot_lines(Bytecode_Profile* profile, Compilation_Data* compilation_data, String* string);
+void bytecode_profile_get_line_counts(Bytecode_Profile* profile, Compilation_Data* compilation_data, Compilation_Unit* unit, Dynamic_Array<i64>* line_counts); // Indexed by 0-based line, used for editor overlay
+bool bytecode_profile_write_files(Bytecode_Profile* profile, Compilation_Data* compilation_data, const char* filepath_prefix);
+
 // Returns if successfull (Only not sucessfull if integer divide by 0)
 bool bytecode_execute_ir_operation(
 	Primitive_Operation operation, void* dst, void* src1, void* src2, Bytecode_Type dst_type, Bytecode_Type left_type, Bytecode_Type right_type
@@ -3,14 +3,18 @@
 #include "compilation_data.hpp"
 #include "../../utility/file_io.hpp"
 #include <cstdlib>
+#ifdef _WIN32
 #include <Windows.h>
-#include "../../win32/windows_helper_functions.hpp"
+#endif
 #include "../../utility/hash_functions.hpp"
 #include "semantic_analyser.hpp"
 #include "../../win32/process.hpp"
 #include "ir_code.hpp"
 #include "symbol_table.hpp"
 #include "constant_pool.hpp"
+#include "ast.hpp"
+#include "../../win32/thread.hpp"
+#include "../../utility/directory_crawler.hpp"
 
 // --------------
 // - C_COMPILER -
@@ -22,16 +26,21 @@ const bool ADD_WAIT_BEFORE_EXIT = false;
 void c_generator_output_global_access(C_Generator* generator, int global_index);
 void c_generator_output_parameter_access(C_Generator* generator, Upp_Function* function, int parameter_index);
 
+struct C_Function_Cache;
 struct C_Compiler
 {
     bool initialized;
     bool last_compile_successfull;
+    u64 last_compile_hash; // Hash of command, generated code and extern sources, cl isn't invoked if nothing changed
+    C_Function_Cache* function_cache; // Generated code of previous compiles, created on first use, freed in c_compiler_shutdown
 };
 
 C_Compiler initial_c_compiler_data() {
     C_Compiler result;
     result.initialized = false;
     result.last_compile_successfull = false;
+    result.last_compile_hash = 0;
+    result.function_cache = nullptr;
     return result;
 }
 
@@ -40,8 +49,13 @@ static C_Compiler c_compiler = initial_c_compiler_data();
 void c_compiler_initialize()
 {
     C_Compiler& result = c_compiler;
-    result.initialized = true;
     result.last_compile_successfull = false;
+#ifndef _WIN32
+    // The generated code is compiled with cl, c_compiler_compile reports that the compiler isn't available
+    result.initialized = false;
+    return;
+#endif
+    result.initialized = true;
 
     // Load system vars (Required to use cl.exe and link.exe)
     // These are generated once with the batch script in some misc folder, and then loaded from that file.
@@ -80,7 +94,11 @@ void c_compiler_initialize()
             if (c == '\r') continue;
             if (c == '\n') {
                 //printf("Var base_name: %s = %s\n", env_var.characters, var_value.characters);
+#ifdef _WIN32
                 SetEnvironmentVariableA(env_var.characters, var_value.characters);
+#else
+                setenv(env_var.characters, var_value.characters, 1);
+#endif
                 string_reset(&env_var);
                 string_reset(&var_value);
                 parsing_name = true;
@@ -92,6 +110,50 @@ void c_compiler_initialize()
     }
 }
 
+static u64 c_compiler_hash_file(u64 hash, const char* filepath)
+{
+    Optional<Array<byte>> content = file_io_load_binary_file(filepath);
+    SCOPE_EXIT(file_io_unload_binary_file(&content));
+    if (content.available) {
+        hash = hash_combine(hash, hash_memory(content.value));
+    }
+    return hash;
+}
+
+// Hashes all files below the directory, either by content or by size and last write time
+static u64 c_compiler_hash_directory(u64 hash, const char* path, bool hash_content)
+{
+    Directory_Crawler* crawler = directory_crawler_create();
+    SCOPE_EXIT(directory_crawler_destroy(crawler));
+    directory_crawler_set_path(crawler, string_create_static(path));
+    Array<File_Info> files = directory_crawler_get_content(crawler);
+
+    String filepath = string_create();
+    SCOPE_EXIT(string_destroy(&filepath));
+    for (int i = 0; i < files.size; i++)
+    {
+        File_Info& file = files[i];
+        if (string_equals_cstring(&file.name, ".") || string_equals_cstring(&file.name, "..")) continue;
+        string_reset(&filepath);
+        string_append_formated(&filepath, "%s/%s", path, file.name.characters);
+        hash = hash_combine(hash, hash_string(&filepath));
+        if (file.is_directory) {
+            hash = c_compiler_hash_directory(hash, filepath.characters, hash_content);
+        }
+        else if (hash_content) {
+            hash = c_compiler_hash_file(hash, filepath.characters);
+        }
+        else {
+            Optional<u64> write_time = file_io_get_last_write_access_time(filepath.characters);
+            hash = hash_combine(hash, hash_i64(&file.size));
+            if (write_time.available) {
+                hash = hash_combine(hash, hash_u64(&write_time.value));
+            }
+        }
+    }
+    return hash;
+}
+
 void c_compiler_compile(Compilation_Data* compilation_data)
 {
     auto& comp = c_compiler;
@@ -117,51 +179,116 @@ void c_compiler_compile(Compilation_Data* compilation_data)
         */
         // Note: MDd should be replaced between debug and optimized build
         const char* compiler_options = "/MDd /EHsc /Zi /std:c++latest /Fobackend/build/ /Fdbackend/build/main.pdb /Febackend/build/main.exe";
-        string_append_formated(&command, "\"cl\" "); // Not sure why we need those Quotations, maybe for CreateProcess?
-        string_append_formated(&command, compiler_options);
+        string_append(&command, "\"cl\" "); // Not sure why we need those Quotations, maybe for CreateProcess?
+        string_append(&command, compiler_options);
 
         auto& extern_sources = compilation_data->extern_sources;
         // Defines
         Dynamic_Array<String*> defines = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::DEFINITION];
         for (int i = 0; i < defines.size; i++) {
-            string_append_formated(&command, " /D \"%s\"", defines[i]->characters);
+            string_append(&command, " /D \"");
+            string_append(&command, defines[i]->characters);
+            string_append(&command, "\"");
         }
 
         // Include directories
         Dynamic_Array<String*> includes = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::INCLUDE_DIRECTORY];
         for (int i = 0; i < includes.size; i++) {
-            string_append_formated(&command, " /I \"%s\"", includes[i]->characters);
+            string_append(&command, " /I \"");
+            string_append(&command, includes[i]->characters);
+            string_append(&command, "\"");
         }
 
         // Forced includes (Header files)
         Dynamic_Array<String*> header_files = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::HEADER_FILE];
         for (int i = 0; i < header_files.size; i++) {
-            string_append_formated(&command, " /FI \"%s\"", header_files[i]->characters);
+            string_append(&command, " /FI \"");
+            string_append(&command, header_files[i]->characters);
+            string_append(&command, "\"");
         }
 
         // Source files
         string_append(&command, " backend/src/main.cpp backend/hardcoded/hardcoded_functions.cpp");
         Dynamic_Array<String*> source_files = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::SOURCE_FILE];
         for (int i = 0; i < source_files.size; i++) {
-            string_append_formated(&command, " \"%s\"", source_files[i]->characters);
+            string_append(&command, " \"");
+            string_append(&command, source_files[i]->characters);
+            string_append(&command, "\"");
         }
 
         // LINKER
-        string_append_formated(&command, " /link");
+        string_append(&command, " /link");
 
         // Library directories
         auto lib_dirs = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::LIBRARY_DIRECTORY];
         for (int i = 0; i < lib_dirs.size; i++) {
-            string_append_formated(&command, " /LIBPATH:\"%s\"", lib_dirs[i]->characters);
+            string_append(&command, " /LIBPATH:\"");
+            string_append(&command, lib_dirs[i]->characters);
+            string_append(&command, "\"");
         }
 
         // Libraries 
         Dynamic_Array<String*> lib_files = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::LIBRARY];
         for (int i = 0; i < lib_files.size; i++) {
-            string_append_formated(&command, " \"%s\"", lib_files[i]->characters);
+            string_append(&command, " \"");
+            string_append(&command, lib_files[i]->characters);
+            string_append(&command, "\"");
         }
     }
 
+    // Skip compilation if neither the generated code nor the extern sources changed
+    u64 compile_hash = hash_string(&command);
+    {
+        C_Program_Translation* translation = c_generator_get_translation(compilation_data->c_generator);
+        compile_hash = hash_combine(compile_hash, hash_string(&translation->source_code));
+
+        // Runtime sources which are compiled/included with every program
+        compile_hash = c_compiler_hash_directory(compile_hash, "backend/hardcoded", true);
+
+        auto& extern_sources = compilation_data->extern_sources;
+        Extern_Compiler_Setting hashed_settings[] = { Extern_Compiler_Setting::SOURCE_FILE, Extern_Compiler_Setting::HEADER_FILE };
+        for (int i = 0; i < 2; i++)
+        {
+            Dynamic_Array<String*> files = extern_sources.compiler_settings[(int)hashed_settings[i]];
+            for (int j = 0; j < files.size; j++) {
+                compile_hash = c_compiler_hash_file(compile_hash, files[j]->characters);
+            }
+        }
+
+        // Include directories may be large, so only size and write time of their files are hashed
+        Dynamic_Array<String*> includes = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::INCLUDE_DIRECTORY];
+        for (int i = 0; i < includes.size; i++) {
+            compile_hash = c_compiler_hash_directory(compile_hash, includes[i]->characters, false);
+        }
+
+        // Libraries are searched in the working directory and in all library directories, like the linker does
+        Dynamic_Array<String*> lib_dirs = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::LIBRARY_DIRECTORY];
+        Dynamic_Array<String*> lib_files = extern_sources.compiler_settings[(int)Extern_Compiler_Setting::LIBRARY];
+        String lib_path = string_create();
+        SCOPE_EXIT(string_destroy(&lib_path));
+        for (int i = 0; i < lib_files.size; i++)
+        {
+            for (int j = -1; j < lib_dirs.size; j++)
+            {
+                string_reset(&lib_path);
+                if (j != -1) {
+                    string_append_formated(&lib_path, "%s/", lib_dirs[j]->characters);
+                }
+                string_append(&lib_path, lib_files[i]->characters);
+                if (file_io_check_if_file_exists(lib_path.characters)) {
+                    compile_hash = c_compiler_hash_file(compile_hash, lib_path.characters);
+                    break;
+                }
+            }
+        }
+    }
+    if (comp.last_compile_hash == compile_hash && file_io_check_if_file_exists("backend/build/main.exe")) {
+        comp.last_compile_successfull = true;
+        logg("C-Code unchanged, skipping compilation\n");
+        return;
+    }
+    comp.last_compile_hash = 0;
+
     logg("Compile command:\n%s\n", command.characters);
     Optional<Process_Result> result = process_start(command);
     SCOPE_EXIT(process_result_destroy(&result));
@@ -173,7 +300,10 @@ void c_compiler_compile(Compilation_Data* compilation_data)
         comp.last_compile_successfull = false;
     }
 
-    if (!comp.last_compile_successfull) {
+    if (comp.last_compile_successfull) {
+        comp.last_compile_hash = compile_hash;
+    }
+    else {
         logg("\n!!! ERROR, C-COMPILE NOT SUCCESSFULL !!!\n\n");
         assert(false, "Should not happen");
     }
@@ -317,15 +447,37 @@ struct Translation_Char_Info
     int char_end;
 };
 
+// Signature + body of one function, generated independently so that functions can be generated in parallel
+struct C_Function_Output
+{
+    Upp_Function* function;
+    String text;
+    Dynamic_Array<Translation_Char_Info> char_infos; // Char indices are relative to text
+    Hashtable<C_Translation, String> register_names; // Moved into name_mapping when outputs are merged
+    bool missing_translation; // Worker required a translation which didn't exist yet, function is regenerated serially
+
+    // Incremental generation, see C_Function_Cache
+    Dynamic_Array<byte> key; // Canonical bytes of signature and IR, hash is only used for the table lookup
+    u64 hash;
+    bool hash_valid; // False if a referenced translation didn't exist after the pre-pass, then the function isn't cached
+    bool is_cached; // Text was taken from the cache
+    Dynamic_Array<IR_Code_Block*> blocks; // Blocks in generation order, the cache refers to blocks by index
+    Hashtable<IR_Code_Block*, int> block_indices;
+};
+
 struct C_Generator
 {
     Compilation_Data* compilation_data;
     String sections[(int)Generator_Section::MAX_ENUM_VALUE];
     String* text; // Current text that's being worked on
-    int name_counter;
+    C_Function_Output* function_output; // Function which is currently generated, nullptr otherwise
+
+    // Workers only read existing translations, so types/constants/globals/parameters are created in a serial pre-pass
+    bool is_worker;
 
     Hashtable<Datatype*, C_Type_Dependency*> type_to_dependency_mapping;
     Dynamic_Array<C_Type_Dependency*> type_dependencies;
+    Hashtable<Datatype*, String> type_reference_cache; // Type (with modifiers) to access name, strings are owned by name_mapping
 
     Dynamic_Array<Translation_Char_Info> translation_characters;
     C_Program_Translation program_translation;
@@ -342,11 +494,14 @@ C_Generator* c_generator_create(Compilation_Data* compilation_data)
     result.program_translation.line_infos = dynamic_array_create<C_Line_Info>(32);
     result.program_translation.name_mapping = hashtable_create_empty<C_Translation, String>(64, c_translation_hash, c_translation_is_equal);
     result.program_translation.source_code = string_create(2048);
+    result.program_translation.profile_slots = dynamic_array_create<C_Profile_Slot>();
     result.type_dependencies = dynamic_array_create<C_Type_Dependency*>();
     result.type_to_dependency_mapping = hashtable_create_pointer_empty<Datatype*, C_Type_Dependency*>(32);
+    result.type_reference_cache = hashtable_create_pointer_empty<Datatype*, String>(64);
     result.translation_characters = dynamic_array_create<Translation_Char_Info>(32);
-    result.name_counter = 0;
     result.text = 0;
+    result.function_output = nullptr;
+    result.is_worker = false;
 
     return &result;
 }
@@ -358,11 +513,13 @@ void c_generator_destroy(C_Generator* generator)
         string_destroy(&gen.sections[i]);
     }
     hashtable_destroy(&gen.type_to_dependency_mapping);
+    hashtable_destroy(&gen.type_reference_cache);
 
     string_destroy(&gen.program_translation.source_code);
     hashtable_for_each_value(&gen.program_translation.name_mapping, string_destroy);
     hashtable_destroy(&gen.program_translation.name_mapping);
     dynamic_array_destroy(&gen.program_translation.line_infos);
+    dynamic_array_destroy(&gen.program_translation.profile_slots);
     dynamic_array_destroy(&gen.translation_characters);
 
     for (int i = 0; i < gen.type_dependencies.size; i++) {
@@ -386,9 +543,7 @@ void output_memory_as_new_constant(C_Generator* generator, byte* base_memory, Da
 
 void string_add_indentation(String* str, int indentation)
 {
-    for (int i = 0; i < indentation; i++) {
-        string_append_formated(str, "    ");
-    }
+    string_append_repeated(str, ' ', indentation * 4);
 }
 
 void c_generator_generate_struct_content(C_Generator* generator, Datatype_Struct* structure, C_Type_Dependency* type_dependency, int indentation_level)
@@ -405,7 +560,9 @@ void c_generator_generate_struct_content(C_Generator* generator, Datatype_Struct
 
         string_add_indentation(gen.text, indentation_level);
         c_generator_output_type_reference(generator, member.datatype);
-        string_append_formated(gen.text, " %s;\n", member.name->characters);
+        string_append(gen.text, " ");
+        string_append(gen.text, member.name->characters);
+        string_append(gen.text, ";\n");
 
         // Add dependencies if necessary
         auto member_type = member.datatype;
@@ -431,7 +588,9 @@ void c_generator_generate_struct_content(C_Generator* generator, Datatype_Struct
             string_append(gen.text, "struct {\n");
             c_generator_generate_struct_content(generator, child_content, type_dependency, indentation_level + 2);
             string_add_indentation(gen.text, indentation_level + 1);
-            string_append_formated(gen.text, "} %s;", child_content->name->characters);
+            string_append(gen.text, "} ");
+            string_append(gen.text, child_content->name->characters);
+            string_append(gen.text, ";");
             string_append(gen.text, "\n");
         }
         string_add_indentation(gen.text, indentation_level);
@@ -467,7 +626,8 @@ C_Type_Dependency* get_type_dependency(C_Generator* generator, Datatype* datatyp
     return dep;
 }
 
-void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
+// Returns the access name of the type (Owned by name_mapping), definitions are added to the sections if the type is new
+static String c_generator_create_type_reference(C_Generator* generator, Datatype* type)
 {
     auto& gen = *generator;
     Type_System* type_system = gen.compilation_data->type_system;
@@ -483,8 +643,7 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
     {
         String* translated = hashtable_find_element(&gen.program_translation.name_mapping, translation);
         if (translated != 0) {
-            string_append(gen.text, translated->characters);
-            return;
+            return *translated;
         }
     }
 
@@ -543,43 +702,55 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
     case Datatype_Type::PATTERN_VARIABLE:
     case Datatype_Type::UNKNOWN_TYPE:
     {
-        string_append_formated(&access_name, "UNUSED_TYPE_BACKEND_"); // See hardcoded_functions.h for definition
+        string_append(&access_name, "UNUSED_TYPE_BACKEND_"); // See hardcoded_functions.h for definition
         break;
     }
     case Datatype_Type::ENUM:
     {
         auto enum_type = downcast<Datatype_Enum>(type);
         auto& members = enum_type->members;
-        string_append_formated(&access_name, "%s_Enum_%d", enum_type->name->characters, gen.name_counter);
-        gen.name_counter++;
+        string_append(&access_name, enum_type->name->characters);
+        string_append(&access_name, "_Enum_");
+        string_append_i64(&access_name, type->type_handle.index);
 
         String* enum_section = &gen.sections[(int)Generator_Section::ENUM_DECLARATIONS];
-        string_append_formated(enum_section, "enum class %s : i64\n{\n", access_name.characters); // Currently enums are i64 in Upp
+        // Currently enums are i64 in Upp
+        string_append(enum_section, "enum class ");
+        string_append(enum_section, access_name.characters);
+        string_append(enum_section, " : i64\n{\n");
         for (int i = 0; i < members.size; i++) {
             auto member = &members[i];
-            string_append_formated(enum_section, "    %s = %d,\n", member->name->characters, member->value);
+            string_append(enum_section, "    ");
+            string_append(enum_section, member->name->characters);
+            string_append(enum_section, " = ");
+            string_append_i64(enum_section, member->value);
+            string_append(enum_section, ",\n");
         }
-        string_append_formated(enum_section, "};\n");
+        string_append(enum_section, "};\n");
         break;
     }
     case Datatype_Type::SLICE:
     {
         auto slice_type = downcast<Datatype_Slice>(type);
-        string_append_formated(&access_name, "Slice_%d", gen.name_counter);
-        gen.name_counter++;
+        string_append(&access_name, "Slice_");
+        string_append_i64(&access_name, type->type_handle.index);
 
         String* section_prototypes = &gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES];
         String* section_structs = &gen.sections[(int)Generator_Section::STRUCT_AND_ARRAY_DECLARATIONS];
-        string_append_formated(section_prototypes, "struct %s;\n", access_name.characters);
+        string_append(section_prototypes, "struct ");
+        string_append(section_prototypes, access_name.characters);
+        string_append(section_prototypes, ";\n");
 
         // Temporary c_string is required when calling this function recursively
         String tmp = string_create(32);
         SCOPE_EXIT(string_destroy(&tmp));
 
         gen.text = &tmp;
-        string_append_formated(gen.text, "struct %s {\n    ", access_name.characters);
+        string_append(gen.text, "struct ");
+        string_append(gen.text, access_name.characters);
+        string_append(gen.text, " {\n    ");
         c_generator_output_type_reference(generator, slice_type->data_member.datatype);
-        string_append_formated(gen.text, " data;\n    u64 size;\n};\n\n");
+        string_append(gen.text, " data;\n    u64 size;\n};\n\n");
 
         // Now we write to struct section
         gen.text = section_structs;
@@ -591,8 +762,8 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
     {
         auto signature = downcast<Datatype_Function_Pointer>(type)->signature;
         auto& parameters = signature->parameters;
-        string_append_formated(&access_name, "fptr_%d", gen.name_counter);
-        gen.name_counter++;
+        string_append(&access_name, "fptr_");
+        string_append_i64(&access_name, type->type_handle.index);
 
         // Temporary c_string is required when calling this function recursively
         String tmp = string_create(32);
@@ -607,19 +778,22 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
             string_append(gen.text, "void");
         }
 
-        string_append_formated(gen.text, " (*%s)(", access_name.characters);
+        string_append(gen.text, " (*");
+        string_append(gen.text, access_name.characters);
+        string_append(gen.text, ")(");
         bool require_comma = false;
         for (int i = 0; i < parameters.size; i++) {
             auto& param = parameters[i];
             if (i == signature->return_type_index) continue;
             if (require_comma) {
-                string_append_formated(gen.text, ", ");
+                string_append(gen.text, ", ");
             }
             require_comma = true;
             c_generator_output_type_reference(generator, param.datatype);
-            string_append_formated(gen.text, " %s", param.name->characters);
+            string_append(gen.text, " ");
+            string_append(gen.text, param.name->characters);
         }
-        string_append_formated(gen.text, ");\n\n");
+        string_append(gen.text, ");\n\n");
 
         gen.text = &gen.sections[(int)Generator_Section::TYPE_DECLARATIONS];
         string_append(gen.text, tmp.characters);
@@ -632,30 +806,37 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
         auto& members = structure->members;
 
         if (structure->base.contains_pattern) {
-            string_append_formated(&access_name, "UNUSED_TYPE_BACKEND_"); // See hardcoded_functions.h for definition
+            string_append(&access_name, "UNUSED_TYPE_BACKEND_"); // See hardcoded_functions.h for definition
             break;
         }
 
         // Extern structs should be accessible by name alone (And forward definition/definition should be in an included header)
         if (structure->upp_struct->is_extern_struct) {
-            string_append_formated(&access_name, structure->name->characters);
+            string_append(&access_name, structure->name->characters);
             break;
         }
 
         // Because structs can contain references to themselves, we need to register the access name before generating the members
         if (structure->upp_struct->is_union) {
-            string_append_formated(&access_name, "%s_Struct_%d", structure->name->characters, gen.name_counter);
+            string_append(&access_name, structure->name->characters);
+            string_append(&access_name, "_Struct_");
+            string_append_i64(&access_name, type->type_handle.index);
         }
         else {
-            string_append_formated(&access_name, "%s_Union_%d", structure->name->characters, gen.name_counter);
+            string_append(&access_name, structure->name->characters);
+            string_append(&access_name, "_Union_");
+            string_append_i64(&access_name, type->type_handle.index);
         }
-        gen.name_counter += 1;
         hashtable_insert_element(&gen.program_translation.name_mapping, translation, access_name);
         if (structure->upp_struct->is_union) {
-            string_append_formated(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "union %s;\n", access_name.characters);
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "union ");
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], access_name.characters);
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], ";\n");
         }
         else {
-            string_append_formated(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct %s;\n", access_name.characters);
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct ");
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], access_name.characters);
+            string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], ";\n");
         }
 
         // Generate struct content
@@ -665,78 +846,831 @@ void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
 
         // Handle extern structs (No members, but size and alignment can be different
         if (structure->members.size == 0 && structure->subtypes.size == 0) {
-            string_append_formated(
-                gen.text, "alignas(%d) %s {\n    u8 values[%d];\n};\n",
-                structure->base.memory_info.value.alignment, access_name.characters, structure->base.memory_info.value.size
-            );
+            string_append(gen.text, "alignas(");
+            string_append_i64(gen.text, structure->base.memory_info.value.alignment);
+            string_append(gen.text, ") ");
+            string_append(gen.text, access_name.characters);
+            string_append(gen.text, " {\n    u8 values[");
+            string_append_i64(gen.text, structure->base.memory_info.value.size);
+            string_append(gen.text, "];\n};\n");
         }
         else
         {
-            string_append_formated(gen.text, "%s {\n", access_name.characters);
+            string_append(gen.text, access_name.characters);
+            string_append(gen.text, " {\n");
             c_generator_generate_struct_content(generator, structure, dependency, 1);
             string_append(gen.text, "};\n\n");
         }
 
-        // We return early because we don't want to insert into the translation table twice
-        gen.text = backup_text;
-        string_append(gen.text, access_name.characters);
-        return;
+        // We return early because we don't want to insert into the translation table twice
+        return access_name;
+    }
+    case Datatype_Type::ARRAY:
+    {
+        auto array_type = downcast<Datatype_Array>(type);
+        string_append(&access_name, "Array_");
+        string_append_i64(&access_name, type->type_handle.index);
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct ");
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], access_name.characters);
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], ";\n");
+
+        // Similar to structs we insert the names early
+        hashtable_insert_element(&gen.program_translation.name_mapping, translation, access_name);
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct ");
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], access_name.characters);
+        string_append(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], ";\n");
+
+        // Generate array definition
+        C_Type_Dependency* dependency = get_type_dependency(generator, type);
+        gen.text = &dependency->type_definition;
+        string_append(gen.text, "struct ");
+        string_append(gen.text, access_name.characters);
+        string_append(gen.text, " {\n");
+        string_add_indentation(gen.text, 1);
+        // Note: Here we use the non-const type, because:
+        //      In type_system, if the element_type is constant, the array_type is also constant
+        //      In C, if a struct is constant, the array in the struct is also automatically constant
+        //      By not making the values constant, array_initializers will still work by using a temporary, non-const array
+        c_generator_output_type_reference(generator, array_type->element_type);
+        string_append(gen.text, " values[");
+        string_append_i64(gen.text, array_type->element_count);
+        string_append(gen.text, "];\n};\n");
+
+        // Add dependency if necessary
+        auto member_type = array_type->element_type;
+        if (member_type->type == Datatype_Type::STRUCT || member_type->type == Datatype_Type::ARRAY)
+        {
+            member_type = datatype_get_undecorated(member_type, true, true, true);
+            C_Type_Dependency* member_dependency = get_type_dependency(generator, member_type);
+            dynamic_array_push_back(&dependency->depends_on, member_dependency);
+            dynamic_array_push_back(&member_dependency->dependees, dependency);
+            dependency->dependency_count += 1;
+        }
+
+        // We return early because we don't want to insert into the translation table twice
+        return access_name;
+    }
+    case Datatype_Type::POINTER: 
+    {
+        Datatype_Pointer* pointer_type = downcast<Datatype_Pointer>(type);
+        Datatype* child_type = pointer_type->element_type;
+        gen.text = &access_name;
+        c_generator_output_type_reference(generator, child_type);
+        string_append(&access_name, "*");
+        break;
+    }
+    default: panic("Hey");
+    }
+
+    // Insert translation into table
+    hashtable_insert_element(&gen.program_translation.name_mapping, translation, access_name);
+    return access_name;
+}
+
+void c_generator_output_type_reference(C_Generator* generator, Datatype* type)
+{
+    auto& gen = *generator;
+    String* cached = hashtable_find_element(&gen.type_reference_cache, type);
+    if (cached != nullptr) {
+        string_append(gen.text, cached->characters);
+        return;
+    }
+    if (gen.is_worker) {
+        gen.function_output->missing_translation = true;
+        return;
+    }
+
+    String access_name = c_generator_create_type_reference(generator, type);
+    hashtable_insert_element(&gen.type_reference_cache, type, access_name);
+    string_append(gen.text, access_name.characters);
+}
+
+// Slots are filled by generated code: functions add calls + inclusive cycles, loops only count iterations.
+// Cycles of frames which are active on exit() are not recorded, and recursive calls are counted multiple times.
+static void c_generator_append_profiling_runtime(C_Generator* generator, String* string)
+{
+    int slot_count = math_maximum(1, generator->program_translation.profile_slots.size);
+    string_append(string, "#include <intrin.h>\n");
+    string_append(string, "struct Upp_Profile_Slot_ { unsigned long long count; unsigned long long cycles; };\n");
+    string_append(string, "Upp_Profile_Slot_ upp_profile_slots_[");
+    string_append_i64(string, slot_count);
+    string_append(string, "];\n");
+    string_append(string, "struct Upp_Profile_Scope_ {\n");
+    string_append(string, "    Upp_Profile_Slot_* slot;\n    unsigned long long start;\n");
+    string_append(string, "    Upp_Profile_Scope_(int index) { slot = &upp_profile_slots_[index]; slot->count += 1; start = __rdtsc(); }\n");
+    string_append(string, "    ~Upp_Profile_Scope_() { slot->cycles += __rdtsc() - start; }\n");
+    string_append(string, "};\n");
+    string_append(string, "void upp_profile_dump_() {\n");
+    string_append(string, "    FILE* file = fopen(\"");
+    string_append(string, c_profile_dump_filepath);
+    string_append(string, "\", \"w\");\n");
+    string_append(string, "    if (file == nullptr) return;\n");
+    string_append(string, "    for (int i = 0; i < ");
+    string_append_i64(string, slot_count);
+    string_append(string, "; i++) {\n");
+    string_append(string, "        fprintf(file, \"%d %llu %llu\\n\", i, upp_profile_slots_[i].count, upp_profile_slots_[i].cycles);\n");
+    string_append(string, "    }\n    fclose(file);\n}\n");
+}
+
+static void c_generator_output_function_signature(C_Generator* generator, Upp_Function* function, const char* access_name)
+{
+    auto& gen = *generator;
+    Call_Signature* signature = function->signature;
+    if (signature->return_type().available) {
+        c_generator_output_type_reference(generator, signature->return_type().value);
+    }
+    else {
+        string_append(gen.text, "void");
+    }
+    string_append(gen.text, " ");
+    string_append(gen.text, access_name);
+    string_append(gen.text, "(");
+
+    auto& parameters = signature->parameters;
+    bool require_comma = false;
+    for (int j = 0; j < parameters.size; j++)
+    {
+        auto& param = parameters[j];
+        if (j == signature->return_type_index) continue;
+        if (require_comma) {
+            string_append(gen.text, ", ");
+        }
+        require_comma = true;
+
+        c_generator_output_type_reference(generator, param.datatype);
+        string_append(gen.text, " ");
+
+        // Note: This has to be the same name as in output_data_access for parameter access
+        c_generator_output_parameter_access(generator, function, j);
+    }
+    string_append(gen.text, ")");
+}
+
+// Creates the translations of all types, constants, globals and parameters an access requires
+static void c_generator_prepare_data_access(C_Generator* generator, IR_Data_Access* access)
+{
+    switch (access->type)
+    {
+    case IR_Data_Access_Type::NOTHING: return;
+    case IR_Data_Access_Type::REGISTER: break;
+    case IR_Data_Access_Type::GLOBAL_DATA:
+    case IR_Data_Access_Type::CONSTANT:
+    case IR_Data_Access_Type::PARAMETER:
+        c_generator_output_data_access(generator, access);
+        break;
+    case IR_Data_Access_Type::POINTER_DEREFERENCE:
+    case IR_Data_Access_Type::ADDRESS_OF_VALUE:
+        c_generator_prepare_data_access(generator, access->option.pointer_value);
+        break;
+    case IR_Data_Access_Type::MEMBER_ACCESS:
+        c_generator_prepare_data_access(generator, access->option.member_access.struct_access);
+        break;
+    case IR_Data_Access_Type::ARRAY_ELEMENT_ACCESS:
+        c_generator_prepare_data_access(generator, access->option.array_access.array_access);
+        c_generator_prepare_data_access(generator, access->option.array_access.index_access);
+        break;
+    case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST:
+        c_generator_prepare_data_access(generator, access->option.non_destructive_cast.value_access);
+        break;
+    default: panic("");
+    }
+
+    if (access->datatype != nullptr) {
+        c_generator_output_type_reference(generator, access->datatype);
+    }
+}
+
+static void c_generator_prepare_code_block(C_Generator* generator, IR_Code_Block* code_block)
+{
+    for (int i = 0; i < code_block->registers.size; i++) {
+        c_generator_output_type_reference(generator, code_block->registers[i].type);
+    }
+
+    for (int i = 0; i < code_block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &code_block->instructions[i];
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::FUNCTION_CALL: {
+            IR_Instruction_Call* call = &instr->options.call;
+            if (call->call_type == IR_Instruction_Call_Type::FUNCTION_POINTER_CALL) {
+                c_generator_prepare_data_access(generator, call->options.pointer_access);
+            }
+            for (int j = 0; j < call->arguments.size; j++) {
+                c_generator_prepare_data_access(generator, call->arguments[j]);
+            }
+            c_generator_prepare_data_access(generator, call->destination);
+            break;
+        }
+        case IR_Instruction_Type::MATCH: {
+            IR_Instruction_Switch* switch_instr = &instr->options.switch_instr;
+            c_generator_prepare_data_access(generator, switch_instr->condition_access);
+            for (int j = 0; j < switch_instr->cases.size; j++) {
+                c_generator_prepare_code_block(generator, switch_instr->cases[j].block);
+            }
+            c_generator_prepare_code_block(generator, switch_instr->default_block);
+            break;
+        }
+        case IR_Instruction_Type::IF:
+            c_generator_prepare_data_access(generator, instr->options.if_instr.condition);
+            c_generator_prepare_code_block(generator, instr->options.if_instr.true_branch);
+            c_generator_prepare_code_block(generator, instr->options.if_instr.false_branch);
+            break;
+        case IR_Instruction_Type::WHILE:
+            c_generator_prepare_code_block(generator, instr->options.while_instr.condition_code);
+            c_generator_prepare_data_access(generator, instr->options.while_instr.condition_access);
+            c_generator_prepare_code_block(generator, instr->options.while_instr.code);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            c_generator_prepare_code_block(generator, instr->options.block);
+            break;
+        case IR_Instruction_Type::RETURN:
+            if (instr->options.return_instr.type == IR_Instruction_Return_Type::RETURN_DATA) {
+                c_generator_prepare_data_access(generator, instr->options.return_instr.options.return_value);
+            }
+            break;
+        case IR_Instruction_Type::VARIABLE_DEFINITION:
+            c_generator_prepare_data_access(generator, instr->options.variable_definition.variable_access);
+            if (instr->options.variable_definition.initial_value.available) {
+                c_generator_prepare_data_access(generator, instr->options.variable_definition.initial_value.value);
+            }
+            break;
+        case IR_Instruction_Type::FUNCTION_ADDRESS:
+            c_generator_prepare_data_access(generator, instr->options.function_address.destination);
+            break;
+        case IR_Instruction_Type::MOVE:
+            c_generator_prepare_data_access(generator, instr->options.move.source);
+            c_generator_prepare_data_access(generator, instr->options.move.destination);
+            break;
+        case IR_Instruction_Type::OPERATION:
+            c_generator_prepare_data_access(generator, instr->options.operation.destination);
+            c_generator_prepare_data_access(generator, instr->options.operation.operand_1);
+            c_generator_prepare_data_access(generator, instr->options.operation.operand_2);
+            break;
+        default: break;
+        }
+    }
+}
+
+static void c_generator_output_function(C_Generator* generator, C_Function_Output* output)
+{
+    auto& gen = *generator;
+    Upp_Function* function = output->function;
+    gen.function_output = output;
+    gen.text = &output->text;
+
+    if (function != gen.compilation_data->entry_function)
+    {
+        C_Translation fn_translation;
+        fn_translation.type = C_Translation_Type::FUNCTION;
+        fn_translation.options.function = function;
+        String* fn_name = hashtable_find_element(&gen.program_translation.name_mapping, fn_translation);
+        assert(fn_name != 0, "");
+        c_generator_output_function_signature(generator, function, fn_name->characters);
+    }
+    else {
+        c_generator_output_function_signature(generator, function, "upp_entry_");
+    }
+
+    string_append(gen.text, "\n");
+    c_generator_output_code_block(generator, function->ir_block, 0, false);
+    string_append(gen.text, "\n");
+    gen.function_output = nullptr;
+}
+
+struct C_Generator_Worker
+{
+    C_Generator generator; // Copy of the main generator, with is_worker set
+    Dynamic_Array<C_Function_Output>* outputs;
+    int worker_index;
+    int worker_count;
+};
+
+static unsigned long c_generator_worker_entry_fn(void* userdata)
+{
+    C_Generator_Worker* worker = (C_Generator_Worker*)userdata;
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::C_GENERATOR);
+    auto& outputs = *worker->outputs;
+    for (int i = worker->worker_index; i < outputs.size; i += worker->worker_count) {
+        if (outputs[i].is_cached) continue;
+        c_generator_output_function(&worker->generator, &outputs[i]);
+    }
+    return 0;
+}
+
+// Generated function texts are kept across compiles, keyed by a hash of everything the text depends on:
+// IR, signature and the access names of referenced types/constants/globals/functions (Names are derived from indices).
+// Cached texts only reference translations which the pre-pass creates, so sections are still generated from scratch.
+struct C_Cached_Char_Info
+{
+    int block_index;
+    int instruction_index;
+    int char_start;
+    int char_end;
+};
+
+struct C_Cached_Register_Name
+{
+    int block_index;
+    int register_index;
+    String name;
+};
+
+struct C_Function_Cache_Entry
+{
+    Array<byte> key; // Compared on lookup, so that hash collisions never splice in the wrong function
+    String text;
+    Dynamic_Array<C_Cached_Char_Info> char_infos;
+    Dynamic_Array<C_Cached_Register_Name> register_names;
+    int last_used_generation;
+};
+
+struct C_Function_Cache
+{
+    Hashtable<u64, C_Function_Cache_Entry> entries;
+    int generation;
+};
+
+static void c_function_cache_entry_destroy(C_Function_Cache_Entry* entry)
+{
+    array_destroy(&entry->key);
+    string_destroy(&entry->text);
+    dynamic_array_destroy(&entry->char_infos);
+    for (int i = 0; i < entry->register_names.size; i++) {
+        string_destroy(&entry->register_names[i].name);
+    }
+    dynamic_array_destroy(&entry->register_names);
+}
+
+void c_compiler_shutdown()
+{
+    C_Function_Cache* cache = c_compiler.function_cache;
+    if (cache == nullptr) return;
+    auto iter = hashtable_iterator_create(&cache->entries);
+    while (hashtable_iterator_has_next(&iter)) {
+        SCOPE_EXIT(hashtable_iterator_next(&iter));
+        c_function_cache_entry_destroy(iter.value);
+    }
+    hashtable_destroy(&cache->entries);
+    delete cache;
+    c_compiler.function_cache = nullptr;
+}
+
+static void c_generator_collect_blocks(C_Function_Output* output, IR_Code_Block* code_block)
+{
+    hashtable_insert_element(&output->block_indices, code_block, output->blocks.size);
+    dynamic_array_push_back(&output->blocks, code_block);
+    for (int i = 0; i < code_block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &code_block->instructions[i];
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::IF:
+            c_generator_collect_blocks(output, instr->options.if_instr.true_branch);
+            c_generator_collect_blocks(output, instr->options.if_instr.false_branch);
+            break;
+        case IR_Instruction_Type::WHILE:
+            c_generator_collect_blocks(output, instr->options.while_instr.condition_code);
+            c_generator_collect_blocks(output, instr->options.while_instr.code);
+            break;
+        case IR_Instruction_Type::MATCH:
+            for (int j = 0; j < instr->options.switch_instr.cases.size; j++) {
+                c_generator_collect_blocks(output, instr->options.switch_instr.cases[j].block);
+            }
+            c_generator_collect_blocks(output, instr->options.switch_instr.default_block);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            c_generator_collect_blocks(output, instr->options.block);
+            break;
+        default: break;
+        }
+    }
+}
+
+static void c_function_hash_bytes(C_Function_Output* output, void* data, int size)
+{
+    Dynamic_Array<byte>* key = &output->key;
+    dynamic_array_reserve_exponential(key, key->size + size);
+    memory_copy(key->data + key->size, data, size);
+    key->size += size;
+}
+
+static void c_function_hash_int(C_Function_Output* output, int value) {
+    c_function_hash_bytes(output, &value, sizeof(int));
+}
+
+static void c_function_hash_name(C_Function_Output* output, String* name)
+{
+    if (name == nullptr) {
+        output->hash_valid = false;
+        return;
+    }
+    c_function_hash_int(output, name->size);
+    c_function_hash_bytes(output, name->characters, name->size);
+}
+
+static void c_function_hash_translation(C_Generator* generator, C_Function_Output* output, C_Translation translation) {
+    c_function_hash_name(output, hashtable_find_element(&generator->program_translation.name_mapping, translation));
+}
+
+// Handles decide casts (types_are_equal), names decide the emitted text
+static void c_function_hash_type(C_Generator* generator, C_Function_Output* output, Datatype* type)
+{
+    if (type == nullptr) {
+        c_function_hash_int(output, -1);
+        return;
+    }
+    c_function_hash_int(output, type->type_handle.index);
+    c_function_hash_int(output, (int)type->type);
+    c_function_hash_name(output, hashtable_find_element(&generator->type_reference_cache, type));
+}
+
+static void c_function_hash_return_type(C_Function_Output* output, Call_Signature* signature) {
+    c_function_hash_int(output, signature->return_type().available ? signature->return_type().value->type_handle.index : -1);
+}
+
+static void c_function_hash_data_access(C_Generator* generator, C_Function_Output* output, IR_Data_Access* access)
+{
+    c_function_hash_int(output, (int)access->type);
+    switch (access->type)
+    {
+    case IR_Data_Access_Type::NOTHING: return;
+    case IR_Data_Access_Type::REGISTER: {
+        int* block_index = hashtable_find_element(&output->block_indices, access->option.register_access.definition_block);
+        if (block_index == nullptr) {
+            output->hash_valid = false;
+            return;
+        }
+        c_function_hash_int(output, *block_index);
+        c_function_hash_int(output, access->option.register_access.index);
+        break;
+    }
+    case IR_Data_Access_Type::PARAMETER: {
+        C_Translation translation;
+        translation.type = C_Translation_Type::PARAMETER;
+        translation.options.parameter.function = access->option.parameter.function;
+        translation.options.parameter.index = access->option.parameter.index;
+        c_function_hash_translation(generator, output, translation);
+        break;
+    }
+    case IR_Data_Access_Type::GLOBAL_DATA: {
+        C_Translation translation;
+        translation.type = C_Translation_Type::GLOBAL;
+        translation.options.global_index = access->option.global_index;
+        c_function_hash_translation(generator, output, translation);
+        break;
+    }
+    case IR_Data_Access_Type::CONSTANT: {
+        // Same lookup order as constant_access, where requires_memory_address may be set by the type
+        C_Translation translation;
+        translation.type = C_Translation_Type::CONSTANT;
+        translation.options.constant.index = access->option.constant_index;
+        translation.options.constant.requires_memory_address = false;
+        String* name = hashtable_find_element(&generator->program_translation.name_mapping, translation);
+        if (name == nullptr) {
+            translation.options.constant.requires_memory_address = true;
+            name = hashtable_find_element(&generator->program_translation.name_mapping, translation);
+        }
+        c_function_hash_name(output, name);
+        break;
+    }
+    case IR_Data_Access_Type::POINTER_DEREFERENCE:
+    case IR_Data_Access_Type::ADDRESS_OF_VALUE:
+        c_function_hash_data_access(generator, output, access->option.pointer_value);
+        break;
+    case IR_Data_Access_Type::MEMBER_ACCESS:
+    {
+        Datatype* access_type = access->option.member_access.struct_access->datatype;
+        c_function_hash_data_access(generator, output, access->option.member_access.struct_access);
+        if (access_type->type == Datatype_Type::STRUCT) {
+            Datatype_Struct* iter = downcast<Datatype_Struct>(access_type);
+            while (iter->parent != nullptr) {
+                c_function_hash_name(output, iter->name);
+                iter = iter->parent;
+            }
+        }
+        c_function_hash_name(output, access->option.member_access.member.name);
+        break;
+    }
+    case IR_Data_Access_Type::ARRAY_ELEMENT_ACCESS:
+        c_function_hash_data_access(generator, output, access->option.array_access.array_access);
+        c_function_hash_data_access(generator, output, access->option.array_access.index_access);
+        break;
+    case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST:
+        c_function_hash_data_access(generator, output, access->option.non_destructive_cast.value_access);
+        break;
+    default: panic("");
+    }
+
+    c_function_hash_type(generator, output, access->datatype);
+}
+
+static void c_function_hash_code_block(C_Generator* generator, C_Function_Output* output, IR_Code_Block* code_block)
+{
+    c_function_hash_int(output, code_block->registers.size);
+    for (int i = 0; i < code_block->registers.size; i++)
+    {
+        auto& reg = code_block->registers[i];
+        c_function_hash_int(output, reg.has_definition_instruction ? 1 : 0);
+        c_function_hash_type(generator, output, reg.type);
+        if (reg.name.available) {
+            c_function_hash_name(output, reg.name.value);
+        }
+    }
+
+    c_function_hash_int(output, code_block->instructions.size);
+    for (int i = 0; i < code_block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &code_block->instructions[i];
+        c_function_hash_int(output, (int)instr->type);
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::FUNCTION_CALL:
+        {
+            IR_Instruction_Call* call = &instr->options.call;
+            c_function_hash_int(output, (int)call->call_type);
+            switch (call->call_type)
+            {
+            case IR_Instruction_Call_Type::FUNCTION_CALL: {
+                C_Translation translation;
+                translation.type = C_Translation_Type::FUNCTION;
+                translation.options.function = call->options.function;
+                c_function_hash_translation(generator, output, translation);
+                c_function_hash_return_type(output, call->options.function->signature);
+                break;
+            }
+            case IR_Instruction_Call_Type::FUNCTION_POINTER_CALL:
+                c_function_hash_data_access(generator, output, call->options.pointer_access);
+                c_function_hash_return_type(output, downcast<Datatype_Function_Pointer>(call->options.pointer_access->datatype)->signature);
+                break;
+            case IR_Instruction_Call_Type::BUILTIN_CALL:
+                c_function_hash_int(output, (int)call->options.builtin_fn);
+                c_function_hash_return_type(
+                    output, generator->compilation_data->hardcoded_function_signatures[(int)ir_builtin_fn_to_hardcoded_type(call->options.builtin_fn)]
+                );
+                break;
+            default: panic("");
+            }
+            c_function_hash_int(output, call->arguments.size);
+            for (int j = 0; j < call->arguments.size; j++) {
+                c_function_hash_data_access(generator, output, call->arguments[j]);
+            }
+            c_function_hash_data_access(generator, output, call->destination);
+            break;
+        }
+        case IR_Instruction_Type::MATCH:
+        {
+            IR_Instruction_Switch* switch_instr = &instr->options.switch_instr;
+            c_function_hash_data_access(generator, output, switch_instr->condition_access);
+            c_function_hash_int(output, switch_instr->cases.size);
+            for (int j = 0; j < switch_instr->cases.size; j++) {
+                c_function_hash_int(output, switch_instr->cases[j].value);
+                c_function_hash_code_block(generator, output, switch_instr->cases[j].block);
+            }
+            c_function_hash_code_block(generator, output, switch_instr->default_block);
+            break;
+        }
+        case IR_Instruction_Type::IF:
+            c_function_hash_data_access(generator, output, instr->options.if_instr.condition);
+            c_function_hash_code_block(generator, output, instr->options.if_instr.true_branch);
+            c_function_hash_code_block(generator, output, instr->options.if_instr.false_branch);
+            break;
+        case IR_Instruction_Type::WHILE:
+            c_function_hash_code_block(generator, output, instr->options.while_instr.condition_code);
+            c_function_hash_data_access(generator, output, instr->options.while_instr.condition_access);
+            c_function_hash_code_block(generator, output, instr->options.while_instr.code);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            c_function_hash_code_block(generator, output, instr->options.block);
+            break;
+        case IR_Instruction_Type::GOTO:
+        case IR_Instruction_Type::LABEL:
+            c_function_hash_int(output, instr->options.label_index);
+            break;
+        case IR_Instruction_Type::RETURN:
+        {
+            IR_Instruction_Return* return_instr = &instr->options.return_instr;
+            c_function_hash_int(output, (int)return_instr->type);
+            if (return_instr->type == IR_Instruction_Return_Type::EXIT) {
+                c_function_hash_int(output, (int)return_instr->options.exit_code.type);
+            }
+            else if (return_instr->type == IR_Instruction_Return_Type::RETURN_DATA) {
+                c_function_hash_data_access(generator, output, return_instr->options.return_value);
+                c_function_hash_return_type(output, code_block->function->signature);
+            }
+            break;
+        }
+        case IR_Instruction_Type::VARIABLE_DEFINITION:
+        {
+            auto& def = instr->options.variable_definition;
+            c_function_hash_data_access(generator, output, def.variable_access);
+            c_function_hash_int(output, def.initial_value.available ? 1 : 0);
+            if (def.initial_value.available) {
+                c_function_hash_data_access(generator, output, def.initial_value.value);
+            }
+            break;
+        }
+        case IR_Instruction_Type::FUNCTION_ADDRESS:
+        {
+            C_Translation translation;
+            translation.type = C_Translation_Type::FUNCTION;
+            translation.options.function = instr->options.function_address.function;
+            c_function_hash_translation(generator, output, translation);
+            c_function_hash_data_access(generator, output, instr->options.function_address.destination);
+            break;
+        }
+        case IR_Instruction_Type::MOVE:
+            c_function_hash_data_access(generator, output, instr->options.move.source);
+            c_function_hash_data_access(generator, output, instr->options.move.destination);
+            break;
+        case IR_Instruction_Type::OPERATION:
+            c_function_hash_int(output, (int)instr->options.operation.type);
+            c_function_hash_data_access(generator, output, instr->options.operation.destination);
+            c_function_hash_data_access(generator, output, instr->options.operation.operand_1);
+            c_function_hash_data_access(generator, output, instr->options.operation.operand_2);
+            break;
+        default: panic("");
+        }
+    }
+}
+
+static void c_function_hash_signature(C_Generator* generator, C_Function_Output* output)
+{
+    Upp_Function* function = output->function;
+    Call_Signature* signature = function->signature;
+    if (function == generator->compilation_data->entry_function) {
+        c_function_hash_int(output, -1);
     }
-    case Datatype_Type::ARRAY:
+    else {
+        C_Translation translation;
+        translation.type = C_Translation_Type::FUNCTION;
+        translation.options.function = function;
+        c_function_hash_translation(generator, output, translation);
+    }
+
+    c_function_hash_int(output, signature->parameters.size);
+    c_function_hash_int(output, signature->return_type_index);
+    for (int i = 0; i < signature->parameters.size; i++)
     {
-        auto array_type = downcast<Datatype_Array>(type);
-        string_append_formated(&access_name, "Array_%d", gen.name_counter);
-        gen.name_counter++;
-        string_append_formated(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct %s;\n", access_name.characters);
+        c_function_hash_type(generator, output, signature->parameters[i].datatype);
+        if (i == signature->return_type_index) continue;
+        C_Translation translation;
+        translation.type = C_Translation_Type::PARAMETER;
+        translation.options.parameter.function = function;
+        translation.options.parameter.index = i;
+        c_function_hash_translation(generator, output, translation);
+    }
+}
 
-        // Similar to structs we insert the names early
-        hashtable_insert_element(&gen.program_translation.name_mapping, translation, access_name);
-        string_append_formated(&gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES], "struct %s;\n", access_name.characters);
+// Must run after the pre-pass, so that all names referenced by the function exist
+static void c_generator_load_cached_function(C_Generator* generator, C_Function_Output* output)
+{
+    auto& cache = *c_compiler.function_cache;
+    output->hash_valid = true;
+    dynamic_array_reset(&output->key);
+    c_generator_collect_blocks(output, output->function->ir_block);
+    c_function_hash_signature(generator, output);
+    c_function_hash_code_block(generator, output, output->function->ir_block);
+    if (!output->hash_valid) return;
+    output->hash = hash_memory(dynamic_array_as_bytes(&output->key));
+
+    C_Function_Cache_Entry* entry = hashtable_find_element(&cache.entries, output->hash);
+    if (entry == nullptr) return;
+    if (entry->key.size != output->key.size || !memory_compare(entry->key.data, output->key.data, output->key.size)) {
+        return; // Hash collision
+    }
 
-        // Generate array definition
-        C_Type_Dependency* dependency = get_type_dependency(generator, type);
-        gen.text = &dependency->type_definition;
-        string_append_formated(gen.text, "struct %s {\n", access_name.characters);
-        string_add_indentation(gen.text, 1);
-        // Note: Here we use the non-const type, because:
-        //      In type_system, if the element_type is constant, the array_type is also constant
-        //      In C, if a struct is constant, the array in the struct is also automatically constant
-        //      By not making the values constant, array_initializers will still work by using a temporary, non-const array
-        c_generator_output_type_reference(generator, array_type->element_type);
-        string_append_formated(gen.text, " values[%d];\n};\n", array_type->element_count);
+    entry->last_used_generation = cache.generation;
+    output->is_cached = true;
+    string_append_string(&output->text, &entry->text);
+    for (int i = 0; i < entry->char_infos.size; i++) {
+        C_Cached_Char_Info& cached = entry->char_infos[i];
+        Translation_Char_Info char_info;
+        char_info.code_block = output->blocks[cached.block_index];
+        char_info.instruction_index = cached.instruction_index;
+        char_info.char_start = cached.char_start;
+        char_info.char_end = cached.char_end;
+        dynamic_array_push_back(&output->char_infos, char_info);
+    }
+    for (int i = 0; i < entry->register_names.size; i++) {
+        C_Cached_Register_Name& cached = entry->register_names[i];
+        C_Translation translation;
+        translation.type = C_Translation_Type::REGISTER;
+        translation.options.register_translation.code_block = output->blocks[cached.block_index];
+        translation.options.register_translation.index = cached.register_index;
+        hashtable_insert_element(&output->register_names, translation, string_create(cached.name.characters));
+    }
+}
 
-        // Add dependency if necessary
-        auto member_type = array_type->element_type;
-        if (member_type->type == Datatype_Type::STRUCT || member_type->type == Datatype_Type::ARRAY)
-        {
-            member_type = datatype_get_undecorated(member_type, true, true, true);
-            C_Type_Dependency* member_dependency = get_type_dependency(generator, member_type);
-            dynamic_array_push_back(&dependency->depends_on, member_dependency);
-            dynamic_array_push_back(&member_dependency->dependees, dependency);
-            dependency->dependency_count += 1;
+static void c_generator_store_cached_function(C_Function_Output* output)
+{
+    auto& cache = *c_compiler.function_cache;
+    if (!output->hash_valid || output->is_cached) return;
+    if (hashtable_find_element(&cache.entries, output->hash) != nullptr) return; // Identical function was generated twice
+
+    C_Function_Cache_Entry entry;
+    entry.key = array_create<byte>(output->key.size);
+    memory_copy(entry.key.data, output->key.data, output->key.size);
+    entry.text = string_create(output->text.size + 1);
+    string_append_string(&entry.text, &output->text);
+    entry.char_infos = dynamic_array_create<C_Cached_Char_Info>(output->char_infos.size + 1);
+    for (int i = 0; i < output->char_infos.size; i++) {
+        Translation_Char_Info& char_info = output->char_infos[i];
+        C_Cached_Char_Info cached;
+        cached.block_index = *hashtable_find_element(&output->block_indices, char_info.code_block);
+        cached.instruction_index = char_info.instruction_index;
+        cached.char_start = char_info.char_start;
+        cached.char_end = char_info.char_end;
+        dynamic_array_push_back(&entry.char_infos, cached);
+    }
+    entry.register_names = dynamic_array_create<C_Cached_Register_Name>(output->register_names.element_count + 1);
+    auto iter = hashtable_iterator_create(&output->register_names);
+    while (hashtable_iterator_has_next(&iter)) {
+        SCOPE_EXIT(hashtable_iterator_next(&iter));
+        C_Cached_Register_Name cached;
+        cached.block_index = *hashtable_find_element(&output->block_indices, iter.key->options.register_translation.code_block);
+        cached.register_index = iter.key->options.register_translation.index;
+        cached.name = string_create(iter.value->characters);
+        dynamic_array_push_back(&entry.register_names, cached);
+    }
+    entry.last_used_generation = cache.generation;
+    hashtable_insert_element(&cache.entries, output->hash, entry);
+}
+
+// Removes entries of functions which weren't generated in the current generation
+static void c_function_cache_remove_unused_entries()
+{
+    auto& cache = *c_compiler.function_cache;
+    Dynamic_Array<u64> unused = dynamic_array_create<u64>();
+    SCOPE_EXIT(dynamic_array_destroy(&unused));
+    auto iter = hashtable_iterator_create(&cache.entries);
+    while (hashtable_iterator_has_next(&iter)) {
+        SCOPE_EXIT(hashtable_iterator_next(&iter));
+        if (iter.value->last_used_generation != cache.generation) {
+            c_function_cache_entry_destroy(iter.value);
+            dynamic_array_push_back(&unused, *iter.key);
         }
+    }
+    for (int i = 0; i < unused.size; i++) {
+        hashtable_remove_element(&cache.entries, unused[i]);
+    }
+}
 
-        // We return early because we don't want to insert into the translation table twice
-        gen.text = backup_text;
-        string_append(gen.text, access_name.characters);
+// Generates all function bodies, output is identical for all thread counts
+static void c_generator_generate_function_outputs(C_Generator* generator, Dynamic_Array<C_Function_Output>* outputs)
+{
+    auto& gen = *generator;
+
+    // Profile slot indices depend on the generation order, so profiled code is neither cached nor generated in parallel
+    if (enable_c_profiling) {
+        for (int i = 0; i < outputs->size; i++) {
+            c_generator_output_function(generator, &(*outputs)[i]);
+        }
         return;
     }
-    case Datatype_Type::POINTER: 
-    {
-        Datatype_Pointer* pointer_type = downcast<Datatype_Pointer>(type);
-        Datatype* child_type = pointer_type->element_type;
-        gen.text = &access_name;
-        c_generator_output_type_reference(generator, child_type);
-        string_append(&access_name, "*");
-        break;
+
+    int worker_count = math_maximum(1, math_minimum(c_generation_thread_count, outputs->size));
+    Array<C_Generator_Worker> workers = array_create<C_Generator_Worker>(worker_count);
+    SCOPE_EXIT(array_destroy(&workers));
+    Array<Thread> threads = array_create<Thread>(worker_count);
+    SCOPE_EXIT(array_destroy(&threads));
+    for (int i = 0; i < worker_count; i++) {
+        C_Generator_Worker& worker = workers[i];
+        worker.generator = gen;
+        worker.generator.is_worker = true;
+        worker.outputs = outputs;
+        worker.worker_index = i;
+        worker.worker_count = worker_count;
     }
-    default: panic("Hey");
+
+    // The calling thread works on the first share itself
+    for (int i = 1; i < worker_count; i++) {
+        threads[i] = thread_create(c_generator_worker_entry_fn, &workers[i]);
+    }
+    c_generator_worker_entry_fn(&workers[0]);
+    for (int i = 1; i < worker_count; i++) {
+        wait_for_thread_to_finish(threads[i]);
+        thread_destroy(threads[i]);
     }
 
-    // Insert translation into table and append access to text
-    hashtable_insert_element(&gen.program_translation.name_mapping, translation, access_name);
-    gen.text = backup_text;
-    string_append(gen.text, access_name.characters);
+    // Functions which required new translations are regenerated in order, so that new definitions are always added in the same order
+    for (int i = 0; i < outputs->size; i++)
+    {
+        C_Function_Output* output = &(*outputs)[i];
+        if (!output->missing_translation) {
+            c_generator_store_cached_function(output);
+            continue;
+        }
+
+        // Cached text could reference translations which aren't created by the pre-pass of the next compile
+        output->hash_valid = false;
+        string_reset(&output->text);
+        dynamic_array_reset(&output->char_infos);
+        hashtable_for_each_value(&output->register_names, string_destroy);
+        hashtable_reset(&output->register_names);
+        output->missing_translation = false;
+        c_generator_output_function(generator, output);
+    }
 }
 
 void c_generator_generate(C_Generator* generator)
@@ -754,17 +1688,20 @@ void c_generator_generate(C_Generator* generator)
             string_reset(&gen.sections[i]);
         }
 
+        hashtable_reset(&gen.type_reference_cache);
         hashtable_for_each_value(&gen.program_translation.name_mapping, string_destroy);
         hashtable_reset(&gen.program_translation.name_mapping);
         dynamic_array_reset(&gen.translation_characters);
         dynamic_array_reset(&gen.program_translation.line_infos);
+        dynamic_array_reset(&gen.program_translation.profile_slots);
 
         hashtable_reset(&gen.type_to_dependency_mapping);
         for (int i = 0; i < gen.type_dependencies.size; i++) {
             type_dependency_destroy(&gen.type_dependencies[i]);
         }
         dynamic_array_reset(&gen.type_dependencies);
-        gen.name_counter = 0;
+        gen.function_output = nullptr;
+        gen.is_worker = false;
     }
 
     // Create globals Translations
@@ -787,43 +1724,12 @@ void c_generator_generate(C_Generator* generator)
         }
     }
 
-    auto append_function_signature = [&](String* function_access_name, Upp_Function* function)
-    {
-        Call_Signature* signature = function->signature;
-        if (signature->return_type().available) {
-            c_generator_output_type_reference(generator, signature->return_type().value);
-        }
-        else {
-            string_append(gen.text, "void");
-        }
-        string_append_formated(gen.text, " %s(", function_access_name->characters);
-
-        auto& parameters = signature->parameters;
-        bool require_comma = false;
-        for (int j = 0; j < parameters.size; j++)
-        {
-            auto& param = parameters[j];
-            if (j == signature->return_type_index) continue;
-            if (require_comma) {
-                string_append(gen.text, ", ");
-            }
-            require_comma = true;
-
-            c_generator_output_type_reference(generator, param.datatype);
-            string_append(gen.text, " ");
-
-            // Note: This has to be the same name as in output_data_access for parameter access
-            c_generator_output_parameter_access(generator, function, j);
-        }
-        string_append(gen.text, ")");
-    };
-
     // Create function prototypes (Required before code-generation, as functions calling other functions require the translation)
     {
         for (int i = 0; i < compilation_data->functions.size; i++)
         {
             Upp_Function* function = compilation_data->functions[i];
-            if (function->ir_block == nullptr) {
+            if (function->ir_block == nullptr || !function->is_reachable) {
                 continue;
             }
             assert(!function->is_extern, "Extern functions should not be generated by ir_code");
@@ -835,8 +1741,8 @@ void c_generator_generate(C_Generator* generator)
 
             String access_name = string_create();
             string_append_string(&access_name, function->name);
-            string_append_formated(&access_name, "_%d", gen.name_counter);
-            gen.name_counter++;
+            string_append(&access_name, "_f");
+            string_append_i64(&access_name, function->function_index);
 
             C_Translation translation;
             translation.type = C_Translation_Type::FUNCTION;
@@ -845,7 +1751,7 @@ void c_generator_generate(C_Generator* generator)
 
             // Generate prototype
             gen.text = &gen.sections[(int)Generator_Section::FUNCTION_PROTOTYPES];
-            append_function_signature(&access_name, function);
+            c_generator_output_function_signature(generator, function, access_name.characters);
             string_append(gen.text, ";\n");
         }
 
@@ -867,37 +1773,100 @@ void c_generator_generate(C_Generator* generator)
     }
 
     // Create functions
-    for (int i = 0; i < compilation_data->functions.size; i++)
     {
-        Upp_Function* function = compilation_data->functions[i];
-        if (function->ir_block == nullptr) continue;
-
-        Call_Signature* signature = function->signature;
-        auto& parameters = signature->parameters;
-
-        // Generate function signature into tmp string
-        gen.text = &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION];
+        Dynamic_Array<C_Function_Output> outputs = dynamic_array_create<C_Function_Output>(compilation_data->functions.size);
+        SCOPE_EXIT(dynamic_array_destroy(&outputs));
+        for (int i = 0; i < compilation_data->functions.size; i++)
         {
-            if (function != compilation_data->entry_function)
-            {
-                C_Translation fn_translation;
-                fn_translation.type = C_Translation_Type::FUNCTION;
-                fn_translation.options.function = function;
-                String* fn_name = hashtable_find_element(&gen.program_translation.name_mapping, fn_translation);
-                assert(fn_name != 0, "");
-
-                append_function_signature(fn_name, function);
+            Upp_Function* function = compilation_data->functions[i];
+            if (function->ir_block == nullptr || !function->is_reachable) continue;
+
+            C_Function_Output output;
+            output.function = function;
+            output.text = string_create(256);
+            output.char_infos = dynamic_array_create<Translation_Char_Info>(16);
+            output.register_names = hashtable_create_empty<C_Translation, String>(16, c_translation_hash, c_translation_is_equal);
+            output.missing_translation = false;
+            output.key = dynamic_array_create<byte>();
+            output.hash = 0;
+            output.hash_valid = false;
+            output.is_cached = false;
+            output.blocks = dynamic_array_create<IR_Code_Block*>(8);
+            output.block_indices = hashtable_create_pointer_empty<IR_Code_Block*, int>(8);
+            dynamic_array_push_back(&outputs, output);
+        }
+
+        // Serial pre-pass, creates all translations shared between functions
+        {
+            String scratch = string_create(256);
+            SCOPE_EXIT(string_destroy(&scratch));
+            gen.text = &scratch;
+            c_generator_output_type_reference(generator, types.u8_type->upcast());
+            c_generator_output_type_reference(generator, types.u16_type->upcast());
+            c_generator_output_type_reference(generator, types.u32_type->upcast());
+            c_generator_output_type_reference(generator, types.u64_type->upcast());
+            for (int i = 0; i < outputs.size; i++) {
+                Upp_Function* function = outputs[i].function;
+                string_reset(&scratch);
+                c_generator_output_function_signature(generator, function, "");
+                c_generator_prepare_code_block(generator, function->ir_block);
+            }
+        }
+
+        bool use_function_cache = enable_c_function_cache && !enable_c_profiling;
+        if (use_function_cache)
+        {
+            if (c_compiler.function_cache == nullptr) {
+                c_compiler.function_cache = new C_Function_Cache;
+                c_compiler.function_cache->entries = hashtable_create_empty<u64, C_Function_Cache_Entry>(64, hash_u64, equals_u64);
+                c_compiler.function_cache->generation = 0;
             }
-            else {
-                String name = string_create_static("upp_entry_");
-                append_function_signature(&name, function);
+            auto& cache = *c_compiler.function_cache;
+            cache.generation += 1;
+            for (int i = 0; i < outputs.size; i++) {
+                c_generator_load_cached_function(generator, &outputs[i]);
             }
         }
 
-        // Generate function body
-        string_append(gen.text, "\n");
-        c_generator_output_code_block(generator, function->ir_block, 0, false);
-        string_append(gen.text, "\n");
+        c_generator_generate_function_outputs(generator, &outputs);
+        if (use_function_cache) {
+            c_function_cache_remove_unused_entries();
+        }
+
+        // Merge in function order
+        String* implementation = &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION];
+        {
+            int text_size = 0;
+            for (int i = 0; i < outputs.size; i++) {
+                text_size += outputs[i].text.size;
+            }
+            string_reserve_append(implementation, text_size);
+        }
+        for (int i = 0; i < outputs.size; i++)
+        {
+            C_Function_Output& output = outputs[i];
+            int char_offset = implementation->size;
+            for (int j = 0; j < output.char_infos.size; j++) {
+                Translation_Char_Info char_info = output.char_infos[j];
+                char_info.char_start += char_offset;
+                char_info.char_end += char_offset;
+                dynamic_array_push_back(&gen.translation_characters, char_info);
+            }
+            string_append_string(implementation, &output.text);
+
+            // Register names are now owned by name_mapping
+            auto iter = hashtable_iterator_create(&output.register_names);
+            while (hashtable_iterator_has_next(&iter)) {
+                SCOPE_EXIT(hashtable_iterator_next(&iter));
+                hashtable_insert_element(&gen.program_translation.name_mapping, *iter.key, *iter.value);
+            }
+            hashtable_destroy(&output.register_names);
+            string_destroy(&output.text);
+            dynamic_array_destroy(&output.char_infos);
+            dynamic_array_destroy(&output.key);
+            dynamic_array_destroy(&output.blocks);
+            hashtable_destroy(&output.block_indices);
+        }
     }
 
     // Create type_info init function
@@ -906,7 +1875,9 @@ void c_generator_generate(C_Generator* generator)
         gen.text = &gen.sections[(int)Generator_Section::CONSTANT_ARRAY_HOLDERS];
         string_append(gen.text, "struct Type_Information_Holder_ {\n    ");
         c_generator_output_type_reference(generator, upcast(types.type_information_type));
-        string_append_formated(gen.text, " infos[%d];\n};\n", type_system->types.size);
+        string_append(gen.text, " infos[");
+        string_append_i64(gen.text, type_system->types.size);
+        string_append(gen.text, "];\n};\n");
 
         // Create constant
         gen.text = &gen.sections[(int)Generator_Section::CONSTANTS];
@@ -930,13 +1901,21 @@ void c_generator_generate(C_Generator* generator)
 
             // Set base info
             string_add_indentation(gen.text, 1);
-            string_append_formated(gen.text, "info = &type_infos_.infos[%d];\n", i);
+            string_append(gen.text, "info = &type_infos_.infos[");
+            string_append_i64(gen.text, i);
+            string_append(gen.text, "];\n");
             string_add_indentation(gen.text, 1);
-            string_append_formated(gen.text, "info->type      = %d;\n", type->type_handle.index);
+            string_append(gen.text, "info->type      = ");
+            string_append_i64(gen.text, type->type_handle.index);
+            string_append(gen.text, ";\n");
             string_add_indentation(gen.text, 1);
-            string_append_formated(gen.text, "info->size      = %d;\n", memory.size);
+            string_append(gen.text, "info->size      = ");
+            string_append_i64(gen.text, memory.size);
+            string_append(gen.text, ";\n");
             string_add_indentation(gen.text, 1);
-            string_append_formated(gen.text, "info->alignment = %d;\n", memory.alignment);
+            string_append(gen.text, "info->alignment = ");
+            string_append_i64(gen.text, memory.alignment);
+            string_append(gen.text, ";\n");
             string_add_indentation(gen.text, 1);
             string_append(gen.text, "info->tag_      = ");
             output_memory_as_new_constant(
@@ -959,9 +1938,13 @@ void c_generator_generate(C_Generator* generator)
             }
             case Datatype_Type::ARRAY: {
                 auto array_type = downcast<Datatype_Array>(type);
-                string_append_formated(gen.text, "info->subtypes_.Array.element_type = %d;\n", array_type->element_type->type_handle.index);
+                string_append(gen.text, "info->subtypes_.Array.element_type = ");
+                string_append_i64(gen.text, array_type->element_type->type_handle.index);
+                string_append(gen.text, ";\n");
                 string_add_indentation(gen.text, 1);
-                string_append_formated(gen.text, "info->subtypes_.Array.size         = %d;\n", array_type->element_count);
+                string_append(gen.text, "info->subtypes_.Array.size         = ");
+                string_append_i64(gen.text, array_type->element_count);
+                string_append(gen.text, ";\n");
                 break;
             }
             case Datatype_Type::BUILT_IN: 
@@ -969,48 +1952,64 @@ void c_generator_generate(C_Generator* generator)
                 auto built_in = downcast<Datatype_Builtin>(type);
                 string_append(gen.text, "info->subtypes_.Builtin.type = (");
                 c_generator_output_type_reference(generator, types.builtin_type_enum);
-                string_append_formated(gen.text, ")%d;\n", (int)built_in->builtin_type); // Do i need plus one here?
+                string_append(gen.text, ")");
+                string_append_i64(gen.text, (int)built_in->builtin_type); // Do i need plus one here?
+                string_append(gen.text, ";\n");
                 string_add_indentation(gen.text, 1);
                 break;
             }
             case Datatype_Type::POINTER: {
                 auto pointer = downcast<Datatype_Pointer>(type);
-                string_append_formated(gen.text, "info->subtypes_.Pointer.element_type = %d;\n", pointer->element_type->type_handle.index);
+                string_append(gen.text, "info->subtypes_.Pointer.element_type = ");
+                string_append_i64(gen.text, pointer->element_type->type_handle.index);
+                string_append(gen.text, ";\n");
                 break;
             }
             case Datatype_Type::SLICE: {
                 auto slice = downcast<Datatype_Slice>(type);
-                string_append_formated(gen.text, "info->subtypes_.Slice.element_type = %d;\n", slice->element_type->type_handle.index);
+                string_append(gen.text, "info->subtypes_.Slice.element_type = ");
+                string_append_i64(gen.text, slice->element_type->type_handle.index);
+                string_append(gen.text, ";\n");
                 break;
             }
             case Datatype_Type::ENUM:
             {
                 auto enumeration = downcast<Datatype_Enum>(type);
                 auto& internal_info = type_system->types[i]->internal_info->options.enumeration;
-                string_append_formated(gen.text, "info->subtypes_.Enum.name = ");
+                string_append(gen.text, "info->subtypes_.Enum.name = ");
                 output_memory_as_new_constant(generator, (byte*)&internal_info.name, types.string->upcast(), false, 1);
                 string_append(gen.text, ";\n");
 
                 string_add_indentation(gen.text, 1);
-                string_append_formated(gen.text, "info->subtypes_.Enum.members.size = %d;\n", internal_info.members.size);
+                string_append(gen.text, "info->subtypes_.Enum.members.size = ");
+                string_append_i64(gen.text, internal_info.members.size);
+                string_append(gen.text, ";\n");
                 string_add_indentation(gen.text, 1);
                 if (internal_info.members.size > 0)
                 {
-                    string_append_formated(gen.text, "info->subtypes_.Enum.members.data = new ");
+                    string_append(gen.text, "info->subtypes_.Enum.members.data = new ");
                     c_generator_output_type_reference(generator, upcast(types.internal_enum_member_info_type)); // Check if this works
-                    string_append_formated(gen.text, "[%d];\n", internal_info.members.size);
+                    string_append(gen.text, "[");
+                    string_append_i64(gen.text, internal_info.members.size);
+                    string_append(gen.text, "];\n");
                     for (int j = 0; j < internal_info.members.size; j++) {
                         auto& member = internal_info.members.data[j];
                         string_add_indentation(gen.text, 1);
-                        string_append_formated(gen.text, "info->subtypes_.Enum.members.data[%d].name = ", j);
+                        string_append(gen.text, "info->subtypes_.Enum.members.data[");
+                        string_append_i64(gen.text, j);
+                        string_append(gen.text, "].name = ");
                         output_memory_as_new_constant(generator, (byte*)&member.name, types.string->upcast(), false, 1);
                         string_append(gen.text, ";\n");
                         string_add_indentation(gen.text, 1);
-                        string_append_formated(gen.text, "info->subtypes_.Enum.members.data[%d].value = %d;\n", j, member.value);
+                        string_append(gen.text, "info->subtypes_.Enum.members.data[");
+                        string_append_i64(gen.text, j);
+                        string_append(gen.text, "].value = ");
+                        string_append_i64(gen.text, member.value);
+                        string_append(gen.text, ";\n");
                     }
                 }
                 else {
-                    string_append_formated(gen.text, "info->subtypes_.Enum.members.data = nullptr;\n");
+                    string_append(gen.text, "info->subtypes_.Enum.members.data = nullptr;\n");
                 }
                 break;
             }
@@ -1023,25 +2022,34 @@ void c_generator_generate(C_Generator* generator)
                 // string_append_formated(gen.text, "info->subtypes_.Function.return_type = %d;\n", 
                 //     return_type.available ? return_type.value->type_handle.index : -1);
                 // string_add_indentation(gen.text, 1);
-                string_append_formated(gen.text, "info->subtypes_.Function_Pointer.has_return_type = %s;\n", return_type.available ? "true" : "false");
+                string_append(gen.text, "info->subtypes_.Function_Pointer.has_return_type = ");
+                string_append(gen.text, return_type.available ? "true" : "false");
+                string_append(gen.text, ";\n");
                 string_add_indentation(gen.text, 1);
-                string_append_formated(gen.text, "info->subtypes_.Function_Pointer.parameter_types.size = %d;\n", parameters.size);
+                string_append(gen.text, "info->subtypes_.Function_Pointer.parameter_types.size = ");
+                string_append_i64(gen.text, parameters.size);
+                string_append(gen.text, ";\n");
                 if (parameters.size != 0) 
                 {
                     string_add_indentation(gen.text, 1);
-                    string_append_formated(gen.text, "info->subtypes_.Function_Pointer.parameter_types.data = new ");
+                    string_append(gen.text, "info->subtypes_.Function_Pointer.parameter_types.data = new ");
                     c_generator_output_type_reference(generator, upcast(types.type_handle)); // Check if this works
-                    string_append_formated(gen.text, "[%d];\n", parameters.size);
+                    string_append(gen.text, "[");
+                    string_append_i64(gen.text, parameters.size);
+                    string_append(gen.text, "];\n");
                     for (int j = 0; j < parameters.size; j++) {
                         auto& param = parameters[j];
                         string_add_indentation(gen.text, 1);
-                        string_append_formated(
-                            gen.text, "info->subtypes_.Function_Pointer.parameter_types.data[%d] = %d;\n", j, param.datatype->type_handle.index);
+                        string_append(gen.text, "info->subtypes_.Function_Pointer.parameter_types.data[");
+                        string_append_i64(gen.text, j);
+                        string_append(gen.text, "] = ");
+                        string_append_i64(gen.text, param.datatype->type_handle.index);
+                        string_append(gen.text, ";\n");
                     }
                 }
                 else {
                     string_add_indentation(gen.text, 1);
-                    string_append_formated(gen.text, "info->subtypes_.Function_Pointer.parameter_types.data = nullptr;\n");
+                    string_append(gen.text, "info->subtypes_.Function_Pointer.parameter_types.data = nullptr;\n");
                 }
                 break;
             }
@@ -1051,10 +2059,14 @@ void c_generator_generate(C_Generator* generator)
                 const char* access_prefix = "info->subtypes_.Struct";
 
                 auto structure = downcast<Datatype_Struct>(type);
-                string_append_formated(gen.text, "%s.is_union = %s;\n", access_prefix, structure->upp_struct->is_union ? "true" : "false");
+                string_append(gen.text, access_prefix);
+                string_append(gen.text, ".is_union = ");
+                string_append(gen.text, structure->upp_struct->is_union ? "true" : "false");
+                string_append(gen.text, ";\n");
                 string_add_indentation(gen.text, indentation_level);
 
-                string_append_formated(gen.text, "%s.name = ", access_prefix);
+                string_append(gen.text, access_prefix);
+                string_append(gen.text, ".name = ");
                 Upp_String upp_string = upp_string_from_id(structure->name);
                 output_memory_as_new_constant(generator, (byte*)&upp_string, types.string->upcast(), false, 1);
                 string_append(gen.text, ";\n");
@@ -1064,61 +2076,100 @@ void c_generator_generate(C_Generator* generator)
                 {
                     const char* access_prefix = "info->subtypes_.Struct.tag_member";
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.name = ", access_prefix);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".name = ");
                     upp_string = upp_string_from_id(structure->tag_member.name);
                     output_memory_as_new_constant(generator, (byte*)&upp_string, types.string->upcast(), false, 1);
                     string_append(gen.text, ";\n");
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.type = %d;\n", access_prefix, structure->tag_member.datatype->type_handle.index);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".type = ");
+                    string_append_i64(gen.text, structure->tag_member.datatype->type_handle.index);
+                    string_append(gen.text, ";\n");
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.offset = %d;\n", access_prefix, structure->tag_member.offset);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".offset = ");
+                    string_append_i64(gen.text, structure->tag_member.offset);
+                    string_append(gen.text, ";\n");
                 }
 
                 // Generate members
                 string_add_indentation(gen.text, indentation_level);
-                string_append_formated(gen.text, "%s.members.size = %d;\n", access_prefix, structure->members.size);
+                string_append(gen.text, access_prefix);
+                string_append(gen.text, ".members.size = ");
+                string_append_i64(gen.text, structure->members.size);
+                string_append(gen.text, ";\n");
                 if (structure->members.size != 0)
                 {
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.members.data = new ", access_prefix);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".members.data = new ");
                     c_generator_output_type_reference(generator, upcast(types.internal_member_info_type));
-                    string_append_formated(gen.text, "[%d];\n", structure->members.size);
+                    string_append(gen.text, "[");
+                    string_append_i64(gen.text, structure->members.size);
+                    string_append(gen.text, "];\n");
                     for (int i = 0; i < structure->members.size; i++) {
                         auto& member = structure->members[i];
                         string_add_indentation(gen.text, indentation_level);
-                        string_append_formated(gen.text, "%s.members.data[%d].name = ", access_prefix, i);
+                        string_append(gen.text, access_prefix);
+                        string_append(gen.text, ".members.data[");
+                        string_append_i64(gen.text, i);
+                        string_append(gen.text, "].name = ");
                         upp_string = upp_string_from_id(member.name);
                         output_memory_as_new_constant(generator, (byte*)&upp_string, types.string->upcast(), false, 1);
                         string_append(gen.text, ";\n");
 
                         string_add_indentation(gen.text, indentation_level);
-                        string_append_formated(gen.text, "%s.members.data[%d].type = %d;\n", access_prefix, i, member.datatype->type_handle.index);
+                        string_append(gen.text, access_prefix);
+                        string_append(gen.text, ".members.data[");
+                        string_append_i64(gen.text, i);
+                        string_append(gen.text, "].type = ");
+                        string_append_i64(gen.text, member.datatype->type_handle.index);
+                        string_append(gen.text, ";\n");
                         string_add_indentation(gen.text, indentation_level);
-                        string_append_formated(gen.text, "%s.members.data[%d].offset = %d;\n", access_prefix, i, member.offset);
+                        string_append(gen.text, access_prefix);
+                        string_append(gen.text, ".members.data[");
+                        string_append_i64(gen.text, i);
+                        string_append(gen.text, "].offset = ");
+                        string_append_i64(gen.text, member.offset);
+                        string_append(gen.text, ";\n");
                     }
                 }
                 else { // Extern c struct i guess?
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.members.data = nullptr;\n", access_prefix);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".members.data = nullptr;\n");
                 }
 
                 // Generate subtypes
                 string_add_indentation(gen.text, indentation_level);
-                string_append_formated(gen.text, "%s.subtypes.size = %d;\n", access_prefix, structure->subtypes.size);
+                string_append(gen.text, access_prefix);
+                string_append(gen.text, ".subtypes.size = ");
+                string_append_i64(gen.text, structure->subtypes.size);
+                string_append(gen.text, ";\n");
                 if (structure->subtypes.size > 0)
                 {
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.subtypes.data = new ", access_prefix);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".subtypes.data = new ");
                     c_generator_output_type_reference(generator, upcast(types.type_handle));
-                    string_append_formated(gen.text, "[%d];\n", structure->subtypes.size);
+                    string_append(gen.text, "[");
+                    string_append_i64(gen.text, structure->subtypes.size);
+                    string_append(gen.text, "];\n");
                     for (int i = 0; i < structure->subtypes.size; i++) {
                         string_add_indentation(gen.text, indentation_level);
-                        string_append_formated(gen.text, "%s.subtypes.data[%d] = %d;\n", access_prefix, i, structure->subtypes[i]->base.type_handle.index);
+                        string_append(gen.text, access_prefix);
+                        string_append(gen.text, ".subtypes.data[");
+                        string_append_i64(gen.text, i);
+                        string_append(gen.text, "] = ");
+                        string_append_i64(gen.text, structure->subtypes[i]->base.type_handle.index);
+                        string_append(gen.text, ";\n");
                     }
                 }
                 else {
                     string_add_indentation(gen.text, indentation_level);
-                    string_append_formated(gen.text, "%s.subtypes.data = nullptr;\n", access_prefix);
+                    string_append(gen.text, access_prefix);
+                    string_append(gen.text, ".subtypes.data = nullptr;\n");
                 }
 
                 break;
@@ -1188,39 +2239,54 @@ void c_generator_generate(C_Generator* generator)
     {
         string_append(
             &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION],
-            "\nint main(int argc, char** argv) {\n    inititalize_type_infos_global_(); \n    upp_entry_();\n"
+            "\nint main(int argc, char** argv) {\n"
         );
+        if (enable_c_profiling) {
+            string_append(&gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION], "    atexit(upp_profile_dump_);\n");
+        }
+        string_append(&gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION], "    inititalize_type_infos_global_(); \n    upp_entry_();\n");
         if (ADD_WAIT_BEFORE_EXIT) {
             string_append(&gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION], "    printf(\"\\n\\nEND OF PROGRAM\");\n");
             string_append(&gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION], "    std::cin.ignore();\n");
         }
         string_append(&gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION], "    return 0;\n}\n\n");
 
-        // Combine sections into one program
-        string_append_formated(&source_code, "/* INTRODUCTION\n----------------*/\n");
+        // Combine sections into one program, the 1024 cover the section headers and introduction
+        {
+            int section_size = 1024;
+            for (int i = 0; i < (int)Generator_Section::MAX_ENUM_VALUE; i++) {
+                section_size += gen.sections[i].size;
+            }
+            string_reserve_append(&source_code, section_size);
+        }
+        string_append(&source_code, "/* INTRODUCTION\n----------------*/\n");
         string_append(&source_code, "#pragma once\n#include <cstdlib>\n#include \"../hardcoded/hardcoded_functions.h\"\n#include \"../hardcoded/datatypes.h\"\n\n");
         string_append(&source_code, "#include <iostream>\n#include <cstdio>\n");
-        // string_append_formated(&source_code, "/* EXTERN HEADERS\n----------------*/\n");
+        // string_append(&source_code, "/* EXTERN HEADERS\n----------------*/\n");
         // string_append_string(&source_code, &section_extern_includes);
-        // string_append_formated(&source_code, "\n/* STRING_DATA\n----------------*/\n");
+        // string_append(&source_code, "\n/* STRING_DATA\n----------------*/\n");
         // string_append_string(&source_code, &generator->section_string_data);
-        string_append_formated(&source_code, "\n/* ENUMS\n----------------*/\n");
+        string_append(&source_code, "\n/* ENUMS\n----------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::ENUM_DECLARATIONS]);
-        string_append_formated(&source_code, "\n/* STRUCT_PROTOTYPES\n----------------*/\n");
+        string_append(&source_code, "\n/* STRUCT_PROTOTYPES\n----------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::STRUCT_PROTOTYPES]);
-        string_append_formated(&source_code, "\n/* TYPE_DECLARATIONS\n------------------*/\n");
+        string_append(&source_code, "\n/* TYPE_DECLARATIONS\n------------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::TYPE_DECLARATIONS]);
-        string_append_formated(&source_code, "\n/* STRUCT_IMPLEMENTATIONS\n----------------*/\n");
+        string_append(&source_code, "\n/* STRUCT_IMPLEMENTATIONS\n----------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::STRUCT_AND_ARRAY_DECLARATIONS]);
-        string_append_formated(&source_code, "\n/* ARRAY_HOLDER_SECTION\n----------------*/\n");
+        string_append(&source_code, "\n/* ARRAY_HOLDER_SECTION\n----------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::CONSTANT_ARRAY_HOLDERS]);
-        string_append_formated(&source_code, "\n/* FUNCTION PROTOTYPES\n------------------*/\n"); // Need to be declared before constants for function pointers constants to work
+        string_append(&source_code, "\n/* FUNCTION PROTOTYPES\n------------------*/\n"); // Need to be declared before constants for function pointers constants to work
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::FUNCTION_PROTOTYPES]);
-        string_append_formated(&source_code, "\n/* CONSTANTS\n------------------*/\n");
+        string_append(&source_code, "\n/* CONSTANTS\n------------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::CONSTANTS]);
-        string_append_formated(&source_code, "\n/* GLOBALS\n------------------*/\n");
+        string_append(&source_code, "\n/* GLOBALS\n------------------*/\n");
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::GLOBALS]);
-        string_append_formated(&source_code, "\n/* FUNCTIONS\n------------------*/\n");
+        if (enable_c_profiling) {
+            string_append(&source_code, "\n/* PROFILING\n------------------*/\n");
+            c_generator_append_profiling_runtime(generator, &source_code);
+        }
+        string_append(&source_code, "\n/* FUNCTIONS\n------------------*/\n");
         function_implementation_char_index = source_code.size;
         string_append_string(&source_code, &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION]);
     }
@@ -1314,12 +2380,311 @@ void c_generator_generate(C_Generator* generator)
             dynamic_array_push_back(&gen.program_translation.line_infos, line_info);
         }
     }
+    compilation_data->code_gen_c_lines = gen.program_translation.line_offset + gen.program_translation.line_infos.size;
 }
 
 C_Program_Translation* c_generator_get_translation(C_Generator* generator) {
     return &generator->program_translation;
 }
 
+// Hot functions need at least this many calls and this share of all calls
+const i64 C_PROFILE_HOT_MIN_CALLS = 1000;
+const i64 C_PROFILE_HOT_CALL_PERMILLE = 10;
+
+struct C_Profile_Entry
+{
+    C_Profile_Slot slot;
+    i64 count;
+    i64 inlined_count; // Calls which were inlined into callers, only for function entries
+    i64 cycles;
+};
+
+static AST::Node* c_profile_function_definition_node(Upp_Function* function)
+{
+    auto& origin = function->origin;
+    switch (origin.type)
+    {
+    case Function_Origin_Type::TOPLEVEL: return AST::upcast(origin.options.toplevel.header_workload->function_node); // Base definition for instances
+    case Function_Origin_Type::INFERRED: return AST::upcast(origin.options.inferred_expr);
+    case Function_Origin_Type::BAKE: return AST::upcast(origin.options.bake_expr);
+    case Function_Origin_Type::EXTERN: return AST::upcast(origin.options.extern_import_workload->import_node);
+    default: break;
+    }
+    return nullptr;
+}
+
+struct C_Profile_Definition
+{
+    AST::Node* node;
+    Compilation_Unit* unit;
+    String* name;
+    Text_Index position;
+};
+
+// Numbers definitions with the same name in the same unit in source order, so keys don't change when unrelated code above is edited
+static Hashtable<AST::Node*, int> c_profile_create_definition_ordinals(Compilation_Data* compilation_data)
+{
+    Dynamic_Array<C_Profile_Definition> definitions = dynamic_array_create<C_Profile_Definition>();
+    SCOPE_EXIT(dynamic_array_destroy(&definitions));
+    Hashtable<AST::Node*, int> ordinals = hashtable_create_pointer_empty<AST::Node*, int>(64);
+
+    auto& functions = compilation_data->functions;
+    for (int i = 0; i < functions.size; i++)
+    {
+        Upp_Function* function = functions[i];
+        AST::Node* node = c_profile_function_definition_node(function);
+        if (node == nullptr || hashtable_find_element(&ordinals, node) != nullptr) continue;
+        hashtable_insert_element(&ordinals, node, 0);
+
+        C_Profile_Definition definition;
+        definition.node = node;
+        definition.unit = ast_node_to_compilation_unit(compilation_data, node);
+        definition.name = function->name;
+        definition.position = ast_node_get_ranges(compilation_data, node).range.start;
+        dynamic_array_push_back(&definitions, definition);
+    }
+
+    dynamic_array_sort(&definitions, [](const C_Profile_Definition& a, const C_Profile_Definition& b) -> bool {
+        if (a.unit != b.unit) return a.unit < b.unit;
+        if (a.name != b.name) return a.name < b.name; // Names are from the identifier pool
+        if (a.position.line != b.position.line) return a.position.line < b.position.line;
+        return a.position.character < b.position.character;
+    });
+    for (int i = 0; i < definitions.size; i++)
+    {
+        int ordinal = 0;
+        if (i > 0 && definitions[i - 1].unit == definitions[i].unit && definitions[i - 1].name == definitions[i].name) {
+            ordinal = *hashtable_find_element(&ordinals, definitions[i - 1].node) + 1;
+        }
+        *hashtable_find_element(&ordinals, definitions[i].node) = ordinal;
+    }
+    return ordinals;
+}
+
+// Function keys are formated as "file name#ordinal(instance values)", which is also the key for c_profile_mark_hot_functions
+static void c_profile_append_function_key(String* string, Compilation_Data* compilation_data, Upp_Function* function, Hashtable<AST::Node*, int>* ordinals)
+{
+    AST::Node* node = c_profile_function_definition_node(function);
+    Compilation_Unit* unit = node == nullptr ? nullptr : ast_node_to_compilation_unit(compilation_data, node);
+    string_append(string, unit == nullptr ? "?" : unit->filepath.characters);
+    string_append(string, " ");
+    string_append(string, function->name->characters);
+    if (node != nullptr) {
+        string_append(string, "#");
+        string_append_i64(string, *hashtable_find_element(ordinals, node));
+    }
+
+    // Instances of the same definition are differentiated by their pattern values, like polymorphic struct names
+    if (function->poly_type != Poly_Type::INSTANCE) {
+        return;
+    }
+    Poly_Instance* instance = function->options.instance;
+    String values = string_create();
+    SCOPE_EXIT(string_destroy(&values));
+    for (int i = 0; i < instance->header->pattern_variables.size; i++)
+    {
+        auto& variable_state = instance->variable_states[i];
+        switch (variable_state.type)
+        {
+        case Pattern_Variable_State_Type::SET: {
+            auto& constant = variable_state.options.value;
+            datatype_append_value_to_string(
+                constant.type, &values, constant.memory, datatype_value_format_single_line(),
+                0, Memory_Source(nullptr), Memory_Source(nullptr), compilation_data->type_system
+            );
+            break;
+        }
+        case Pattern_Variable_State_Type::UNSET: string_append(&values, "_"); break;
+        case Pattern_Variable_State_Type::PATTERN: datatype_append_to_string(variable_state.options.pattern_type, &values, compilation_data->type_system); break;
+        default: panic("");
+        }
+        if (i != instance->header->pattern_variables.size - 1) {
+            string_append(&values, ", ");
+        }
+    }
+    string_style_remove_codes(&values);
+    string_append(string, "(");
+    string_append_string(string, &values);
+    string_append(string, ")");
+}
+
+// Lines are 1-based, so they can be used as file:line links
+static void c_profile_append_location(String* string, Compilation_Data* compilation_data, AST::Node* node)
+{
+    Compilation_Unit* unit = ast_node_to_compilation_unit(compilation_data, node);
+    string_append(string, unit->filepath.characters);
+    string_append(string, ":");
+    string_append_i64(string, ast_node_get_ranges(compilation_data, node).range.start.line + 1);
+}
+
+bool c_generator_write_profile_report(C_Generator* generator, const char* dump_filepath, const char* report_filepath)
+{
+    Compilation_Data* compilation_data = generator->compilation_data;
+    auto& slots = generator->program_translation.profile_slots;
+    Optional<String> text = file_io_load_text_file(dump_filepath);
+    SCOPE_EXIT(file_io_unload_text_file(&text));
+    if (!text.available) {
+        return false;
+    }
+
+    // Function and inlined-call slots of the same function are merged into one entry
+    Dynamic_Array<C_Profile_Entry> functions = dynamic_array_create<C_Profile_Entry>();
+    SCOPE_EXIT(dynamic_array_destroy(&functions));
+    Hashtable<Upp_Function*, int> function_entry_indices = hashtable_create_pointer_empty<Upp_Function*, int>(64);
+    SCOPE_EXIT(hashtable_destroy(&function_entry_indices));
+    Dynamic_Array<C_Profile_Entry> loops = dynamic_array_create<C_Profile_Entry>();
+    SCOPE_EXIT(dynamic_array_destroy(&loops));
+
+    // Dump format: slot_index count cycles
+    Array<String> lines = string_split(text.value, '\n');
+    SCOPE_EXIT(string_split_destroy(lines));
+    for (int i = 0; i < lines.size; i++)
+    {
+        String line = lines[i];
+        string_remove_trailing_whitespace(&line);
+        Array<String> parts = string_split(line, ' ');
+        SCOPE_EXIT(string_split_destroy(parts));
+        if (parts.size != 3) continue;
+
+        Optional<int> slot_index = string_parse_int(&parts[0]);
+        Optional<i64> count = string_parse_i64(&parts[1]);
+        Optional<i64> cycles = string_parse_i64(&parts[2]);
+        if (!slot_index.available || !count.available || !cycles.available) continue;
+        if (slot_index.value < 0 || slot_index.value >= slots.size || count.value == 0) continue;
+
+        C_Profile_Slot& slot = slots[slot_index.value];
+        if (slot.loop_statement != nullptr) {
+            C_Profile_Entry entry;
+            entry.slot = slot;
+            entry.count = count.value;
+            entry.inlined_count = 0;
+            entry.cycles = cycles.value;
+            dynamic_array_push_back(&loops, entry);
+            continue;
+        }
+
+        int* entry_index = hashtable_find_element(&function_entry_indices, slot.function);
+        if (entry_index == nullptr) {
+            C_Profile_Entry entry;
+            entry.slot = slot;
+            entry.slot.is_inlined_call = false;
+            entry.count = 0;
+            entry.inlined_count = 0;
+            entry.cycles = 0;
+            dynamic_array_push_back(&functions, entry);
+            hashtable_insert_element(&function_entry_indices, slot.function, functions.size - 1);
+            entry_index = hashtable_find_element(&function_entry_indices, slot.function);
+        }
+        C_Profile_Entry& entry = functions[*entry_index];
+        if (slot.is_inlined_call) {
+            entry.inlined_count += count.value;
+        }
+        else {
+            entry.count += count.value;
+            entry.cycles += cycles.value;
+        }
+    }
+    dynamic_array_sort(&functions, [](const C_Profile_Entry& a, const C_Profile_Entry& b) -> bool { 
+        if (a.cycles != b.cycles) return a.cycles > b.cycles;
+        return a.inlined_count > b.inlined_count;
+    });
+    dynamic_array_sort(&loops, [](const C_Profile_Entry& a, const C_Profile_Entry& b) -> bool { return a.count > b.count; });
+
+    Hashtable<AST::Node*, int> ordinals = c_profile_create_definition_ordinals(compilation_data);
+    SCOPE_EXIT(hashtable_destroy(&ordinals));
+    String content = string_create(1024);
+    SCOPE_EXIT(string_destroy(&content));
+    string_append(&content, "# Functions: calls inlined_calls cycles cycles_per_call file name#ordinal(instance) (cycles are inclusive, inlined calls are counted at the call site)\n");
+    for (int i = 0; i < functions.size; i++) {
+        C_Profile_Entry& entry = functions[i];
+        string_append_i64(&content, entry.count);
+        string_append(&content, " ");
+        string_append_i64(&content, entry.inlined_count);
+        string_append(&content, " ");
+        string_append_i64(&content, entry.cycles);
+        string_append(&content, " ");
+        string_append_i64(&content, entry.count == 0 ? 0 : entry.cycles / entry.count);
+        string_append(&content, " ");
+        c_profile_append_function_key(&content, compilation_data, entry.slot.function, &ordinals);
+        string_append(&content, "\n");
+    }
+    string_append(&content, "\n# Loops: iterations file:line function\n");
+    for (int i = 0; i < loops.size; i++) {
+        C_Profile_Entry& entry = loops[i];
+        string_append_i64(&content, entry.count);
+        string_append(&content, " ");
+        c_profile_append_location(&content, compilation_data, &entry.slot.loop_statement->base);
+        string_append(&content, " ");
+        c_profile_append_function_key(&content, compilation_data, entry.slot.function, &ordinals);
+        string_append(&content, "\n");
+    }
+
+    return file_io_write_file(report_filepath, array_create_static_as_bytes(content.characters, content.size));
+}
+
+void c_profile_mark_hot_functions(Compilation_Data* compilation_data, const char* report_filepath)
+{
+    Optional<String> text = file_io_load_text_file(report_filepath);
+    SCOPE_EXIT(file_io_unload_text_file(&text));
+    if (!text.available) {
+        return;
+    }
+
+    // Keys point into the loaded text, values are calls including inlined calls
+    Hashtable<String, i64> call_counts = hashtable_create_empty<String, i64>(64, hash_string, string_equals);
+    SCOPE_EXIT(hashtable_destroy(&call_counts));
+    i64 total_calls = 0;
+    Array<String> lines = string_split(text.value, '\n');
+    SCOPE_EXIT(string_split_destroy(lines));
+    for (int i = 0; i < lines.size; i++)
+    {
+        String line = lines[i];
+        string_remove_trailing_whitespace(&line);
+        if (line.size == 0) continue;
+        if (line.characters[0] == '#') {
+            // Only the function section is relevant
+            if (i != 0) break;
+            continue;
+        }
+
+        // Key starts after the fourth space (calls inlined_calls cycles cycles_per_call)
+        int space_indices[2] = { -1, -1 };
+        int key_start = 0;
+        for (int space_count = 0; key_start < line.size && space_count < 4; key_start++) {
+            if (line.characters[key_start] == ' ') {
+                if (space_count < 2) {
+                    space_indices[space_count] = key_start;
+                }
+                space_count += 1;
+            }
+        }
+        if (space_indices[1] == -1 || key_start >= line.size) continue;
+        String calls_string = string_create_substring_static(&line, 0, space_indices[0]);
+        String inlined_string = string_create_substring_static(&line, space_indices[0] + 1, space_indices[1]);
+        Optional<i64> calls = string_parse_i64(&calls_string);
+        Optional<i64> inlined_calls = string_parse_i64(&inlined_string);
+        if (!calls.available || !inlined_calls.available) continue;
+
+        // Inlined calls count as well, otherwise the decision flips once a hot function gets inlined
+        hashtable_insert_element(&call_counts, string_create_substring_static(&line, key_start, line.size), calls.value + inlined_calls.value);
+        total_calls += calls.value + inlined_calls.value;
+    }
+
+    Hashtable<AST::Node*, int> ordinals = c_profile_create_definition_ordinals(compilation_data);
+    SCOPE_EXIT(hashtable_destroy(&ordinals));
+    String key = string_create();
+    SCOPE_EXIT(string_destroy(&key));
+    auto& functions = compilation_data->functions;
+    for (int i = 0; i < functions.size; i++)
+    {
+        Upp_Function* function = functions[i];
+        string_reset(&key);
+        c_profile_append_function_key(&key, compilation_data, function, &ordinals);
+        i64* calls = hashtable_find_element(&call_counts, key);
+        function->is_profile_hot = calls != nullptr && *calls >= C_PROFILE_HOT_MIN_CALLS && *calls * 1000 >= total_calls * C_PROFILE_HOT_CALL_PERMILLE;
+    }
+}
+
 // Outputs "{" + the struct content on indentation level + 1 and "}"
 void output_struct_content_block_recursive(C_Generator* generator, Datatype_Struct* structure, byte* struct_start_memory, int current_indentation_level)
 {
@@ -1334,7 +2699,9 @@ void output_struct_content_block_recursive(C_Generator* generator, Datatype_Stru
         byte* member_memory = struct_start_memory + member.offset;
 
         // Generate designator
-        string_append_formated(gen.text, ".%s = ", member.name->characters);
+        string_append(gen.text, ".");
+        string_append(gen.text, member.name->characters);
+        string_append(gen.text, " = ");
         output_memory_as_new_constant(generator, member_memory, member.datatype, false, block_indentation);
         if (i != members.size - 1) {
             string_append(gen.text, ", \n");
@@ -1347,7 +2714,9 @@ void output_struct_content_block_recursive(C_Generator* generator, Datatype_Stru
         int subtype_index = (*(int*)(struct_start_memory + structure->tag_member.offset)) - 1;
         assert(subtype_index >= 0 && subtype_index < structure->subtypes.size, "");
         Datatype_Struct* child_structure = structure->subtypes[subtype_index];
-        string_append_formated(gen.text, ".subtypes_ = { .%s = ", child_structure->name->characters);
+        string_append(gen.text, ".subtypes_ = { .");
+        string_append(gen.text, child_structure->name->characters);
+        string_append(gen.text, " = ");
         output_struct_content_block_recursive(generator, child_structure, struct_start_memory, block_indentation);
         string_append(gen.text, "}, \n");
 
@@ -1390,6 +2759,10 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
             string_append(gen.text, access_name->characters);
             return;
         }
+        if (gen.is_worker) {
+            gen.function_output->missing_translation = true;
+            return;
+        }
     }
 
     // Create access
@@ -1413,9 +2786,11 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
             gen.text = &constant_string;
 
             c_generator_output_type_reference(generator, base_type);
-            string_append_formated(gen.text, " const_%d = ", gen.name_counter);
-            string_append_formated(backup_text, "const_%d", gen.name_counter);
-            gen.name_counter += 1;
+            string_append(gen.text, " const_");
+            string_append_i64(gen.text, constant.constant_index);
+            string_append(gen.text, " = ");
+            string_append(backup_text, "const_");
+            string_append_i64(backup_text, constant.constant_index);
         }
 
         // Generate constant access
@@ -1434,7 +2809,7 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
                 break;
             }
             case Builtin_Type::TYPE_HANDLE: {
-                string_append_formated(gen.text, "%u", *(u32*)base_memory);
+                string_append_u64(gen.text, *(u32*)base_memory);
                 break;
             }
             case Builtin_Type::ANY: 
@@ -1442,14 +2817,16 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
                 // Any in constant-pool only works
                 Upp_Any* any = (Upp_Any*)base_memory;
                 assert(any->data == nullptr, "Any in constnat pool cannot work with pointers");
-                string_append_formated(gen.text, "upp_any_make_(nullptr, %u)", any->type.index);
+                string_append(gen.text, "upp_any_make_(nullptr, ");
+                string_append_u64(gen.text, any->type.index);
+                string_append(gen.text, ")");
                 break;
             }
             case Builtin_Type::STRING: 
             {
                 // Note: Maybe we need something smarter in the future to handle multi-line strings 
                 Upp_String string = *(Upp_String*)base_memory;
-                string_append_formated(gen.text, "{.data = (void*) \"");
+                string_append(gen.text, "{.data = (void*) \"");
 
                 // Note: I need to escape escape sequences, so this is what i'm doing now...
                 String escaped = string_create(16);
@@ -1469,7 +2846,9 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
                 }
 
                 string_append(gen.text, escaped.characters);
-                string_append_formated(gen.text, "\", .size = %d }", string.size);
+                string_append(gen.text, "\", .size = ");
+                string_append_i64(gen.text, string.size);
+                string_append(gen.text, " }");
                 break;
             }
             case Builtin_Type::C_STRING: {
@@ -1478,11 +2857,13 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
             }
             case Builtin_Type::C_CHAR: {
                 u8* value = (u8*)base_memory;
-                string_append_formated(gen.text, "((char)%d)", *value);
+                string_append(gen.text, "((char)");
+                string_append_i64(gen.text, *value);
+                string_append(gen.text, ")");
                 break;
             }
             case Builtin_Type::CODE_POINT: {
-                string_append_formated(gen.text, "%u", *(u32*)base_memory);
+                string_append_u64(gen.text, *(u32*)base_memory);
                 break;
             }
             default: panic("");
@@ -1495,18 +2876,18 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
             byte* memory = base_memory;
             switch (primitive->primitive_type)
             {
-            case Primitive_Type::INT:  string_append_formated(gen.text, "%lld", (*(i64*)memory)); break;
-            case Primitive_Type::UINT: string_append_formated(gen.text, "%llu", (*(u64*)memory)); break;
-            case Primitive_Type::I8:  string_append_formated(gen.text, "%d", (int)(*(i8*)memory)); break;
-            case Primitive_Type::I16: string_append_formated(gen.text, "%d", (int)(*(i16*)memory)); break;
-            case Primitive_Type::I32: string_append_formated(gen.text, "%d", (int)(*(i32*)memory)); break;
-            case Primitive_Type::I64: string_append_formated(gen.text, "%lld", (i64)(*(i64*)memory)); break;
-            case Primitive_Type::U8:  string_append_formated(gen.text, "%u", (u32)(*(u8*)memory)); break;
-            case Primitive_Type::U16: string_append_formated(gen.text, "%u", (u32)(*(u16*)memory)); break;
-            case Primitive_Type::U32: string_append_formated(gen.text, "%u", (u32)(*(u32*)memory)); break;
-            case Primitive_Type::U64: string_append_formated(gen.text, "%llu", (u64)(*(u64*)memory)); break;
-            case Primitive_Type::F32: string_append_formated(gen.text, "%f", (double)(*(float*)memory)); break;
-            case Primitive_Type::F64: string_append_formated(gen.text, "%f", (double)(*(double*)memory)); break;
+            case Primitive_Type::INT:  string_append_i64(gen.text, (*(i64*)memory)); break;
+            case Primitive_Type::UINT: string_append_u64(gen.text, (*(u64*)memory)); break;
+            case Primitive_Type::I8:  string_append_i64(gen.text, (int)(*(i8*)memory)); break;
+            case Primitive_Type::I16: string_append_i64(gen.text, (int)(*(i16*)memory)); break;
+            case Primitive_Type::I32: string_append_i64(gen.text, (int)(*(i32*)memory)); break;
+            case Primitive_Type::I64: string_append_i64(gen.text, (i64)(*(i64*)memory)); break;
+            case Primitive_Type::U8:  string_append_u64(gen.text, (u32)(*(u8*)memory)); break;
+            case Primitive_Type::U16: string_append_u64(gen.text, (u32)(*(u16*)memory)); break;
+            case Primitive_Type::U32: string_append_u64(gen.text, (u32)(*(u32*)memory)); break;
+            case Primitive_Type::U64: string_append_u64(gen.text, (u64)(*(u64*)memory)); break;
+            case Primitive_Type::F32: string_append_f64(gen.text, (double)(*(float*)memory)); break;
+            case Primitive_Type::F64: string_append_f64(gen.text, (double)(*(double*)memory)); break;
             case Primitive_Type::BOOLEAN: string_append(gen.text, ((*(bool*)memory) ? "true" : "false")); break;
             default: panic("What");
             }
@@ -1531,7 +2912,8 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
 
             auto member = enum_type->members[member_index];
             c_generator_output_type_reference(generator, type);
-            string_append_formated(gen.text, "::%s", member.name->characters);
+            string_append(gen.text, "::");
+            string_append(gen.text, member.name->characters);
             break;
         }
         case Datatype_Type::FUNCTION_POINTER:
@@ -1548,7 +2930,9 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
                 function_translation.options.function = gen.compilation_data->functions[function_index - 1];
                 String* fn_name = hashtable_find_element(&gen.program_translation.name_mapping, function_translation);
                 assert(fn_name != 0, "");
-                string_append_formated(gen.text, "(&%s)", fn_name->characters);
+                string_append(gen.text, "(&");
+                string_append(gen.text, fn_name->characters);
+                string_append(gen.text, ")");
             }
             break;
         }
@@ -1565,7 +2949,7 @@ void c_generator_output_constant_access(C_Generator* generator, Upp_Constant& co
             Datatype* element_type = downcast<Datatype_Slice>(type)->element_type;
             Upp_Slice_Base slice = *(Upp_Slice_Base*)base_memory;
             assert(slice.size == 0 && slice.data == nullptr, "");
-            string_append_formated(gen.text, "{.data = nullptr, .size = 0}");
+            string_append(gen.text, "{.data = nullptr, .size = 0}");
             break;
         }
         case Datatype_Type::ARRAY:
@@ -1640,12 +3024,17 @@ void c_generator_output_parameter_access(C_Generator* generator, Upp_Function* f
             string_append(gen.text, name->characters);
             return;
         }
+        if (gen.is_worker) {
+            gen.function_output->missing_translation = true;
+            return;
+        }
     }
 
     String new_name = string_create(16);
     auto& param = function->signature->parameters[parameter_index];
-    string_append_formated(&new_name, "%s_%d", param.name->characters, gen.name_counter);
-    gen.name_counter++;
+    string_append(&new_name, param.name->characters);
+    string_append(&new_name, "_p");
+    string_append_i64(&new_name, parameter_index);
 
     hashtable_insert_element(&gen.program_translation.name_mapping, translation, new_name);
     string_append(gen.text, new_name.characters);
@@ -1667,6 +3056,10 @@ void c_generator_output_global_access(C_Generator* generator, int global_index)
             string_append(gen.text, name->characters);
             return;
         }
+        if (gen.is_worker) {
+            gen.function_output->missing_translation = true;
+            return;
+        }
     }
 
     String new_name = string_create(16);
@@ -1675,13 +3068,15 @@ void c_generator_output_global_access(C_Generator* generator, int global_index)
     }
     else {
         if (global->symbol != 0) {
-            string_append_formated(&new_name, "%s_g%d", global->symbol->id->characters, gen.name_counter);
+            string_append(&new_name, global->symbol->id->characters);
+            string_append(&new_name, "_g");
+            string_append_i64(&new_name, global_index);
         }
         else {
-            string_append_formated(&new_name, "global_%d", gen.name_counter);
+            string_append(&new_name, "global_");
+            string_append_i64(&new_name, global_index);
         }
     }
-    gen.name_counter++;
 
     hashtable_insert_element(&gen.program_translation.name_mapping, translation, new_name);
     string_append(gen.text, new_name.characters);
@@ -1696,12 +3091,15 @@ void c_generator_output_data_access(C_Generator* generator, IR_Data_Access* acce
     {
     case IR_Data_Access_Type::REGISTER:
     {
+        // Registers are local to the function, so names are numbered per function
+        assert(gen.function_output != nullptr, "Registers are only accessed in function bodies");
+        auto& register_names = gen.function_output->register_names;
         C_Translation translation;
         translation.type = C_Translation_Type::REGISTER;
         translation.options.register_translation.code_block = access->option.register_access.definition_block;
         translation.options.register_translation.index = access->option.register_access.index;
         {
-            String* name = hashtable_find_element(&gen.program_translation.name_mapping, translation);
+            String* name = hashtable_find_element(&register_names, translation);
             if (name != 0) {
                 string_append(gen.text, name->characters);
                 break;
@@ -1716,10 +3114,10 @@ void c_generator_output_data_access(C_Generator* generator, IR_Data_Access* acce
         else {
             string_append(&new_name, "tmp");
         }
-        string_append_formated(&new_name, "%_%d", gen.name_counter);
-        gen.name_counter++;
+        string_append(&new_name, "_r");
+        string_append_i64(&new_name, register_names.element_count);
 
-        hashtable_insert_element(&gen.program_translation.name_mapping, translation, new_name);
+        hashtable_insert_element(&register_names, translation, new_name);
         string_append(gen.text, new_name.characters);
         break;
     }
@@ -1790,12 +3188,14 @@ void c_generator_output_data_access(C_Generator* generator, IR_Data_Access* acce
                 for (int j = 0; j < deref_count; j++) {
                     iter = iter->parent;
                 }
-                string_append_formated(gen.text, ".subtypes_.%s", iter->name->characters);
+                string_append(gen.text, ".subtypes_.");
+                string_append(gen.text, iter->name->characters);
             }
         }
 
         // Append member access
-        string_append_formated(gen.text, ".%s", member.name->characters);
+        string_append(gen.text, ".");
+        string_append(gen.text, member.name->characters);
 
         break;
     }
@@ -1821,9 +3221,9 @@ void c_generator_output_data_access(C_Generator* generator, IR_Data_Access* acce
     case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST:
     {
         auto& infos = access->option.non_destructive_cast;
-        string_append_formated(gen.text, "(");
+        string_append(gen.text, "(");
         c_generator_output_type_reference(generator, access->datatype);
-        string_append_formated(gen.text, ") ");
+        string_append(gen.text, ") ");
         c_generator_output_data_access(generator, infos.value_access, add_parenthesis_on_pointer_ops);
         break;
     }
@@ -1845,9 +3245,9 @@ void c_generator_output_cast_if_necessary(C_Generator* generator, Datatype* dst_
 
     if (types_are_equal(dst_type, src_type)) return;
 
-    string_append_formated(gen.text, "(");
+    string_append(gen.text, "(");
     c_generator_output_type_reference(generator, dst_type);
-    string_append_formated(gen.text, ") ");
+    string_append(gen.text, ") ");
 }
 
 // define_registers_in_outer_scope is used for e.g. the while loop condition-block
@@ -1861,7 +3261,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
         if (!define_registers_in_outer_scope)
         {
             string_add_indentation(gen.text, indentation_level);
-            string_append_formated(gen.text, "{\n");
+            string_append(gen.text, "{\n");
         }
         for (int i = 0; i < code_block->registers.size; i++)
         {
@@ -1876,40 +3276,68 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
             }
             Datatype* sig = code_block->registers[i].type;
             c_generator_output_type_reference(generator, sig);
-            string_append_formated(gen.text, " ");
+            string_append(gen.text, " ");
 
             IR_Data_Access access;
             access.type = IR_Data_Access_Type::REGISTER;
             access.option.register_access.definition_block = code_block;
             access.option.register_access.index = i;
             c_generator_output_data_access(generator, &access);
-            string_append_formated(gen.text, ";\n");
+            string_append(gen.text, ";\n");
         }
         if (define_registers_in_outer_scope) {
             string_add_indentation(gen.text, indentation_level);
-            string_append_formated(gen.text, "{\n");
+            string_append(gen.text, "{\n");
         }
     }
 
+    // Function profile scope, counts the call and adds cycles on every return path
+    if (enable_c_profiling && code_block->parent_block == nullptr)
+    {
+        assert(!gen.is_worker, "Profiling code is generated serially, as slot indices are shared");
+        C_Profile_Slot slot;
+        slot.function = code_block->function;
+        slot.loop_statement = nullptr;
+        slot.is_inlined_call = false;
+        dynamic_array_push_back(&gen.program_translation.profile_slots, slot);
+        string_add_indentation(gen.text, indentation_level + 1);
+        string_append(gen.text, "Upp_Profile_Scope_ upp_profile_scope_(");
+        string_append_i64(gen.text, gen.program_translation.profile_slots.size - 1);
+        string_append(gen.text, ");\n");
+    }
+    // Inlined calls are counted at the call site, cycles stay with the caller
+    else if (enable_c_profiling && code_block->inlined_function != nullptr)
+    {
+        C_Profile_Slot slot;
+        slot.function = code_block->inlined_function;
+        slot.loop_statement = nullptr;
+        slot.is_inlined_call = true;
+        dynamic_array_push_back(&gen.program_translation.profile_slots, slot);
+        string_add_indentation(gen.text, indentation_level + 1);
+        string_append(gen.text, "upp_profile_slots_[");
+        string_append_i64(gen.text, gen.program_translation.profile_slots.size - 1);
+        string_append(gen.text, "].count += 1;\n");
+    }
+
     // Output code
     for (int i = 0; i < code_block->instructions.size; i++)
     {
         IR_Instruction* instr = &code_block->instructions[i];
 
         // Add instruction to char mapping
-        bool add_char_info = gen.text == &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION];
+        bool add_char_info = gen.function_output != nullptr && gen.text == &gen.function_output->text;
         Translation_Char_Info char_info;
         char_info.code_block = code_block;
         char_info.instruction_index = i;
         char_info.char_start = gen.text->size;
         char_info.char_end = char_info.char_start;
-        int char_info_index = gen.translation_characters.size;
+        int char_info_index = add_char_info ? gen.function_output->char_infos.size : -1;
         if (add_char_info) {
-            dynamic_array_push_back(&gen.translation_characters, char_info);
+            dynamic_array_push_back(&gen.function_output->char_infos, char_info);
         }
         SCOPE_EXIT(
-            if (add_char_info && gen.text == &gen.sections[(int)Generator_Section::FUNCTION_IMPLEMENTATION]) {
-                gen.translation_characters[char_info_index].char_end = gen.text->size;
+            if (add_char_info && gen.text == &gen.function_output->text) {
+                gen.function_output->char_infos[char_info_index].char_end = gen.text->size;
             }
         );
 
@@ -1939,7 +3367,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
             }
             if (signature->return_type().available) {
                 c_generator_output_data_access(generator, call->destination);
-                string_append_formated(gen.text, " = ");
+                string_append(gen.text, " = ");
                 c_generator_output_cast_if_necessary(generator, call->destination->datatype, signature->return_type().value);
             }
 
@@ -1953,7 +3381,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                 fn_translation.options.function = call->options.function;
                 String* fn_name = hashtable_find_element(&gen.program_translation.name_mapping, fn_translation);
                 assert(fn_name != 0, "Hey");
-                string_append_formated(gen.text, fn_name->characters);
+                string_append(gen.text, fn_name->characters);
                 break;
             }
             case IR_Instruction_Call_Type::FUNCTION_POINTER_CALL: {
@@ -1970,7 +3398,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                     string_append(gen.text, "&type_infos_.infos[");
                     assert(call->arguments.size == 1, "");
                     c_generator_output_data_access(generator, call->arguments[0]);
-                    string_append_formated(gen.text, "];\n");
+                    string_append(gen.text, "];\n");
                     call_handled = true;
                     break;
                 }
@@ -1997,52 +3425,54 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                 break;
             }
 
-            string_append_formated(gen.text, "(");
+            string_append(gen.text, "(");
             for (int j = 0; j < call->arguments.size; j++)
             {
                 // Add cast (Implemented because of signed char/char difference in C) // ? Is this comment outdated ?
                 c_generator_output_data_access(generator, call->arguments[j]);
                 if (j != call->arguments.size - 1) {
-                    string_append_formated(gen.text, ", ");
+                    string_append(gen.text, ", ");
                 }
             }
-            string_append_formated(gen.text, ");\n");
+            string_append(gen.text, ");\n");
             break;
         }
         case IR_Instruction_Type::MATCH:
         {
             IR_Instruction_Switch* switch_instr = &instr->options.switch_instr;
-            string_append_formated(gen.text, "switch ((int) ");
+            string_append(gen.text, "switch ((int) ");
             c_generator_output_data_access(generator, switch_instr->condition_access);
-            string_append_formated(gen.text, ")\n");
+            string_append(gen.text, ")\n");
             string_add_indentation(gen.text, indentation_level);
-            string_append_formated(gen.text, "{\n");
+            string_append(gen.text, "{\n");
             for (int i = 0; i < switch_instr->cases.size; i++)
             {
                 IR_Switch_Case* switch_case = &switch_instr->cases[i];
                 string_add_indentation(gen.text, indentation_level);
-                string_append_formated(gen.text, "case %d: \n", switch_case->value);
+                string_append(gen.text, "case ");
+                string_append_i64(gen.text, switch_case->value);
+                string_append(gen.text, ": \n");
                 c_generator_output_code_block(generator, switch_case->block, indentation_level + 1, false);
                 string_add_indentation(gen.text, indentation_level);
-                string_append_formated(gen.text, "break;\n");
+                string_append(gen.text, "break;\n");
             }
             string_add_indentation(gen.text, indentation_level);
-            string_append_formated(gen.text, "default:\n");
+            string_append(gen.text, "default:\n");
             c_generator_output_code_block(generator, switch_instr->default_block, indentation_level + 1, false);
             string_add_indentation(gen.text, indentation_level);
-            string_append_formated(gen.text, "}\n");
+            string_append(gen.text, "}\n");
             break;
         }
         case IR_Instruction_Type::IF:
         {
             IR_Instruction_If* if_instr = &instr->options.if_instr;
-            string_append_formated(gen.text, "if (");
+            string_append(gen.text, "if (");
             c_generator_output_data_access(generator, if_instr->condition);
-            string_append_formated(gen.text, ")\n");
+            string_append(gen.text, ")\n");
             c_generator_output_code_block(generator, if_instr->true_branch, indentation_level + 1, false);
             if (if_instr->false_branch->instructions.size != 0) {
                 string_add_indentation(gen.text, indentation_level + 1);
-                string_append_formated(gen.text, "else\n");
+                string_append(gen.text, "else\n");
                 c_generator_output_code_block(generator, if_instr->false_branch, indentation_level + 1, false);
             }
             break;
@@ -2050,15 +3480,27 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
         case IR_Instruction_Type::WHILE:
         {
             IR_Instruction_While* while_instr = &instr->options.while_instr;
-            string_append_formated(gen.text, "while(true){\n");
+            string_append(gen.text, "while(true){\n");
             c_generator_output_code_block(generator, while_instr->condition_code, indentation_level + 2, true);
             string_add_indentation(gen.text, indentation_level + 2);
-            string_append_formated(gen.text, "if(!(");
+            string_append(gen.text, "if(!(");
             c_generator_output_data_access(generator, while_instr->condition_access);
-            string_append_formated(gen.text, ")) break;\n");
+            string_append(gen.text, ")) break;\n");
+            if (enable_c_profiling && c_profiling_count_loops)
+            {
+                C_Profile_Slot slot;
+                slot.function = code_block->function;
+                slot.loop_statement = instr->associated_statement;
+                slot.is_inlined_call = false;
+                dynamic_array_push_back(&gen.program_translation.profile_slots, slot);
+                string_add_indentation(gen.text, indentation_level + 2);
+                string_append(gen.text, "upp_profile_slots_[");
+                string_append_i64(gen.text, gen.program_translation.profile_slots.size - 1);
+                string_append(gen.text, "].count += 1;\n");
+            }
             c_generator_output_code_block(generator, while_instr->code, indentation_level + 2, false);
             string_add_indentation(gen.text, indentation_level + 1);
-            string_append_formated(gen.text, "}\n");
+            string_append(gen.text, "}\n");
             break;
         }
         case IR_Instruction_Type::BLOCK:
@@ -2067,11 +3509,15 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
             break;
         }
         case IR_Instruction_Type::GOTO: {
-            string_append_formated(gen.text, "goto upp_label_%d;\n", instr->options.label_index);
+            string_append(gen.text, "goto upp_label_");
+            string_append_i64(gen.text, instr->options.label_index);
+            string_append(gen.text, ";\n");
             break;
         }
         case IR_Instruction_Type::LABEL: {
-            string_append_formated(gen.text, "upp_label_%d: {}\n", instr->options.label_index);
+            string_append(gen.text, "upp_label_");
+            string_append_i64(gen.text, instr->options.label_index);
+            string_append(gen.text, ": {}\n");
             break;
         }
         case IR_Instruction_Type::RETURN:
@@ -2086,18 +3532,20 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                     string_append(gen.text, "std::cin.ignore();\n");
                     string_add_indentation(gen.text, indentation_level);
                 }
-                string_append_formated(gen.text, "exit(%d);\n", (i32)return_instr->options.exit_code.type);
+                string_append(gen.text, "exit(");
+                string_append_i64(gen.text, (i32)return_instr->options.exit_code.type);
+                string_append(gen.text, ");\n");
                 break;
             }
             case IR_Instruction_Return_Type::RETURN_DATA: {
-                string_append_formated(gen.text, "return ");
+                string_append(gen.text, "return ");
                 c_generator_output_cast_if_necessary(generator, return_instr->options.return_value->datatype, code_block->function->signature->return_type().value);
                 c_generator_output_data_access(generator, return_instr->options.return_value);
-                string_append_formated(gen.text, ";\n");
+                string_append(gen.text, ";\n");
                 break;
             }
             case IR_Instruction_Return_Type::RETURN_EMPTY: {
-                string_append_formated(gen.text, "return;\n");
+                string_append(gen.text, "return;\n");
                 break;
             }
             default: panic("What");
@@ -2109,7 +3557,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
             auto& def = instr->options.variable_definition;
 
             c_generator_output_type_reference(generator, def.variable_access->datatype);
-            string_append_formated(gen.text, " ");
+            string_append(gen.text, " ");
             c_generator_output_data_access(generator, def.variable_access);
 
             if (def.initial_value.available) {
@@ -2123,24 +3571,26 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
         {
             IR_Instruction_Function_Address* addr_of = &instr->options.function_address;
             c_generator_output_data_access(generator, addr_of->destination);
-            string_append_formated(gen.text, " = ");
+            string_append(gen.text, " = ");
 
             C_Translation fn_translation;
             fn_translation.type = C_Translation_Type::FUNCTION;
             fn_translation.options.function = addr_of->function;
             String* fn_name = hashtable_find_element(&gen.program_translation.name_mapping, fn_translation);
             assert(fn_name != 0, "HEY");
-            string_append_formated(gen.text, "&%s;\n", fn_name->characters);
+            string_append(gen.text, "&");
+            string_append(gen.text, fn_name->characters);
+            string_append(gen.text, ";\n");
             break;
         }
         case IR_Instruction_Type::MOVE:
         {
             auto& move = instr->options.move;
             c_generator_output_data_access(generator, move.destination);
-            string_append_formated(gen.text, " = ");
+            string_append(gen.text, " = ");
             c_generator_output_cast_if_necessary(generator, move.destination->datatype, move.source->datatype);
             c_generator_output_data_access(generator, move.source);
-            string_append_formated(gen.text, ";\n");
+            string_append(gen.text, ";\n");
             break;
         }
         case IR_Instruction_Type::OPERATION:
@@ -2161,10 +3611,10 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
             {
                 op_handled = true;
                 c_generator_output_data_access(generator, operation.destination);
-                string_append_formated(gen.text, " = ");
+                string_append(gen.text, " = ");
                 c_generator_output_cast_if_necessary(generator, operation.destination->datatype, operation.operand_1->datatype);
                 c_generator_output_data_access(generator, operation.operand_1);
-                string_append_formated(gen.text, ";\n");
+                string_append(gen.text, ";\n");
                 break;
             }
             case Primitive_Operation::HIGHEST_SET_BIT:
@@ -2189,10 +3639,12 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                 c_generator_output_data_access(generator, operation.destination);
                 string_append(gen.text, " = ");
                 c_generator_output_cast_if_necessary(generator, operation.destination->datatype, function_value_datatype);
-                string_append_formated(gen.text, "%s%s(", fn_name, postfix);
+                string_append(gen.text, fn_name);
+                string_append(gen.text, postfix);
+                string_append(gen.text, "(");
                 c_generator_output_cast_if_necessary(generator, operation.operand_1->datatype, function_value_datatype);
                 c_generator_output_data_access(generator, operation.operand_1);
-                string_append_formated(gen.text, ");\n");
+                string_append(gen.text, ");\n");
                 break;
             }
 
@@ -2283,7 +3735,9 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                 c_generator_output_data_access(generator, operation.operand_1);
                 string_append(gen.text, ")");
 
-                string_append_formated(gen.text, " %s ", binop_str);
+                string_append(gen.text, " ");
+                string_append(gen.text, binop_str);
+                string_append(gen.text, " ");
 
                 string_append(gen.text, "(");
                 c_generator_output_cast_if_necessary(
@@ -2292,25 +3746,25 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                 c_generator_output_data_access(generator, operation.operand_2);
                 string_append(gen.text, ")");
 
-                string_append_formated(gen.text, ";\n");
+                string_append(gen.text, ";\n");
             }
             else if (unop_str != nullptr)
             {
                 c_generator_output_data_access(generator, operation.destination);
-                string_append_formated(gen.text, " = ");
-                string_append_formated(gen.text, "%s", unop_str);
+                string_append(gen.text, " = ");
+                string_append(gen.text, unop_str);
                 c_generator_output_data_access(generator, operation.operand_1);
-                string_append_formated(gen.text, ";\n");
+                string_append(gen.text, ";\n");
             }
             else if (float_fn_name != nullptr)
             {
                 int param_count = ir_operation_parameter_count(operation.type);
                 c_generator_output_data_access(generator, operation.destination);
-                string_append_formated(gen.text, " = ");
-                string_append_formated(gen.text, "%s");
+                string_append(gen.text, " = ");
+                string_append(gen.text, float_fn_name);
                 if (append_f_for_f32_version && downcast<Datatype_Primitive>(operation.operand_1->datatype)->primitive_type == Primitive_Type::F32)
                 {
-                    string_append_formated(gen.text, "f");
+                    string_append(gen.text, "f");
                 }
                 string_append(gen.text, "(");
                 c_generator_output_data_access(generator, operation.operand_1);
@@ -2318,7 +3772,7 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
                     string_append(gen.text, ", ");
                     c_generator_output_data_access(generator, operation.operand_2);
                 }
-                string_append_formated(gen.text, ");\n");
+                string_append(gen.text, ");\n");
             }
             else {
                 panic("operation was not handled");
@@ -2331,6 +3785,6 @@ void c_generator_output_code_block(C_Generator* generator, IR_Code_Block* code_b
     }
 
     string_add_indentation(gen.text, indentation_level);
-    string_append_formated(gen.text, "}\n");
+    string_append(gen.text, "}\n");
 }
 
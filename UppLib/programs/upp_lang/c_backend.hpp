@@ -13,10 +13,14 @@ struct Datatype;
 struct String;
 struct Upp_Function;
 struct Compilation_Data;
+namespace AST {
+    struct Statement;
+}
 
 
 // C_COMPILER
 void c_compiler_initialize();
+void c_compiler_shutdown(); // Frees the cache of generated functions, call once no more compiles happen
 void c_compiler_compile(Compilation_Data* compilation_data);
 Exit_Code c_compiler_execute();
 
@@ -64,12 +68,21 @@ struct C_Line_Info
     int line_end_index;
 };
 
+// Counter in the generated profile buffer (see enable_c_profiling)
+struct C_Profile_Slot
+{
+    Upp_Function* function;
+    AST::Statement* loop_statement; // nullptr for function slots (calls + inclusive cycles), otherwise loop iterations
+    bool is_inlined_call; // Counts calls of function which were inlined at one call site
+};
+
 struct C_Program_Translation
 {
     String source_code;
     int line_offset; // Our line-indices start at 0, and the function-implementation starts at an offset
     Dynamic_Array<C_Line_Info> line_infos;
     Hashtable<C_Translation, String> name_mapping;
+    Dynamic_Array<C_Profile_Slot> profile_slots;
 };
 
 
@@ -79,3 +92,8 @@ void c_generator_destroy(C_Generator* generator);
 
 void c_generator_generate(C_Generator* generator);
 C_Program_Translation* c_generator_get_translation(C_Generator* generator);
+
+// Maps the profile dump of the last execution to functions/lines, writes hottest entries first
+bool c_generator_write_profile_report(C_Generator* generator, const char* dump_filepath, const char* report_filepath);
+// Sets is_profile_hot on functions which were called often in a previous report (Used for inlining decisions)
+void c_profile_mark_hot_functions(Compilation_Data* compilation_data, const char* report_filepath);
@@ -1,5 +1,7 @@
 #include "compilation_data.hpp"
 
+#include <cmath>
+
 #include "constant_pool.hpp"
 #include "ast.hpp"
 #include "symbol_table.hpp"
@@ -7,11 +9,13 @@
 #include "semantic_analyser.hpp"
 #include "syntax_colors.hpp"
 #include "../../win32/timing.hpp"
+#include "../../win32/thread.hpp"
 #include "../../utility/rich_text.hpp"
 #include "ir_code.hpp"
 #include "bytecode_generator.hpp"
 #include "bytecode_interpreter.hpp"
 #include "c_backend.hpp"
+#include "trace_recorder.hpp"
 #include "../../utility/file_io.hpp"
 #include "../../utility/character_info.hpp"
 #include "../../utility/directory_crawler.hpp"
@@ -25,7 +29,14 @@ bool enable_analysis = true;
 bool enable_ir_gen = true;
 bool enable_bytecode_gen = true;
 bool compiler_enable_c_generation = false;
+bool enable_dead_function_elimination = true; // Only generate code for functions reachable from main
+bool enable_lazy_body_analysis = true; // Analysis-only compiles skip unneeded function bodies in units which aren't open in the editor
+int c_generation_thread_count = 4; // Threads generating C function bodies, output is identical for every count
+bool enable_c_function_cache = true; // Reuse generated C code of unchanged functions from previous compiles
+bool enable_allocation_tracking = false; // Count allocations per Memory_Subsystem, printed with the timings
+bool enable_allocation_leak_check = false; // Editor logs subsystems which hold more memory after each compilation_data is destroyed
 bool enable_c_compilation = true;
+int compiler_optimization_level = 0; // 0 = no inlining (editor/debug default), 1 = small functions, 2 = larger functions and deeper inlining
 
 // Output stages
 bool output_identifiers = false;
@@ -35,6 +46,8 @@ bool output_root_table = false;
 bool output_ir = false;
 bool output_bytecode = false;
 bool output_timing = true;
+bool enable_trace_recording = false; // Writes Chrome trace json of the pipeline to trace_output_filepath
+const char* trace_output_filepath = "compiler_trace.json";
 
 // Testcases
 bool enable_testcases = false;
@@ -46,6 +59,13 @@ bool enable_output = false;
 bool output_only_on_code_gen = false;
 bool enable_execution = true;
 bool compiler_execute_binary = false;
+bool enable_bytecode_profiling = false; // Writes <bytecode_profile_filepath>.folded and <bytecode_profile_filepath>_lines.txt after execution
+const char* bytecode_profile_filepath = "bytecode_profile";
+bool enable_c_profiling = false; // Generated C-code counts calls/cycles per function, the executable dumps them to c_profile_dump_filepath on exit
+bool c_profiling_count_loops = true;
+const char* c_profile_dump_filepath = "backend/build/c_profile_dump.txt";
+const char* c_profile_report_filepath = "c_profile.txt"; // Dump mapped to function names and lines
+bool enable_profile_guided_inlining = false; // Functions hot in c_profile_report_filepath get larger inlining limits
 
 
 
@@ -69,6 +89,15 @@ bool ast_info_equals(AST_Info_Key* a, AST_Info_Key* b) {
 	return a->base == b->base && a->pass == b->pass;
 }
 
+u64 comptime_memo_key_hash(Comptime_Memo_Key* key) {
+	return hash_combine(hash_pointer(key->function), hash_memory(key->argument_bytes));
+}
+
+bool comptime_memo_key_equals(Comptime_Memo_Key* a, Comptime_Memo_Key* b) {
+	if (a->function != b->function || a->argument_bytes.size != b->argument_bytes.size) return false;
+	return memory_compare(a->argument_bytes.data, b->argument_bytes.data, a->argument_bytes.size);
+}
+
 void compilation_unit_parse_ast(Compilation_Unit* unit, Compilation_Data* compilation_data)
 {
 	// Already parsed
@@ -82,20 +111,34 @@ void compilation_unit_parse_ast(Compilation_Unit* unit, Compilation_Data* compil
     }
 
     // Parse code
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::PARSER);
+    double start_time = timer_current_time_in_seconds();
     Parser::execute_clean(unit, compilation_data);
+    unit->node_annotations = compilation_data->arena.allocate_array<Node_Annotations>(unit->root->range_table.packed.size);
+    memory_set_bytes(unit->node_annotations.data, sizeof(Node_Annotations) * unit->node_annotations.size, 0);
+    unit->node_passes = compilation_data->arena.allocate_array<DynArray<Analysis_Pass*>*>(unit->root->range_table.packed.size);
+    memory_set_bytes(unit->node_passes.data, sizeof(DynArray<Analysis_Pass*>*) * unit->node_passes.size, 0);
+    if (compilation_data->trace_recorder != nullptr) {
+        trace_recorder_add_span(
+            compilation_data->trace_recorder, Trace_Event_Type::PARSE_UNIT, unit, 0, start_time, timer_current_time_in_seconds()
+        );
+    }
 }
 
-void call_signature_destroy(Call_Signature* signature)
+void call_signature_destroy(Call_Signature* signature, Compilation_Data* compilation_data)
 {
-	dynamic_array_destroy(&signature->parameters);
-	delete signature;
+	// Memory is given back to the arena, so that the next signature can reuse it
+	auto& parameters = signature->parameters;
+	compilation_data->arena.release(parameters.buffer.data, parameters.buffer.size * sizeof(Call_Parameter));
+	compilation_data->arena.release(signature, sizeof(Call_Signature));
 }
 
 u64 hash_call_signature(Call_Signature** callable_p)
 {
 	Call_Signature* signature = *callable_p;
 	u64 hash = hash_i32(&signature->return_type_index);
-	hash = hash_combine(hash, hash_i32(&signature->parameters.size));
+	int parameter_count = (int)signature->parameters.size;
+	hash = hash_combine(hash, hash_i32(&parameter_count));
 	for (int i = 0; i < signature->parameters.size; i++)
 	{
 		auto& param = signature->parameters[i];
@@ -174,11 +217,18 @@ Text_Range text_index_to_word_range(Text_Index pos, Source_Code* code)
 // COMPILATION_DATA
 Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 {
+	if (enable_allocation_tracking && !allocation_tracker_is_enabled()) {
+		memory_subsystem_register_tag_names();
+		allocation_tracker_set_enabled(true);
+	}
+
 	Compilation_Data* result = new Compilation_Data;
 	result->arena = Arena::create(2048);
 	result->tmp_arena = Arena::create(2048);
 	result->root_semantic_context_scratch_arena = Arena::create();
 	result->fiber_pool = fiber_pool;
+	result->cancellation_token = nullptr;
+	result->was_cancelled = false;
 
 	// Create datastructures
 	{
@@ -186,7 +236,6 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 		result->identifier_pool = identifier_pool_create();
 
 		// Initialize Data
-		result->ast_to_pass_mapping = hashtable_create_pointer_empty<AST::Node*, Node_Passes>(16);
 		result->ast_to_info_mapping = DynTable<AST_Info_Key, Analysis_Info*>::create(&result->arena, ast_info_key_hash, ast_info_equals);
 
 		result->error_symbol = nullptr; // Initialized after this block
@@ -196,17 +245,25 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 
 		// Allocations
 		result->compilation_units = dynamic_array_create<Compilation_Unit*>();
-		result->allocated_symbol_tables = dynamic_array_create<Symbol_Table*>();
-		result->allocated_symbols = dynamic_array_create<Symbol*>();
-		result->allocated_passes = dynamic_array_create<Analysis_Pass*>();
 		result->call_signatures = hashset_create_empty<Call_Signature*>(0, hash_call_signature, equals_call_signature);
 		result->bytecode = DynArray<Bytecode_Instruction>::create(&result->arena);
+		result->bytecode_statements = DynArray<AST::Statement*>::create(&result->arena);
 		result->custom_operator_instances = DynTable<Custom_Operator_Instance_Key, Custom_Operator_Instance_Value>::create(
 			&result->arena, hash_custom_operator_instance_key, equals_custom_operator_instance_key
 		);
+		result->comptime_memo = DynTable<Comptime_Memo_Key, Comptime_Memo_Value>::create(&result->arena, comptime_memo_key_hash, comptime_memo_key_equals);
+		result->comptime_memo_hits = 0;
+		result->comptime_memo_misses = 0;
+		result->comptime_memo_instructions_saved = 0;
+		result->code_gen_skipped_functions = 0;
+		result->code_gen_skipped_ir_instructions = 0;
+		result->code_gen_ir_instructions = 0;
+		result->code_gen_c_lines = 0;
 
 		result->semantic_infos = dynamic_array_create<Editor_Info>();
 		result->next_editor_info_index = 0;
+		result->trace_recorder = enable_trace_recording ? trace_recorder_create(1 << 16) : nullptr;
+		result->bytecode_profile = enable_bytecode_profiling ? bytecode_profile_create() : nullptr;
 
 		// Initialize stages
 		result->type_system = type_system_create(result);
@@ -381,7 +438,7 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 				return identifier_pool_add(id_pool, string_create_static(name));
 			};
 
-			Call_Signature* call_signature = call_signature_create_empty();
+			Call_Signature* call_signature = call_signature_create_empty(compilation_data);
 			compilation_data->empty_call_signature = call_signature_register(call_signature, compilation_data);
 
 			for (int i = 0; i < (int)Custom_Operator_Type::MAX_ENUM_VALUE; i++) {
@@ -392,18 +449,18 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 			}
 
 			// String/Any initializer signature
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("data"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("size"), upcast(types.size_type), true, false, false);
 			compilation_data->string_initalizer_signature = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("data"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("type"), upcast(types.type_handle), true, false, false);
 			compilation_data->any_initializer_signature = call_signature_register(call_signature, compilation_data);
 
 			// Context functions
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("from_type"),   upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("to_type"),     upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("function"),    upcast(types.empty_pattern_variable), true, false, false);
@@ -411,7 +468,7 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 			call_signature_add_parameter(call_signature, make_id("to_by_ref"),   upcast(types.bool_type), false, false, false);
 			context_signatures[(int)Custom_Operator_Type::AUTO_CAST] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("left_type"),     upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("right_type"),    upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("function"),      upcast(types.empty_pattern_variable), true, false, false);
@@ -423,7 +480,7 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 				context_signatures[i] = binop_signature;
 			}
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("datatype"), upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("function"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("value_by_ref"), upcast(types.bool_type), false, false, false);
@@ -431,21 +488,21 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 			context_signatures[(int)Custom_Operator_Type::UNOP_NEGATE] = call_signature_register(call_signature, compilation_data);
 			context_signatures[(int)Custom_Operator_Type::UNOP_NOT] = context_signatures[(int)Custom_Operator_Type::UNOP_NEGATE];
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("container_type"), upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("function"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("container_by_ref"), upcast(types.bool_type), false, false, false);
 			call_signature_add_parameter(call_signature, make_id("result_by_ref"), upcast(types.bool_type), false, false, false);
 			context_signatures[(int)Custom_Operator_Type::ARRAY_ACCESS] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("iterable_type"),   upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("create_function"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("next_function"),   upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("iterable_by_ref"), upcast(types.bool_type), false, false, false);
 			context_signatures[(int)Custom_Operator_Type::ITERATOR] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("name"),     upcast(types.c_string), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("datatype"), upcast(types.type_handle), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("value"),    upcast(types.empty_pattern_variable), true, false, false);
@@ -457,62 +514,62 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 
 
 			// HARDCODED FUNCTIONS
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("condition"), upcast(types.bool_type), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::ASSERT_FN] = call_signature_register(call_signature, compilation_data);
 
 			hardcoded_signatures[(int)Hardcoded_Type::PANIC_FN] = compilation_data->empty_call_signature;
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.type_handle), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::TYPE_OF] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("type"), upcast(types.type_handle), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.size_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::SIZE_OF] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("type"), upcast(types.type_handle), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.size_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::ALIGN_OF] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_return_type(call_signature, upcast(types.empty_pattern_variable), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::RETURN_TYPE] = call_signature;
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("type"), upcast(types.type_handle), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(type_system_make_pointer(type_system, upcast(types.type_information_type))), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::TYPE_INFO] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.empty_pattern_variable), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::STRUCT_TAG] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.string), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::ENUM_VALUE_AS_STRING] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("datatype"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.i32_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::ENUM_TYPE_MAX_VALUE] = call_signature_register(call_signature, compilation_data);
 			
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("datatype"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.i32_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::ENUM_TYPE_MIN_VALUE] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("datatype"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.bool_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::ENUM_TYPE_IS_CONTINOUS] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.empty_pattern_variable), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("to"), upcast(types.type_handle), false, false, false);
 			call_signature_add_parameter(call_signature, make_id("from"), upcast(types.type_handle), false, false, false);
@@ -520,55 +577,55 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 			hardcoded_signatures[(int)Hardcoded_Type::CAST_PRIMITIVE] = call_signature_register(call_signature, compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::CAST_POINTER] = hardcoded_signatures[(int)Hardcoded_Type::CAST_PRIMITIVE];
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.uint_type), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.rawptr), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::UINT_TO_RAWPTR] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.rawptr), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.uint_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::RAWPTR_TO_UINT] = call_signature_register(call_signature, compilation_data);
 
 			// Memory functions
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("destination"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("source"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("size"), upcast(types.size_type), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::MEMORY_COPY] = call_signature_register(call_signature, compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::MEMORY_COPY_NO_OVERLAP] = hardcoded_signatures[(int)Hardcoded_Type::MEMORY_COPY];
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("destination"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("size"), upcast(types.size_type), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::MEMORY_ZERO] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("a"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("b"), upcast(types.rawptr), true, false, false);
 			call_signature_add_parameter(call_signature, make_id("size"), upcast(types.size_type), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.bool_type), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::MEMORY_COMPARE] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("size"), upcast(types.size_type), true, false, false);
 			call_signature_add_return_type(call_signature, upcast(types.rawptr), compilation_data);
 			hardcoded_signatures[(int)Hardcoded_Type::SYSTEM_ALLOC] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("data"), upcast(types.rawptr), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::SYSTEM_FREE] = call_signature_register(call_signature, compilation_data);
 
 			// Basic IO-Functions
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.int_type), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::PRINT_INT] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.f32_type), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::PRINT_FLOAT] = call_signature_register(call_signature, compilation_data);
 
-			call_signature = call_signature_create_empty();
+			call_signature = call_signature_create_empty(compilation_data);
 			call_signature_add_parameter(call_signature, make_id("value"), upcast(types.string), true, false, false);
 			hardcoded_signatures[(int)Hardcoded_Type::PRINT_STRING] = call_signature_register(call_signature, compilation_data);
 
@@ -582,45 +639,45 @@ Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool)
 				}
 
 				// Bitshift
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("value"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_parameter(call_signature, make_id("count"), upcast(types.size_type), true, false, false);
 				call_signature_add_return_type(call_signature, types.empty_pattern_variable, compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::BITSHIFT] = call_signature_register(call_signature, compilation_data);
 				
 				// Bitwise not
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("value"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.empty_pattern_variable, compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::BITWISE_NOT] = call_signature_register(call_signature, compilation_data);
 
 				// Bitwise binop
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("a"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_parameter(call_signature, make_id("b"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.empty_pattern_variable, compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::BITWISE_BINOP] = call_signature_register(call_signature, compilation_data);
 
 				// Bit-index
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("value"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.size_type->upcast(), compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::BIT_INDEX] = call_signature_register(call_signature, compilation_data);
 
 				// Float unop
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("value"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.empty_pattern_variable, compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::FLOAT_UNARY] = call_signature_register(call_signature, compilation_data);
 
 				// Float predicate
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("value"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.bool_type->upcast(), compilation_data);
 				hardcoded_class_signatures[(int)Hardcoded_Type_Class::FLOAT_PREDICATE] = call_signature_register(call_signature, compilation_data);
 
 				// Float binop
-				call_signature = call_signature_create_empty();
+				call_signature = call_signature_create_empty(compilation_data);
 				call_signature_add_parameter(call_signature, make_id("a"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_parameter(call_signature, make_id("b"), types.empty_pattern_variable, true, false, false);
 				call_signature_add_return_type(call_signature, types.empty_pattern_variable, compilation_data);
@@ -662,62 +719,17 @@ void compilation_data_destroy(Compilation_Data* data)
 	extern_sources_destroy(&data->extern_sources);
 	c_generator_destroy(data->c_generator);
 
-	for (int i = 0; i < data->functions.size; i++) {
-		Upp_Function* function = data->functions[i];
-		if (function->ir_block != nullptr) {
-			ir_code_block_destroy(function->ir_block);
-			function->ir_block = nullptr;
-		}
-	}
+	// IR blocks were freed with the ir_generator arena
 	dynamic_array_destroy(&data->functions);
 	dynamic_array_destroy(&data->globals);
 
 	dynamic_array_destroy(&data->semantic_infos);
 	hashtable_destroy(&data->code_block_comptimes);
 
-	{
-		for (int i = 0; i < data->ast_to_info_mapping.entries.size; i++)
-		{
-			auto& entry = data->ast_to_info_mapping.entries[i];
-			if (entry.state != DynSet_Entry_State::OCCUPIED) continue;
-			Analysis_Info* info = entry.value;
-			delete info;
-		}
-	}
-	{
-		auto iter = hashtable_iterator_create(&data->ast_to_pass_mapping);
-		while (hashtable_iterator_has_next(&iter)) {
-			Node_Passes* workloads = iter.value;
-			dynamic_array_destroy(&workloads->passes);
-			hashtable_iterator_next(&iter);
-		}
-		hashtable_destroy(&data->ast_to_pass_mapping);
-	}
-	{
-		for (int i = 0; i < data->allocated_passes.size; i++) {
-			delete data->allocated_passes[i];
-		}
-		dynamic_array_destroy(&data->allocated_passes);
-	}
-
+	// Analysis_Infos, Analysis_Passes, Symbols, Symbol_Tables and Call_Signatures are allocated in the arena
 	data->arena.destroy();
 	data->tmp_arena.destroy();
 	data->root_semantic_context_scratch_arena.destroy();
-
-	// Symbol tables + workloads
-	for (int i = 0; i < data->allocated_symbol_tables.size; i++) {
-		symbol_table_destroy(data->allocated_symbol_tables[i]);
-	}
-	dynamic_array_destroy(&data->allocated_symbol_tables);
-
-	for (int i = 0; i < data->allocated_symbols.size; i++) {
-		symbol_destroy(data->allocated_symbols[i]);
-	}
-	dynamic_array_destroy(&data->allocated_symbols);
-
-	for (auto iter = data->call_signatures.make_iter(); iter.has_next(); iter.next()) {
-		call_signature_destroy(*iter.value);
-	}
 	hashset_destroy(&data->call_signatures);
 
 	for (int i = 0; i < data->compilation_units.size; i++) {
@@ -731,24 +743,69 @@ void compilation_data_destroy(Compilation_Data* data)
 	}
 	dynamic_array_destroy(&data->compilation_units);
 
+	if (data->trace_recorder != nullptr) {
+		trace_recorder_destroy(data->trace_recorder);
+	}
+	if (data->bytecode_profile != nullptr) {
+		bytecode_profile_destroy(data->bytecode_profile);
+	}
+
 	delete data;
 }
 
+static Thread background_destroy_thread;
+static bool background_destroy_running = false;
+
+static unsigned long background_destroy_entry_fn(void* userdata)
+{
+	compilation_data_destroy((Compilation_Data*)userdata);
+	return 0;
+}
+
+void compilation_data_destroy_in_background(Compilation_Data* data)
+{
+	compilation_data_wait_for_background_destroy();
+	background_destroy_thread = thread_create(background_destroy_entry_fn, data);
+	background_destroy_running = true;
+}
+
+void compilation_data_wait_for_background_destroy()
+{
+	if (!background_destroy_running) return;
+	wait_for_thread_to_finish(background_destroy_thread);
+	thread_destroy(background_destroy_thread);
+	background_destroy_running = false;
+}
+
 Compilation_Unit* compilation_data_add_compilation_unit_unique(Compilation_Data* compilation_data, String filepath, bool load_file_if_new, bool parse_ast)
 {
+	auto find_unit = [&](String* path) -> Compilation_Unit* {
+		for (int i = 0; i < compilation_data->compilation_units.size; i++) {
+			auto other = compilation_data->compilation_units[i];
+			if (string_equals(&other->filepath, path)) {
+				if (parse_ast) {
+					compilation_unit_parse_ast(other, compilation_data);
+				}
+				return other;
+			}
+		}
+		return nullptr;
+	};
+
+	// Editor tabs and imports already pass full paths, so check before creating the full-path copy
+	Compilation_Unit* existing = find_unit(&filepath);
+	if (existing != nullptr) {
+		return existing;
+	}
+
     String full_file_path = string_copy(filepath);
     file_io_relative_to_full_path(&full_file_path);
     SCOPE_EXIT(string_destroy(&full_file_path)); // On success capacity is set to 0, so this won't do anything
 
 	// Check if filename alreay exists
-	for (int i = 0; i < compilation_data->compilation_units.size; i++) {
-		auto other = compilation_data->compilation_units[i];
-		if (string_equals(&other->filepath, &full_file_path)) {
-			if (parse_ast) {
-				compilation_unit_parse_ast(other, compilation_data);
-			}
-			return other;
-		}
+	existing = find_unit(&full_file_path);
+	if (existing != nullptr) {
+		return existing;
 	}
 
 	Source_Code* source_code = nullptr;
@@ -767,13 +824,20 @@ Compilation_Unit* compilation_data_add_compilation_unit_unique(Compilation_Data*
 
 	unit->code = source_code;
 	unit->root = nullptr;
+	unit->node_annotations.data = nullptr;
+	unit->node_annotations.size = 0;
+	unit->node_passes.data = nullptr;
+	unit->node_passes.size = 0;
 	unit->upp_module = nullptr;
+	unit->open_in_editor = false;
+	unit->index = compilation_data->compilation_units.size;
+	assert(unit->index <= 0xFFFF, "Unit index must fit into AST::Node::unit_index");
+	dynamic_array_push_back(&compilation_data->compilation_units, unit);
+
 	if (parse_ast) {
 		compilation_unit_parse_ast(unit, compilation_data);
 	}
 
-	dynamic_array_push_back(&compilation_data->compilation_units, unit);
-
 	return unit;
 }
 
@@ -795,10 +859,12 @@ void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Un
         compilation_data->time_reset = 0;
         compilation_data->time_code_exec = 0;
         compilation_data->time_output = 0;
+        compilation_data->fiber_switch_count = 0;
         compilation_data->task_last_start_time = compilation_data->time_compile_start;
         compilation_data->task_current = Timing_Task::FINISH;
         compilation_data_switch_timing_task(compilation_data, Timing_Task::RESET);
     }
+    allocation_tracker_reset_peaks();
 
     // Parse main unit
     compilation_unit_parse_ast(main_unit, compilation_data);
@@ -811,8 +877,13 @@ void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Un
     bool do_analysis = enable_lexing && enable_parsing && enable_analysis;
     if (do_analysis) 
     {
+        ALLOCATION_TAG_SCOPE(Memory_Subsystem::ANALYSER);
         workload_executer_add_module_discovery(main_unit->root, compilation_data);
         workload_executer_resolve(compilation_data->workload_executer, compilation_data);
+        if (compilation_data->was_cancelled) {
+            fiber_pool_abort_unfinished_tasks(compilation_data->fiber_pool);
+            return;
+        }
 		semantic_analyser_finish_analysis(compilation_data);
     }
 
@@ -827,26 +898,45 @@ void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Un
         compilation_data_switch_timing_task(compilation_data, Timing_Task::CODE_GEN);
         if (do_ir_gen) 
         {
-            for (int i = 0; i < compilation_data->functions.size; i++) {
-                Upp_Function* function = compilation_data->functions[i];
-                ir_generator_generate_function(function, compilation_data);
-            }
+            ALLOCATION_TAG_SCOPE(Memory_Subsystem::IR);
             ir_generator_finish(compilation_data);
+            ir_generator_generate_reachable_functions(compilation_data, enable_dead_function_elimination);
+            if (compilation_data_check_cancelled(compilation_data)) {
+                return;
+            }
+            if (enable_profile_guided_inlining) {
+                c_profile_mark_hot_functions(compilation_data, c_profile_report_filepath);
+            }
+            ir_generator_inline_functions(compilation_data, ir_inline_settings_from_optimization_level(compiler_optimization_level));
         }
         if (do_bytecode_gen) 
         {
             for (int i = 0; i < compilation_data->functions.size; i++) {
                 Upp_Function* function = compilation_data->functions[i];
-                if (function->ir_block != nullptr) {
+                if (compilation_data_check_cancelled(compilation_data)) {
+                    return;
+                }
+                if (function->ir_block != nullptr && function->is_reachable) {
                     bytecode_generator_compile_function(compilation_data, function);
                 }
             }
+            for (int i = 0; i < compilation_data->functions.size; i++) {
+                bytecode_generator_link_function_calls(compilation_data, compilation_data->functions[i]);
+            }
         }
         if (do_c_generation) {
+            ALLOCATION_TAG_SCOPE(Memory_Subsystem::C_GENERATOR);
             c_generator_generate(compilation_data->c_generator);
         }
         if (do_c_compilation) {
+            ALLOCATION_TAG_SCOPE(Memory_Subsystem::C_GENERATOR);
+            double start_time = timer_current_time_in_seconds();
             c_compiler_compile(compilation_data);
+            if (compilation_data->trace_recorder != nullptr) {
+                trace_recorder_add_span(
+                    compilation_data->trace_recorder, Trace_Event_Type::C_COMPILATION, nullptr, 0, start_time, timer_current_time_in_seconds()
+                );
+            }
         }
     }
 
@@ -914,9 +1004,23 @@ void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Un
             if (enable_analysis) {
                 logg("analysis    ... %3.2fms\n", (float)(compilation_data->time_analysing) * 1000);
                 logg("code_exec   ... %3.2fms\n", (float)(compilation_data->time_code_exec) * 1000);
+                logg("fiber switches: %lld\n", (i64)compilation_data->fiber_switch_count);
+                int memo_calls = compilation_data->comptime_memo_hits + compilation_data->comptime_memo_misses;
+                if (memo_calls > 0) {
+                    logg("comptime memo hits: %d/%d (%3.1f%%), instructions saved: %lld\n", 
+                        compilation_data->comptime_memo_hits, memo_calls, 
+                        (float)compilation_data->comptime_memo_hits / memo_calls * 100.0f, compilation_data->comptime_memo_instructions_saved
+                    );
+                }
             }
             if (enable_bytecode_gen) {
                 logg("code_gen    ... %3.2fms\n", (float)(compilation_data->time_code_gen) * 1000);
+                logg("code_gen: %d IR instructions, skipped %d unreachable functions (%d IR instructions from comptime)\n",
+                    compilation_data->code_gen_ir_instructions, compilation_data->code_gen_skipped_functions, compilation_data->code_gen_skipped_ir_instructions
+                );
+                if (compilation_data->code_gen_c_lines > 0) {
+                    logg("code_gen: %d lines of C-code\n", compilation_data->code_gen_c_lines);
+                }
             }
             if (true) {
                 logg("output      ... %3.2fms\n", (float)(compilation_data->time_output) * 1000);
@@ -924,6 +1028,18 @@ void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Un
             logg("--------------------------\n");
             logg("sum         ... %3.2fms\n", (float)(sum) * 1000);
             logg("--------------------------\n");
+            if (allocation_tracker_is_enabled()) {
+                String memory_stats = string_create(512);
+                SCOPE_EXIT(string_destroy(&memory_stats));
+                allocation_tracker_append_stats_to_string(&memory_stats);
+                logg("%s--------------------------\n", memory_stats.characters);
+            }
+        }
+
+        if (compilation_data->trace_recorder != nullptr) {
+            if (!trace_recorder_write_chrome_trace(compilation_data->trace_recorder, trace_output_filepath)) {
+                logg("Could not write compiler trace to %s\n", trace_output_filepath);
+            }
         }
     }
 }
@@ -984,12 +1100,13 @@ void find_editor_infos_recursive(
 {
 	auto code = unit->code;
 	auto type_system = compilation_data->type_system;
+	AST::Node_Ranges node_ranges = AST::node_range_table_get(&unit->root->range_table, node->index);
 
 	// Add additional passes to active-passes array
-	auto node_passes_opt = hashtable_find_element(&compilation_data->ast_to_pass_mapping, node);
+	auto node_passes_opt = unit->node_passes[(int)node->index];
 	int active_pass_count_before = active_passes.size;
 	if (node_passes_opt != nullptr) {
-		auto new_passes = node_passes_opt->passes;
+		auto& new_passes = *node_passes_opt;
 		for (int i = 0; i < new_passes.size; i++) {
 			Analysis_Pass* pass = new_passes[i];
 			assert(pass != nullptr, "");
@@ -1035,7 +1152,7 @@ void find_editor_infos_recursive(
 			if (symbol_table != nullptr)
 			{
 				Symbol_Table_Range table_range;
-				table_range.range = node->bounding_range;
+				table_range.range = node_ranges.bounding_range;
 				table_range.symbol_table = symbol_table;
 				table_range.tree_depth = tree_depth;
 				table_range.pass = pass;
@@ -1054,7 +1171,7 @@ void find_editor_infos_recursive(
 			if (info->upp_module == nullptr) { continue; }
 
 			Symbol_Table_Range table_range;
-			table_range.range = node->bounding_range;
+			table_range.range = node_ranges.bounding_range;
 			table_range.symbol_table = info->upp_module->symbol_table;
 			table_range.tree_depth = tree_depth;
 			table_range.pass = pass;
@@ -1067,7 +1184,7 @@ void find_editor_infos_recursive(
 		auto block_node = AST::downcast<AST::Code_Block>(node);
 		if (block_node->block_id.available) {
 			Block_ID_Range id_range;
-			id_range.range = node->bounding_range;
+			id_range.range = node_ranges.bounding_range;
 			id_range.block_id = block_node->block_id.value;
 			dynamic_array_push_back(&code->block_id_range, id_range);
 		}
@@ -1079,7 +1196,7 @@ void find_editor_infos_recursive(
 			if (block == nullptr) { continue; }
 			if (block->symbol_table == nullptr) { continue; }
 			Symbol_Table_Range table_range;
-			table_range.range = node->bounding_range;
+			table_range.range = node_ranges.bounding_range;
 			table_range.symbol_table = block->symbol_table;
 			table_range.tree_depth = tree_depth;
 			table_range.pass = pass;
@@ -1091,11 +1208,11 @@ void find_editor_infos_recursive(
 	{
 		auto expr = downcast<AST::Expression>(node);
 		if (expr->type == AST::Expression_Type::AUTO_ENUM) {
-			add_markup(node->range, code, tree_depth, Syntax_Color::ENUM_MEMBER, compilation_data);
+			add_markup(node_ranges.range, code, tree_depth, Syntax_Color::ENUM_MEMBER, compilation_data);
 		}
 		if (active_passes.size == 0) break;
 
-		int analysis_item_index = add_code_analysis_item(node->range, code, tree_depth, compilation_data);
+		int analysis_item_index = add_code_analysis_item(node_ranges.range, code, tree_depth, compilation_data);
 		for (int i = 0; i < active_passes.size; i++)
 		{
 			auto pass = active_passes[i];
@@ -1126,8 +1243,8 @@ void find_editor_infos_recursive(
 					if (enum_type->definition_node != nullptr)
 					{
 						option.expression.member_access_info.has_definition = true;
-						option.expression.member_access_info.member_definition_unit = ast_node_to_compilation_unit(enum_type->definition_node);
-						option.expression.member_access_info.definition_index = enum_type->definition_node->range.start;
+						option.expression.member_access_info.member_definition_unit = ast_node_to_compilation_unit(compilation_data, enum_type->definition_node);
+						option.expression.member_access_info.definition_index = ast_node_get_ranges(compilation_data, enum_type->definition_node).range.start;
 					}
 				}
 			}
@@ -1173,8 +1290,8 @@ void find_editor_infos_recursive(
 				if (goto_node != nullptr)
 				{
 					option.expression.member_access_info.has_definition = true;
-					option.expression.member_access_info.member_definition_unit = ast_node_to_compilation_unit(goto_node);
-					option.expression.member_access_info.definition_index = goto_node->range.start;
+					option.expression.member_access_info.member_definition_unit = ast_node_to_compilation_unit(compilation_data, goto_node);
+					option.expression.member_access_info.definition_index = ast_node_get_ranges(compilation_data, goto_node).range.start;
 				}
 			}
 
@@ -1187,14 +1304,14 @@ void find_editor_infos_recursive(
 	case AST::Node_Type::STRUCT_MEMBER: {
 		auto member = downcast<AST::Structure_Member_Node>(node);
 		add_markup(
-			node->range, code, tree_depth, 
+			node_ranges.range, code, tree_depth, 
 			member->is_expression ? Syntax_Color::MEMBER : Syntax_Color::SUBTYPE, 
 			compilation_data
 		);
 		break;
 	}
 	case AST::Node_Type::ENUM_MEMBER: {
-		add_markup(text_index_to_word_range(node->range.start, code), code, tree_depth, Syntax_Color::ENUM_MEMBER, compilation_data);
+		add_markup(text_index_to_word_range(node_ranges.range.start, code), code, tree_depth, Syntax_Color::ENUM_MEMBER, compilation_data);
 		break;
 	}
 	case AST::Node_Type::CALL_NODE:
@@ -1202,7 +1319,7 @@ void find_editor_infos_recursive(
 		if (active_passes.size == 0) break;
 		auto arguments = downcast<AST::Call_Node>(node);
 
-		int analysis_item_index = add_code_analysis_item(node->range, code, tree_depth, compilation_data);
+		int analysis_item_index = add_code_analysis_item(node_ranges.range, code, tree_depth, compilation_data);
 		for (int i = 0; i < active_passes.size; i++)
 		{
 			auto pass = active_passes[i];
@@ -1221,7 +1338,7 @@ void find_editor_infos_recursive(
 		// Add named argument highlighting
 		auto arg = downcast<AST::Argument>(node);
 		if (arg->name.available) {
-			add_markup(text_index_to_word_range(node->range.start, code), code, tree_depth, Syntax_Color::VARIABLE, compilation_data);
+			add_markup(text_index_to_word_range(node_ranges.range.start, code), code, tree_depth, Syntax_Color::VARIABLE, compilation_data);
 		}
 
 		// Find argument index
@@ -1237,7 +1354,7 @@ void find_editor_infos_recursive(
 		Editor_Info_Option option;
 		option.argument_info.call_node = arguments;
 		option.argument_info.argument_index = arg_index;
-		int analysis_item_index = add_code_analysis_item(node->range, code, tree_depth, compilation_data);
+		int analysis_item_index = add_code_analysis_item(node_ranges.range, code, tree_depth, compilation_data);
 		add_semantic_info(analysis_item_index, Editor_Info_Type::ARGUMENT, option, nullptr, compilation_data);
 		break;
 	}
@@ -1245,7 +1362,7 @@ void find_editor_infos_recursive(
 	{
 		AST::Symbol_Node* symbol_node = downcast<AST::Symbol_Node>(node);
 		bool is_definition = symbol_node->is_definition;
-		Text_Range range = text_index_to_word_range(node->range.start, code);
+		Text_Range range = text_index_to_word_range(node_ranges.range.start, code);
 
 		int analysis_item_index = add_code_analysis_item(range, code, tree_depth, compilation_data);
 		for (int i = 0; i < active_passes.size; i++)
@@ -1403,7 +1520,13 @@ Exit_Code compiler_execute(Compilation_Data* compilation_data)
     if (!compilation_data_errors_occured(compilation_data) && do_execution)
     {
         if (compiler_execute_binary) {
-            return c_compiler_execute();
+            Exit_Code exit_code = c_compiler_execute();
+            if (enable_c_profiling && compiler_enable_c_generation) {
+                if (!c_generator_write_profile_report(compilation_data->c_generator, c_profile_dump_filepath, c_profile_report_filepath)) {
+                    logg("Could not map C profile %s to %s\n", c_profile_dump_filepath, c_profile_report_filepath);
+                }
+            }
+            return exit_code;
         }
         else
         {
@@ -1413,7 +1536,13 @@ Exit_Code compiler_execute(Compilation_Data* compilation_data)
 
             Bytecode_Thread* thread = bytecode_thread_create(compilation_data, scratch_arena, 1000000, 1024 * 64, 1024 * 8, true);
             bytecode_thread_set_initial_state(thread, compilation_data->entry_function);
-            return bytecode_thread_execute(thread);
+            Exit_Code exit_code = bytecode_thread_execute(thread);
+            if (compilation_data->bytecode_profile != nullptr) {
+                if (!bytecode_profile_write_files(compilation_data->bytecode_profile, compilation_data, bytecode_profile_filepath)) {
+                    logg("Could not write bytecode profile to %s\n", bytecode_profile_filepath);
+                }
+            }
+            return exit_code;
         }
     }
     return exit_code_make(Exit_Code_Type::COMPILATION_FAILED);
@@ -1424,9 +1553,9 @@ void compilation_data_add_code_error_code_section(Compilation_Data* compilation_
 	Code_Error error;
 	error.msg = msg;
 	error.infos = DynArray<Error_Information>::create(&compilation_data->arena);
-	error.unit = ast_node_to_compilation_unit(node);
+	error.unit = ast_node_to_compilation_unit(compilation_data, node);
 	error.ranges = Parser::ast_base_get_section_token_range(
-		error.unit->code, node, section, &compilation_data->arena
+		error.unit->code, &error.unit->root->range_table, node, section, &compilation_data->arena
 	);
 	compilation_data->code_errors.push_back(error);
 }
@@ -1449,13 +1578,37 @@ bool compilation_data_errors_occured(Compilation_Data* compilation_data)
 	return compilation_data->code_errors.size > 0;
 }
 
-Compilation_Unit* ast_node_to_compilation_unit(AST::Node* base)
+bool compilation_data_check_cancelled(Compilation_Data* compilation_data)
 {
-    while (base->type != AST::Node_Type::ROOT) {
-        base = base->parent;
-    }
-    AST::Root_Node* root = downcast<AST::Root_Node>(base);
-	return root->compilation_unit;
+	if (!compilation_data->was_cancelled && compilation_data->cancellation_token != nullptr) {
+		compilation_data->was_cancelled = cancellation_token_is_cancelled(compilation_data->cancellation_token);
+	}
+	return compilation_data->was_cancelled;
+}
+
+Compilation_Unit* ast_node_to_compilation_unit(Compilation_Data* compilation_data, AST::Node* node)
+{
+	return compilation_data->compilation_units[node->unit_index];
+}
+
+AST::Node_Ranges ast_node_get_ranges(Compilation_Data* compilation_data, AST::Node* node)
+{
+	Compilation_Unit* unit = compilation_data->compilation_units[node->unit_index];
+	return AST::node_range_table_get(&unit->root->range_table, node->index);
+}
+
+Node_Annotations* compilation_data_get_node_annotations(Compilation_Data* compilation_data, AST::Node* node)
+{
+	Compilation_Unit* unit = compilation_data->compilation_units[node->unit_index];
+	assert(node->index < (u32)unit->node_annotations.size, "");
+	return &unit->node_annotations.data[node->index];
+}
+
+DynArray<Analysis_Pass*>** compilation_data_get_node_passes(Compilation_Data* compilation_data, AST::Node* node)
+{
+	Compilation_Unit* unit = compilation_data->compilation_units[node->unit_index];
+	assert(node->index < (u32)unit->node_passes.size, "");
+	return &unit->node_passes.data[node->index];
 }
 
 Semantic_Context compilation_data_make_root_semantic_context(Compilation_Data* compilation_data)
@@ -1488,6 +1641,12 @@ void compilation_data_switch_timing_task(Compilation_Data* compilation_data, Tim
     double now = timer_current_time_in_seconds();
     double time_spent = now - compilation_data->task_last_start_time;
     *add_to = *add_to + time_spent;
+    if (compilation_data->trace_recorder != nullptr) {
+        trace_recorder_add_span(
+            compilation_data->trace_recorder, Trace_Event_Type::PHASE, nullptr, (int)compilation_data->task_current, 
+            compilation_data->task_last_start_time, now
+        );
+    }
     //logg("Spent %3.2fms on: %s\n", time_spent, timing_task_to_string(compilation_data->task_current));
     compilation_data->task_last_start_time = now;
     compilation_data->task_current = task;
@@ -1734,10 +1893,10 @@ void compiler_run_testcases(bool force_run)
 
 
 
-Call_Signature* call_signature_create_empty()
+Call_Signature* call_signature_create_empty(Compilation_Data* compilation_data)
 {
-	Call_Signature* result = new Call_Signature;
-	result->parameters = dynamic_array_create<Call_Parameter>();
+	Call_Signature* result = compilation_data->arena.allocate<Call_Signature>();
+	result->parameters = DynArray<Call_Parameter>::create(&compilation_data->arena);
 	result->return_type_index = -1;
 	result->is_registered = false;
 	return result;
@@ -1757,7 +1916,7 @@ Call_Parameter* call_signature_add_parameter(
 	param.must_not_be_set = must_not_be_set;
 	param.pattern_variable_index = -1;
 
-	dynamic_array_push_back(&signature->parameters, param);
+	signature->parameters.push_back(param);
 	return &signature->parameters[signature->parameters.size - 1];
 }
 
@@ -1777,7 +1936,7 @@ Call_Signature* call_signature_register(Call_Signature* signature, Compilation_D
 	// Deduplicate
 	Call_Signature** dedup = hashset_find(&compilation_data->call_signatures, signature);
 	if (dedup != nullptr) {
-		call_signature_destroy(signature);
+		call_signature_destroy(signature, compilation_data);
 		return *dedup;
 	}
 
@@ -13,6 +13,7 @@ namespace AST
     struct Expression;
     struct Call_Node;
     struct Code_Block;
+    struct Statement;
 };
 
 struct Editor_Info;
@@ -35,6 +36,9 @@ struct Symbol;
 struct IR_Generator;
 struct C_Generator;
 struct Compilation_Unit;
+struct Trace_Recorder;
+struct Bytecode_Profile;
+struct Cancellation_Token;
 
 namespace AST
 {
@@ -44,7 +48,25 @@ namespace AST
 
 // Global defs
 extern bool compiler_enable_c_generation;
+extern bool enable_c_compilation; // Only generate C-code if false
 extern bool compiler_execute_binary;
+extern int compiler_optimization_level;
+extern bool output_timing;
+extern bool enable_trace_recording;
+extern bool enable_bytecode_profiling;
+extern const char* bytecode_profile_filepath;
+extern const char* trace_output_filepath;
+extern bool enable_c_profiling;
+extern bool c_profiling_count_loops;
+extern const char* c_profile_dump_filepath;
+extern const char* c_profile_report_filepath;
+extern bool enable_profile_guided_inlining;
+extern bool enable_dead_function_elimination;
+extern bool enable_lazy_body_analysis;
+extern int c_generation_thread_count;
+extern bool enable_c_function_cache;
+extern bool enable_allocation_tracking;
+extern bool enable_allocation_leak_check;
 
 struct Code_Error
 {
@@ -62,7 +84,27 @@ struct Compilation_Unit
     // All data may be nullptr until loaded...
     Source_Code* code; // Nullptr if file does not exist?
     AST::Root_Node* root;
+    Array<Node_Annotations> node_annotations; // Indexed by AST::Node::index, allocated after parsing
+    // Passes with the node as mapping node, nullptr if there are none. Indexed by AST::Node::index, separate from node_annotations
+    // because only few nodes are mapping nodes, so this keeps both arrays small
+    Array<DynArray<Analysis_Pass*>*> node_passes;
     Upp_Module* upp_module;
+    int index; // In Compilation_Data::compilation_units, also stored in each AST::Node
+    bool open_in_editor; // Function bodies of other units may be analysed lazily, see enable_lazy_body_analysis
+};
+
+// Results of comptime calls to pure functions, see ir_function_is_pure
+struct Comptime_Memo_Key
+{
+    Upp_Function* function;
+    Array<byte> argument_bytes; // Concatenated parameter values
+};
+
+struct Comptime_Memo_Value
+{
+    Array<byte> result_bytes;
+    Datatype* result_type;
+    int instruction_count; // Instructions executed by the memoized call
 };
 
 struct Compilation_Data
@@ -72,11 +114,14 @@ struct Compilation_Data
     Compilation_Unit* main_unit;
     Dynamic_Array<Compilation_Unit*> compilation_units;
     DynArray<Code_Error> code_errors;
+    Cancellation_Token* cancellation_token; // nullptr if compilation cannot be cancelled, non-owning
+    bool was_cancelled; // Results are incomplete and should be discarded
 
     // Program
     Dynamic_Array<Upp_Function*> functions;
     Dynamic_Array<Upp_Global*> globals;
     DynArray<Bytecode_Instruction> bytecode;
+    DynArray<AST::Statement*> bytecode_statements; // Source statement of each bytecode instruction, may be nullptr
 
     // Known functions
     Upp_Function* main_function;
@@ -94,16 +139,25 @@ struct Compilation_Data
     IR_Generator* ir_generator;
     C_Generator* c_generator;
 
+    // Dead function elimination, see ir_generator_generate_reachable_functions
+    int code_gen_skipped_functions;
+    int code_gen_skipped_ir_instructions; // Only IR which was generated for comptime execution can be counted
+    int code_gen_ir_instructions;
+    int code_gen_c_lines;
+
     // Semantic-Analysis information
     Symbol_Table* root_symbol_table; // Contains int, float, bool and all basic symbols (e.g. size_of)
     Upp_Module* builtin_module;      // ~ module, for more specific things, like print_string, bitwise_and, sin/cos/tan
     Symbol* builtin_module_symbol;
     Workload_Root* root_workload;
 
-    Hashtable<AST::Node*, Node_Passes> ast_to_pass_mapping;
-    DynTable<AST_Info_Key, Analysis_Info*> ast_to_info_mapping;
+    DynTable<AST_Info_Key, Analysis_Info*> ast_to_info_mapping; // Infos which don't fit into Node_Annotations
     Hashtable<AST::Code_Block*, Symbol_Table*> code_block_comptimes; // To prevent re-analysis of comptime-definitions in code-blocks
     DynTable<Custom_Operator_Instance_Key, Custom_Operator_Instance_Value> custom_operator_instances;
+    DynTable<Comptime_Memo_Key, Comptime_Memo_Value> comptime_memo;
+    int comptime_memo_hits;
+    int comptime_memo_misses;
+    i64 comptime_memo_instructions_saved;
 
     Symbol* error_symbol;
 
@@ -123,9 +177,6 @@ struct Compilation_Data
     Arena arena;
     Arena tmp_arena;
     Arena root_semantic_context_scratch_arena;
-    Dynamic_Array<Symbol_Table*> allocated_symbol_tables;
-    Dynamic_Array<Symbol*> allocated_symbols;
-    Dynamic_Array<Analysis_Pass*> allocated_passes;
 
     // Timing stuff
     Timing_Task task_current;
@@ -138,10 +189,18 @@ struct Compilation_Data
     double time_output;
     double time_code_exec;
     double time_reset;
+    u64 fiber_switch_count; // Switches between workload fibers and the executer, see workload_executer_resolve
+    Trace_Recorder* trace_recorder; // nullptr if trace recording is disabled
+    Bytecode_Profile* bytecode_profile; // nullptr if profiling is disabled, collects bakes and execution
 };
 
 Compilation_Data* compilation_data_create(Fiber_Pool* fiber_pool);
 void compilation_data_destroy(Compilation_Data* data);
+// Runs compilation_data_destroy on a background thread, so that the caller does not wait for the frees.
+// Data must not share anything with live compilation_datas anymore (e.g. Source_Code, see syntax_editor_destroy_compilation_data_keep_code).
+// Waits for the previous background destroy, so at most one runs at a time
+void compilation_data_destroy_in_background(Compilation_Data* data);
+void compilation_data_wait_for_background_destroy();
 
 Compilation_Unit* compilation_data_add_compilation_unit_unique(Compilation_Data* compilation_data, String filepath, bool load_file_if_new, bool parse_ast);
 void compilation_data_compile(Compilation_Data* compilation_data, Compilation_Unit* main_unit, Compile_Type compile_type);
@@ -151,7 +210,12 @@ Exit_Code compiler_execute(Compilation_Data* compilation_data);
 void compilation_data_add_code_error_code_section(Compilation_Data* compilation_data, const char* msg, AST::Node* node, Node_Section section);
 bool compilation_data_is_configured_for_c_compilation(Compilation_Data* compilation_data);
 bool compilation_data_errors_occured(Compilation_Data* compilation_data);
-Compilation_Unit* ast_node_to_compilation_unit(AST::Node* base);
+bool compilation_data_check_cancelled(Compilation_Data* compilation_data); // Polled at workload/function boundaries
+// Constant time through AST::Node::unit_index
+Compilation_Unit* ast_node_to_compilation_unit(Compilation_Data* compilation_data, AST::Node* node);
+AST::Node_Ranges ast_node_get_ranges(Compilation_Data* compilation_data, AST::Node* node);
+Node_Annotations* compilation_data_get_node_annotations(Compilation_Data* compilation_data, AST::Node* node);
+DynArray<Analysis_Pass*>** compilation_data_get_node_passes(Compilation_Data* compilation_data, AST::Node* node);
 void compilation_data_switch_timing_task(Compilation_Data* compilation_data, Timing_Task task);
 Semantic_Context compilation_data_make_root_semantic_context(Compilation_Data* compilation_data);
 
@@ -226,8 +290,8 @@ struct Editor_Info
 
 // CALL_SIGNATURES
 // Note: Call_Signatures get deduplicated (Because function-pointer-types get deduplicated, so we need to do this anyway)
-Call_Signature* call_signature_create_empty();
-void call_signature_destroy(Call_Signature* signature);
+Call_Signature* call_signature_create_empty(Compilation_Data* compilation_data);
+void call_signature_destroy(Call_Signature* signature, Compilation_Data* compilation_data); // Only for unregistered signatures
 // Note: Returned pointer is invalidated if another parameter is added
 Call_Parameter* call_signature_add_parameter(
     Call_Signature* signature, String* name, Datatype* datatype, 
@@ -21,6 +21,32 @@ const char* timing_task_to_string(Timing_Task task)
 	return "";
 }
 
+const char* memory_subsystem_to_string(Memory_Subsystem subsystem)
+{
+	switch (subsystem)
+	{
+	case Memory_Subsystem::OTHER: return "Other";
+	case Memory_Subsystem::PARSER: return "Parser";
+	case Memory_Subsystem::ANALYSER: return "Analyser";
+	case Memory_Subsystem::TYPE_SYSTEM: return "Type-System";
+	case Memory_Subsystem::CONSTANT_POOL: return "Constant-Pool";
+	case Memory_Subsystem::IR: return "IR";
+	case Memory_Subsystem::BYTECODE: return "Bytecode";
+	case Memory_Subsystem::C_GENERATOR: return "C-Generator";
+	case Memory_Subsystem::EDITOR_INFO: return "Editor-Info";
+	default: panic("");
+	}
+	return "";
+}
+
+void memory_subsystem_register_tag_names()
+{
+	static_assert((int)Memory_Subsystem::MAX_ENUM_VALUE <= ALLOCATION_TRACKER_MAX_TAGS, "");
+	for (int i = 0; i < (int)Memory_Subsystem::MAX_ENUM_VALUE; i++) {
+		allocation_tracker_set_tag_name(i, memory_subsystem_to_string((Memory_Subsystem)i));
+	}
+}
+
 Hardcoded_Type_Info hardcoded_type_get_info(Hardcoded_Type type)
 {
 	auto make_info = [&](
@@ -159,6 +185,7 @@ const char* exit_code_type_as_string(Exit_Code_Type type)
 	case Exit_Code_Type::INSTRUCTION_LIMIT_REACHED: return "INSTRUCTION_LIMIT_REACHED";
 	case Exit_Code_Type::TYPE_INFO_WAITING_FOR_TYPE_FINISHED: return "TYPE_INFO_WAITING_FOR_TYPE_FINISH";
 	case Exit_Code_Type::CALL_TO_UNFINISHED_FUNCTION: return "CALL_TO_UNFINISHED_FUNCTION";
+	case Exit_Code_Type::CANCELLED: return "CANCELLED";
 	default: panic("");
 	}
 	return "";
@@ -203,6 +230,7 @@ Identifier_Pool identifier_pool_create()
 {
 	Identifier_Pool result;
 	result.identifier_lookup_table = hashtable_create_empty<String, String*>(128, hash_string, string_equals);
+	result.arena = Arena::create(4096);
 
 	// Add predefined IDs
 	{
@@ -298,29 +326,30 @@ Identifier_Pool identifier_pool_create()
 
 void identifier_pool_destroy(Identifier_Pool* pool)
 {
-	auto iter = hashtable_iterator_create(&pool->identifier_lookup_table);
-	while (hashtable_iterator_has_next(&iter)) {
-		String* str = *iter.value;
-		string_destroy(str);
-		delete str;
-		hashtable_iterator_next(&iter);
-	}
 	hashtable_destroy(&pool->identifier_lookup_table);
+	pool->arena.destroy();
 }
 
-String* identifier_pool_add(Identifier_Pool* pool, String identifier)
+String* identifier_pool_add(Identifier_Pool* pool, String_View identifier)
 {
-	String** found = hashtable_find_element(&pool->identifier_lookup_table, identifier);
+	String** found = hashtable_find_element(&pool->identifier_lookup_table, string_view_to_string(identifier));
 	if (found != 0) {
 		return *found;
 	}
-	else {
-		String* copy = new String;
-		*copy = string_create(identifier.size);
-		string_append_string(copy, &identifier);
-		hashtable_insert_element(&pool->identifier_lookup_table, *copy, copy);
-		return copy;
-	}
+
+	// String and characters are allocated together, the strings are static (capacity 0) so they are never resized/freed
+	String* copy = pool->arena.allocate<String>();
+	char* characters = (char*)pool->arena.allocate_raw(identifier.size + 1, 1);
+	memory_copy(characters, identifier.characters, identifier.size);
+	characters[identifier.size] = 0;
+	*copy = string_create_static_with_size(characters, (int)identifier.size);
+	hashtable_insert_element(&pool->identifier_lookup_table, *copy, copy);
+	return copy;
+}
+
+String* identifier_pool_add(Identifier_Pool* pool, String identifier)
+{
+	return identifier_pool_add(pool, string_view_from_string(identifier));
 }
 
 void identifier_pool_print(Identifier_Pool* pool)
@@ -361,12 +390,14 @@ struct Fiber_Info
 struct Fiber_Pool
 {
 	Fiber_Handle main_fiber; // Fiber that created the fiber pool
-	Dynamic_Array<Fiber_Info> allocated_fibers;
+	u64 stack_size;
+	Dynamic_Array<Fiber_Info> allocated_fibers; // Fibers (and their stacks) are kept until the pool is destroyed
 	Dynamic_Array<int> next_free_index;
 };
 
-Fiber_Pool* fiber_pool_create() {
+Fiber_Pool* fiber_pool_create(u64 stack_size) {
 	Fiber_Pool* pool = new Fiber_Pool;
+	pool->stack_size = stack_size;
 	pool->allocated_fibers = dynamic_array_create<Fiber_Info>(1);
 	pool->next_free_index = dynamic_array_create<int>(1);
 	if (!fiber_initialize()) {
@@ -424,7 +455,7 @@ Fiber_Pool_Handle fiber_pool_get_handle(Fiber_Pool* pool, fiber_entry_fn entry_f
 	{
 		Fiber_Startup_Info startup;
 		Fiber_Info info;
-		info.handle = fiber_create(fiber_pool_instance_entry, &startup); // Note: startup is not filled out yet, but the pointer is still valid!
+		info.handle = fiber_create(fiber_pool_instance_entry, &startup, pool->stack_size); // Note: startup is not filled out yet, but the pointer is still valid!
 		info.next_entry = 0;
 		info.next_userdata = 0;
 		info.has_task_to_run = false;
@@ -489,6 +520,31 @@ void fiber_pool_check_all_handles_completed(Fiber_Pool* pool)
 	}
 }
 
+void fiber_pool_abort_unfinished_tasks(Fiber_Pool* pool)
+{
+	for (int i = 0; i < pool->allocated_fibers.size; i++)
+	{
+		auto& info = pool->allocated_fibers[i];
+		if (!info.has_task_to_run) {
+			continue;
+		}
+
+		// Note: The suspended stack is discarded, so destructors/SCOPE_EXITs of the aborted task never run.
+		//       Analysis workloads keep their heap memory in workload->scratch_arena or compilation_data, which are destroyed with the compile
+		Fiber_Startup_Info startup;
+		startup.pool = pool;
+		startup.index_in_pool = i;
+		fiber_reset(info.handle, fiber_pool_instance_entry, &startup);
+		info.next_entry = 0;
+		info.next_userdata = 0;
+		info.has_task_to_run = false;
+		dynamic_array_push_back(&pool->next_free_index, i);
+
+		// Switch to fiber so it can grab its startup info, see 'fiber_pool_instance_entry'
+		fiber_switch_to(info.handle);
+	}
+}
+
 void fiber_pool_switch_to_main_fiber(Fiber_Pool* pool)
 {
 	fiber_switch_to(pool->main_fiber);
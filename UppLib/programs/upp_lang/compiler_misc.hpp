@@ -3,7 +3,10 @@
 #include "../../datastructures/dynamic_array.hpp"
 #include "../../datastructures/hashtable.hpp"
 #include "../../datastructures/string.hpp"
+#include "../../datastructures/allocators.hpp"
+#include "../../utility/allocation_tracker.hpp"
 #include "../../win32/process.hpp"
+#include "../../win32/fiber.hpp"
 
 struct Datatype;
 struct String;
@@ -96,6 +99,24 @@ enum class Timing_Task
 };
 const char* timing_task_to_string(Timing_Task task);
 
+// Allocation tags, see allocation_tracker.hpp
+enum class Memory_Subsystem
+{
+	OTHER,
+	PARSER,
+	ANALYSER,
+	TYPE_SYSTEM,
+	CONSTANT_POOL,
+	IR,
+	BYTECODE,
+	C_GENERATOR,
+	EDITOR_INFO, // Analysis infos + ast-to-info mapping, used by the editor for highlighting/suggestions
+
+	MAX_ENUM_VALUE
+};
+const char* memory_subsystem_to_string(Memory_Subsystem subsystem);
+void memory_subsystem_register_tag_names();
+
 enum class Extern_Compiler_Setting
 {
 	LIBRARY,           // .lib filename
@@ -372,6 +393,7 @@ enum class Exit_Code_Type
 	INSTRUCTION_LIMIT_REACHED,
 	TYPE_INFO_WAITING_FOR_TYPE_FINISHED,
 	CALL_TO_UNFINISHED_FUNCTION,
+	CANCELLED, // Compilation was cancelled while executing comptime code
 
 	MAX_ENUM_VALUE
 };
@@ -413,7 +435,7 @@ struct Call_Parameter
 
 struct Call_Signature
 {
-    Dynamic_Array<Call_Parameter> parameters;
+    DynArray<Call_Parameter> parameters; // Signatures live in Compilation_Data::arena
     // Return type of functions/poly-functions is stored as one of the parameters
     //  or -1 if no return type exists
     int return_type_index; 
@@ -512,11 +534,13 @@ struct Predefined_IDs
 struct Identifier_Pool
 {
 	Hashtable<String, String*> identifier_lookup_table;
+	Arena arena; // Identifier strings + characters, freed all at once on destroy
 	Predefined_IDs predefined_ids;
 };
 
 Identifier_Pool identifier_pool_create();
 void identifier_pool_destroy(Identifier_Pool* pool);
+String* identifier_pool_add(Identifier_Pool* pool, String_View identifier); // Only allocates if the identifier is new
 String* identifier_pool_add(Identifier_Pool* pool, String identifier);
 void identifier_pool_print(Identifier_Pool* pool);
 
@@ -529,11 +553,12 @@ struct Fiber_Pool_Handle { // Handle to a fiber from a fiber pool
 	int pool_index;
 };
 
-Fiber_Pool* fiber_pool_create();
+Fiber_Pool* fiber_pool_create(u64 stack_size = FIBER_DEFAULT_STACK_SIZE); // Stack size of the pooled fibers
 void fiber_pool_destroy(Fiber_Pool* pool);
 Fiber_Pool_Handle fiber_pool_get_handle(Fiber_Pool* pool, fiber_entry_fn entry_fn, void* userdata);
 void fiber_pool_set_current_fiber_to_main(Fiber_Pool* pool);
 bool fiber_pool_switch_to_handel(Fiber_Pool_Handle handle); // Returns true if fiber finished, or if fiber waits for more stuff to happen
 void fiber_pool_switch_to_main_fiber(Fiber_Pool* pool);
 void fiber_pool_check_all_handles_completed(Fiber_Pool* pool);
+void fiber_pool_abort_unfinished_tasks(Fiber_Pool* pool); // Restarts fibers of suspended tasks on their stacks, e.g. after cancellation
 void fiber_pool_test(); // Just tests the fiber pool if everything works correctly
@@ -254,6 +254,9 @@ void datatype_memory_check_correctness_and_set_padding_bytes_zero(
             result = constant_pool_result_make_error("Found function pointer with invalid value");
             return;
         }
+        if (function_index != -1) {
+            compilation_data->functions[function_index]->has_constant_address = true;
+        }
         return;
     }
     case Datatype_Type::POINTER:
@@ -324,6 +327,7 @@ void datatype_memory_check_correctness_and_set_padding_bytes_zero(
 
 Constant_Pool_Result constant_pool_add_constant(Constant_Pool* constant_pool, Datatype* signature, Array<byte> bytes)
 {
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::CONSTANT_POOL);
     Constant_Pool& pool = *constant_pool;
     assert(signature->memory_info.available, "Otherwise how could the bytes have been generated without knowing size of type?");
     auto& memory_info = signature->memory_info.value;
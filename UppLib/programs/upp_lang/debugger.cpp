@@ -2886,7 +2886,7 @@ void source_mapping_generate_statement_to_line_mapping_recursive(
 		Statement_Mapping stat_mapping;
 		stat_mapping.ir_instructions = dynamic_array_create<IR_Instruction_Mapping*>();
 		stat_mapping.statement = statement;
-		stat_mapping.parent_line = &unit_mapping->lines[node->bounding_range.start.line];
+		stat_mapping.parent_line = &unit_mapping->lines[AST::node_range_table_get(&unit_mapping->compilation_unit->root->range_table, node->index).bounding_range.start.line];
 		dynamic_array_push_back(&debugger->statement_mapping, stat_mapping);
 	}
 
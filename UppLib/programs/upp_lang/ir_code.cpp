@@ -18,49 +18,6 @@ thread_local static IR_Generator* ir_generator;
 
 
 // IR Program
-void ir_code_block_destroy(IR_Code_Block* block);
-void ir_instruction_destroy(IR_Instruction* instruction)
-{
-    switch (instruction->type)
-    {
-    case IR_Instruction_Type::FUNCTION_CALL: {
-        dynamic_array_destroy(&instruction->options.call.arguments);
-        break;
-    }
-    case IR_Instruction_Type::IF: {
-        ir_code_block_destroy(instruction->options.if_instr.true_branch);
-        ir_code_block_destroy(instruction->options.if_instr.false_branch);
-        break;
-    }
-    case IR_Instruction_Type::WHILE: {
-        ir_code_block_destroy(instruction->options.while_instr.code);
-        ir_code_block_destroy(instruction->options.while_instr.condition_code);
-        break;
-    }
-    case IR_Instruction_Type::BLOCK: {
-        ir_code_block_destroy(instruction->options.block);
-        break;
-    }
-    case IR_Instruction_Type::MATCH: {
-        for (int i = 0; i < instruction->options.switch_instr.cases.size; i++) {
-            ir_code_block_destroy(instruction->options.switch_instr.cases[i].block);
-        }
-        dynamic_array_destroy(&instruction->options.switch_instr.cases);
-        ir_code_block_destroy(instruction->options.switch_instr.default_block);
-        break;
-    }
-    case IR_Instruction_Type::RETURN:
-    case IR_Instruction_Type::FUNCTION_ADDRESS:
-    case IR_Instruction_Type::OPERATION:
-    case IR_Instruction_Type::LABEL:
-    case IR_Instruction_Type::GOTO:
-    case IR_Instruction_Type::VARIABLE_DEFINITION:
-    case IR_Instruction_Type::MOVE:
-        break;
-    default: panic("Lul");
-    }
-}
-
 IR_Code_Block* ir_code_block_create(Upp_Function* function = nullptr)
 {
     if (function == nullptr) {
@@ -69,10 +26,11 @@ IR_Code_Block* ir_code_block_create(Upp_Function* function = nullptr)
         assert(function != nullptr, "");
     }
 
-    IR_Code_Block* block = new IR_Code_Block();
+    IR_Code_Block* block = ir_generator->arena.allocate<IR_Code_Block>();
     block->function = function;
-    block->instructions = dynamic_array_create<IR_Instruction>();
-    block->registers = dynamic_array_create<IR_Register>();
+    block->inlined_function = nullptr;
+    block->instructions = DynArray<IR_Instruction>::create(&ir_generator->arena);
+    block->registers = DynArray<IR_Register>::create(&ir_generator->arena);
     if (ir_generator->current_block == nullptr) {
         block->parent_block = nullptr;
         block->parent_instruction_index = -1;
@@ -84,17 +42,6 @@ IR_Code_Block* ir_code_block_create(Upp_Function* function = nullptr)
     return block;
 }
 
-void ir_code_block_destroy(IR_Code_Block* block)
-{
-    for (int i = 0; i < block->instructions.size; i++) {
-        ir_instruction_destroy(&block->instructions[i]);
-    }
-    dynamic_array_destroy(&block->instructions);
-    dynamic_array_destroy(&block->registers);
-    delete block;
-}
-
-
 // To_String
 void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_Code_Block* current_block, Compilation_Data* compilation_data)
 {
@@ -104,9 +51,11 @@ void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_
     case IR_Data_Access_Type::CONSTANT: {
         auto const_index = access->option.constant_index;
         Upp_Constant* constant = &compilation_data->constant_pool->constants[const_index];
-        string_append_formated(string, "Constant #%d ", const_index);
+        string_append(string, "Constant #");
+        string_append_i64(string, const_index);
+        string_append(string, " ");
         datatype_append_to_string(constant->type, string, type_system);
-        string_append_formated(string, " ");
+        string_append(string, " ");
         datatype_append_value_to_string(
             constant->type, string, constant->memory, datatype_value_format_single_line(),
             0, Memory_Source(nullptr), Memory_Source(nullptr), type_system
@@ -114,14 +63,18 @@ void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_
         break;
     }
     case IR_Data_Access_Type::GLOBAL_DATA: {
-        string_append_formated(string, "Global #%d, type: ", access->option.global_index);
+        string_append(string, "Global #");
+        string_append_i64(string, access->option.global_index);
+        string_append(string, ", type: ");
         datatype_append_to_string(access->datatype, string, type_system);
         break;
     }
     case IR_Data_Access_Type::PARAMETER: {
         auto& param_info = access->option.parameter;
         auto& param = param_info.function->signature->parameters[param_info.index];
-        string_append_formated(string, "Param \"%s\", type: ", param.name->characters);
+        string_append(string, "Param \"");
+        string_append(string, param.name->characters);
+        string_append(string, "\", type: ");
         datatype_append_to_string(param.datatype, string, type_system);
         break;
     }
@@ -129,14 +82,20 @@ void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_
         auto& reg_access = access->option.register_access;
         auto& reg = reg_access.definition_block->registers[reg_access.index];
         if (reg.name.available) {
-            string_append_formated(string, "Register #%d \"%s\", type: ", reg_access.index, reg.name.value->characters);
+            string_append(string, "Register #");
+            string_append_i64(string, reg_access.index);
+            string_append(string, " \"");
+            string_append(string, reg.name.value->characters);
+            string_append(string, "\", type: ");
         }
         else {
-            string_append_formated(string, "Register #%d, type: ", reg_access.index);
+            string_append(string, "Register #");
+            string_append_i64(string, reg_access.index);
+            string_append(string, ", type: ");
         }
         datatype_append_to_string(reg.type, string, type_system);
         if (reg_access.definition_block != current_block) {
-            string_append_formated(string, " (Non local)");
+            string_append(string, " (Non local)");
         }
         break;
     }
@@ -158,12 +117,16 @@ void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_
         break;
     }
     case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST: {
-        string_append_formated(string, "Nondestructive-Cast(%s) ");
+        string_append(string, "Nondestructive-Cast(");
+        datatype_append_to_string(access->datatype, string, type_system);
+        string_append(string, ") ");
         ir_data_access_append_to_string(access->option.non_destructive_cast.value_access, string, current_block, compilation_data);
         break;
     }
     case IR_Data_Access_Type::MEMBER_ACCESS: {
-        string_append_formated(string, "Member \"%s\" of: ", access->option.member_access.member.name->characters);
+        string_append(string, "Member \"");
+        string_append(string, access->option.member_access.member.name->characters);
+        string_append(string, "\" of: ");
         ir_data_access_append_to_string(access->option.member_access.struct_access, string, current_block, compilation_data);
         break;
     }
@@ -177,7 +140,7 @@ void ir_data_access_append_to_string(IR_Data_Access* access, String* string, IR_
 
 void indent_string(String* string, int indentation) {
     for (int i = 0; i < indentation; i++) {
-        string_append_formated(string, "    ");
+        string_append(string, "    ");
     }
 }
 
@@ -192,9 +155,11 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
         IR_Instruction_Function_Address* function_address = &instruction->options.function_address;
         auto& function = function_address->function;
 
-        string_append_formated(string, "FUNCTION_ADDRESS of %s\n", function->name->characters);
+        string_append(string, "FUNCTION_ADDRESS of ");
+        string_append(string, function->name->characters);
+        string_append(string, "\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string, "dst: ");
+        string_append(string, "dst: ");
         ir_data_access_append_to_string(function_address->destination, string, code_block, compilation_data);
         break;
     }
@@ -202,27 +167,28 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
     {
         auto& op = instruction->options.operation;
         string->append(ir_operation_as_string(op.type));
-        string_append_formated(string, " dst: ");
+        string_append(string, " dst: ");
         ir_data_access_append_to_string(op.destination, string, code_block, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string, "operand 1: ");
+        string_append(string, "operand 1: ");
         ir_data_access_append_to_string(op.operand_1, string, code_block, compilation_data);
         if (ir_operation_parameter_count(op.type) == 2) {
-            string_append_formated(string, "\n");
+            string_append(string, "\n");
             indent_string(string, indentation + 1);
-            string_append_formated(string, "operand 2: ");
+            string_append(string, "operand 2: ");
             ir_data_access_append_to_string(op.operand_2, string, code_block, compilation_data);
         }
         break;
     }
     case IR_Instruction_Type::BLOCK: {
-        string_append_formated(string, "BLOCK\n");
+        string_append(string, "BLOCK\n");
         ir_code_block_append_to_string(instruction->options.block, string, indentation + 1, compilation_data);
         break;
     }
     case IR_Instruction_Type::VARIABLE_DEFINITION: {
-        string_append_formated(string, "VARIABLE_DEFINITION %s", instruction->options.variable_definition.symbol->id->characters);
+        string_append(string, "VARIABLE_DEFINITION ");
+        string_append(string, instruction->options.variable_definition.symbol->id->characters);
         if (instruction->options.variable_definition.initial_value.available) {
             string_append(string, ", value: ");
             ir_data_access_append_to_string(instruction->options.variable_definition.initial_value.value, string, code_block, compilation_data);
@@ -230,17 +196,19 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
         break;
     }
     case IR_Instruction_Type::GOTO: {
-        string_append_formated(string, "GOTO %d", instruction->options.label_index);
+        string_append(string, "GOTO ");
+        string_append_i64(string, instruction->options.label_index);
         break;
     }
     case IR_Instruction_Type::LABEL: {
-        string_append_formated(string, "LABEL %d", instruction->options.label_index);
+        string_append(string, "LABEL ");
+        string_append_i64(string, instruction->options.label_index);
         break;
     }
     case IR_Instruction_Type::FUNCTION_CALL:
     {
         IR_Instruction_Call* call = &instruction->options.call;
-        string_append_formated(string, "FUNCTION_CALL\n");
+        string_append(string, "FUNCTION_CALL\n");
         indent_string(string, indentation + 1);
 
         Call_Signature* function_sig;
@@ -264,44 +232,46 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
         }
         if (function_sig != 0) {
             if (function_sig->return_type().available) {
-                string_append_formated(string, "dst: ");
+                string_append(string, "dst: ");
                 ir_data_access_append_to_string(call->destination, string, code_block, compilation_data);
-                string_append_formated(string, "\n");
+                string_append(string, "\n");
                 indent_string(string, indentation + 1);
             }
         }
-        string_append_formated(string, "args: (%d)\n", call->arguments.size);
+        string_append(string, "args: (");
+        string_append_i64(string, call->arguments.size);
+        string_append(string, ")\n");
         for (int i = 0; i < call->arguments.size; i++) {
             indent_string(string, indentation + 2);
             ir_data_access_append_to_string(call->arguments[i], string, code_block, compilation_data);
-            string_append_formated(string, "\n");
+            string_append(string, "\n");
         }
 
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Call-Type: ");
+        string_append(string, "Call-Type: ");
         switch (call->call_type)
         {
         case IR_Instruction_Call_Type::FUNCTION_CALL:
-            string_append_formated(string, "FUNCTION (later)");
+            string_append(string, "FUNCTION (later)");
             break;
         case IR_Instruction_Call_Type::FUNCTION_POINTER_CALL:
-            string_append_formated(string, "FUNCTION_POINTER_CALL, access: ");
+            string_append(string, "FUNCTION_POINTER_CALL, access: ");
             ir_data_access_append_to_string(call->options.pointer_access, string, code_block, compilation_data);
             break;
         case IR_Instruction_Call_Type::BUILTIN_CALL:
-            string_append_formated(string, "BUILTIN_CALL, type: ");
+            string_append(string, "BUILTIN_CALL, type: ");
             string->append(ir_builtin_fn_as_string(call->options.builtin_fn));
             break;
         }
         break;
     }
     case IR_Instruction_Type::IF: {
-        string_append_formated(string, "IF ");
+        string_append(string, "IF ");
         ir_data_access_append_to_string(instruction->options.if_instr.condition, string, code_block, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
         ir_code_block_append_to_string(instruction->options.if_instr.true_branch, string, indentation + 1, compilation_data);
         indent_string(string, indentation);
-        string_append_formated(string, "ELSE\n");
+        string_append(string, "ELSE\n");
         ir_code_block_append_to_string(instruction->options.if_instr.false_branch, string, indentation + 1, compilation_data);
         break;
     }
@@ -317,44 +287,46 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
             assert(value_type->type == Datatype_Type::ENUM, "If not union, this must be an enum");
             enum_type = downcast<Datatype_Enum>(value_type);
         }
-        string_append_formated(string, "MATCH\n");
+        string_append(string, "MATCH\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Condition access: ");
+        string_append(string, "Condition access: ");
         ir_data_access_append_to_string(instruction->options.switch_instr.condition_access, string, code_block, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
         for (int i = 0; i < instruction->options.switch_instr.cases.size; i++) {
             IR_Switch_Case* switch_case = &instruction->options.switch_instr.cases[i];
             indent_string(string, indentation + 1);
             Optional<Enum_Member> member = enum_type_find_member_by_value(enum_type, switch_case->value);
             assert(member.available, "");
-            string_append_formated(string, "Case %s: \n", member.value.name->characters);
+            string_append(string, "Case ");
+            string_append(string, member.value.name->characters);
+            string_append(string, ": \n");
             ir_code_block_append_to_string(switch_case->block, string, indentation + 2, compilation_data);
         }
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Default case: \n");
+        string_append(string, "Default case: \n");
         ir_code_block_append_to_string(instruction->options.switch_instr.default_block, string, indentation + 2, compilation_data);
         break;
     }
     case IR_Instruction_Type::MOVE: {
-        string_append_formated(string, "MOVE\n", instruction->options.label_index);
+        string_append(string, "MOVE\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string,   "Source:      ");
+        string_append(string, "Source:      ");
         ir_data_access_append_to_string(instruction->options.move.source, string, code_block, compilation_data);
-        string_append_formated(string, "\nDestination: ");
+        string_append(string, "\nDestination: ");
         ir_data_access_append_to_string(instruction->options.move.destination, string, code_block, compilation_data);
         break;
     }
     case IR_Instruction_Type::WHILE: {
-        string_append_formated(string, "WHILE\n");
+        string_append(string, "WHILE\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Condition code: \n");
+        string_append(string, "Condition code: \n");
         ir_code_block_append_to_string(instruction->options.while_instr.condition_code, string, indentation + 2, compilation_data);
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Condition access: ");
+        string_append(string, "Condition access: ");
         ir_data_access_append_to_string(instruction->options.while_instr.condition_access, string, code_block, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
         indent_string(string, indentation + 1);
-        string_append_formated(string, "Body: \n");
+        string_append(string, "Body: \n");
         ir_code_block_append_to_string(instruction->options.while_instr.code, string, indentation + 2, compilation_data);
         break;
     }
@@ -363,15 +335,15 @@ void ir_instruction_append_to_string(IR_Instruction* instruction, String* string
         switch (return_instr->type)
         {
         case IR_Instruction_Return_Type::EXIT:
-            string_append_formated(string, "EXIT ");
+            string_append(string, "EXIT ");
             exit_code_append_to_string(string, return_instr->options.exit_code);
             break;
         case IR_Instruction_Return_Type::RETURN_DATA:
-            string_append_formated(string, "RETURN ");
+            string_append(string, "RETURN ");
             ir_data_access_append_to_string(return_instr->options.return_value, string, code_block, compilation_data);
             break;
         case IR_Instruction_Return_Type::RETURN_EMPTY:
-            string_append_formated(string, "RETURN");
+            string_append(string, "RETURN");
             break;
         }
         break;
@@ -385,24 +357,30 @@ void ir_code_block_append_to_string(IR_Code_Block* code_block, String* string, i
     auto type_system = compilation_data->type_system;
 
     indent_string(string, indentation);
-    string_append_formated(string, "Registers:\n");
+    string_append(string, "Registers:\n");
     for (int i = 0; i < code_block->registers.size; i++) {
         auto& reg = code_block->registers[i];
         indent_string(string, indentation + 1);
         if (reg.name.available) {
-            string_append_formated(string, "#%d %s: ", i, reg.name.value->characters);
+            string_append(string, "#");
+            string_append_i64(string, i);
+            string_append(string, " ");
+            string_append(string, reg.name.value->characters);
+            string_append(string, ": ");
         }
         else {
-            string_append_formated(string, "#%d: ", i);
+            string_append(string, "#");
+            string_append_i64(string, i);
+            string_append(string, ": ");
         }
         datatype_append_to_string(reg.type, string, type_system);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
     }
     indent_string(string, indentation);
-    string_append_formated(string, "Instructions:\n");
+    string_append(string, "Instructions:\n");
     for (int i = 0; i < code_block->instructions.size; i++) {
         ir_instruction_append_to_string(&code_block->instructions[i], string, indentation + 1, code_block, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
     }
 }
 
@@ -411,15 +389,15 @@ void function_ir_append_to_string(Upp_Function* function, String* string, int in
     auto type_system = compilation_data->type_system;
 
     indent_string(string, indentation);
-    string_append_formated(string, "Function-Type:");
+    string_append(string, "Function-Type:");
     call_signature_append_to_string(function->signature, string, type_system, datatype_format_make_default());
-    string_append_formated(string, "\n");
+    string_append(string, "\n");
     ir_code_block_append_to_string(function->ir_block, string, indentation, compilation_data);
 }
 
 void ir_program_append_to_string(String* string, bool print_generated_functions, Compilation_Data* compilation_data)
 {
-    string_append_formated(string, "Program Dump:\n-----------------\n");
+    string_append(string, "Program Dump:\n-----------------\n");
     for (int i = 0; i < compilation_data->functions.size; i++)
     {
         auto function = compilation_data->functions[i];
@@ -430,9 +408,11 @@ void ir_program_append_to_string(String* string, bool print_generated_functions,
             continue;
         }
 
-        string_append_formated(string, "Function #%d ", i);
+        string_append(string, "Function #");
+        string_append_i64(string, i);
+        string_append(string, " ");
         function_ir_append_to_string(function, string, 0, compilation_data);
-        string_append_formated(string, "\n");
+        string_append(string, "\n");
     }
 }
 
@@ -449,7 +429,7 @@ static IR_Instruction* add_instruction(IR_Instruction& instruction, IR_Code_Bloc
     instruction.associated_expr = gen.current_expr;
     instruction.associated_statement = gen.current_statement;
     instruction.associated_pass = gen.current_pass;
-    dynamic_array_push_back(&ir_block->instructions, instruction);
+    ir_block->instructions.push_back(instruction);
     return &ir_block->instructions[ir_block->instructions.size - 1];
 }
 
@@ -483,34 +463,31 @@ IR_Instruction_Operation* add_move_instruction(IR_Data_Access* destination, IR_D
 
 IR_Data_Access* ir_data_access_create_global(Upp_Global* global)
 {
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = global->type;
     access->type = IR_Data_Access_Type::GLOBAL_DATA;
     access->option.global_index = global->index;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
 IR_Data_Access* ir_data_access_create_parameter(Upp_Function* function, int parameter_index)
 {
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = function->signature->parameters[parameter_index].datatype;
     access->type = IR_Data_Access_Type::PARAMETER;
     access->option.parameter.function = function;
     access->option.parameter.index = parameter_index;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
 IR_Data_Access* ir_data_access_create_register(int register_index)
 {
     auto& gen = *ir_generator;
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = gen.current_block->registers[register_index].type;
     access->type = IR_Data_Access_Type::REGISTER;
     access->option.register_access.definition_block = gen.current_block;
     access->option.register_access.index = register_index;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
@@ -521,18 +498,17 @@ IR_Data_Access* ir_data_access_create_intermediate(Datatype* signature)
     assert(!datatype_is_unknown(signature), "Cannot have register with unknown type");
     assert(!type_size_is_unfinished(signature), "Cannot have register with 0 size!");
 
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = signature;
     access->type = IR_Data_Access_Type::REGISTER;
     access->option.register_access.definition_block = gen.current_block;
     access->option.register_access.index = gen.current_block->registers.size;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
 
     IR_Register reg;
     reg.type = signature;
     reg.name.available = false;
     reg.has_definition_instruction = false;
-    dynamic_array_push_back(&gen.current_block->registers, reg);
+    gen.current_block->registers.push_back(reg);
 
     return access;
 }
@@ -547,21 +523,19 @@ IR_Data_Access* ir_data_access_create_dereference(IR_Data_Access* pointer_access
     Datatype* ptr_type = pointer_access->datatype;
     assert(ptr_type->type == Datatype_Type::POINTER, "");
 
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = downcast<Datatype_Pointer>(ptr_type)->element_type;
     access->type = IR_Data_Access_Type::POINTER_DEREFERENCE;
     access->option.pointer_value = pointer_access;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
 IR_Data_Access* ir_data_access_create_non_destructive_cast(IR_Data_Access* value_access, Datatype* result_type)
 {
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = result_type;
     access->type = IR_Data_Access_Type::NON_DESTRUCTIVE_CAST;
     access->option.non_destructive_cast.value_access = value_access;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
@@ -572,22 +546,20 @@ IR_Data_Access* ir_data_access_create_address_of(IR_Data_Access* value_access)
         return value_access->option.pointer_value;
     }
 
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = upcast(type_system_make_pointer(ir_generator->compilation_data->type_system, value_access->datatype));
     access->type = IR_Data_Access_Type::ADDRESS_OF_VALUE;
     access->option.address_of_value = value_access;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
 IR_Data_Access* ir_data_access_create_member(IR_Data_Access* struct_access, Struct_Member member)
 {
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = member.datatype;
     access->type = IR_Data_Access_Type::MEMBER_ACCESS;
     access->option.member_access.struct_access = struct_access;
     access->option.member_access.member = member;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
@@ -642,12 +614,11 @@ IR_Data_Access* ir_data_access_create_array_or_slice_access(IR_Data_Access* arra
         add_instruction(exit_instr, if_instr.options.if_instr.true_branch);
     }
 
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = element_type;
     access->type = IR_Data_Access_Type::ARRAY_ELEMENT_ACCESS;
     access->option.array_access.array_access = array_access;
     access->option.array_access.index_access = index_access;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
@@ -656,21 +627,19 @@ IR_Data_Access* ir_data_access_create_constant(Datatype* signature, Array<byte>
     auto result = constant_pool_add_constant(ir_generator->compilation_data->constant_pool, signature, bytes);
     assert(result.success, "Must always work");
 
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = result.options.constant.type;
     access->type = IR_Data_Access_Type::CONSTANT;
     access->option.constant_index = result.options.constant.constant_index;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
 IR_Data_Access* ir_data_access_create_constant(Upp_Constant constant)
 {
-    IR_Data_Access* access = new IR_Data_Access;
+    IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
     access->datatype = constant.type;
     access->type = IR_Data_Access_Type::CONSTANT;
     access->option.constant_index = constant.constant_index;
-    dynamic_array_push_back(&ir_generator->data_accesses, access);
     return access;
 }
 
@@ -840,8 +809,8 @@ IR_Data_Access* ir_generator_generate_cast(IR_Data_Access* source, IR_Data_Acces
         IR_Instruction instr;
         instr.type = IR_Instruction_Type::FUNCTION_CALL;
         instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
-        instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(1);
-        dynamic_array_push_back(&instr.options.call.arguments, source);
+        instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, 1);
+        instr.options.call.arguments.push_back(source);
         if (to_by_ref) {
             instr.options.call.destination = ir_data_access_create_intermediate(function->signature->return_type().value);
         }
@@ -904,12 +873,12 @@ IR_Data_Access* ir_generator_generate_custom_operator_call(
     IR_Instruction instr;
     instr.type = IR_Instruction_Type::FUNCTION_CALL;
     instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
-    instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(access1 == nullptr ? 1 : 2);
+    instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, access1 == nullptr ? 1 : 2);
     if (access0 != nullptr) {
-        dynamic_array_push_back(&instr.options.call.arguments, access0);
+        instr.options.call.arguments.push_back(access0);
     }
     if (access1 != nullptr) {
-        dynamic_array_push_back(&instr.options.call.arguments, access1);
+        instr.options.call.arguments.push_back(access1);
     }
     if (instance.custom_op->result_by_reference) {
         instr.options.call.destination = ir_data_access_create_intermediate(instance_function->signature->return_type().value);
@@ -1120,7 +1089,7 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
                 // Create function if not cached
                 if (enumeration->value_as_string_fn == nullptr)
                 {
-                    Call_Signature* signature = call_signature_create_empty();
+                    Call_Signature* signature = call_signature_create_empty(compilation_data);
                     call_signature_add_parameter(signature, ids.value, datatype, true, false, false);
                     call_signature_add_return_type(signature, upcast(types.string), compilation_data);
                     signature = call_signature_register(signature, compilation_data);
@@ -1148,7 +1117,7 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
                     switch_instr.type = IR_Instruction_Type::MATCH;
                     switch_instr.options.switch_instr.condition_access = ir_data_access_create_parameter(function, 0);
                     switch_instr.options.switch_instr.default_block = ir_code_block_create(function);
-                    switch_instr.options.switch_instr.cases = dynamic_array_create<IR_Switch_Case>();
+                    switch_instr.options.switch_instr.cases = DynArray<IR_Switch_Case>::create(&ir_generator->arena);
                     {
                         RESTORE_ON_SCOPE_EXIT(ir_generator->current_block, switch_instr.options.switch_instr.default_block);
                         IR_Instruction return_instr;
@@ -1167,7 +1136,7 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
                         switch_case.value = member.value;
 
                         RESTORE_ON_SCOPE_EXIT(ir_generator->current_block, switch_case.block);
-                        dynamic_array_push_back(&switch_instr.options.switch_instr.cases, switch_case);
+                        switch_instr.options.switch_instr.cases.push_back(switch_case);
 
                         IR_Instruction return_instr;
                         return_instr.type = IR_Instruction_Type::RETURN;
@@ -1192,10 +1161,8 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
                 call_instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
                 call_instr.options.call.options.function = enumeration->value_as_string_fn;
                 call_instr.options.call.destination = make_destination_access_on_demand(upcast(types.string));
-                call_instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>();
-                dynamic_array_push_back(
-                    &call_instr.options.call.arguments, ir_generator_generate_expression(arg_expr)
-                );
+                call_instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena);
+                call_instr.options.call.arguments.push_back(ir_generator_generate_expression(arg_expr));
                 add_instruction(call_instr);
 
                 return destination;
@@ -1261,7 +1228,7 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
         }
 
         // Generate arguments 
-        call_instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(signature->parameters.size);
+        call_instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, signature->parameters.size);
         for (int i = 0; i < call_info->parameter_values.size && i != call_info->origin.signature->return_type_index; i++)
         {
             auto& param_info = call_info->origin.signature->parameters[i];
@@ -1283,7 +1250,7 @@ IR_Data_Access* ir_generator_generate_expression_no_cast(AST::Expression* expres
             {
                 panic("We don't have default arguments anymore, so this shouldn't happen");
             }
-            dynamic_array_push_back(&call_instr.options.call.arguments, argument_access);
+            call_instr.options.call.arguments.push_back(argument_access);
         }
 
         add_instruction(call_instr);
@@ -1715,7 +1682,7 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
         var_reg.has_definition_instruction = true;
         var_reg.name = optional_make_success(value_node->symbol->name);
         var_reg.type = variable_symbol->options.variable_type;
-        dynamic_array_push_back(&ir_block->registers, var_reg);
+        ir_block->registers.push_back(var_reg);
         IR_Data_Access* variable_access = ir_data_access_create_register(ir_block->registers.size - 1);
         bool success = hashtable_insert_element(&ir_generator->variable_mapping, variable_symbol, variable_access);
         assert(success, "Variable symbols should not be encountered twice");
@@ -1777,7 +1744,7 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
         IR_Instruction instr;
         instr.type = IR_Instruction_Type::MATCH;
         instr.options.switch_instr.condition_access = condition_access;
-        instr.options.switch_instr.cases = dynamic_array_create<IR_Switch_Case>(statement->options.match_statement.cases.size);
+        instr.options.switch_instr.cases = DynArray<IR_Switch_Case>::create(&ir_generator->arena, statement->options.match_statement.cases.size);
 
         // Check for subtype access
         auto cond_type = instr.options.switch_instr.condition_access->datatype;
@@ -1811,7 +1778,7 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
             }
 
             ir_generator_generate_block(new_case.block, case_node->block);
-            dynamic_array_push_back(&instr.options.switch_instr.cases, new_case);
+            instr.options.switch_instr.cases.push_back(new_case);
         }
 
         instr.options.switch_instr.default_block = ir_code_block_create(ir_block->function);
@@ -1918,12 +1885,12 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
                 iter_create_instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
                 iter_create_instr.options.call.destination = iterator_access;
                 iter_create_instr.options.call.options.function = overload.instance_functions[0];
-                iter_create_instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(1);
+                iter_create_instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, 1);
                 if (overload.custom_op->parameters[0].by_reference) {
-                    dynamic_array_push_back(&iter_create_instr.options.call.arguments, ir_data_access_create_address_of(iterable_access));
+                    iter_create_instr.options.call.arguments.push_back(ir_data_access_create_address_of(iterable_access));
                 }
                 else {
-                    dynamic_array_push_back(&iter_create_instr.options.call.arguments, iterable_access);
+                    iter_create_instr.options.call.arguments.push_back(iterable_access);
                 }
                 add_instruction(iter_create_instr);
                 assert(iter_create_instr.options.call.options.function != nullptr, "");
@@ -1972,8 +1939,8 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
                     next_call_instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
                     next_call_instr.options.call.destination = loop_variable_access;
                     next_call_instr.options.call.options.function = overload.instance_functions[1];
-                    next_call_instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(1);
-                    dynamic_array_push_back(&next_call_instr.options.call.arguments, ir_data_access_create_address_of(iterator_access));
+                    next_call_instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, 1);
+                    next_call_instr.options.call.arguments.push_back(ir_data_access_create_address_of(iterator_access));
                     add_instruction(next_call_instr, condition_code);
 
                     void* empty = nullptr;
@@ -2127,9 +2094,9 @@ void ir_generator_generate_statement(AST::Statement* statement, IR_Code_Block* i
             call.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
             call.options.call.destination = left_access;
             call.options.call.options.function = info->specifics.overload.instance_functions[0];
-            call.options.call.arguments = dynamic_array_create<IR_Data_Access*>(2);
-            dynamic_array_push_back(&call.options.call.arguments, left_access);
-            dynamic_array_push_back(&call.options.call.arguments, right_access);
+            call.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, 2);
+            call.options.call.arguments.push_back(left_access);
+            call.options.call.arguments.push_back(right_access);
             add_instruction(call);
             break;
         }
@@ -2168,6 +2135,7 @@ void ir_generator_generate_block(IR_Code_Block* ir_block, AST::Code_Block* ast_b
 
 void ir_generator_generate_function(Upp_Function* function, Compilation_Data* compilation_data)
 {
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::IR);
     Timing_Task before_task = compilation_data->task_current;
     SCOPE_EXIT(compilation_data_switch_timing_task(compilation_data, before_task));
     compilation_data_switch_timing_task(compilation_data, Timing_Task::CODE_GEN);
@@ -2271,8 +2239,9 @@ void ir_generator_finish(Compilation_Data* compilation_data)
             IR_Instruction call_instr;
             call_instr.type = IR_Instruction_Type::FUNCTION_CALL;
             call_instr.options.call.call_type = IR_Instruction_Call_Type::FUNCTION_CALL;
-            call_instr.options.call.arguments = dynamic_array_create<IR_Data_Access*>(1);
+            call_instr.options.call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, 1);
             call_instr.options.call.options.function = compilation_data->main_function;
+            call_instr.options.call.destination = ir_data_access_create_nothing();
             add_instruction(call_instr);
             assert(call_instr.options.call.options.function != nullptr, "");
         }
@@ -2288,6 +2257,703 @@ void ir_generator_finish(Compilation_Data* compilation_data)
     }
 }
 
+// Purity Analysis
+// Note: A function is pure if its result only depends on the argument values, so results of comptime calls can be memoized.
+//       Calls cycles are handled optimistically, results that depend on functions still on the stack are not cached.
+struct Purity_Analysis
+{
+    Dynamic_Array<Upp_Function*> function_stack;
+    int lowest_dependency_depth; // Lowest stack-depth of an in-progress function we depend on
+};
+
+static bool ir_function_calculate_purity(Upp_Function* function, Purity_Analysis* analysis);
+
+static bool ir_data_access_is_pure(IR_Data_Access* access)
+{
+    switch (access->type)
+    {
+    case IR_Data_Access_Type::GLOBAL_DATA: return false;
+    case IR_Data_Access_Type::CONSTANT:
+    case IR_Data_Access_Type::PARAMETER:
+    case IR_Data_Access_Type::REGISTER:
+    case IR_Data_Access_Type::NOTHING: return true;
+    case IR_Data_Access_Type::MEMBER_ACCESS: return ir_data_access_is_pure(access->option.member_access.struct_access);
+    case IR_Data_Access_Type::ARRAY_ELEMENT_ACCESS: 
+        return ir_data_access_is_pure(access->option.array_access.array_access) && ir_data_access_is_pure(access->option.array_access.index_access);
+    case IR_Data_Access_Type::POINTER_DEREFERENCE: return ir_data_access_is_pure(access->option.pointer_value);
+    case IR_Data_Access_Type::ADDRESS_OF_VALUE: return ir_data_access_is_pure(access->option.address_of_value);
+    case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST: return ir_data_access_is_pure(access->option.non_destructive_cast.value_access);
+    default: panic("");
+    }
+    return false;
+}
+
+static bool ir_code_block_is_pure(IR_Code_Block* block, Purity_Analysis* analysis)
+{
+    for (int i = 0; i < block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &block->instructions[i];
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::IF: {
+            auto& if_instr = instr->options.if_instr;
+            if (!ir_data_access_is_pure(if_instr.condition)) return false;
+            if (!ir_code_block_is_pure(if_instr.true_branch, analysis)) return false;
+            if (!ir_code_block_is_pure(if_instr.false_branch, analysis)) return false;
+            break;
+        }
+        case IR_Instruction_Type::WHILE: {
+            auto& while_instr = instr->options.while_instr;
+            if (!ir_code_block_is_pure(while_instr.condition_code, analysis)) return false;
+            if (!ir_data_access_is_pure(while_instr.condition_access)) return false;
+            if (!ir_code_block_is_pure(while_instr.code, analysis)) return false;
+            break;
+        }
+        case IR_Instruction_Type::MATCH: {
+            auto& switch_instr = instr->options.switch_instr;
+            if (!ir_data_access_is_pure(switch_instr.condition_access)) return false;
+            for (int j = 0; j < switch_instr.cases.size; j++) {
+                if (!ir_code_block_is_pure(switch_instr.cases[j].block, analysis)) return false;
+            }
+            if (!ir_code_block_is_pure(switch_instr.default_block, analysis)) return false;
+            break;
+        }
+        case IR_Instruction_Type::BLOCK: {
+            if (!ir_code_block_is_pure(instr->options.block, analysis)) return false;
+            break;
+        }
+        case IR_Instruction_Type::FUNCTION_CALL:
+        {
+            auto& call = instr->options.call;
+            switch (call.call_type)
+            {
+            case IR_Instruction_Call_Type::FUNCTION_CALL: {
+                if (!ir_function_calculate_purity(call.options.function, analysis)) return false;
+                break;
+            }
+            case IR_Instruction_Call_Type::FUNCTION_POINTER_CALL: return false;
+            case IR_Instruction_Call_Type::BUILTIN_CALL: 
+            {
+                // Memory builtins only operate on memory reachable from arguments/locals, which cannot contain references
+                switch (call.options.builtin_fn)
+                {
+                case IR_Builtin_Function::TYPE_INFO:
+                case IR_Builtin_Function::MEMORY_COPY:
+                case IR_Builtin_Function::MEMORY_COPY_NO_OVERLAP:
+                case IR_Builtin_Function::MEMORY_ZERO:
+                case IR_Builtin_Function::MEMORY_COMPARE: break;
+                default: return false;
+                }
+                break;
+            }
+            default: panic("");
+            }
+
+            for (int j = 0; j < call.arguments.size; j++) {
+                if (!ir_data_access_is_pure(call.arguments[j])) return false;
+            }
+            if (!ir_data_access_is_pure(call.destination)) return false;
+            break;
+        }
+        case IR_Instruction_Type::RETURN: {
+            auto& return_instr = instr->options.return_instr;
+            if (return_instr.type == IR_Instruction_Return_Type::RETURN_DATA && !ir_data_access_is_pure(return_instr.options.return_value)) {
+                return false;
+            }
+            break;
+        }
+        case IR_Instruction_Type::MOVE: {
+            if (!ir_data_access_is_pure(instr->options.move.source)) return false;
+            if (!ir_data_access_is_pure(instr->options.move.destination)) return false;
+            break;
+        }
+        case IR_Instruction_Type::OPERATION: {
+            auto& op = instr->options.operation;
+            if (!ir_data_access_is_pure(op.destination) || !ir_data_access_is_pure(op.operand_1)) return false;
+            if (ir_operation_parameter_count(op.type) == 2 && !ir_data_access_is_pure(op.operand_2)) return false;
+            break;
+        }
+        case IR_Instruction_Type::VARIABLE_DEFINITION: {
+            auto& definition = instr->options.variable_definition;
+            if (!ir_data_access_is_pure(definition.variable_access)) return false;
+            if (definition.initial_value.available && !ir_data_access_is_pure(definition.initial_value.value)) return false;
+            break;
+        }
+        case IR_Instruction_Type::FUNCTION_ADDRESS: return false; // Function pointers may escape the function
+        case IR_Instruction_Type::LABEL:
+        case IR_Instruction_Type::GOTO: break;
+        default: panic("");
+        }
+    }
+
+    return true;
+}
+
+static bool ir_function_calculate_purity(Upp_Function* function, Purity_Analysis* analysis)
+{
+    switch (function->purity)
+    {
+    case Function_Purity::PURE: return true;
+    case Function_Purity::IMPURE: return false;
+    case Function_Purity::IN_PROGRESS: {
+        for (int i = 0; i < analysis->function_stack.size; i++) {
+            if (analysis->function_stack[i] == function) {
+                analysis->lowest_dependency_depth = math_minimum(analysis->lowest_dependency_depth, i);
+                break;
+            }
+        }
+        return true;
+    }
+    case Function_Purity::UNKNOWN: break;
+    default: panic("");
+    }
+
+    if (function->is_extern || function->contains_errors) {
+        function->purity = Function_Purity::IMPURE;
+        return false;
+    }
+    if (function->ir_block == nullptr || function->signature == nullptr) {
+        analysis->lowest_dependency_depth = -1; // Cannot be decided yet, so don't cache callers
+        return false;
+    }
+
+    // Parameters and return value must not contain references, otherwise results depend on memory outside of arguments
+    auto& params = function->signature->parameters;
+    for (int i = 0; i < params.size; i++) 
+    {
+        auto& memory_info = params[i].datatype->memory_info;
+        if (!memory_info.available) {
+            analysis->lowest_dependency_depth = -1;
+            return false;
+        }
+        if (memory_info.value.contains_reference) {
+            function->purity = Function_Purity::IMPURE;
+            return false;
+        }
+    }
+
+    int depth = analysis->function_stack.size;
+    int dependency_depth_before = analysis->lowest_dependency_depth;
+    analysis->lowest_dependency_depth = depth;
+    dynamic_array_push_back(&analysis->function_stack, function);
+    function->purity = Function_Purity::IN_PROGRESS;
+
+    bool is_pure = ir_code_block_is_pure(function->ir_block, analysis);
+
+    dynamic_array_rollback_to_size(&analysis->function_stack, depth);
+    if (analysis->lowest_dependency_depth >= depth || (!is_pure && analysis->lowest_dependency_depth >= 0)) {
+        function->purity = is_pure ? Function_Purity::PURE : Function_Purity::IMPURE;
+    }
+    else {
+        function->purity = Function_Purity::UNKNOWN;
+    }
+    analysis->lowest_dependency_depth = math_minimum(dependency_depth_before, analysis->lowest_dependency_depth);
+    return is_pure;
+}
+
+bool ir_function_is_pure(Upp_Function* function)
+{
+    if (function->purity == Function_Purity::PURE) return true;
+    if (function->purity == Function_Purity::IMPURE) return false;
+
+    Purity_Analysis analysis;
+    analysis.function_stack = dynamic_array_create<Upp_Function*>();
+    SCOPE_EXIT(dynamic_array_destroy(&analysis.function_stack));
+    analysis.lowest_dependency_depth = 0;
+    return ir_function_calculate_purity(function, &analysis);
+}
+
+// Inlining
+IR_Inline_Settings ir_inline_settings_from_optimization_level(int optimization_level)
+{
+    IR_Inline_Settings settings;
+    switch (optimization_level)
+    {
+    case 0: settings.max_callee_instructions = 0;  settings.max_hot_callee_instructions = 0;  settings.max_depth = 0; break;
+    case 1: settings.max_callee_instructions = 12; settings.max_hot_callee_instructions = 40; settings.max_depth = 2; break;
+    default: settings.max_callee_instructions = 40; settings.max_hot_callee_instructions = 80; settings.max_depth = 4; break;
+    }
+    return settings;
+}
+
+struct IR_Inline_Copy
+{
+    Upp_Function* callee;
+    Upp_Function* caller;
+    Dynamic_Array<IR_Data_Access*> parameter_registers; // Parameter index to register in inline block
+    IR_Data_Access* return_destination;
+    int return_label_index;
+    Hashtable<IR_Code_Block*, IR_Code_Block*> block_mapping;
+    Hashtable<int, int> label_mapping;
+};
+
+struct IR_Inliner
+{
+    IR_Inline_Settings settings;
+    Upp_Function* current_function;
+    Dynamic_Array<Upp_Function*> inline_stack; // Prevents inlining recursive functions
+};
+
+static int ir_code_block_instruction_count(IR_Code_Block* block)
+{
+    int count = 0;
+    for (int i = 0; i < block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &block->instructions[i];
+        count += 1;
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::IF: 
+            count += ir_code_block_instruction_count(instr->options.if_instr.true_branch);
+            count += ir_code_block_instruction_count(instr->options.if_instr.false_branch);
+            break;
+        case IR_Instruction_Type::WHILE:
+            count += ir_code_block_instruction_count(instr->options.while_instr.condition_code);
+            count += ir_code_block_instruction_count(instr->options.while_instr.code);
+            break;
+        case IR_Instruction_Type::MATCH:
+            for (int j = 0; j < instr->options.switch_instr.cases.size; j++) {
+                count += ir_code_block_instruction_count(instr->options.switch_instr.cases[j].block);
+            }
+            count += ir_code_block_instruction_count(instr->options.switch_instr.default_block);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            count += ir_code_block_instruction_count(instr->options.block);
+            break;
+        default: break;
+        }
+    }
+    return count;
+}
+
+static int ir_generator_allocate_label(IR_Code_Block* block, int instruction_index)
+{
+    IR_Instruction_Reference ref;
+    ref.block = block;
+    ref.index = instruction_index;
+    dynamic_array_push_back(&ir_generator->label_positions, ref);
+    return ir_generator->label_positions.size;
+}
+
+static int ir_inline_copy_map_label(IR_Inline_Copy* copy, int label_index, IR_Code_Block* block)
+{
+    int* mapped = hashtable_find_element(&copy->label_mapping, label_index);
+    if (mapped != nullptr) return *mapped;
+    int new_label_index = ir_generator_allocate_label(block, block->instructions.size);
+    hashtable_insert_element(&copy->label_mapping, label_index, new_label_index);
+    return new_label_index;
+}
+
+static IR_Data_Access* ir_inline_copy_data_access(IR_Inline_Copy* copy, IR_Data_Access* access)
+{
+    switch (access->type)
+    {
+    case IR_Data_Access_Type::GLOBAL_DATA:
+    case IR_Data_Access_Type::CONSTANT:
+    case IR_Data_Access_Type::NOTHING: return access; // Don't reference callee data, so they can be shared
+    case IR_Data_Access_Type::PARAMETER: {
+        assert(access->option.parameter.function == copy->callee, "");
+        return copy->parameter_registers[access->option.parameter.index];
+    }
+    default: break;
+    }
+
+    IR_Data_Access* result = ir_generator->arena.allocate<IR_Data_Access>();
+    *result = *access;
+    switch (access->type)
+    {
+    case IR_Data_Access_Type::REGISTER: {
+        IR_Code_Block** mapped = hashtable_find_element(&copy->block_mapping, access->option.register_access.definition_block);
+        assert(mapped != nullptr, "Register definition block must be copied before usage");
+        result->option.register_access.definition_block = *mapped;
+        break;
+    }
+    case IR_Data_Access_Type::MEMBER_ACCESS:
+        result->option.member_access.struct_access = ir_inline_copy_data_access(copy, access->option.member_access.struct_access);
+        break;
+    case IR_Data_Access_Type::ARRAY_ELEMENT_ACCESS:
+        result->option.array_access.array_access = ir_inline_copy_data_access(copy, access->option.array_access.array_access);
+        result->option.array_access.index_access = ir_inline_copy_data_access(copy, access->option.array_access.index_access);
+        break;
+    case IR_Data_Access_Type::POINTER_DEREFERENCE:
+        result->option.pointer_value = ir_inline_copy_data_access(copy, access->option.pointer_value);
+        break;
+    case IR_Data_Access_Type::ADDRESS_OF_VALUE:
+        result->option.address_of_value = ir_inline_copy_data_access(copy, access->option.address_of_value);
+        break;
+    case IR_Data_Access_Type::NON_DESTRUCTIVE_CAST:
+        result->option.non_destructive_cast.value_access = ir_inline_copy_data_access(copy, access->option.non_destructive_cast.value_access);
+        break;
+    default: panic("");
+    }
+    return result;
+}
+
+static IR_Code_Block* ir_inline_copy_code_block(IR_Inline_Copy* copy, IR_Code_Block* block, IR_Code_Block* parent_block, int parent_instruction_index);
+
+static void ir_inline_copy_instruction(IR_Inline_Copy* copy, IR_Instruction* instr, IR_Code_Block* block)
+{
+    IR_Instruction result = *instr;
+    int index = block->instructions.size;
+    switch (instr->type)
+    {
+    case IR_Instruction_Type::MOVE:
+        result.options.move.source = ir_inline_copy_data_access(copy, instr->options.move.source);
+        result.options.move.destination = ir_inline_copy_data_access(copy, instr->options.move.destination);
+        break;
+    case IR_Instruction_Type::OPERATION: {
+        auto& op = result.options.operation;
+        op.destination = ir_inline_copy_data_access(copy, instr->options.operation.destination);
+        op.operand_1 = ir_inline_copy_data_access(copy, instr->options.operation.operand_1);
+        op.operand_2 = ir_inline_copy_data_access(copy, instr->options.operation.operand_2);
+        break;
+    }
+    case IR_Instruction_Type::FUNCTION_CALL: {
+        auto& call = result.options.call;
+        call.arguments = DynArray<IR_Data_Access*>::create(&ir_generator->arena, instr->options.call.arguments.size);
+        for (int i = 0; i < instr->options.call.arguments.size; i++) {
+            call.arguments.push_back(ir_inline_copy_data_access(copy, instr->options.call.arguments[i]));
+        }
+        call.destination = ir_inline_copy_data_access(copy, instr->options.call.destination);
+        if (call.call_type == IR_Instruction_Call_Type::FUNCTION_POINTER_CALL) {
+            call.options.pointer_access = ir_inline_copy_data_access(copy, instr->options.call.options.pointer_access);
+        }
+        break;
+    }
+    case IR_Instruction_Type::IF: {
+        auto& if_instr = result.options.if_instr;
+        if_instr.condition = ir_inline_copy_data_access(copy, instr->options.if_instr.condition);
+        if_instr.true_branch = ir_inline_copy_code_block(copy, instr->options.if_instr.true_branch, block, index);
+        if_instr.false_branch = ir_inline_copy_code_block(copy, instr->options.if_instr.false_branch, block, index);
+        break;
+    }
+    case IR_Instruction_Type::WHILE: {
+        auto& while_instr = result.options.while_instr;
+        while_instr.condition_code = ir_inline_copy_code_block(copy, instr->options.while_instr.condition_code, block, index);
+        while_instr.condition_access = ir_inline_copy_data_access(copy, instr->options.while_instr.condition_access);
+        while_instr.code = ir_inline_copy_code_block(copy, instr->options.while_instr.code, block, index);
+        break;
+    }
+    case IR_Instruction_Type::MATCH: {
+        auto& switch_instr = result.options.switch_instr;
+        auto& source_cases = instr->options.switch_instr.cases;
+        switch_instr.condition_access = ir_inline_copy_data_access(copy, instr->options.switch_instr.condition_access);
+        switch_instr.cases = DynArray<IR_Switch_Case>::create(&ir_generator->arena, source_cases.size);
+        for (int i = 0; i < source_cases.size; i++) {
+            IR_Switch_Case switch_case;
+            switch_case.value = source_cases[i].value;
+            switch_case.block = ir_inline_copy_code_block(copy, source_cases[i].block, block, index);
+            switch_instr.cases.push_back(switch_case);
+        }
+        switch_instr.default_block = ir_inline_copy_code_block(copy, instr->options.switch_instr.default_block, block, index);
+        break;
+    }
+    case IR_Instruction_Type::BLOCK:
+        result.options.block = ir_inline_copy_code_block(copy, instr->options.block, block, index);
+        break;
+    case IR_Instruction_Type::LABEL: {
+        result.options.label_index = ir_inline_copy_map_label(copy, instr->options.label_index, block);
+        ir_generator->label_positions[result.options.label_index - 1].block = block;
+        ir_generator->label_positions[result.options.label_index - 1].index = index;
+        break;
+    }
+    case IR_Instruction_Type::GOTO:
+        result.options.label_index = ir_inline_copy_map_label(copy, instr->options.label_index, block);
+        break;
+    case IR_Instruction_Type::RETURN: 
+    {
+        // Returns become moves to the call destination and a jump to the end of the inlined block
+        auto& return_instr = instr->options.return_instr;
+        if (return_instr.type == IR_Instruction_Return_Type::EXIT) break;
+
+        if (return_instr.type == IR_Instruction_Return_Type::RETURN_DATA && copy->return_destination->type != IR_Data_Access_Type::NOTHING) {
+            IR_Instruction move_instr = *instr;
+            move_instr.type = IR_Instruction_Type::MOVE;
+            move_instr.options.move.destination = copy->return_destination;
+            move_instr.options.move.source = ir_inline_copy_data_access(copy, return_instr.options.return_value);
+            block->instructions.push_back(move_instr);
+        }
+        result.type = IR_Instruction_Type::GOTO;
+        result.options.label_index = copy->return_label_index;
+        break;
+    }
+    case IR_Instruction_Type::FUNCTION_ADDRESS:
+        result.options.function_address.destination = ir_inline_copy_data_access(copy, instr->options.function_address.destination);
+        break;
+    case IR_Instruction_Type::VARIABLE_DEFINITION: {
+        auto& definition = result.options.variable_definition;
+        definition.variable_access = ir_inline_copy_data_access(copy, instr->options.variable_definition.variable_access);
+        if (definition.initial_value.available) {
+            definition.initial_value.value = ir_inline_copy_data_access(copy, instr->options.variable_definition.initial_value.value);
+        }
+        break;
+    }
+    default: panic("");
+    }
+
+    block->instructions.push_back(result);
+}
+
+static IR_Code_Block* ir_inline_copy_code_block(IR_Inline_Copy* copy, IR_Code_Block* block, IR_Code_Block* parent_block, int parent_instruction_index)
+{
+    IR_Code_Block* result = ir_generator->arena.allocate<IR_Code_Block>();
+    result->function = copy->caller;
+    result->parent_block = parent_block;
+    result->parent_instruction_index = parent_instruction_index;
+    result->inlined_function = block->inlined_function;
+    result->registers = DynArray<IR_Register>::create(&ir_generator->arena, block->registers.size);
+    for (int i = 0; i < block->registers.size; i++) {
+        result->registers.push_back(block->registers[i]);
+    }
+    result->instructions = DynArray<IR_Instruction>::create(&ir_generator->arena, block->instructions.size);
+    hashtable_insert_element(&copy->block_mapping, block, result);
+
+    for (int i = 0; i < block->instructions.size; i++) {
+        ir_inline_copy_instruction(copy, &block->instructions[i], result);
+    }
+    return result;
+}
+
+// Replaces the call instruction with a block containing the callee code, returns the new block
+static IR_Code_Block* ir_inliner_inline_call(IR_Inliner* inliner, IR_Code_Block* block, int instruction_index)
+{
+    IR_Instruction call_instr = block->instructions[instruction_index];
+    IR_Instruction_Call* call = &call_instr.options.call;
+    Upp_Function* callee = call->options.function;
+    auto signature = callee->signature;
+
+    IR_Inline_Copy copy;
+    copy.callee = callee;
+    copy.caller = inliner->current_function;
+    copy.return_destination = call->destination;
+    copy.parameter_registers = dynamic_array_create<IR_Data_Access*>(signature->parameters.size);
+    copy.block_mapping = hashtable_create_pointer_empty<IR_Code_Block*, IR_Code_Block*>(4);
+    copy.label_mapping = hashtable_create_empty<int, int>(4, hash_i32, equals_i32);
+    SCOPE_EXIT(dynamic_array_destroy(&copy.parameter_registers));
+    SCOPE_EXIT(hashtable_destroy(&copy.block_mapping));
+    SCOPE_EXIT(hashtable_destroy(&copy.label_mapping));
+
+    // Inline block contains parameters as registers: [Argument moves] [Callee block] [Return label]
+    IR_Code_Block* inline_block = ir_generator->arena.allocate<IR_Code_Block>();
+    inline_block->function = inliner->current_function;
+    inline_block->parent_block = block;
+    inline_block->parent_instruction_index = instruction_index;
+    inline_block->inlined_function = callee;
+    inline_block->registers = DynArray<IR_Register>::create(&ir_generator->arena, signature->parameters.size);
+    inline_block->instructions = DynArray<IR_Instruction>::create(&ir_generator->arena, signature->parameters.size + 2);
+
+    IR_Instruction instr_template = call_instr;
+    for (int i = 0; i < signature->parameters.size; i++)
+    {
+        if (i == signature->return_type_index) {
+            dynamic_array_push_back(&copy.parameter_registers, (IR_Data_Access*)nullptr);
+            continue;
+        }
+
+        IR_Register reg;
+        reg.type = signature->parameters[i].datatype;
+        reg.name.available = false;
+        reg.has_definition_instruction = false;
+        inline_block->registers.push_back(reg);
+
+        IR_Data_Access* access = ir_generator->arena.allocate<IR_Data_Access>();
+        access->datatype = reg.type;
+        access->type = IR_Data_Access_Type::REGISTER;
+        access->option.register_access.definition_block = inline_block;
+        access->option.register_access.index = inline_block->registers.size - 1;
+        dynamic_array_push_back(&copy.parameter_registers, access);
+
+        IR_Instruction move_instr = instr_template;
+        move_instr.type = IR_Instruction_Type::MOVE;
+        move_instr.options.move.destination = access;
+        move_instr.options.move.source = call->arguments[i];
+        inline_block->instructions.push_back(move_instr);
+    }
+
+    IR_Instruction body_instr = instr_template;
+    body_instr.type = IR_Instruction_Type::BLOCK;
+    copy.return_label_index = ir_generator_allocate_label(inline_block, inline_block->instructions.size + 1);
+    body_instr.options.block = ir_inline_copy_code_block(&copy, callee->ir_block, inline_block, inline_block->instructions.size);
+    inline_block->instructions.push_back(body_instr);
+
+    IR_Instruction label_instr = instr_template;
+    label_instr.type = IR_Instruction_Type::LABEL;
+    label_instr.options.label_index = copy.return_label_index;
+    inline_block->instructions.push_back(label_instr);
+
+    // Replace call, the argument array can be reused by the arena
+    auto& arguments = block->instructions[instruction_index].options.call.arguments;
+    ir_generator->arena.release(arguments.buffer.data, arguments.buffer.size * sizeof(IR_Data_Access*));
+    IR_Instruction block_instr = instr_template;
+    block_instr.type = IR_Instruction_Type::BLOCK;
+    block_instr.options.block = inline_block;
+    block->instructions[instruction_index] = block_instr;
+    return inline_block;
+}
+
+static bool ir_inliner_should_inline(IR_Inliner* inliner, Upp_Function* callee, int depth)
+{
+    if (depth >= inliner->settings.max_depth) return false;
+    if (callee->ir_block == nullptr || callee->is_extern || callee->contains_errors) return false;
+    if (callee == inliner->current_function) return false;
+    for (int i = 0; i < inliner->inline_stack.size; i++) {
+        if (inliner->inline_stack[i] == callee) return false;
+    }
+    int max_instructions = callee->is_profile_hot ? inliner->settings.max_hot_callee_instructions : inliner->settings.max_callee_instructions;
+    return ir_code_block_instruction_count(callee->ir_block) <= max_instructions;
+}
+
+static void ir_inliner_process_block(IR_Inliner* inliner, IR_Code_Block* block, int depth)
+{
+    for (int i = 0; i < block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &block->instructions[i];
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::IF:
+            ir_inliner_process_block(inliner, instr->options.if_instr.true_branch, depth);
+            ir_inliner_process_block(inliner, instr->options.if_instr.false_branch, depth);
+            break;
+        case IR_Instruction_Type::WHILE:
+            ir_inliner_process_block(inliner, instr->options.while_instr.condition_code, depth);
+            ir_inliner_process_block(inliner, instr->options.while_instr.code, depth);
+            break;
+        case IR_Instruction_Type::MATCH:
+            for (int j = 0; j < instr->options.switch_instr.cases.size; j++) {
+                ir_inliner_process_block(inliner, instr->options.switch_instr.cases[j].block, depth);
+            }
+            ir_inliner_process_block(inliner, instr->options.switch_instr.default_block, depth);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            ir_inliner_process_block(inliner, instr->options.block, depth);
+            break;
+        case IR_Instruction_Type::FUNCTION_CALL:
+        {
+            if (instr->options.call.call_type != IR_Instruction_Call_Type::FUNCTION_CALL) break;
+            Upp_Function* callee = instr->options.call.options.function;
+            if (!ir_inliner_should_inline(inliner, callee, depth)) break;
+
+            IR_Code_Block* inline_block = ir_inliner_inline_call(inliner, block, i);
+            dynamic_array_push_back(&inliner->inline_stack, callee);
+            ir_inliner_process_block(inliner, inline_block, depth + 1);
+            dynamic_array_rollback_to_size(&inliner->inline_stack, inliner->inline_stack.size - 1);
+            break;
+        }
+        default: break;
+        }
+    }
+}
+
+void ir_generator_inline_functions(Compilation_Data* compilation_data, IR_Inline_Settings settings)
+{
+    if (settings.max_depth <= 0) return;
+    ir_generator = compilation_data->ir_generator;
+
+    IR_Inliner inliner;
+    inliner.settings = settings;
+    inliner.inline_stack = dynamic_array_create<Upp_Function*>();
+    SCOPE_EXIT(dynamic_array_destroy(&inliner.inline_stack));
+
+    auto& functions = compilation_data->functions;
+    for (int i = 0; i < functions.size; i++)
+    {
+        Upp_Function* function = functions[i];
+        if (function->ir_block == nullptr || !function->is_reachable) continue;
+        inliner.current_function = function;
+        ir_inliner_process_block(&inliner, function->ir_block, 0);
+    }
+}
+
+static void ir_reachability_mark_function(Dynamic_Array<Upp_Function*>* queue, Upp_Function* function)
+{
+    if (function->is_reachable) return;
+    function->is_reachable = true;
+    dynamic_array_push_back(queue, function);
+}
+
+static void ir_reachability_scan_block(Dynamic_Array<Upp_Function*>* queue, IR_Code_Block* block)
+{
+    for (int i = 0; i < block->instructions.size; i++)
+    {
+        IR_Instruction* instr = &block->instructions[i];
+        switch (instr->type)
+        {
+        case IR_Instruction_Type::FUNCTION_CALL:
+            if (instr->options.call.call_type == IR_Instruction_Call_Type::FUNCTION_CALL) {
+                ir_reachability_mark_function(queue, instr->options.call.options.function);
+            }
+            break;
+        case IR_Instruction_Type::FUNCTION_ADDRESS:
+            ir_reachability_mark_function(queue, instr->options.function_address.function);
+            break;
+        case IR_Instruction_Type::IF:
+            ir_reachability_scan_block(queue, instr->options.if_instr.true_branch);
+            ir_reachability_scan_block(queue, instr->options.if_instr.false_branch);
+            break;
+        case IR_Instruction_Type::WHILE:
+            ir_reachability_scan_block(queue, instr->options.while_instr.condition_code);
+            ir_reachability_scan_block(queue, instr->options.while_instr.code);
+            break;
+        case IR_Instruction_Type::MATCH:
+            for (int j = 0; j < instr->options.switch_instr.cases.size; j++) {
+                ir_reachability_scan_block(queue, instr->options.switch_instr.cases[j].block);
+            }
+            ir_reachability_scan_block(queue, instr->options.switch_instr.default_block);
+            break;
+        case IR_Instruction_Type::BLOCK:
+            ir_reachability_scan_block(queue, instr->options.block);
+            break;
+        default: break;
+        }
+    }
+}
+
+void ir_generator_generate_reachable_functions(Compilation_Data* compilation_data, bool eliminate_dead_functions)
+{
+    auto& functions = compilation_data->functions;
+    Dynamic_Array<Upp_Function*> queue = dynamic_array_create<Upp_Function*>();
+    SCOPE_EXIT(dynamic_array_destroy(&queue));
+
+    // Roots
+    ir_reachability_mark_function(&queue, compilation_data->entry_function);
+    for (int i = 0; i < functions.size; i++) {
+        Upp_Function* function = functions[i];
+        if (!eliminate_dead_functions || function->has_constant_address) {
+            ir_reachability_mark_function(&queue, function);
+        }
+    }
+
+    int ir_instruction_count = 0;
+    while (queue.size > 0)
+    {
+        if (compilation_data_check_cancelled(compilation_data)) {
+            return; // Caller discards partial IR
+        }
+        Upp_Function* function = queue[queue.size - 1];
+        dynamic_array_rollback_to_size(&queue, queue.size - 1);
+        ir_generator_generate_function(function, compilation_data);
+        if (function->ir_block == nullptr) continue;
+        ir_reachability_scan_block(&queue, function->ir_block);
+        ir_instruction_count += ir_code_block_instruction_count(function->ir_block);
+    }
+
+    int skipped_function_count = 0;
+    int skipped_instruction_count = 0;
+    for (int i = 0; i < functions.size; i++)
+    {
+        Upp_Function* function = functions[i];
+        if (function->is_reachable || function->is_extern || function->contains_errors || !function->body_node.available) continue;
+        if (function->poly_type == Poly_Type::BASE || function->poly_type == Poly_Type::PARTIAL) continue;
+        skipped_function_count += 1;
+        if (function->ir_block != nullptr) {
+            skipped_instruction_count += ir_code_block_instruction_count(function->ir_block);
+        }
+    }
+    compilation_data->code_gen_ir_instructions = ir_instruction_count;
+    compilation_data->code_gen_skipped_functions = skipped_function_count;
+    compilation_data->code_gen_skipped_ir_instructions = skipped_instruction_count;
+}
+
 IR_Generator* ir_generator_create(Compilation_Data* compilation_data)
 {
     auto& type_system = compilation_data->type_system;
@@ -2297,10 +2963,14 @@ IR_Generator* ir_generator_create(Compilation_Data* compilation_data)
     generator->compilation_data = compilation_data;
     generator->nothing_access.datatype = upcast(types.unknown_type);
     generator->nothing_access.type = IR_Data_Access_Type::NOTHING;
+    generator->current_pass = nullptr;
+    generator->current_expr = nullptr;
+    generator->current_statement = nullptr;
+    generator->current_block = nullptr;
 
     // Create datastructures
     {
-        generator->data_accesses = dynamic_array_create<IR_Data_Access*>();
+        generator->arena = Arena::create();
         generator->loop_increment_instructions = hashtable_create_pointer_empty<AST::Code_Block*, Loop_Increment>(8);
         generator->variable_mapping = hashtable_create_pointer_empty<Symbol*, IR_Data_Access*>(8);
         generator->labels_break = hashtable_create_pointer_empty<AST::Code_Block*, int>(8);
@@ -2316,10 +2986,6 @@ IR_Generator* ir_generator_create(Compilation_Data* compilation_data)
     return generator;
 }
 
-void ir_data_access_delete(IR_Data_Access** access) {
-    delete (*access);
-}
-
 void ir_generator_destroy(IR_Generator* generator)
 {
     hashtable_destroy(&generator->variable_mapping);
@@ -2328,8 +2994,7 @@ void ir_generator_destroy(IR_Generator* generator)
     hashtable_destroy(&generator->block_defer_depths);
     hashtable_destroy(&generator->loop_increment_instructions);
 
-    dynamic_array_for_each(generator->data_accesses, ir_data_access_delete);
-    dynamic_array_destroy(&generator->data_accesses);
+    generator->arena.destroy();
     dynamic_array_destroy(&generator->defer_stack);
     dynamic_array_destroy(&generator->fill_out_breaks);
     dynamic_array_destroy(&generator->fill_out_continues);
@@ -94,7 +94,7 @@ struct IR_Instruction_Call
         IR_Data_Access* pointer_access;
         IR_Builtin_Function builtin_fn;
     } options;
-    Dynamic_Array<IR_Data_Access*> arguments;
+    DynArray<IR_Data_Access*> arguments;
     IR_Data_Access* destination;
 };
 
@@ -143,8 +143,9 @@ struct IR_Code_Block
     Upp_Function* function;
     IR_Code_Block* parent_block; // May be null if function
     int parent_instruction_index;
-    Dynamic_Array<IR_Register> registers;
-    Dynamic_Array<IR_Instruction> instructions;
+    Upp_Function* inlined_function; // Callee if this block replaced a call, see ir_inliner_inline_call
+    DynArray<IR_Register> registers; // Blocks and their arrays live in IR_Generator::arena
+    DynArray<IR_Instruction> instructions;
 };
 
 struct IR_Switch_Case
@@ -156,7 +157,7 @@ struct IR_Switch_Case
 struct IR_Instruction_Switch
 {
     IR_Data_Access* condition_access;
-    Dynamic_Array<IR_Switch_Case> cases;
+    DynArray<IR_Switch_Case> cases;
     IR_Code_Block* default_block;
 };
 
@@ -265,7 +266,7 @@ struct IR_Generator
 {
     // Stuff needed for compilation
     Compilation_Data* compilation_data;
-    Dynamic_Array<IR_Data_Access*> data_accesses;
+    Arena arena; // IR blocks, their arrays and data accesses, freed all at once in ir_generator_destroy
     IR_Data_Access nothing_access;
 
     Hashtable<Symbol*, IR_Data_Access*> variable_mapping;
@@ -286,12 +287,25 @@ struct IR_Generator
     IR_Code_Block* current_block;
 };
 
+// Inlining of small functions, see ir_inline_settings_from_optimization_level
+struct IR_Inline_Settings
+{
+    int max_callee_instructions; // Counted recursively, including nested blocks
+    int max_hot_callee_instructions; // Limit for functions marked as is_profile_hot
+    int max_depth;               // Maximum depth of inlined calls inside inlined code
+};
+
 IR_Generator* ir_generator_create(Compilation_Data* compilation_data);
 void ir_generator_destroy(IR_Generator* ir_generator);
-void ir_code_block_destroy(IR_Code_Block* block);
 
 void ir_generator_finish(Compilation_Data* compilation_data);
+// Generates IR for all functions reachable from the entry function (calls, function addresses, constant function pointers) and sets is_reachable.
+// Without elimination all functions are generated. Requires ir_generator_finish to create the entry function.
+void ir_generator_generate_reachable_functions(Compilation_Data* compilation_data, bool eliminate_dead_functions);
 void ir_generator_generate_function(Upp_Function* function, Compilation_Data* compilation_data);
+bool ir_function_is_pure(Upp_Function* function);
+IR_Inline_Settings ir_inline_settings_from_optimization_level(int optimization_level);
+void ir_generator_inline_functions(Compilation_Data* compilation_data, IR_Inline_Settings settings);
 
 void ir_program_append_to_string(String* string, bool print_generated_functions, Compilation_Data* compilation_data);
 void ir_instruction_append_to_string(IR_Instruction* instruction, String* string, int indentation, IR_Code_Block* code_block, Compilation_Data* compilation_data);
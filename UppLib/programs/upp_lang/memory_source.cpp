@@ -1,8 +1,10 @@
 #include "memory_source.hpp"
 
-#include <Windows.h>
 #include "../../datastructures/string.hpp"
 
+#ifdef _WIN32
+#include <Windows.h>
+
 Page_Info Memory_Source::get_page_info(void* address, uint size) 
 {
 	Page_Info info;
@@ -219,3 +221,173 @@ void wide_string_to_utf8(const wchar_t* wide_string, String* string)
     string->size = (int)strlen(string->characters);
 }
 
+#else
+#include <cstdio>
+#include <cstring>
+
+// Only memory of the own process can be accessed, process handles are only created by the debugger (Windows only)
+struct Memory_Mapping
+{
+	u64 start;
+	u64 end;
+	char permissions[5];
+};
+
+static bool memory_source_find_mapping(void* address, Memory_Mapping* out_mapping)
+{
+	FILE* maps = fopen("/proc/self/maps", "r");
+	if (maps == nullptr) return false;
+	SCOPE_EXIT(fclose(maps));
+
+	char line[512];
+	while (fgets(line, sizeof(line), maps) != nullptr)
+	{
+		unsigned long long start, end;
+		char permissions[5];
+		if (sscanf(line, "%llx-%llx %4s", &start, &end, permissions) != 3) continue;
+		if ((u64)address >= start && (u64)address < end) {
+			out_mapping->start = start;
+			out_mapping->end = end;
+			memory_copy(out_mapping->permissions, permissions, 5);
+			return true;
+		}
+	}
+	return false;
+}
+
+Page_Info Memory_Source::get_page_info(void* address, uint size) 
+{
+	Page_Info info;
+	info.readable = false;
+	info.writable = false;
+	info.executable = false;
+
+	Memory_Mapping mapping;
+	if (process_handle != nullptr || !memory_source_find_mapping(address, &mapping)) {
+		return info;
+	}
+	if ((uint)address + size > mapping.end) {
+		// The whole range has to be from the same mapping for this function to work
+		return info;
+	}
+	info.readable = mapping.permissions[0] == 'r';
+	info.writable = mapping.permissions[1] == 'w';
+	info.executable = mapping.permissions[2] == 'x';
+	return info;
+}
+
+bool Memory_Source::read(void* destination, void* source, uint size) 
+{
+	if (process_handle != nullptr) return false;
+	memory_copy(destination, source, size);
+	return true;
+}
+
+bool Memory_Source::write(void* destination, void* source, uint size) 
+{
+	if (process_handle != nullptr) return false;
+	memory_copy(destination, source, size);
+	return true;
+}
+
+void Memory_Source::read_as_much_as_possible(void* address, Dynamic_Array<u8>* out_bytes, uint read_size) 
+{
+	dynamic_array_reset(out_bytes);
+    if (address == nullptr || read_size == 0 || process_handle != nullptr) {
+        return;
+    }
+
+	Memory_Mapping mapping;
+	if (!memory_source_find_mapping(address, &mapping) || mapping.permissions[0] != 'r') {
+		return;
+	}
+	read_size = math_minimum((uint)(mapping.end - (u64)address), read_size);
+
+	dynamic_array_reserve(out_bytes, (int)read_size);
+	memory_copy(out_bytes->data, address, read_size);
+	out_bytes->size = (int)read_size;
+}
+
+bool Memory_Source::read_null_terminated_string(
+	void* virtual_address, String* out_string, uint max_char_count, bool is_wide_char, Dynamic_Array<u8>* byte_buffer)
+{
+	string_reset(out_string);
+	if (virtual_address == nullptr || max_char_count == 0) {
+		return false;
+	}
+	uint char_size = is_wide_char ? sizeof(wchar_t) : 1;
+	read_as_much_as_possible(virtual_address, byte_buffer, (max_char_count + 1) * char_size);
+
+	int char_count = -1;
+	for (int i = 0; (i + 1) * (int)char_size <= byte_buffer->size && i < (int)max_char_count; i++) {
+		bool is_zero = is_wide_char ? ((wchar_t*)byte_buffer->data)[i] == 0 : byte_buffer->data[i] == 0;
+		if (is_zero) {
+			char_count = i;
+			break;
+		}
+	}
+	if (char_count == -1) {
+		return false;
+	}
+
+	if (is_wide_char) {
+		wide_string_to_utf8((wchar_t*)byte_buffer->data, out_string);
+	}
+	else {
+		string_reserve(out_string, char_count + 1);
+		memory_copy(out_string->characters, byte_buffer->data, char_count + 1);
+		out_string->size = char_count;
+	}
+	return true;
+}
+
+// wchar_t holds UTF-32 on Linux
+void wide_string_from_utf8(Dynamic_Array<wchar_t>* character_buffer, const char* string)
+{
+	dynamic_array_reset(character_buffer);
+	const u8* c = (const u8*)string;
+	while (*c != 0)
+	{
+		u32 code_point = *c;
+		int continuation_count = 0;
+		if (code_point >= 0xF0) { code_point &= 0x07; continuation_count = 3; }
+		else if (code_point >= 0xE0) { code_point &= 0x0F; continuation_count = 2; }
+		else if (code_point >= 0xC0) { code_point &= 0x1F; continuation_count = 1; }
+		c += 1;
+		for (int i = 0; i < continuation_count && (*c & 0xC0) == 0x80; i++) {
+			code_point = (code_point << 6) | (*c & 0x3F);
+			c += 1;
+		}
+		dynamic_array_push_back(character_buffer, (wchar_t)code_point);
+	}
+	dynamic_array_push_back(character_buffer, (wchar_t)0);
+	character_buffer->size -= 1;
+}
+
+void wide_string_to_utf8(const wchar_t* wide_string, String* string)
+{
+	string_reset(string);
+	for (const wchar_t* c = wide_string; *c != 0; c++)
+	{
+		u32 code_point = (u32)*c;
+		if (code_point < 0x80) {
+			string_append_character(string, (char)code_point);
+		}
+		else if (code_point < 0x800) {
+			string_append_character(string, (char)(0xC0 | (code_point >> 6)));
+			string_append_character(string, (char)(0x80 | (code_point & 0x3F)));
+		}
+		else if (code_point < 0x10000) {
+			string_append_character(string, (char)(0xE0 | (code_point >> 12)));
+			string_append_character(string, (char)(0x80 | ((code_point >> 6) & 0x3F)));
+			string_append_character(string, (char)(0x80 | (code_point & 0x3F)));
+		}
+		else {
+			string_append_character(string, (char)(0xF0 | (code_point >> 18)));
+			string_append_character(string, (char)(0x80 | ((code_point >> 12) & 0x3F)));
+			string_append_character(string, (char)(0x80 | ((code_point >> 6) & 0x3F)));
+			string_append_character(string, (char)(0x80 | (code_point & 0x3F)));
+		}
+	}
+}
+#endif
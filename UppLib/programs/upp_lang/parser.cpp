@@ -1,5 +1,7 @@
 #include "parser.hpp"
 
+#include <cstdio>
+
 #include "ast.hpp"
 #include "syntax_editor.hpp"
 #include "compilation_data.hpp"
@@ -157,7 +159,7 @@ DynArray<Token> tokenize_source_code_and_build_hierarchy(Source_Code* code, Aren
 			{
 				Token& token = tokens[i];
 				if (token.type == Token_Type::IDENTIFIER) {
-					token.options.string_value = identifier_pool_add(id_pool, string_create_substring_static(&line->text, token.start, token.end));
+					token.options.string_value = identifier_pool_add(id_pool, string_view_from_substring(&line->text, token.start, token.end));
 				}
 				else if (token.type == Token_Type::LITERAL_STRING)
 				{
@@ -326,6 +328,7 @@ namespace Parser
 		Arena_Checkpoint temporary_arena_checkpoint;
 		int pos;
 		int error_count;
+		int node_count;
 	};
 
 	struct Parser
@@ -334,6 +337,7 @@ namespace Parser
 		Arena* temporary_arena; // Used for list-parsing
 		DynArray<Token> tokens;
 		DynArray<Parser_Error> errors;
+		DynArray<Node_Ranges> node_ranges; // Indexed by Node::index, packed into the Root_Node at the end
 		Compilation_Unit* unit;
 		Predefined_IDs* predefined_ids;
 		Token error_token;
@@ -346,6 +350,7 @@ namespace Parser
 	Parser_Checkpoint parser_checkpoint_make() {
 		Parser_Checkpoint checkpoint;
 		checkpoint.error_count = parser.errors.size;
+		checkpoint.node_count = parser.node_ranges.size;
 		checkpoint.permanent_arena_checkpoint = parser.permanent_arena->make_checkpoint();
 		checkpoint.temporary_arena_checkpoint = parser.temporary_arena->make_checkpoint();
 		checkpoint.pos = parser.pos;
@@ -356,6 +361,7 @@ namespace Parser
 	void parser_rollback(Parser_Checkpoint checkpoint)
 	{
 		parser.errors.rollback_to_size(checkpoint.error_count);
+		parser.node_ranges.rollback_to_size(checkpoint.node_count);
 		parser.pos = checkpoint.pos;
 		checkpoint.permanent_arena_checkpoint.rewind();
 		checkpoint.temporary_arena_checkpoint.rewind();
@@ -370,13 +376,24 @@ namespace Parser
 		Node* base = &result->base;
 		base->parent = parent;
 		base->type = type;
+		base->unit_index = (u16)parser.unit->index;
+		base->index = parser.node_ranges.size;
+
 		auto& token = parser.tokens[parser.pos];
-		base->range.start = text_index_make(token.line, token.start);
-		base->range.end = base->range.start;
+		Node_Ranges ranges;
+		ranges.range.start = text_index_make(token.line, token.start);
+		ranges.range.end = ranges.range.start;
+		ranges.bounding_range = ranges.range;
+		parser.node_ranges.push_back(ranges);
 
 		return result;
 	}
 
+	// Only valid until the next node is allocated
+	Node_Ranges& node_ranges(Node* node) {
+		return parser.node_ranges[node->index];
+	}
+
 
 
 	// Error reporting
@@ -497,13 +514,14 @@ namespace Parser
 
 	void node_calculate_bounding_range(AST::Node* node)
 	{
-		auto& bounding_range = node->bounding_range;
-		bounding_range = node->range;
+		auto& ranges = node_ranges(node);
+		auto& bounding_range = ranges.bounding_range;
+		bounding_range = ranges.range;
 		int index = 0;
 		auto child = AST::base_get_child(node, index);
 		while (child != 0)
 		{
-			auto child_range = child->bounding_range;
+			auto child_range = node_ranges(child).bounding_range;
 			if (!text_index_in_order(bounding_range.start, child_range.start)) {
 				bounding_range.start = child_range.start;
 			}
@@ -523,7 +541,7 @@ namespace Parser
 		//      * Sanity checks
 		//      * Sets the end of the node
 		//      * Calcualtes bounding-ranges (for editor) (Could also be done once at the end of parsing, maybe I do that?)
-		auto& range = node->range;
+		auto& range = node_ranges(node).range;
 
 		// Set end of node
 		Token& token = parser.tokens[parser.pos - 1];
@@ -1412,8 +1430,7 @@ namespace Parser
 			fast_call.expression = allocate_base<AST::Expression>(upcast(result), Node_Type::EXPRESSION);
 			fast_call.expression->type = Expression_Type::PATH_LOOKUP;
 			fast_call.expression->options.path_lookup = parse_path_lookup_or_error(upcast(fast_call.expression));
-			fast_call.expression->base.range = fast_call.expression->options.path_lookup->base.range;
-			fast_call.expression->base.bounding_range = fast_call.expression->options.path_lookup->base.bounding_range;
+			node_ranges(upcast(fast_call.expression)) = node_ranges(upcast(fast_call.expression->options.path_lookup));
 
 			if (test_token(Token_Type::FAST_CALL_ARROW)) {
 				advance_token();
@@ -1425,8 +1442,9 @@ namespace Parser
 				fast_call.symbol->is_definition = false;
 				fast_call.symbol->is_root_lookup = false;
 				fast_call.symbol->name = ids.invalid_symbol_name;
-				fast_call.symbol->base.range.end = fast_call.symbol->base.range.start;
-				fast_call.symbol->base.bounding_range = fast_call.symbol->base.range;
+				auto& symbol_ranges = node_ranges(upcast(fast_call.symbol));
+				symbol_ranges.range.end = symbol_ranges.range.start;
+				symbol_ranges.bounding_range = symbol_ranges.range;
 			}
 
 			PARSE_SUCCESS(result);
@@ -2021,8 +2039,7 @@ namespace Parser
 
 			code_block->statements[0] = statement;
 			statement->base.parent = upcast(code_block);
-			code_block->base.range = statement->base.range;
-			code_block->base.bounding_range = statement->base.bounding_range;
+			node_ranges(upcast(code_block)) = node_ranges(upcast(statement));
 
 			result->options.defer_block = code_block;
 			PARSE_SUCCESS(result);
@@ -2659,8 +2676,7 @@ namespace Parser
 			AST::Argument* argument = allocate_base<Argument>(nullptr, AST::Node_Type::ARGUMENT);
 			argument->name = optional_make_failure<String*>();
 			argument->value = child;
-			argument->base.range = child->base.range;
-			argument->base.bounding_range = child->base.bounding_range;
+			node_ranges(upcast(argument)) = node_ranges(upcast(child));
 			call.call_node = parse_call_node(upcast(result), argument);
 			argument->base.parent = upcast(call.call_node);
 
@@ -2758,7 +2774,7 @@ namespace Parser
 				expr = result;
 
 				Token* token = get_token_by_index(link.token_index);
-				auto& range = result->base.range;
+				auto& range = node_ranges(upcast(result)).range;
 				range.start = text_index_make(token->line, token->start);
 				range.end = text_index_make(token->line, token->end);
 				node_calculate_bounding_range(AST::upcast(result->options.binop.left));
@@ -2849,6 +2865,9 @@ namespace Parser
 		Arena error_arena = Arena::create();
 		SCOPE_EXIT(error_arena.destroy());
 		parser.errors = DynArray<Parser_Error>::create(&error_arena); // Only temporary, we copy at the end
+		Arena range_arena = Arena::create();
+		SCOPE_EXIT(range_arena.destroy());
+		parser.node_ranges = DynArray<Node_Ranges>::create(&range_arena);
 
 		// Initialize parser
 		parser.permanent_arena = permanent_arena;
@@ -2868,8 +2887,10 @@ namespace Parser
 		AST::Root_Node* root = allocate_base<Root_Node>(nullptr, Node_Type::ROOT);
 		root->definitions = parse_list_items_as_array<Definition>(upcast(root), wrapper_parse_definition);
 		root->compilation_unit = unit;
-		root->base.range = text_range_make(text_index_make(0, 0), text_index_make_line_end(unit->code, unit->code->line_count - 1));
-		root->base.bounding_range = root->base.range;
+		auto& root_ranges = node_ranges(upcast(root));
+		root_ranges.range = text_range_make(text_index_make(0, 0), text_index_make_line_end(unit->code, unit->code->line_count - 1));
+		root_ranges.bounding_range = root_ranges.range;
+		root->range_table = node_range_table_create(array_create_static(parser.node_ranges.buffer.data, (int)parser.node_ranges.size), permanent_arena);
 		unit->root = root;
 
 		// Copy errors from tmp arena to permanent arena
@@ -2887,9 +2908,11 @@ namespace Parser
 	}
 
 	// AST queries based on Token-Indices
-	DynArray<Text_Range> ast_base_get_section_token_range(Source_Code* code, AST::Node* base, Node_Section section, Arena* arena)
+	DynArray<Text_Range> ast_base_get_section_token_range(
+		Source_Code* code, Node_Range_Table* range_table, AST::Node* base, Node_Section section, Arena* arena)
 	{
-		auto range = base->range;
+		Node_Ranges base_ranges = node_range_table_get(range_table, base->index);
+		auto range = base_ranges.range;
 		DynArray<Text_Range> ranges = DynArray<Text_Range>::create(arena);
 
 		switch (section)
@@ -2898,7 +2921,7 @@ namespace Parser
 		case Node_Section::WHOLE:
 		{
 			if (base->type == AST::Node_Type::EXPRESSION && downcast<AST::Expression>(base)->type == AST::Expression_Type::FUNCTION_CALL) {
-				ranges.push_back(base->bounding_range);
+				ranges.push_back(base_ranges.bounding_range);
 				break;
 			}
 			ranges.push_back( range);
@@ -2914,7 +2937,7 @@ namespace Parser
 			auto child = AST::base_get_child(base, index);
 			while (child != 0)
 			{
-				auto child_range = child->range;
+				auto child_range = node_range_table_get(range_table, child->index).range;
 				if (text_index_equal(sub_range.start, child_range.start))
 				{
 					sub_range.end = child_range.start;
@@ -2944,7 +2967,7 @@ namespace Parser
 		case Node_Section::IDENTIFIER:
 		{
 			int token_index = 0;
-			DynArray<Token> tokens = tokenize_partial_code(code, base->range.start, arena, token_index, true, false);
+			DynArray<Token> tokens = tokenize_partial_code(code, range.start, arena, token_index, true, false);
 			for (int i = token_index; i < tokens.size; i++) {
 				Token& token = tokens[i];
 				if (token.type == Token_Type::IDENTIFIER) {
@@ -2957,7 +2980,7 @@ namespace Parser
 		case Node_Section::ENCLOSURE:
 		{
 			int token_index = 0;
-			DynArray<Token> tokens = tokenize_partial_code(code, base->range.start, arena, token_index, true, false);
+			DynArray<Token> tokens = tokenize_partial_code(code, range.start, arena, token_index, true, false);
 
 			// Move forward until we find start parenthesis
 			int start_index = -1;
@@ -2991,7 +3014,7 @@ namespace Parser
 		case Node_Section::KEYWORD:
 		{
 			int token_index = 0;
-			DynArray<Token> tokens = tokenize_partial_code(code, base->range.start, arena, token_index, true, false);
+			DynArray<Token> tokens = tokenize_partial_code(code, range.start, arena, token_index, true, false);
 			for (int i = token_index; i < tokens.size; i++) {
 				Token& token = tokens[i];
 				if (token_type_is_keyword(token.type)) {
@@ -3004,7 +3027,7 @@ namespace Parser
 		case Node_Section::FIRST_TOKEN: 
 		{
 			int token_index = 0;
-			DynArray<Token> tokens = tokenize_partial_code(code, base->range.start, arena, token_index, true, false);
+			DynArray<Token> tokens = tokenize_partial_code(code, range.start, arena, token_index, true, false);
 			if (token_index < tokens.size) {
 				Token& token = tokens[token_index];
 				ranges.push_back(text_range_make(text_index_make(token.line, token.start), text_index_make(token.line, token.end)));
@@ -3013,10 +3036,10 @@ namespace Parser
 		}
 		case Node_Section::END_TOKEN: {
 			int token_index = 0;
-			DynArray<Token> tokens = tokenize_partial_code(code, base->range.end, arena, token_index, true, false);
+			DynArray<Token> tokens = tokenize_partial_code(code, range.end, arena, token_index, true, false);
 			if (token_index < tokens.size) {
 				Token& token = tokens[token_index];
-				if (!(token.line == base->range.end.line && token.start == base->range.end.character)) {
+				if (!(token.line == range.end.line && token.start == range.end.character)) {
 					ranges.push_back(text_range_make(text_index_make(token.line, token.start), text_index_make(token.line, token.end)));
 					break;
 				}
@@ -3032,10 +3055,10 @@ namespace Parser
 
 		// For handling empty ranges
 		if (ranges.size == 0) {
-			Text_Range range;
-			range.start = base->range.start;
-			range.end = base->range.start;
-			ranges.push_back(range);
+			Text_Range empty_range;
+			empty_range.start = range.start;
+			empty_range.end = range.start;
+			ranges.push_back(empty_range);
 		}
 
 		return ranges;
@@ -42,5 +42,6 @@ namespace Parser
     void execute_clean(Compilation_Unit* unit, Compilation_Data* compilation_data);
 
     // Utility
-    DynArray<Text_Range> ast_base_get_section_token_range(Source_Code* code, AST::Node* base, Node_Section section, Arena* arena);
+    DynArray<Text_Range> ast_base_get_section_token_range(
+        Source_Code* code, AST::Node_Range_Table* range_table, AST::Node* base, Node_Section section, Arena* arena);
 }
@@ -1,5 +1,7 @@
 #include "semantic_analyser.hpp"
 
+#include <cstring>
+
 #include "../../datastructures/string.hpp"
 #include "../../utility/hash_functions.hpp"
 #include "../../datastructures/hashset.hpp"
@@ -19,6 +21,7 @@
 #include "source_code.hpp"
 #include "symbol_table.hpp"
 #include "syntax_colors.hpp"
+#include "trace_recorder.hpp"
 
 // GLOBALS
 bool PRINT_DEPENDENCIES = false;
@@ -46,6 +49,7 @@ void expression_context_apply(
 );
 
 bool workload_executer_switch_to_workload(Workload_Executer* executer, Workload_Base* workload);
+void workload_executer_push_ready(Workload_Executer* executer, Workload_Base* workload);
 void analysis_workload_entry(void* userdata);
 void analysis_workload_append_to_string(Workload_Base* workload, String* string);
 void workload_executer_wait_for_dependency_resolution(Semantic_Context* semantic_context);
@@ -156,68 +160,80 @@ Pattern_Variable_State pattern_variable_state_make_pattern(Datatype* pattern_typ
 // Analysis-Pass
 Analysis_Pass* analysis_pass_allocate(Workload_Base* origin, AST::Node* mapping_node, Compilation_Data* compilation_data)
 {
-    Analysis_Pass* result = new Analysis_Pass;
-    dynamic_array_push_back(&compilation_data->allocated_passes, result);
+    Analysis_Pass* result = compilation_data->arena.allocate<Analysis_Pass>();
     result->origin_workload = origin;
 
     // Add mapping to workload 
     if (mapping_node) {
-        Node_Passes* workloads_opt = hashtable_find_element(&compilation_data->ast_to_pass_mapping, mapping_node);
-        if (workloads_opt == 0) {
-            Node_Passes passes;
-            passes.base = mapping_node;
-            passes.passes = dynamic_array_create<Analysis_Pass*>(1);
-            dynamic_array_push_back(&passes.passes, result);
-            hashtable_insert_element(&compilation_data->ast_to_pass_mapping, mapping_node, passes);
-        }
-        else {
-            dynamic_array_push_back(&workloads_opt->passes, result);
+        DynArray<Analysis_Pass*>** passes = compilation_data_get_node_passes(compilation_data, mapping_node);
+        if (*passes == nullptr) {
+            *passes = compilation_data->arena.allocate<DynArray<Analysis_Pass*>>();
+            **passes = DynArray<Analysis_Pass*>::create(&compilation_data->arena, 1);
         }
+        (*passes)->push_back(result);
     }
     return result;
 }
 
 Analysis_Info* pass_get_base_info(Analysis_Pass* pass, AST::Node* node, Info_Query query, Compilation_Data* compilation_data) 
 {
+    // The first pass which creates an info uses the node annotations, only further passes need the hashtable
+    Node_Annotations* annotations = compilation_data_get_node_annotations(compilation_data, node);
+    bool use_annotations = annotations->first_pass == nullptr || annotations->first_pass == pass;
+
     AST_Info_Key key;
     key.pass = pass;
     key.base = node;
     auto& info_mapping = compilation_data->ast_to_info_mapping;
-	DynTable_Query_Result query_result = info_mapping.query(key);
+	DynTable_Query_Result query_result;
+    Analysis_Info* existing_info = nullptr;
+    if (use_annotations) {
+        existing_info = annotations->first_info;
+    }
+    else {
+        query_result = info_mapping.query(key);
+        if (query_result.value_is_in_table) {
+            existing_info = *info_mapping.query_to_value(query_result);
+        }
+    }
 
     switch (query)
     {
     case Info_Query::CREATE: 
 	{
-		assert(!query_result.value_is_in_table, "");
+		assert(existing_info == nullptr, "");
 		break;
     }
     case Info_Query::CREATE_IF_NULL: 
 	{
         // Check if already there
-		if (query_result.value_is_in_table) {
-			return *info_mapping.query_to_value(query_result);
+		if (existing_info != nullptr) {
+			return existing_info;
 		}
 		break;
     }
     case Info_Query::READ_NOT_NULL: 
 	{
-		assert(query_result.value_is_in_table, "");
-		return *info_mapping.query_to_value(query_result);
+		assert(existing_info != nullptr, "");
+		return existing_info;
     }
     case Info_Query::TRY_READ: 
 	{
-		if (!query_result.value_is_in_table) {
-			return nullptr;
-		}
-		return *info_mapping.query_to_value(query_result);
+		return existing_info;
     }
     default: panic("");
     }
 
-    Analysis_Info* new_info = new Analysis_Info;
+    ALLOCATION_TAG_SCOPE(Memory_Subsystem::EDITOR_INFO);
+    Analysis_Info* new_info = compilation_data->arena.allocate<Analysis_Info>();
     memory_zero(new_info);
-	info_mapping.insert_with_query(query_result, key, new_info);
+    if (use_annotations) {
+        annotations->first_pass = pass;
+        annotations->first_info = new_info;
+    }
+    else {
+	    info_mapping.insert_with_query(query_result, key, new_info);
+    }
     return new_info;
 }
 
@@ -457,6 +473,9 @@ Upp_Function* upp_function_create_empty(Call_Signature* signature, String* name,
 	function->origin.type = Function_Origin_Type::BUILT_IN;
 	function->is_extern = false;
 	function->contains_errors = false;
+	function->is_profile_hot = false;
+	function->is_reachable = false;
+	function->has_constant_address = false;
 	function->ir_block = nullptr;
 	function->bytecode_start_instruction = -1;
 	function->bytecode_end_instruction = -1;
@@ -467,6 +486,19 @@ Upp_Function* upp_function_create_empty(Call_Signature* signature, String* name,
 
 
 
+// In editor compiles (ANALYSIS_ONLY) bodies are only analysed in units open in tabs, others are analysed once something waits on them (e.g. bakes, comptime calls)
+static bool function_body_analysis_can_be_deferred(Semantic_Context* semantic_context, Upp_Function* function)
+{
+	Compilation_Data* compilation_data = semantic_context->compilation_data;
+	if (!enable_lazy_body_analysis || compilation_data->compile_type != Compile_Type::ANALYSIS_ONLY || !function->body_node.available) {
+		return false;
+	}
+	Compilation_Unit* unit = ast_node_to_compilation_unit(compilation_data, AST::upcast(function->body_node.value));
+	return unit != nullptr && unit != compilation_data->main_unit && !unit->open_in_editor;
+}
+
+
+
 // Progress/Workload creation
 struct Workload_Entry_Info
 {
@@ -478,7 +510,6 @@ template<typename T>
 T* workload_executer_allocate_workload(Semantic_Context* semantic_context)
 {
 	auto& executer = *semantic_context->compilation_data->workload_executer;
-	executer.progress_was_made = true;
 	assert(semantic_context->can_create_toplevel_items, "Should be the case, as this should be checked before workload creation");
 
     // Create new workload
@@ -487,8 +518,21 @@ T* workload_executer_allocate_workload(Semantic_Context* semantic_context)
     workload->type = Helpers::get_workload_type(result);
     workload->is_finished = false;
     workload->was_started = false;
-    workload->dependencies = list_create<Workload_Base*>();
-    workload->dependents = list_create<Workload_Base*>();
+    workload->is_deferred = false;
+    workload->is_priority = false;
+    workload->priority_checked = false;
+    workload->switch_count = 0;
+    workload->wait_start_time = 0.0;
+    workload->scratch_arena = Arena::create();
+    workload->dependencies = dynamic_array_create<Workload_Dependency>();
+    workload->dependents = dynamic_array_create<Workload_Dependent>();
+    workload->dependency_index_table = hashtable_create_pointer_empty<Workload_Base*, int>(0);
+    workload->in_ready_queue = false;
+    workload->is_cycle_search_root = false;
+    workload->cycle_search_generation = 0;
+    workload->cycle_search_index = 0;
+    workload->cycle_search_lowlink = 0;
+    workload->cycle_search_on_stack = false;
 
     workload->real_error_count = 0;
     workload->errors_due_to_unknown_count = 0;
@@ -500,8 +544,9 @@ T* workload_executer_allocate_workload(Semantic_Context* semantic_context)
 
     // Add to workload queue
     dynamic_array_push_back(&executer.all_workloads, workload);
-	// Note: There exists a check for dependencies before executing runnable workloads, so this is ok
-    dynamic_array_push_back(&executer.runnable_workloads, workload); 
+    executer.pending_workload_count += 1;
+	// Note: Popping from the ready queue checks for dependencies/deferred, so this is ok
+    workload_executer_push_ready(&executer, workload);
 
     return result;
 }
@@ -1157,25 +1202,62 @@ Comptime_Result expression_calculate_comptime_value_internal_no_cast(AST::Expres
 		}
 		assert(function->body_pass != nullptr, "");
 
-		// Handle single expression function
-		RESTORE_ON_SCOPE_EXIT(semantic_context->current_pass, function->body_pass);
+		// Check for memoized result
+		auto compilation_data = semantic_context->compilation_data;
+		Comptime_Memo_Key memo_key;
+		memo_key.function = function;
+		memo_key.argument_bytes.data = nullptr;
+		memo_key.argument_bytes.size = 0;
+		Comptime_Memo_Value* memo_value = compilation_data->comptime_memo.find(memo_key);
+		if (memo_value != nullptr) {
+			compilation_data->comptime_memo_hits += 1;
+			return comptime_result_make_available(memo_value->result_bytes.data, memo_value->result_type);
+		}
+		compilation_data->comptime_memo_misses += 1;
+
+		// Find single expression/return statement
+		AST::Expression* body_expr = nullptr;
 		if (function->body_node.value.is_expression) {
-			return expression_calculate_comptime_value_internal(function->body_node.value.expr, semantic_context);
+			body_expr = function->body_node.value.expr;
+		}
+		else
+		{
+			AST::Code_Block* block = function->body_node.value.block;
+			if (block->statements.size != 1) {
+				return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+			}
+			AST::Statement* statement = block->statements[0];
+			if (statement->type != AST::Statement_Type::RETURN_STATEMENT) {
+				return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+			}
+			if (!statement->options.return_value.available) {
+				return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+			}
+			body_expr = statement->options.return_value.value;
 		}
 
-		// Handle single return statement function
-		AST::Code_Block* block = function->body_node.value.block;
-		if (block->statements.size != 1) {
-			return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+		Comptime_Result result;
+		{
+			RESTORE_ON_SCOPE_EXIT(semantic_context->current_pass, function->body_pass);
+			result = expression_calculate_comptime_value_internal(body_expr, semantic_context);
 		}
-		AST::Statement* statement = block->statements[0];
-		if (statement->type != AST::Statement_Type::RETURN_STATEMENT) {
-			return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+		if (result.type != Comptime_Result_Type::AVAILABLE || !result.data_type->memory_info.available) {
+			return result;
 		}
-		if (!statement->options.return_value.available) {
-			return comptime_result_make_not_comptime("Function calls must be single return/expression or #bake to be comptime");
+		if (result.data_type->memory_info.value.contains_reference) {
+			return result; // Referenced memory may be temporary
 		}
-		return expression_calculate_comptime_value_internal(statement->options.return_value.value, semantic_context);
+
+		// Store result (Body doesn't depend on arguments, so result is always the same)
+		Comptime_Memo_Value value;
+		value.result_type = result.data_type;
+		value.result_bytes = compilation_data->arena.allocate_array<byte>(result.data_type->memory_info.value.size);
+		value.instruction_count = 0;
+		if (value.result_bytes.size > 0) {
+			memory_copy(value.result_bytes.data, result.data, value.result_bytes.size);
+		}
+		compilation_data->comptime_memo.insert(memo_key, value);
+		return result;
 	}
 	case AST::Expression_Type::INSTANCIATE: {
 		return comptime_result_make_not_comptime("Instanciate must be successful to use as comptime value");
@@ -1707,7 +1789,7 @@ void path_lookup_set_result_symbol(AST::Path_Lookup* path, Symbol* symbol, Seman
 	info->symbol = symbol;
 	// If symbol is not error, add reference to symbol
 	if (symbol->type != Symbol_Type::ERROR_SYMBOL) {
-		dynamic_array_push_back(&symbol->references, last);
+		symbol->references.push_back(last);
 	}
 }
 
@@ -1743,7 +1825,7 @@ Symbol* symbol_lookup_resolve_to_single_symbol(
 	}
 	else if (results.size == 1) {
 		info->symbol = results[0];
-		dynamic_array_push_back(&info->symbol->references, lookup);
+		info->symbol->references.push_back(lookup);
 	}
 	else // size > 1
 	{
@@ -1765,7 +1847,7 @@ Symbol* symbol_lookup_resolve_to_single_symbol(
 
 			if (found_symbol != 0 && !multiple_modules_found) {
 				info->symbol = found_symbol;
-				dynamic_array_push_back(&info->symbol->references, lookup);
+				info->symbol->references.push_back(lookup);
 				return info->symbol;
 			}
 		}
@@ -1787,7 +1869,7 @@ Symbol* symbol_lookup_resolve_to_single_symbol(
 			}
 			if (non_module_symbol != 0 && !multiple_non_module_symbols_found) {
 				info->symbol = non_module_symbol;
-				dynamic_array_push_back(&info->symbol->references, lookup);
+				info->symbol->references.push_back(lookup);
 				return info->symbol;
 			}
 		}
@@ -1912,30 +1994,24 @@ Symbol* symbol_node_define_symbol(
 
 
 //DEPENDENCY GRAPH/WORKLOAD EXECUTION
-Workload_Pair workload_pair_create(Workload_Base* workload, Workload_Base* depends_on) {
-	Workload_Pair result;
-	result.depends_on = depends_on;
-	result.workload = workload;
-	return result;
-}
-
-u64 workload_pair_hash(Workload_Pair* pair) {
-	return hash_memory(array_create_static_as_bytes(pair, 1));
-}
-
-bool workload_pair_equals(Workload_Pair* p1, Workload_Pair* p2) {
-	return p1->depends_on == p2->depends_on && p1->workload == p2->workload;
-}
 
 Workload_Executer* workload_executer_create(Compilation_Data* compilation_data)
 {
 	Workload_Executer* workload_executer = new Workload_Executer;
 	workload_executer->compilation_data = compilation_data;
 	workload_executer->all_workloads      = dynamic_array_create<Workload_Base*>();
-	workload_executer->runnable_workloads = dynamic_array_create<Workload_Base*>();
+	workload_executer->ready_workloads = dynamic_array_create<Workload_Base*>();
+	workload_executer->ready_workloads_head = 0;
+	workload_executer->ready_background_workloads = dynamic_array_create<Workload_Base*>();
 	workload_executer->finished_workloads = dynamic_array_create<Workload_Base*>();
-	workload_executer->workload_dependencies = hashtable_create_empty<Workload_Pair, Dependency_Information>(8, workload_pair_hash, workload_pair_equals);
-	workload_executer->progress_was_made = false;
+	workload_executer->cycle_search_roots = dynamic_array_create<Workload_Base*>();
+	workload_executer->pending_workload_count = 0;
+	workload_executer->cycle_search_generation = 0;
+	workload_executer->priority_hint.unit = nullptr;
+	workload_executer->priority_hint.priority_finished_callback = nullptr;
+	workload_executer->priority_hint.priority_finished_userdata = nullptr;
+	workload_executer->pending_priority_count = 0;
+	workload_executer->priority_finished_reported = false;
 
 	// Add root workload
 	{
@@ -1946,6 +2022,7 @@ Workload_Executer* workload_executer_create(Compilation_Data* compilation_data)
 		compilation_data->root_workload = workload_executer_allocate_workload<Workload_Root>(&local_context);
 		compilation_data->root_workload->base.is_finished = true;
 		compilation_data->root_workload->base.was_started = true;
+		workload_executer->pending_workload_count -= 1;
 	}
 
 	return workload_executer;
@@ -1958,26 +2035,180 @@ void workload_executer_destroy(Workload_Executer* executer)
 	}
 
 	dynamic_array_destroy(&executer->all_workloads);
-	dynamic_array_destroy(&executer->runnable_workloads);
+	dynamic_array_destroy(&executer->ready_workloads);
+	dynamic_array_destroy(&executer->ready_background_workloads);
 	dynamic_array_destroy(&executer->finished_workloads);
+	dynamic_array_destroy(&executer->cycle_search_roots);
 
-	{
-		auto iter = hashtable_iterator_create(&executer->workload_dependencies);
-		while (hashtable_iterator_has_next(&iter)) {
-			SCOPE_EXIT(hashtable_iterator_next(&iter));
-			auto& dep_info = iter.value;
-			dynamic_array_destroy(&dep_info->fail_indicators);
+	delete executer;
+}
+
+void analysis_workload_destroy(Workload_Base* workload)
+{
+	workload->scratch_arena.destroy(); // Already empty unless the workload fiber was aborted
+	for (int i = 0; i < workload->dependencies.size; i++) {
+		dynamic_array_destroy(&workload->dependencies[i].fail_indicators);
+	}
+	dynamic_array_destroy(&workload->dependencies);
+	dynamic_array_destroy(&workload->dependents);
+	hashtable_destroy(&workload->dependency_index_table);
+}
+
+// Most workloads only wait on a few others at a time, the index table is only created for workloads with more dependencies
+const int DEPENDENCY_INDEX_TABLE_THRESHOLD = 8;
+
+// Returns the index in workload->dependencies, or -1
+int analysis_workload_find_dependency(Workload_Base* workload, Workload_Base* depends_on)
+{
+	if (workload->dependency_index_table.entries.size > 0) {
+		int* index = hashtable_find_element(&workload->dependency_index_table, depends_on);
+		return index == nullptr ? -1 : *index;
+	}
+	for (int i = 0; i < workload->dependencies.size; i++) {
+		if (workload->dependencies[i].depends_on == depends_on) {
+			return i;
 		}
-		hashtable_destroy(&executer->workload_dependencies);
 	}
+	return -1;
+}
 
-	delete executer;
+// Deferred workloads don't count as pending, see enable_lazy_body_analysis
+void analysis_workload_set_deferred(Workload_Executer* executer, Workload_Base* workload, bool deferred)
+{
+	if (workload->is_deferred == deferred) return;
+	workload->is_deferred = deferred;
+	if (!workload->is_finished) {
+		executer->pending_workload_count += deferred ? -1 : 1;
+	}
 }
 
-void analysis_workload_destroy(Workload_Base* workload)
+void workload_executer_push_ready(Workload_Executer* executer, Workload_Base* workload)
 {
-	list_destroy(&workload->dependencies);
-	list_destroy(&workload->dependents);
+	if (workload->in_ready_queue) return;
+	workload->in_ready_queue = true;
+	dynamic_array_push_back(&executer->ready_workloads, workload);
+}
+
+// Returns nullptr for workloads without a definition (e.g. root)
+static AST::Node* analysis_workload_get_definition_node(Workload_Base* workload)
+{
+	switch (workload->type)
+	{
+	case Analysis_Workload_Type::MODULE_ANALYSIS: return AST::upcast(downcast<Workload_Module_Analysis>(workload)->root_node);
+	case Analysis_Workload_Type::GLOBAL: return AST::upcast(downcast<Workload_Global>(workload)->definition_node);
+	case Analysis_Workload_Type::EXTERN_IMPORT: return AST::upcast(downcast<Workload_Extern_Import>(workload)->import_node);
+	case Analysis_Workload_Type::ENUM: return AST::upcast(downcast<Workload_Enum>(workload)->node);
+	case Analysis_Workload_Type::FAST_CALL: return AST::upcast(downcast<Workload_Fast_Call>(workload)->definition_node);
+	case Analysis_Workload_Type::FUNCTION_HEADER: return AST::upcast(downcast<Workload_Function_Header>(workload)->function_node);
+	case Analysis_Workload_Type::FUNCTION_BODY: {
+		Upp_Function* function = downcast<Workload_Function_Body>(workload)->function;
+		return function->body_node.available ? AST::upcast(function->body_node.value) : nullptr;
+	}
+	case Analysis_Workload_Type::STRUCT_HEADER: {
+		auto struct_node = downcast<Workload_Structure_Header>(workload)->upp_struct->struct_node;
+		return struct_node == nullptr ? nullptr : AST::upcast(struct_node);
+	}
+	case Analysis_Workload_Type::STRUCT_BODY: {
+		auto struct_node = downcast<Workload_Structure_Body>(workload)->upp_struct->struct_node;
+		return struct_node == nullptr ? nullptr : AST::upcast(struct_node);
+	}
+	default: break;
+	}
+	return nullptr;
+}
+
+static bool analysis_workload_matches_priority_hint(Workload_Base* workload, Workload_Priority_Hint hint, Compilation_Data* compilation_data)
+{
+	AST::Node* node = analysis_workload_get_definition_node(workload);
+	if (node == nullptr) {
+		return false;
+	}
+	Compilation_Unit* unit = ast_node_to_compilation_unit(compilation_data, node);
+	if (unit != hint.unit) {
+		return false;
+	}
+	Text_Range range = AST::node_range_table_get(&unit->root->range_table, node->index).bounding_range;
+	bool is_visible = range.start.line <= hint.visible_line_end && range.end.line >= hint.visible_line_start;
+	bool contains_cursor = range.start.line <= hint.cursor_line && range.end.line >= hint.cursor_line;
+	return is_visible || contains_cursor;
+}
+
+// Marks the whole dependency chain, so that priority workloads don't wait on the rest of the program
+static void analysis_workload_mark_priority(Workload_Executer* executer, Workload_Base* workload)
+{
+	if (workload->is_priority || workload->is_finished) {
+		return;
+	}
+	workload->is_priority = true;
+	workload->priority_checked = true;
+	executer->pending_priority_count += 1;
+	for (int i = 0; i < workload->dependencies.size; i++) {
+		analysis_workload_mark_priority(executer, workload->dependencies[i].depends_on);
+	}
+}
+
+// Only checked once the main queue is drained, so that workloads created by finished priority workloads (e.g. bodies) were checked against the hint
+// Note: More workloads may be marked as priority later on, but results are only published once
+static void workload_executer_check_priority_finished(Workload_Executer* executer)
+{
+	auto& hint = executer->priority_hint;
+	if (executer->pending_priority_count > 0 || executer->priority_finished_reported || hint.priority_finished_callback == nullptr) {
+		return;
+	}
+	executer->priority_finished_reported = true;
+	hint.priority_finished_callback(executer->compilation_data, hint.priority_finished_userdata);
+}
+
+// Returns the next runnable workload or nullptr. With a priority hint, non-priority workloads only run once no priority workload is ready
+static Workload_Base* workload_executer_pop_ready(Workload_Executer* executer)
+{
+	auto& queue = executer->ready_workloads;
+	auto& background = executer->ready_background_workloads;
+	bool use_priority = executer->priority_hint.unit != nullptr;
+	while (true)
+	{
+		Workload_Base* workload = nullptr;
+		bool from_background = false;
+		if (executer->ready_workloads_head < queue.size) {
+			workload = queue[executer->ready_workloads_head];
+			executer->ready_workloads_head += 1;
+			if (executer->ready_workloads_head == queue.size) {
+				dynamic_array_reset(&queue);
+				executer->ready_workloads_head = 0;
+			}
+		}
+		else if (background.size > 0) {
+			workload_executer_check_priority_finished(executer);
+			workload = background[background.size - 1];
+			dynamic_array_rollback_to_size(&background, background.size - 1);
+			from_background = true;
+		}
+		else {
+			workload_executer_check_priority_finished(executer);
+			return nullptr;
+		}
+
+		// Queue entries aren't removed when a workload gets dependencies or is deferred again
+		if (workload->is_finished || workload->is_deferred || workload->dependencies.size > 0) {
+			workload->in_ready_queue = false;
+			continue;
+		}
+		if (use_priority && !from_background)
+		{
+			if (!workload->priority_checked) {
+				workload->priority_checked = true;
+				if (analysis_workload_matches_priority_hint(workload, executer->priority_hint, executer->compilation_data)) {
+					analysis_workload_mark_priority(executer, workload);
+				}
+			}
+			if (!workload->is_priority) {
+				dynamic_array_push_back(&background, workload);
+				continue;
+			}
+		}
+		workload->in_ready_queue = false;
+		return workload;
+	}
 }
 
 void analysis_workload_add_dependency(
@@ -1990,22 +2221,51 @@ void analysis_workload_add_dependency(
 	if (dependency->is_finished) {
 		return;
 	}
+	if (dependency->is_deferred) {
+		analysis_workload_set_deferred(executer, dependency, false);
+		workload_executer_push_ready(executer, dependency);
+	}
+	if (workload->is_priority) {
+		analysis_workload_mark_priority(executer, dependency);
+	}
 
-	Workload_Pair pair = workload_pair_create(workload, dependency);
-	Dependency_Information* infos = hashtable_find_element(&executer->workload_dependencies, pair);
-	if (infos == 0) {
-		Dependency_Information info;
-		info.dependency_node = list_add_at_end(&workload->dependencies, dependency);
-		info.dependent_node = list_add_at_end(&dependency->dependents, workload);
+	int dependency_index = analysis_workload_find_dependency(workload, dependency);
+	if (dependency_index == -1) 
+	{
+		Workload_Dependent dependent;
+		dependent.workload = workload;
+		dependent.dependency_index = workload->dependencies.size;
+
+		Workload_Dependency info;
+		info.depends_on = dependency;
+		info.dependent_index = dependency->dependents.size;
 		info.fail_indicators = dynamic_array_create<Dependency_Failure_Info>(1);
 		info.can_be_broken = can_be_broken;
 		if (can_be_broken) {
 			dynamic_array_push_back(&info.fail_indicators, failure_info);
 		}
-		bool inserted = hashtable_insert_element(&executer->workload_dependencies, pair, info);
-		assert(inserted, "");
+		dynamic_array_push_back(&workload->dependencies, info);
+		dynamic_array_push_back(&dependency->dependents, dependent);
+
+		auto& index_table = workload->dependency_index_table;
+		if (index_table.entries.size > 0) {
+			hashtable_insert_element(&index_table, dependency, dependent.dependency_index);
+		}
+		else if (workload->dependencies.size > DEPENDENCY_INDEX_TABLE_THRESHOLD) {
+			hashtable_reserve(&index_table, workload->dependencies.size * 2);
+			for (int i = 0; i < workload->dependencies.size; i++) {
+				hashtable_insert_element(&index_table, workload->dependencies[i].depends_on, i);
+			}
+		}
+
+		// New edges are the only way to create a cycle
+		if (!workload->is_cycle_search_root) {
+			workload->is_cycle_search_root = true;
+			dynamic_array_push_back(&executer->cycle_search_roots, workload);
+		}
 	}
 	else {
+		Workload_Dependency* infos = &workload->dependencies[dependency_index];
 		if (can_be_broken) {
 			dynamic_array_push_back(&infos->fail_indicators, failure_info);
 		}
@@ -2015,52 +2275,200 @@ void analysis_workload_add_dependency(
 	}
 }
 
-void workload_executer_remove_dependency(
-	Workload_Executer* executer, Workload_Base* workload, Workload_Base* depends_on, bool allow_add_to_runnables, bool dependency_succeeded)
+// Removes workload->dependencies[dependency_index]
+// If remove_dependent is false the caller clears depends_on->dependents itself (e.g. when depends_on finished)
+void workload_executer_remove_dependency_at(
+	Workload_Executer* executer, Workload_Base* workload, int dependency_index, bool allow_add_to_runnables, bool dependency_succeeded, 
+	bool remove_dependent = true)
 {
-	auto graph = executer;
-	Workload_Pair pair = workload_pair_create(workload, depends_on);
-	Dependency_Information* info = hashtable_find_element(&graph->workload_dependencies, pair);
-	assert(info != 0, "");
-	list_remove_node(&workload->dependencies, info->dependency_node);
-	list_remove_node(&depends_on->dependents, info->dependent_node);
+	auto& dependencies = workload->dependencies;
+	Workload_Dependency info = dependencies[dependency_index];
 
 	// Signal all fail indicators to have passed
-	for (int i = 0; i < info->fail_indicators.size; i++) {
-		*(info->fail_indicators[i].fail_indicator) = !dependency_succeeded;
+	for (int i = 0; i < info.fail_indicators.size; i++) {
+		*(info.fail_indicators[i].fail_indicator) = !dependency_succeeded;
 	}
-	dynamic_array_destroy(&info->fail_indicators);
+	dynamic_array_destroy(&info.fail_indicators);
 
-	bool worked = hashtable_remove_element(&graph->workload_dependencies, pair);
-	if (allow_add_to_runnables && workload->dependencies.count == 0) {
-		dynamic_array_push_back(&graph->runnable_workloads, workload);
+	// Swap-remove both edges, and patch the index stored in the counterpart of the moved edge
+	if (remove_dependent)
+	{
+		auto& dependents = info.depends_on->dependents;
+		int last_index = dependents.size - 1;
+		if (info.dependent_index != last_index) {
+			Workload_Dependent moved = dependents[last_index];
+			dependents[info.dependent_index] = moved;
+			moved.workload->dependencies[moved.dependency_index].dependent_index = info.dependent_index;
+		}
+		dynamic_array_rollback_to_size(&dependents, last_index);
+	}
+	auto& index_table = workload->dependency_index_table;
+	if (index_table.entries.size > 0) {
+		hashtable_remove_element(&index_table, info.depends_on);
+	}
+	int last_index = dependencies.size - 1;
+	if (dependency_index != last_index) {
+		Workload_Dependency moved = dependencies[last_index];
+		dependencies[dependency_index] = moved;
+		moved.depends_on->dependents[moved.dependent_index].dependency_index = dependency_index;
+		if (index_table.entries.size > 0) {
+			*hashtable_find_element(&index_table, moved.depends_on) = dependency_index;
+		}
+	}
+	dynamic_array_rollback_to_size(&dependencies, last_index);
+
+	if (allow_add_to_runnables && dependencies.size == 0) {
+		workload_executer_push_ready(executer, workload);
 	}
 }
 
-bool analysis_workload_find_cycle(
-	Workload_Base* current_workload, int current_depth, Workload_Base* start_workload, int desired_cycle_size,
-	Dynamic_Array<Workload_Base*>* loop_nodes, Hashtable<Workload_Base*, int>* valid_workloads)
+void workload_executer_remove_dependency(
+	Workload_Executer* executer, Workload_Base* workload, Workload_Base* depends_on, bool allow_add_to_runnables, bool dependency_succeeded)
 {
-	if (hashtable_find_element(valid_workloads, current_workload) == 0) {
-		return false;
-	}
-	if (current_workload->is_finished) return false;
-	if (current_depth > desired_cycle_size) return false;
-	if (current_workload == start_workload) {
-		assert(current_depth == desired_cycle_size, "");
-		dynamic_array_push_back(loop_nodes, current_workload);
-		return true;
+	int dependency_index = analysis_workload_find_dependency(workload, depends_on);
+	assert(dependency_index != -1, "");
+	workload_executer_remove_dependency_at(executer, workload, dependency_index, allow_add_to_runnables, dependency_succeeded);
+}
+
+// Breadth first search along dependencies inside one strongly connected component (members are marked with member_generation),
+// the first edge back to root closes the shortest cycle through root
+static void workload_component_find_shortest_cycle(Workload_Base* root, int member_generation, Dynamic_Array<Workload_Base*>* cycle)
+{
+	Dynamic_Array<Workload_Base*> queue = dynamic_array_create<Workload_Base*>(8);
+	SCOPE_EXIT(dynamic_array_destroy(&queue));
+	Dynamic_Array<int> parent_indices = dynamic_array_create<int>(8);
+	SCOPE_EXIT(dynamic_array_destroy(&parent_indices));
+
+	root->cycle_search_index = 0;
+	dynamic_array_push_back(&queue, root);
+	dynamic_array_push_back(&parent_indices, -1);
+	for (int i = 0; i < queue.size; i++)
+	{
+		Workload_Base* workload = queue[i];
+		for (int j = 0; j < workload->dependencies.size; j++)
+		{
+			Workload_Base* dependency = workload->dependencies[j].depends_on;
+			if (dependency == root) {
+				int index = i;
+				while (index != -1) {
+					dynamic_array_push_back(cycle, queue[index]);
+					index = parent_indices[index];
+				}
+				dynamic_array_reverse_order(cycle);
+				return;
+			}
+			if (dependency->cycle_search_generation != member_generation || dependency->cycle_search_index != -1) {
+				continue;
+			}
+			dependency->cycle_search_index = queue.size;
+			dynamic_array_push_back(&queue, dependency);
+			dynamic_array_push_back(&parent_indices, i);
+		}
 	}
+	panic("Strongly connected component must contain a cycle through its root");
+}
 
-	List_Node<Workload_Base*>* node = current_workload->dependencies.head;
-	while (node != 0)
+// Tarjan's strongly connected components (iterative, as dependency chains can be long), only started from the cycle search roots.
+// Roots whose reachable subgraph is acyclic are removed, so stalled workloads aren't searched again until they add a dependency.
+// Fills cycle with the workloads of the first cycle found, where cycle[i] depends on cycle[i + 1] (and the last one on the first)
+static bool workload_executer_find_cycle(Workload_Executer* executer, Dynamic_Array<Workload_Base*>* cycle)
+{
+	struct Search_Frame
 	{
-		SCOPE_EXIT(node = node->next);
-		Workload_Base* dependency = node->value;
-		if (analysis_workload_find_cycle(dependency, current_depth + 1, start_workload, desired_cycle_size, loop_nodes, valid_workloads)) {
-			dynamic_array_push_back(loop_nodes, current_workload);
-			return true;
+		Workload_Base* workload;
+		int next_dependency;
+	};
+
+	executer->cycle_search_generation += 1;
+	int generation = executer->cycle_search_generation;
+	int next_index = 0;
+	Dynamic_Array<Search_Frame> call_stack = dynamic_array_create<Search_Frame>(16);
+	SCOPE_EXIT(dynamic_array_destroy(&call_stack));
+	Dynamic_Array<Workload_Base*> component_stack = dynamic_array_create<Workload_Base*>(16);
+	SCOPE_EXIT(dynamic_array_destroy(&component_stack));
+
+	auto visit = [&](Workload_Base* workload) {
+		workload->cycle_search_generation = generation;
+		workload->cycle_search_index = next_index;
+		workload->cycle_search_lowlink = next_index;
+		workload->cycle_search_on_stack = true;
+		next_index += 1;
+		dynamic_array_push_back(&component_stack, workload);
+		Search_Frame frame;
+		frame.workload = workload;
+		frame.next_dependency = 0;
+		dynamic_array_push_back(&call_stack, frame);
+	};
+
+	auto& roots = executer->cycle_search_roots;
+	for (int i = 0; i < roots.size; i++)
+	{
+		Workload_Base* start = roots[i];
+		// Note: Workloads visited from a previous root are in acyclic components
+		if (start->is_finished || start->cycle_search_generation == generation) {
+			start->is_cycle_search_root = false;
+			dynamic_array_swap_remove(&roots, i);
+			i -= 1;
+			continue;
+		}
+		if (start->is_deferred) {
+			continue;
+		}
+
+		visit(start);
+		while (call_stack.size > 0)
+		{
+			Search_Frame& frame = call_stack[call_stack.size - 1];
+			Workload_Base* workload = frame.workload;
+			if (frame.next_dependency < workload->dependencies.size)
+			{
+				Workload_Base* dependency = workload->dependencies[frame.next_dependency].depends_on;
+				frame.next_dependency += 1;
+				if (dependency->cycle_search_generation != generation) {
+					visit(dependency); // Invalidates frame
+				}
+				else if (dependency->cycle_search_on_stack) {
+					workload->cycle_search_lowlink = math_minimum(workload->cycle_search_lowlink, dependency->cycle_search_index);
+				}
+				continue;
+			}
+
+			// All dependencies visited
+			dynamic_array_rollback_to_size(&call_stack, call_stack.size - 1);
+			if (call_stack.size > 0) {
+				Workload_Base* parent = call_stack[call_stack.size - 1].workload;
+				parent->cycle_search_lowlink = math_minimum(parent->cycle_search_lowlink, workload->cycle_search_lowlink);
+			}
+			if (workload->cycle_search_lowlink != workload->cycle_search_index) {
+				continue;
+			}
+
+			// Workload is the root of a component
+			int component_start = component_stack.size - 1;
+			while (component_stack[component_start] != workload) {
+				component_start -= 1;
+			}
+			bool is_cycle = component_stack.size - component_start > 1 || analysis_workload_find_dependency(workload, workload) != -1;
+			if (is_cycle)
+			{
+				executer->cycle_search_generation += 1;
+				int member_generation = executer->cycle_search_generation;
+				for (int j = component_start; j < component_stack.size; j++) {
+					component_stack[j]->cycle_search_generation = member_generation;
+					component_stack[j]->cycle_search_index = -1;
+				}
+				workload_component_find_shortest_cycle(workload, member_generation, cycle);
+				return true;
+			}
+			for (int j = component_start; j < component_stack.size; j++) {
+				component_stack[j]->cycle_search_on_stack = false;
+			}
+			dynamic_array_rollback_to_size(&component_stack, component_start);
 		}
+
+		start->is_cycle_search_root = false;
+		dynamic_array_swap_remove(&roots, i);
+		i -= 1;
 	}
 	return false;
 }
@@ -2125,44 +2533,35 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 	double time_per_workload_type[(int)Analysis_Workload_Type::MAX_ENUM_VALUE];
 	memory_set_bytes(&time_per_workload_type[0], sizeof(double) * (size_t)Analysis_Workload_Type::MAX_ENUM_VALUE, 0);
 	double last_timestamp = timer_current_time_in_seconds();
+	u64 switch_count_start = fiber_get_switch_count();
 
-	Arena scratch_arena = Arena::create(0);
-	SCOPE_EXIT(scratch_arena.destroy());
-	Semantic_Context error_logging_context = semantic_context_make(
-		compilation_data, nullptr, nullptr, Symbol_Access_Level::GLOBAL, nullptr, &scratch_arena
-	);
-	
 	auto& all_workloads = executer->all_workloads;
 	int round_no = 0;
 	while (true)
 	{
 		SCOPE_EXIT(round_no += 1);
-		executer->progress_was_made = false;
 		// Print workloads and dependencies
 		if (PRINT_DEPENDENCIES)
 		{
 			String tmp = string_create(256);
 			SCOPE_EXIT(string_destroy(&tmp));
 			string_append_formated(&tmp, "\n\n--------------------\nWorkload Execution Round %d\n---------------------\n", round_no);
-			for (int i = 0; i < executer->runnable_workloads.size; i++)
+			for (int i = executer->ready_workloads_head; i < executer->ready_workloads.size; i++)
 			{
-				auto workload = executer->runnable_workloads[i];
-				if (i == 0) {
+				auto workload = executer->ready_workloads[i];
+				if (i == executer->ready_workloads_head) {
 					string_append_formated(&tmp, "Runnable workloads:\n");
 				}
-				if (workload->dependencies.count > 0) continue;
+				if (workload->dependencies.size > 0) continue;
 				if (workload->is_finished) continue;
 				string_append_formated(&tmp, "  ");
 				analysis_workload_append_to_string(workload, &tmp);
 				string_append_formated(&tmp, "\n");
 
 				// Append dependents
-				List_Node<Workload_Base*>* dependent_node = workload->dependents.head;
-				while (dependent_node != 0) {
-					SCOPE_EXIT(dependent_node = dependent_node->next);
-					Workload_Base* dependent = dependent_node->value;
+				for (int j = 0; j < workload->dependents.size; j++) {
 					string_append_formated(&tmp, "    ");
-					analysis_workload_append_to_string(dependent, &tmp);
+					analysis_workload_append_to_string(workload->dependents[j].workload, &tmp);
 					string_append_formated(&tmp, "\n");
 				}
 			}
@@ -2173,37 +2572,25 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 					string_append_formated(&tmp, "\nWorkloads with dependencies:\n");
 				}
 				Workload_Base* workload = all_workloads[i];
-				if (workload->is_finished || workload->dependencies.count == 0) continue;
+				if (workload->is_finished || workload->dependencies.size == 0) continue;
 				string_append_formated(&tmp, "  ");
 				analysis_workload_append_to_string(workload, &tmp);
 				string_append_formated(&tmp, "\n");
 				// Print dependencies
-				{
-					List_Node<Workload_Base*>* dependency_node = workload->dependencies.head;
-					if (dependency_node != 0) {
-						string_append_formated(&tmp, "    Depends On:\n");
-					}
-					while (dependency_node != 0) {
-						SCOPE_EXIT(dependency_node = dependency_node->next);
-						Workload_Base* dependency = dependency_node->value;
-						string_append_formated(&tmp, "      ");
-						analysis_workload_append_to_string(dependency, &tmp);
-						string_append_formated(&tmp, "\n");
-					}
+				string_append_formated(&tmp, "    Depends On:\n");
+				for (int j = 0; j < workload->dependencies.size; j++) {
+					string_append_formated(&tmp, "      ");
+					analysis_workload_append_to_string(workload->dependencies[j].depends_on, &tmp);
+					string_append_formated(&tmp, "\n");
 				}
 				// Dependents
-				{
-					List_Node<Workload_Base*>* dependent_node = workload->dependents.head;
-					if (dependent_node != 0) {
-						string_append_formated(&tmp, "    Dependents:\n");
-					}
-					while (dependent_node != 0) {
-						SCOPE_EXIT(dependent_node = dependent_node->next);
-						Workload_Base* dependent = dependent_node->value;
-						string_append_formated(&tmp, "      ");
-						analysis_workload_append_to_string(dependent, &tmp);
-						string_append_formated(&tmp, "\n");
-					}
+				if (workload->dependents.size > 0) {
+					string_append_formated(&tmp, "    Dependents:\n");
+				}
+				for (int j = 0; j < workload->dependents.size; j++) {
+					string_append_formated(&tmp, "      ");
+					analysis_workload_append_to_string(workload->dependents[j].workload, &tmp);
+					string_append_formated(&tmp, "\n");
 				}
 
 			}
@@ -2211,17 +2598,16 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 			logg("%s", tmp.characters);
 		}
 
-		// Execute runnable workloads
-		for (int i = 0; i < executer->runnable_workloads.size; i++)
+		// Execute ready workloads until the queue is empty (With priority hint, priority workloads are executed first)
+		while (true)
 		{
-			Workload_Base* workload = executer->runnable_workloads[i];
-			if (workload->dependencies.count > 0) {
-				continue; // Skip runnable workload
+			Workload_Base* workload = workload_executer_pop_ready(executer);
+			if (workload == nullptr) {
+				break;
 			}
-			if (workload->is_finished) {
-				continue;
+			if (compilation_data_check_cancelled(compilation_data)) {
+				return; // Suspended workload fibers are aborted in compilation_data_compile
 			}
-			executer->progress_was_made = true;
 
 			if (PRINT_DEPENDENCIES) {
 				String tmp = string_create(128);
@@ -2234,58 +2620,59 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 			double now = timer_current_time_in_seconds();
 			time_in_executer += now - last_timestamp;
 			last_timestamp = now;
+			if (compilation_data->trace_recorder != nullptr && workload->switch_count > 0) {
+				trace_recorder_add_span(
+					compilation_data->trace_recorder, Trace_Event_Type::DEPENDENCY_WAIT, workload, 0, workload->wait_start_time, now
+				);
+			}
 
+			workload->switch_count += 1;
 			bool finished = workload_executer_switch_to_workload(executer, workload);
 
 			// TIMING
 			now = timer_current_time_in_seconds();
 			time_per_workload_type[(int)workload->type] += now - last_timestamp;
+			if (compilation_data->trace_recorder != nullptr) {
+				trace_recorder_add_span(
+					compilation_data->trace_recorder, Trace_Event_Type::WORKLOAD, workload, workload->switch_count, last_timestamp, now
+				);
+				workload->wait_start_time = now;
+			}
 			last_timestamp = now;
 
 			// Note: After a workload executes, it may have added new dependencies to itself
-			if (workload->dependencies.count == 0)
+			if (workload->dependencies.size == 0)
 			{
 				assert(finished, "When on dependencies remain, the fiber should have exited normally!\n");
 				workload->is_finished = true;
-				List_Node<Workload_Base*>* node = workload->dependents.head;
-				// Loop over all dependents and remove this workload from that list
-				while (node != 0) {
-					Workload_Base* dependent = node->value;
-					node = node->next; // INFO: This is required before remove_dependency, since remove will remove nodes from the list
-					workload_executer_remove_dependency(executer, dependent, workload, true, true);
+				if (!workload->is_deferred) {
+					executer->pending_workload_count -= 1;
+				}
+				// Remove this workload from all dependents, the dependents array is cleared afterwards instead of per edge
+				for (int j = 0; j < workload->dependents.size; j++) {
+					Workload_Dependent dependent = workload->dependents[j];
+					workload_executer_remove_dependency_at(executer, dependent.workload, dependent.dependency_index, true, true, false);
+				}
+				dynamic_array_reset(&workload->dependents);
+
+				if (workload->is_priority) {
+					executer->pending_priority_count -= 1;
 				}
-				assert(workload->dependents.count == 0, "Remove dependency should already have cleared the list!");
 			}
 			else {
 				assert(!finished, "If there are dependencies, the fiber must still be running!");
 			}
 		}
-		dynamic_array_reset(&executer->runnable_workloads);
-		if (executer->progress_was_made) {
-			if (PRINT_DEPENDENCIES) {
-				logg("Progress was made!");
-			}
-			continue;
-		}
 
-		// Check if all workloads finished
-		{
-			bool all_finished = true;
-			for (int i = 0; i < all_workloads.size; i++) {
-				if (!all_workloads[i]->is_finished) {
-					all_finished = false;
-					break;
-				}
-			}
-			if (all_finished) {
-				break;
-			}
+		// Check if all workloads finished (Note: Deferred workloads which nothing depends on are never executed)
+		if (executer->pending_workload_count == 0) {
+			break;
 		}
 
 		/*
 			Circular Dependency Detection:
-			 1. Do breadth first search to find smallest possible loop/if loop exists
-			 2. If a loop was found, do a depth first search to reconstruct the loop (Could probably be done better)
+			 1. Find a strongly connected component with Tarjan's algorithm (Only from workloads which added dependencies since the last search)
+			 2. Breadth first search inside the component for the shortest cycle
 			 3. Resolve the loop (Log Error, set some of the dependencies to error)
 		*/
 		// TIMING
@@ -2294,122 +2681,16 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 		last_timestamp = now;
 
 		{
-			// Initialization
-			Hashtable<Workload_Base*, int> workload_to_layer = hashtable_create_pointer_empty<Workload_Base*, int>(4);
-			SCOPE_EXIT(hashtable_destroy(&workload_to_layer));
-			Hashset<Workload_Base*> unvisited = hashset_create_pointer_empty<Workload_Base*>(4);
-			SCOPE_EXIT(hashset_destroy(&unvisited));
-			for (int i = 0; i < all_workloads.size; i++) {
-				Workload_Base* workload = all_workloads[i];
-				if (!workload->is_finished) {
-					hashset_insert_element(&unvisited, workload);
-				}
-			}
-
-			bool loop_found = false;
-			int loop_node_count = -1;
-			Workload_Base* loop_node = 0;
-			Workload_Base* loop_node_2 = 0;
-
-			// Breadth first search
-			Dynamic_Array<int> layer_start_indices = dynamic_array_create<int>(4);
-			SCOPE_EXIT(dynamic_array_destroy(&layer_start_indices));
-			Dynamic_Array<Workload_Base*> layers = dynamic_array_create<Workload_Base*>(4);
-			SCOPE_EXIT(dynamic_array_destroy(&layers));
-
-			// Note: Since we are dealing with possibly unconnected graphs (Not all workloads are connected) this is a double loop
-			while (!loop_found)
-			{
-				// Remove all nodes that are already confirmed to have no cycles (E.g nodes from last loop run)
-				for (int i = 0; i < layers.size; i++) {
-					hashset_remove_element(&unvisited, layers[i]);
-				}
-				if (unvisited.element_count == 0) break;
-				dynamic_array_reset(&layer_start_indices);
-				dynamic_array_reset(&layers);
-				hashtable_reset(&workload_to_layer);
-
-				Workload_Base* start = *hashset_iterator_create(&unvisited).value;
-				dynamic_array_push_back(&layer_start_indices, layers.size);
-				dynamic_array_push_back(&layers, start);
-				dynamic_array_push_back(&layer_start_indices, layers.size);
-
-				int current_layer = 0;
-				while (true && !loop_found)
-				{
-					SCOPE_EXIT(current_layer++);
-					int layer_start = layer_start_indices[current_layer];
-					int layer_end = layer_start_indices[current_layer + 1];
-					if (layer_start == layer_end) break;
-					for (int i = layer_start; i < layer_end && !loop_found; i++)
-					{
-						Workload_Base* scan_for_loops = layers[i];
-						assert(!scan_for_loops->is_finished, "");
-						List_Node<Workload_Base*>* node = scan_for_loops->dependencies.head;
-						while (node != 0 && !loop_found)
-						{
-							SCOPE_EXIT(node = node->next;);
-							Workload_Base* dependency = node->value;
-							if (!hashset_contains(&unvisited, dependency)) {
-								// Node is clear because we checked it on a previous cycle
-								continue;
-							}
-							int* found_layer = hashtable_find_element(&workload_to_layer, dependency);
-							if (found_layer == nullptr) {
-								hashtable_insert_element(&workload_to_layer, dependency, current_layer + 1);
-								dynamic_array_push_back(&layers, dependency);
-							}
-							else
-							{
-								int dependency_layer = *found_layer;
-								if (dependency_layer > current_layer) {
-									// This means the workload is already queued for the next layer
-								}
-								else if (dependency_layer == current_layer) {
-									// Here we need to check for self loops and loops with the breadth-first depth
-									if (dependency == scan_for_loops) { // Self dependency
-										loop_found = true;
-										loop_node_count = 1;
-									}
-									else if (hashtable_find_element(&executer->workload_dependencies, workload_pair_create(dependency, scan_for_loops)) != 0) {
-										loop_found = true;
-										loop_node_count = 2;
-									}
-								}
-								else {
-									// Definitly found a loop
-									loop_found = true;
-									loop_node_count = current_layer - dependency_layer + 1;
-								}
-
-								// Recheck and set loop nodes
-								if (loop_found) {
-									loop_node = scan_for_loops;
-									loop_node_2 = dependency;
-									break;
-								}
-							}
-						}
-					}
-					dynamic_array_push_back(&layer_start_indices, layers.size);
-				}
-			}
-
-			// Handle the loop
-			if (loop_found)
+			Dynamic_Array<Workload_Base*> workload_cycle = dynamic_array_create<Workload_Base*>(1);
+			SCOPE_EXIT(dynamic_array_destroy(&workload_cycle));
+			if (workload_executer_find_cycle(executer, &workload_cycle))
 			{
-				// Reconstruct Loop
-				Dynamic_Array<Workload_Base*> workload_cycle = dynamic_array_create<Workload_Base*>(1);
-				SCOPE_EXIT(dynamic_array_destroy(&workload_cycle));
-				if (loop_node_count != 1) {
-					// Depth first search
-					bool found_loop_again = analysis_workload_find_cycle(loop_node_2, 1, loop_node, loop_node_count, &workload_cycle, &workload_to_layer);
-					assert(found_loop_again, "");
-					dynamic_array_reverse_order(&workload_cycle);
-				}
-				else {
-					dynamic_array_push_back(&workload_cycle, loop_node);
-				}
+				// Scratch memory is only taken here, workload fibers use the same thread-local scratch arenas while suspended
+				Arena_Checkpoint scratch = arena_scratch_begin();
+				SCOPE_EXIT(scratch.rewind());
+				Semantic_Context error_logging_context = semantic_context_make(
+					compilation_data, nullptr, nullptr, Symbol_Access_Level::GLOBAL, nullptr, scratch.arena
+				);
 
 				// Resolve and report error
 				bool breakable_dependency_found = false;
@@ -2417,8 +2698,9 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 				{
 					Workload_Base* workload = workload_cycle[i];
 					Workload_Base* depends_on = i + 1 == workload_cycle.size ? workload_cycle[0] : workload_cycle[i + 1];
-					Workload_Pair pair = workload_pair_create(workload, depends_on);
-					Dependency_Information infos = *hashtable_find_element(&executer->workload_dependencies, pair);
+					int dependency_index = analysis_workload_find_dependency(workload, depends_on);
+					assert(dependency_index != -1, "");
+					Workload_Dependency infos = workload->dependencies[dependency_index];
 					if (infos.can_be_broken) {
 						breakable_dependency_found = true;
 						for (int j = 0; j < infos.fail_indicators.size; j++) {
@@ -2428,39 +2710,34 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 								log_error_info_cycle_workload(&error_logging_context, workload);
 							}
 						}
-						workload_executer_remove_dependency(executer, workload, depends_on, true, false);
+						workload_executer_remove_dependency_at(executer, workload, dependency_index, true, false);
 					}
 				}
 				assert(breakable_dependency_found, "");
-				executer->progress_was_made = true;
 				if (PRINT_DEPENDENCIES) {
 					logg("Resolved cyclic dependency loop!");
 				}
-			}
-		}
 
-		if (executer->progress_was_made) {
-			if (PRINT_DEPENDENCIES) {
-				logg("Progress was made!");
-			}
-
-			// TIMING
-			double now = timer_current_time_in_seconds();
-			time_in_loop_resolve += now - last_timestamp;
-			last_timestamp = now;
+				// TIMING
+				double now = timer_current_time_in_seconds();
+				time_in_loop_resolve += now - last_timestamp;
+				last_timestamp = now;
 
-			continue;
+				continue;
+			}
 		}
 
 		panic("Loops must have been resolved by now, so some progress needs to be have made..\n");
 	}
 
+	compilation_data->fiber_switch_count = fiber_get_switch_count() - switch_count_start;
 	if (PRINT_TIMING)
 	{
 		double end_time = timer_current_time_in_seconds();
 		//logg("Time in Bake Analysis    %3.4f")
 		logg("Time in executer         %3.4fms\n", time_in_executer * 1000);
 		logg("Time in loop-resolve     %3.4fms\n", time_in_loop_resolve * 1000);
+		logg("Fiber switches           %lld\n", (i64)compilation_data->fiber_switch_count);
 		for (int i = 0; i < (int)Analysis_Workload_Type::MAX_ENUM_VALUE; i++) {
 			logg("Time in %s %3.4fms\n", analysis_workload_type_as_string((Analysis_Workload_Type) i), time_per_workload_type[i] * 1000);
 		}
@@ -2470,9 +2747,8 @@ void workload_executer_resolve(Workload_Executer* executer, Compilation_Data* co
 
 void workload_add_to_runnable_queue_if_possible(Workload_Executer* executer, Workload_Base* workload)
 {
-	if (!workload->is_finished && workload->dependencies.count == 0) {
-		dynamic_array_push_back(&executer->runnable_workloads, workload);
-		executer->progress_was_made = true;
+	if (!workload->is_finished && workload->dependencies.size == 0) {
+		workload_executer_push_ready(executer, workload);
 	}
 }
 
@@ -2491,22 +2767,17 @@ bool workload_executer_switch_to_workload(Workload_Executer* executer, Workload_
 	if (PRINT_DEPENDENCIES) {
 		auto tmp = string_create(1);
 		analysis_workload_append_to_string(workload, &tmp);
-		if (workload->dependencies.count == 0) {
+		if (workload->dependencies.size == 0) {
 			SCOPE_EXIT(string_destroy(&tmp));
 			logg("FINISHED: %s\n", tmp.characters);
 		}
 		else
 		{
 			// Print dependencies
-			List_Node<Workload_Base*>* dependency_node = workload->dependencies.head;
-			if (dependency_node != 0) {
-				string_append_formated(&tmp, "    Depends On:\n");
-			}
-			while (dependency_node != 0) {
-				SCOPE_EXIT(dependency_node = dependency_node->next);
-				Workload_Base* dependency = dependency_node->value;
+			string_append_formated(&tmp, "    Depends On:\n");
+			for (int i = 0; i < workload->dependencies.size; i++) {
 				string_append_formated(&tmp, "      ");
-				analysis_workload_append_to_string(dependency, &tmp);
+				analysis_workload_append_to_string(workload->dependencies[i].depends_on, &tmp);
 				string_append_formated(&tmp, "\n");
 			}
 			logg("WAITING: %s\n", tmp.characters);
@@ -2520,7 +2791,7 @@ void workload_executer_wait_for_dependency_resolution(Semantic_Context* semantic
 {
 	Workload_Base* workload = semantic_context->current_workload;
 	if (workload == nullptr) return;
-	if (workload->dependencies.count != 0) {
+	if (workload->dependencies.size != 0) {
 		fiber_pool_switch_to_main_fiber(semantic_context->compilation_data->fiber_pool);
 	}
 }
@@ -2561,7 +2832,8 @@ void analysis_workload_append_to_string(Workload_Base* workload, String* string)
 	}
 	case Analysis_Workload_Type::ENUM: {
 		auto enumeration = downcast<Workload_Enum>(workload);
-		string_append_formated(string, "Enum: %s", enumeration->node->symbol->name->characters);
+		string_append(string, "Enum: ");
+		string_append_string(string, enumeration->node->symbol->name);
 		break;
 	}
 	case Analysis_Workload_Type::EXTERN_IMPORT: {
@@ -2571,34 +2843,44 @@ void analysis_workload_append_to_string(Workload_Base* workload, String* string)
 	case Analysis_Workload_Type::FAST_CALL: 
 	{
 		auto fast_call = downcast<Workload_Fast_Call>(workload);
-		string_append_formated(string, "Fast_Call %s", fast_call->symbol->id->characters);
+		string_append(string, "Fast_Call ");
+		string_append_string(string, fast_call->symbol->id);
 		break;
 	}
 	case Analysis_Workload_Type::GLOBAL: 
 	{
 		auto def = downcast<Workload_Global>(workload);
-		string_append_formated(string, "Global/Comptime %s", def->symbol->id->characters);
+		string_append(string, "Global/Comptime ");
+		string_append_string(string, def->symbol->id);
 		break;
 	}
 	case Analysis_Workload_Type::FUNCTION_BODY: {
 		Symbol* symbol = 0;
 		auto function = downcast<Workload_Function_Body>(workload)->function;
-		string_append_formated(string, "Body \"%s\"", function->name->characters);
+		string_append(string, "Body \"");
+		string_append_string(string, function->name);
+		string_append(string, "\"");
 		break;
 	}
 	case Analysis_Workload_Type::FUNCTION_HEADER: {
 		auto function = downcast<Workload_Function_Header>(workload)->function;
-		string_append_formated(string, "Header \"%s\"", function->name->characters);
+		string_append(string, "Header \"");
+		string_append_string(string, function->name);
+		string_append(string, "\"");
 		break;
 	}
 	case Analysis_Workload_Type::STRUCT_BODY: {
 		auto struct_id = downcast<Workload_Structure_Body>(workload)->upp_struct->datatype->name->characters;
-		string_append_formated(string, "Struct-Analysis \"%s\"", struct_id);
+		string_append(string, "Struct-Analysis \"");
+		string_append(string, struct_id);
+		string_append(string, "\"");
 		break;
 	}
 	case Analysis_Workload_Type::STRUCT_HEADER: {
 		auto struct_id = downcast<Workload_Structure_Header>(workload)->upp_struct->datatype->name->characters;
-		string_append_formated(string, "Struct-Analysis \"%s\"", struct_id);
+		string_append(string, "Struct-Analysis \"");
+		string_append(string, struct_id);
+		string_append(string, "\"");
 		break;
 	}
 	default: panic("");
@@ -2647,19 +2929,19 @@ void semantic_analyser_finish_analysis(Compilation_Data* compilation_data)
 	auto& type_system = compilation_data->type_system;
 	auto& ids = compilation_data->identifier_pool.predefined_ids;
 
-	Arena arena = Arena::create();
-	SCOPE_EXIT(arena.destroy());
+	Arena_Checkpoint scratch = arena_scratch_begin();
+	SCOPE_EXIT(scratch.rewind());
 
 	// Semantic context just for error logging
 	Semantic_Context error_context = semantic_context_make(
-		compilation_data, nullptr, compilation_data->root_symbol_table, Symbol_Access_Level::GLOBAL, nullptr, &arena
+		compilation_data, nullptr, compilation_data->root_symbol_table, Symbol_Access_Level::GLOBAL, nullptr, scratch.arena
 	);
 	Semantic_Context* semantic_context = &error_context;
 
 	// Check if main is defined
 	DynArray<Symbol*> main_symbols = symbol_table_query_id(
 		compilation_data->main_unit->upp_module->symbol_table, ids.main, 
-		symbol_query_info_make(Symbol_Access_Level::GLOBAL, Import_Type::NONE, false), &arena
+		symbol_query_info_make(Symbol_Access_Level::GLOBAL, Import_Type::NONE, false), scratch.arena
 	);
 	if (main_symbols.size == 0) {
 		log_semantic_error(semantic_context, "Main function not defined", upcast(compilation_data->main_unit->root), Node_Section::END_TOKEN);
@@ -3285,7 +3567,7 @@ Call_Origin call_origin_make(Datatype_Struct* structure, Semantic_Context* seman
 		assert(structure->base.memory_info.available, "");
 
 		// Create new signature
-		Call_Signature* signature = call_signature_create_empty();
+		Call_Signature* signature = call_signature_create_empty(semantic_context->compilation_data);
 		for (int i = 0; i < structure->members.size; i++) {
 			auto& member = structure->members[i];
 			call_signature_add_parameter(signature, member.name, member.datatype, !is_union_initializer, is_union_initializer, false);
@@ -3305,7 +3587,7 @@ Call_Origin call_origin_make_slice_initializer(Datatype_Slice* slice_type, Compi
 	if (slice_type->slice_initializer_signature_cached == nullptr) 
 	{
 		auto& ids = compilation_data->identifier_pool.predefined_ids;
-		Call_Signature* signature = call_signature_create_empty();
+		Call_Signature* signature = call_signature_create_empty(compilation_data);
 		call_signature_add_parameter(signature, ids.data, slice_type->data_member.datatype, true, false, false);
 		call_signature_add_parameter(signature, ids.size, slice_type->size_member.datatype, true, false, false);
 		signature = call_signature_register(signature, compilation_data);
@@ -3808,7 +4090,7 @@ Call_Info* overloading_analyse_call_expression_and_resolve_overloads(
 		helper_add_overload_candidate(call_origin);
 	}
 
-	auto& helper_set_callable_to_candidate = [&](Overload_Candidate& candidate) {
+	auto helper_set_callable_to_candidate = [&](Overload_Candidate& candidate) {
 		// Update expression infos
 		if (path_lookup != nullptr)
 		{
@@ -4388,7 +4670,7 @@ Poly_Header* poly_header_analyse(
 	header.instances = DynSet<Poly_Instance*>::create(arena, hash_poly_instance, equals_poly_instance);
 	header.pattern_variables = DynArray<Pattern_Variable>::create(arena);
 	header.param_infos = DynArray<Poly_Parameter_Info>::create(arena);
-	header.signature = call_signature_create_empty();
+	header.signature = call_signature_create_empty(compilation_data);
 	header.signature->return_type_index = return_type_index;
 	assert(name != nullptr, "Name should be available for polymorhphic functions/structs");
 	if (poly_struct != nullptr) {
@@ -4811,7 +5093,7 @@ Datatype* datatype_pattern_instanciate(
 		auto function_pointer = downcast<Datatype_Function_Pointer>(pattern_type);
 		auto signature = function_pointer->signature;
 		// Note: create function takes ownership, so only delete this if we have instanciation error
-		Call_Signature* new_signature = call_signature_create_empty();
+		Call_Signature* new_signature = call_signature_create_empty(semantic_context->compilation_data);
 		new_signature->return_type_index = signature->return_type_index;
 		for (int i = 0; i < signature->parameters.size; i++)
 		{
@@ -4820,7 +5102,7 @@ Datatype* datatype_pattern_instanciate(
 				param.datatype, states, error_report_node, error_report_section, semantic_context
 			);
 			if (param_instance_type == nullptr) {
-				call_signature_destroy(new_signature);
+				call_signature_destroy(new_signature, semantic_context->compilation_data);
 				return nullptr;
 			}
 			call_signature_add_parameter(
@@ -5423,6 +5705,9 @@ Poly_Instance* poly_header_instanciate(
 			body_workload->function = instance_function;
 			body_workload->parameter_table = instance_table;
 			body_workload->base.polymorphic_instanciation_depth += 1;
+			analysis_workload_set_deferred(
+				semantic_context->compilation_data->workload_executer, upcast(body_workload), function_body_analysis_can_be_deferred(semantic_context, instance_function)
+			);
 
 			assert(call_info != 0, "");
 			new_instance->options.function_instance = instance_function;
@@ -5431,7 +5716,7 @@ Poly_Instance* poly_header_instanciate(
 
 			// Create instance symbol-table + function signature
 			int return_type_index = poly_header->signature->return_type_index;
-			Call_Signature* instance_signature = call_signature_create_empty();
+			Call_Signature* instance_signature = call_signature_create_empty(compilation_data);
 			auto& base_parameters = poly_header->signature->parameters;
 			for (int i = 0; i < base_parameters.size; i++)
 			{
@@ -5706,6 +5991,9 @@ void toplevel_content_add_definition(Toplevel_Content& content, AST::Definition*
 		Workload_Function_Body* body_workload = workload_executer_allocate_workload<Workload_Function_Body>(semantic_context);
 		body_workload->function = function;
 		body_workload->parameter_table = nullptr; // Should be set by header analysis
+		analysis_workload_set_deferred(
+			semantic_context->compilation_data->workload_executer, upcast(body_workload), function_body_analysis_can_be_deferred(semantic_context, function)
+		);
 
 		function->origin.type = Function_Origin_Type::TOPLEVEL;
 		function->origin.options.toplevel.body_workload = body_workload;
@@ -5820,8 +6108,8 @@ void toplevel_content_add_definition(Toplevel_Content& content, AST::Definition*
 
 			// Analyse module if not done already
 			Upp_Module* import_module = nullptr;
-			Node_Passes* node_passes = hashtable_find_element(&semantic_context->compilation_data->ast_to_pass_mapping, upcast(imported_unit->root));
-			if (node_passes == nullptr) // File was not yet analysed
+			DynArray<Analysis_Pass*>* root_passes = *compilation_data_get_node_passes(compilation_data, upcast(imported_unit->root));
+			if (root_passes == nullptr) // File was not yet analysed
 			{
 				Analysis_Pass* import_module_pass = analysis_pass_allocate(semantic_context->current_workload, upcast(imported_unit->root), compilation_data);
 				RESTORE_ON_SCOPE_EXIT(semantic_context->current_pass, import_module_pass);
@@ -5831,9 +6119,9 @@ void toplevel_content_add_definition(Toplevel_Content& content, AST::Definition*
 			}
 			else
 			{
-				assert(node_passes->passes.size == 1, "Modules should only be analysed at most once currently");
+				assert(root_passes->size == 1, "Modules should only be analysed at most once currently");
 				import_module = pass_get_node_info(
-					node_passes->passes[0], imported_unit->root, Info_Query::TRY_READ, compilation_data
+					(*root_passes)[0], imported_unit->root, Info_Query::TRY_READ, compilation_data
 				)->upp_module;
 			}
 
@@ -6299,7 +6587,9 @@ void analysis_workload_entry(void* userdata)
 	auto& types = type_system->predefined_types;
 	auto& ids = compilation_data->identifier_pool;
 
-	Arena scratch_arena = Arena::create();
+	// Note: Only arena rewinds and restores of semantic_context/compilation_data state may be inside SCOPE_EXITs of workload code
+	//       which spans a fiber switch, since fiber_pool_abort_unfinished_tasks skips them when a compile is cancelled
+	Arena& scratch_arena = workload->scratch_arena;
 	SCOPE_EXIT(scratch_arena.destroy());
 
 	switch (workload->type)
@@ -8338,7 +8628,7 @@ Expression_Info* semantic_analyser_analyse_expression_internal(AST::Expression*
 			assert(result_type != nullptr, "");
 
 			// Set bake function signature
-			Call_Signature* signature = call_signature_create_empty();
+			Call_Signature* signature = call_signature_create_empty(compilation_data);
 			call_signature_add_return_type(signature, result_type, compilation_data);
 			bake_function->signature = call_signature_register(signature, compilation_data);
 
@@ -8365,6 +8655,7 @@ Expression_Info* semantic_analyser_analyse_expression_internal(AST::Expression*
 				break;
 			}
 			bytecode_generator_compile_function(compilation_data, bake_function);
+			bytecode_generator_link_function_calls(compilation_data, bake_function);
 		}
 
 		// Run function
@@ -8376,7 +8667,15 @@ Expression_Info* semantic_analyser_analyse_expression_internal(AST::Expression*
 		bytecode_thread_set_initial_state(thread, bake_function);
 		while (true)
 		{
+			double start_time = timer_current_time_in_seconds();
+			int instructions_before = bytecode_thread_get_executed_instruction_count(thread);
 			Exit_Code exit_code = bytecode_thread_execute(thread);
+			if (compilation_data->trace_recorder != nullptr) {
+				trace_recorder_add_span(
+					compilation_data->trace_recorder, Trace_Event_Type::BAKE_EXECUTION, bake_function,
+					bytecode_thread_get_executed_instruction_count(thread) - instructions_before, start_time, timer_current_time_in_seconds()
+				);
+			}
 			if (exit_code.type == Exit_Code_Type::SUCCESS) {
 				break;
 			}
@@ -8416,6 +8715,11 @@ Expression_Info* semantic_analyser_analyse_expression_internal(AST::Expression*
 				assert(bake_function->ir_block != nullptr, "Should work here");
 				bytecode_generator_compile_function(compilation_data, call_to);
 				assert(call_to->bytecode_start_instruction != -1, "");
+				bytecode_generator_link_function_calls(compilation_data, call_to);
+				bytecode_generator_link_function_calls(compilation_data, bake_function);
+			}
+			else if (exit_code.type == Exit_Code_Type::CANCELLED) {
+				EXIT_ERROR(result_type); // Compile is discarded, so no error is reported
 			}
 			else 
 			{
@@ -8441,7 +8745,7 @@ Expression_Info* semantic_analyser_analyse_expression_internal(AST::Expression*
 	case AST::Expression_Type::FUNCTION_POINTER_TYPE:
 	{
 		auto& parameters = expr->options.function_pointer_signature->parameters;
-		Call_Signature* signature = call_signature_create_empty();
+		Call_Signature* signature = call_signature_create_empty(compilation_data);
 		for (int i = 0; i < parameters.size; i++)
 		{
 			auto& param_node = parameters[i];
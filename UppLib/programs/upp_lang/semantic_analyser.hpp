@@ -161,6 +161,15 @@ struct Function_Origin
     } options;
 };
 
+// Purity is inferred from the IR-Code, see ir_function_is_pure
+enum class Function_Purity
+{
+    UNKNOWN, // Not analysed yet, or IR-Code not available
+    IN_PROGRESS,
+    PURE,    // No globals, no extern/io/heap calls and no references in parameters or return-type
+    IMPURE,
+};
+
 struct Upp_Function
 {
     Call_Signature* signature; // Note: Signature is nullptr until function-header is analysed
@@ -179,12 +188,17 @@ struct Upp_Function
 
     bool is_extern;
     bool contains_errors;
+    Function_Purity purity;
+    bool is_profile_hot; // Called often in previous C profile, see c_profile_mark_hot_functions
+    bool is_reachable; // Code is only generated for reachable functions, see ir_generator_generate_reachable_functions
+    bool has_constant_address; // Function pointer to this function is stored in constant pool, so it's always reachable
 
     // Code-Generation
     IR_Code_Block* ir_block;
     int bytecode_start_instruction;
     int bytecode_end_instruction;
     int bytecode_maximum_stack_offset;
+    Array<int> bytecode_parameter_offsets; // Stack-frame offsets of parameters (Return-type index contains return-value offset)
 };
 
 struct Upp_Struct
@@ -249,16 +263,54 @@ enum class Analysis_Workload_Type
     MAX_ENUM_VALUE,
 };
 
+struct Dependency_Failure_Info
+{
+    bool* fail_indicator;
+    AST::Symbol_Node* error_report_node;
+};
+
+// Dependency edges are stored in both workloads, each side knows the index of the other for O(1) removal
+struct Workload_Dependency
+{
+    Workload_Base* depends_on;
+    int dependent_index; // Index in depends_on->dependents
+    // Information for cyclic resolve
+    bool can_be_broken;
+    Dynamic_Array<Dependency_Failure_Info> fail_indicators;
+};
+
+struct Workload_Dependent
+{
+    Workload_Base* workload;
+    int dependency_index; // Index in workload->dependencies
+};
+
 struct Workload_Base
 {
     Analysis_Workload_Type type;
     bool is_finished;
     bool was_started;
+    bool is_deferred; // Only runs once another workload depends on it, see enable_lazy_body_analysis
+    bool is_priority; // Runs before other runnable workloads, see Workload_Priority_Hint
+    bool priority_checked;
     Fiber_Pool_Handle fiber_handle;
+    int switch_count;       // Number of fiber switches into this workload
+    double wait_start_time; // Time of last switch out while waiting on dependencies (For trace recording)
+    // Owned by the workload instead of the fiber stack, so it's also freed if a cancelled compile discards the suspended fiber
+    Arena scratch_arena;
 
     // Dependencies
-    List<Workload_Base*> dependencies;
-    List<Workload_Base*> dependents;
+    Dynamic_Array<Workload_Dependency> dependencies; // Only unfinished workloads, so size is the pending count
+    Dynamic_Array<Workload_Dependent> dependents;
+    // Maps depends_on to the index in dependencies, only created once dependencies outgrow a linear search
+    Hashtable<Workload_Base*, int> dependency_index_table;
+    bool in_ready_queue;
+    bool is_cycle_search_root;
+    // Tarjan state for cycle detection, only valid if cycle_search_generation matches the executer
+    int cycle_search_generation;
+    int cycle_search_index;
+    int cycle_search_lowlink;
+    bool cycle_search_on_stack;
 
     // Errors
     int real_error_count;
@@ -360,35 +412,34 @@ void analysis_workload_append_to_string(Workload_Base* workload, String* string)
 
 
 // WORKLOAD EXECUTER
-struct Workload_Pair
-{
-    Workload_Base* workload;
-    Workload_Base* depends_on;
-};
-
-struct Dependency_Failure_Info
-{
-    bool* fail_indicator;
-    AST::Symbol_Node* error_report_node;
-};
-
-struct Dependency_Information
+// Set by editor, workloads of definitions in the visible range (or around cursor) and their dependencies are executed first
+struct Workload_Priority_Hint
 {
-    List_Node<Workload_Base*>* dependency_node;
-    List_Node<Workload_Base*>* dependent_node;
-    // Information for cyclic resolve
-    bool can_be_broken;
-    Dynamic_Array<Dependency_Failure_Info> fail_indicators;
+    Compilation_Unit* unit; // nullptr if no hint is given
+    int visible_line_start;
+    int visible_line_end;
+    int cursor_line;
+    // Called once on the compiling thread when all priority workloads have finished, e.g. to show errors of the visible range early
+    void (*priority_finished_callback)(Compilation_Data* compilation_data, void* userdata);
+    void* priority_finished_userdata;
 };
 
 struct Workload_Executer
 {
     Compilation_Data* compilation_data;
+    Workload_Priority_Hint priority_hint;
     Dynamic_Array<Workload_Base*> all_workloads; // Owning array
-    Dynamic_Array<Workload_Base*> runnable_workloads;
+    // Fifo of workloads without dependencies, entries which got finished/deferred in the meantime are dropped when popped
+    Dynamic_Array<Workload_Base*> ready_workloads;
+    int ready_workloads_head;
+    Dynamic_Array<Workload_Base*> ready_background_workloads; // Non-priority ready workloads, held back while a priority hint is set
     Dynamic_Array<Workload_Base*> finished_workloads;
-    bool progress_was_made;
-    Hashtable<Workload_Pair, Dependency_Information> workload_dependencies;
+    // Workloads which added dependencies since the last cycle search, every cycle contains at least one of them
+    Dynamic_Array<Workload_Base*> cycle_search_roots;
+    int pending_workload_count; // Workloads which are neither finished nor deferred
+    int pending_priority_count; // Unfinished workloads with is_priority
+    bool priority_finished_reported;
+    int cycle_search_generation;
 };
 
 Workload_Executer* workload_executer_create(Compilation_Data* compilation_data);
@@ -411,10 +462,14 @@ struct AST_Info_Key
     AST::Node* base;
 };
 
-struct Node_Passes
+union Analysis_Info;
+
+// Dense per-node storage, see Compilation_Unit::node_annotations
+// Most nodes are only analysed by a single pass, infos of other passes (e.g. polymorphic instances) go to ast_to_info_mapping
+struct Node_Annotations
 {
-    Dynamic_Array<Analysis_Pass*> passes;
-    AST::Node* base;
+    Analysis_Pass* first_pass;
+    Analysis_Info* first_info;
 };
 
 enum class Parameter_Value_Type
@@ -19,12 +19,13 @@ bool default_value_query_equals(Default_Value_Query* a, Default_Value_Query* b)
 // SYMBOL TABLE FUNCTIONS
 Symbol_Table* symbol_table_create(Compilation_Data* compilation_data)
 {
-    Symbol_Table* result = new Symbol_Table;
-    result->symbols = hashtable_create_pointer_empty<String*, Dynamic_Array<Symbol*>>(1);
+    // Note: Symbol tables and their contents live in the compilation arena, so they are never destroyed individually
+    Symbol_Table* result = compilation_data->arena.allocate<Symbol_Table>();
+    result->symbols = DynTable<String*, DynArray<Symbol*>>::create_pointer(&compilation_data->arena);
 
 	result->parent_table = nullptr;
 	result->parent_access_level = Symbol_Access_Level::GLOBAL;
-    result->imports = dynamic_array_create<Symbol_Table_Import>();
+    result->imports = DynArray<Symbol_Table_Import>::create(&compilation_data->arena);
 
 	result->custom_operators_workload = nullptr;
 	result->custom_operators = DynArray<Custom_Operator>::create(&compilation_data->arena);
@@ -40,7 +41,6 @@ Symbol_Table* symbol_table_create(Compilation_Data* compilation_data)
 	result->reachable_operator_tables_queried = false;
 	result->reachable_operator_tables_workloads_finished = false;
 
-    dynamic_array_push_back(&compilation_data->allocated_symbol_tables, result);
     return result;
 }
 
@@ -52,17 +52,6 @@ Symbol_Table* symbol_table_create_with_parent(Symbol_Table* parent_table, Symbol
     return result;
 }
 
-void symbol_table_destroy(Symbol_Table* symbol_table)
-{
-    for (auto iter = hashtable_iterator_create(&symbol_table->symbols); hashtable_iterator_has_next(&iter); hashtable_iterator_next(&iter)) {
-        // Note: Symbols are allocated elsewhere...
-        dynamic_array_destroy(iter.value);
-    }
-    hashtable_destroy(&symbol_table->symbols);
-	dynamic_array_destroy(&symbol_table->imports);
-    delete symbol_table;
-}
-
 void symbol_table_add_import(
     Symbol_Table* symbol_table, Symbol_Table* imported_table, 
 	Import_Type import_type, bool is_transitive, Symbol_Access_Level access_level, Semantic_Context* semantic_context,
@@ -93,12 +82,7 @@ void symbol_table_add_import(
 	table_import.type = import_type;
 	table_import.access_level = access_level;
 	table_import.is_transitive = is_transitive;
-    dynamic_array_push_back(&symbol_table->imports, table_import);
-}
-
-void symbol_destroy(Symbol* symbol) {
-    dynamic_array_destroy(&symbol->references);
-    delete symbol;
+    symbol_table->imports.push_back(table_import);
 }
 
 Symbol* symbol_table_define_symbol(
@@ -108,23 +92,22 @@ Symbol* symbol_table_define_symbol(
     assert(id != 0, "HEY");
 
     // Create new symbol
-    Symbol* new_sym = new Symbol;
-    dynamic_array_push_back(&semantic_context->compilation_data->allocated_symbols, new_sym);
+    Arena* arena = &semantic_context->compilation_data->arena;
+    Symbol* new_sym = arena->allocate<Symbol>();
     new_sym->id = id;
     new_sym->type = type;
     new_sym->origin_table = symbol_table;
     new_sym->access_level = access_level;
-    new_sym->references = dynamic_array_create<AST::Symbol_Node*>();
+    new_sym->references = DynArray<AST::Symbol_Node*>::create(arena);
     new_sym->definition_node = definition_node;
 
     // Check if symbol is already defined
     bool add_to_symbol_table = true;
-    Dynamic_Array<Symbol*>* symbols = hashtable_find_element(&symbol_table->symbols, id);
+    DynArray<Symbol*>* symbols = symbol_table->symbols.find(id);
     if (symbols == nullptr) 
 	{
-        Dynamic_Array<Symbol*> new_symbols = dynamic_array_create<Symbol*>(1);
-        hashtable_insert_element(&symbol_table->symbols, id, new_symbols);
-        symbols = hashtable_find_element(&symbol_table->symbols, id);
+        symbol_table->symbols.insert(id, DynArray<Symbol*>::create(arena, 1));
+        symbols = symbol_table->symbols.find(id);
         assert(symbols != 0, "Just inserted!");
     }
 	else if (error_if_not_unique)
@@ -134,7 +117,7 @@ Symbol* symbol_table_define_symbol(
 	}
 
 	// Add to symbol_table
-	dynamic_array_push_back(symbols, new_sym);
+	symbols->push_back(new_sym);
 	return new_sym;
 }
 
@@ -238,7 +221,7 @@ DynArray<Symbol*> symbol_table_query_id(Symbol_Table* symbol_table, String* id,
 	{
 		auto& query_table = query_tables[i];
 		// Try to find symbol
-		Dynamic_Array<Symbol*>* symbols = hashtable_find_element(&query_table.table->symbols, id);
+		DynArray<Symbol*>* symbols = query_table.table->symbols.find(id);
 		if (symbols == nullptr) continue;
 		for (int i = 0; i < symbols->size; i++) 
 		{
@@ -279,9 +262,11 @@ DynArray<Symbol*> symbol_table_query_all_symbols(Symbol_Table* symbol_table, Sym
 	for (int i = 0; i < query_tables.size; i++)
 	{
 		auto& query_table = query_tables[i];
-		for (auto iter = hashtable_iterator_create(&query_table.table->symbols); hashtable_iterator_has_next(&iter); hashtable_iterator_next(&iter))
+		auto& entries = query_table.table->symbols.entries;
+		for (int k = 0; k < entries.size; k++)
 		{
-			Dynamic_Array<Symbol*>* symbols = iter.value;
+			if (entries[k].state != DynSet_Entry_State::OCCUPIED) continue;
+			DynArray<Symbol*>* symbols = &entries[k].value;
 			for (int j = 0; j < symbols->size; j++) {
 				Symbol* symbol = (*symbols)[j];
 				if ((int)symbol->access_level > (int)query_table.access_level) continue;
@@ -528,9 +513,11 @@ void symbol_table_append_to_string_with_parent_info(String* string, Symbol_Table
 	if (!is_parent) {
 		string_append_formated(string, "Symbols: \n");
 	}
-	for (auto iter = hashtable_iterator_create(&table->symbols); hashtable_iterator_has_next(&iter); hashtable_iterator_next(&iter))
+	for (int j = 0; j < table->symbols.entries.size; j++)
 	{
-		Dynamic_Array<Symbol*> symbols = *(iter.value);
+		auto& entry = table->symbols.entries[j];
+		if (entry.state != DynSet_Entry_State::OCCUPIED) continue;
+		DynArray<Symbol*> symbols = entry.value;
 		for (int i = 0; i < symbols.size; i++) {
 			Symbol* s = symbols[i];
 			if (is_parent) {
@@ -211,7 +211,7 @@ struct Symbol
     String* id;
     Symbol_Table* origin_table;
     Symbol_Access_Level access_level;
-    Dynamic_Array<AST::Symbol_Node*> references;
+    DynArray<AST::Symbol_Node*> references;
 
     AST::Symbol_Node* definition_node;
 };
@@ -228,12 +228,12 @@ struct Symbol_Table_Import
 
 struct Symbol_Table
 {
-    Hashtable<String*, Dynamic_Array<Symbol*>> symbols;
+    DynTable<String*, DynArray<Symbol*>> symbols;
 
     // Connections to other symbol tables
     Symbol_Table* parent_table;
     Symbol_Access_Level parent_access_level;
-    Dynamic_Array<Symbol_Table_Import> imports;
+    DynArray<Symbol_Table_Import> imports;
 
     // Custom operators
     Workload_Custom_Operators* custom_operators_workload;
@@ -272,8 +272,6 @@ struct Symbol_Error
 
 Symbol_Table* symbol_table_create(Compilation_Data* compilation_data);
 Symbol_Table* symbol_table_create_with_parent(Symbol_Table* parent_table, Symbol_Access_Level parent_access_level, Compilation_Data* compilation_data);
-void symbol_table_destroy(Symbol_Table* symbol_table);
-void symbol_destroy(Symbol* symbol);
 
 Symbol* symbol_table_define_symbol(
     Symbol_Table* symbol_table, String* id, Symbol_Type type, AST::Symbol_Node* definition_node, Symbol_Access_Level access_level,
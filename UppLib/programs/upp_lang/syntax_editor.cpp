@@ -32,6 +32,8 @@
 #include "../../utility/file_io.hpp"
 
 #include "ir_code.hpp"
+#include "bytecode_interpreter.hpp"
+#include "c_backend.hpp"
 
 #include "../../utility/rich_text.hpp"
 #include "../../utility/line_edit.hpp"
@@ -43,47 +45,6 @@ const int MIN_CURSOR_DISTANCE = 2;
 
 
 // WORD_POOL
-struct String_View
-{
-	char* characters;
-	u32 size;
-};
-
-String_View string_view_make(char* characters, u32 size)
-{
-	String_View result;
-	result.characters = characters;
-	result.size = size;
-	return result;
-}
-
-String_View string_view_from_cstring(const char* str)
-{
-	return string_view_make((char*)str, strlen(str));
-}
-
-String_View string_view_from_string(String string)
-{
-	return string_view_make(string.characters, (u32)string.size);
-}
-
-String string_view_to_string(String_View view)
-{
-	return string_create_static_with_size(view.characters, (int)view.size);
-}
-
-u64 hash_string_view(String_View* string_view)
-{
-	if (string_view->size == 0) return 0x2342343;
-	return hash_memory(array_create_static<byte>((byte*)string_view->characters, (int)string_view->size));
-}
-
-bool equals_string_view(String_View* a, String_View* b)
-{
-	if (a->size != b->size) return false;
-	return memory_compare(a->characters, b->characters, a->size);
-}
-
 struct String_View_Refcount
 {
 	String_View string_view;
@@ -553,9 +514,17 @@ struct Compiler_Thread_Data
 
     Semaphore compiler_wait_semaphore;
     Semaphore compilation_finish_semaphore;
+    Cancellation_Token cancellation_token; // Set by editor when the running analysis is outdated
     bool thread_should_exit;
     bool work_started;
     bool build_code;
+
+    // Error ranges in the priority unit, published before the compile finishes (See Workload_Priority_Hint).
+    // The compiler thread fills the back buffer and swaps under the lock, the editor copies the front buffer under the lock
+    Semaphore early_errors_lock;
+    Dynamic_Array<Text_Range> early_error_buffers[2];
+    int early_errors_front;
+    int early_errors_version;
 };
 
 enum class Toggle_Option
@@ -643,6 +612,14 @@ struct Syntax_Editor
     Dynamic_Array<int> error_indices_sorted;
     int navigate_error_cam_start;
     int navigate_error_index;
+    // Errors published by the running compile, shown in early_errors_filepath until its results arrive
+    Dynamic_Array<Text_Range> early_errors;
+    String early_errors_filepath;
+    int early_errors_version;
+    // Executed instructions per line of hot_lines_filepath from the last profiled run (enable_bytecode_profiling)
+    Dynamic_Array<i64> hot_line_counts;
+    String hot_lines_filepath;
+    i64 hot_lines_max;
 
     // Rendering
     int frame_index;
@@ -3226,6 +3203,12 @@ void syntax_editor_initialize(Text_Renderer* text_renderer, Renderer_2D* rendere
 	syntax_editor.show_semantic_infos = false;
 
 	syntax_editor.error_indices_sorted = dynamic_array_create<int>();
+	syntax_editor.early_errors = dynamic_array_create<Text_Range>();
+	syntax_editor.early_errors_filepath = string_create();
+	syntax_editor.early_errors_version = 0;
+	syntax_editor.hot_line_counts = dynamic_array_create<i64>();
+	syntax_editor.hot_lines_filepath = string_create();
+	syntax_editor.hot_lines_max = 0;
 
 	syntax_editor.watch_values = dynamic_array_create<Watch_Value>();
 	syntax_editor.selected_stack_frame = 0;
@@ -3246,6 +3229,12 @@ void syntax_editor_initialize(Text_Renderer* text_renderer, Renderer_2D* rendere
 	compiler_thread_data.thread_should_exit = false;
 	compiler_thread_data.compiler_wait_semaphore = semaphore_create(0, 1);
 	compiler_thread_data.compilation_finish_semaphore = semaphore_create(0, 1);
+	cancellation_token_reset(&compiler_thread_data.cancellation_token);
+	compiler_thread_data.early_errors_lock = semaphore_create(1, 1);
+	compiler_thread_data.early_error_buffers[0] = dynamic_array_create<Text_Range>();
+	compiler_thread_data.early_error_buffers[1] = dynamic_array_create<Text_Range>();
+	compiler_thread_data.early_errors_front = 0;
+	compiler_thread_data.early_errors_version = 0;
 	compiler_thread_data.compiler_thread = thread_create(compiler_thread_entry_fn, &syntax_editor.compiler_thread_data);
 
 	// Open initial tab
@@ -3373,10 +3362,12 @@ void syntax_editor_destroy()
 
 	// Synchronize with compiler thread
 	if (syntax_editor.compiler_thread_data.work_started) {
+		cancellation_token_cancel(&syntax_editor.compiler_thread_data.cancellation_token);
 		semaphore_wait(syntax_editor.compiler_thread_data.compilation_finish_semaphore);
 		syntax_editor.compiler_thread_data.thread_should_exit = true;
 		semaphore_increment(syntax_editor.compiler_thread_data.compiler_wait_semaphore, 1);
 	}
+	compilation_data_wait_for_background_destroy();
 
 	ui_system_shutdown();
 	debugger_destroy(editor.debugger);
@@ -3388,6 +3379,10 @@ void syntax_editor_destroy()
 	string_destroy(&syntax_editor.fuzzy_search_text);
 	string_destroy(&syntax_editor.search_text);
 	dynamic_array_destroy(&syntax_editor.error_indices_sorted);
+	dynamic_array_destroy(&syntax_editor.early_errors);
+	string_destroy(&syntax_editor.early_errors_filepath);
+	dynamic_array_destroy(&syntax_editor.hot_line_counts);
+	string_destroy(&syntax_editor.hot_lines_filepath);
 	editor.arena.destroy();
 	editor.font_renderer->destroy();
 
@@ -3412,8 +3407,10 @@ void syntax_editor_destroy()
 	hashtable_destroy(&editor.filtered_passes);
 
 	fiber_pool_destroy(editor.fiber_pool);
+	c_compiler_shutdown();
 
 	editor.word_pool_arena.destroy();
+	arena_block_pool_trim(); // Blocks cached for the next compile aren't needed anymore
 }
 
 void syntax_editor_save_text_file()
@@ -3454,7 +3451,9 @@ unsigned long compiler_thread_entry_fn(void* userdata)
 		// Compile here
 		Compilation_Data* compilation_data = compiler_thread_data->compilation_data;
 		compilation_data_compile(compilation_data, compilation_unit, generate_code ? Compile_Type::BUILD_CODE : Compile_Type::ANALYSIS_ONLY);
-		compilation_data_update_source_code_information(compilation_data);
+		if (!compilation_data->was_cancelled) {
+			compilation_data_update_source_code_information(compilation_data);
+		}
 
 		// Artificial sleep, to see how 'sluggish' editor becomes...
 		// timer_sleep_for(1.0);
@@ -3466,10 +3465,84 @@ unsigned long compiler_thread_entry_fn(void* userdata)
 
 	semaphore_destroy(compiler_thread_data->compilation_finish_semaphore);
 	semaphore_destroy(compiler_thread_data->compiler_wait_semaphore);
+	semaphore_destroy(compiler_thread_data->early_errors_lock);
+	dynamic_array_destroy(&compiler_thread_data->early_error_buffers[0]);
+	dynamic_array_destroy(&compiler_thread_data->early_error_buffers[1]);
 	thread_destroy(compiler_thread_data->compiler_thread);
 	return 0;
 }
 
+// Runs on the compiler thread once the workloads of the visible range have finished
+void compiler_thread_publish_early_errors(Compilation_Data* compilation_data, void* userdata)
+{
+	Compiler_Thread_Data* compiler_thread_data = (Compiler_Thread_Data*)userdata;
+	Compilation_Unit* unit = compilation_data->workload_executer->priority_hint.unit;
+
+	// Note: Only this thread changes early_errors_front, so the back buffer can be filled without the lock
+	auto& back_buffer = compiler_thread_data->early_error_buffers[1 - compiler_thread_data->early_errors_front];
+	dynamic_array_reset(&back_buffer);
+	for (int i = 0; i < compilation_data->code_errors.size; i++) 
+	{
+		auto& error = compilation_data->code_errors[i];
+		if (error.unit != unit) continue;
+		for (int j = 0; j < error.ranges.size; j++) {
+			dynamic_array_push_back(&back_buffer, error.ranges[j]);
+		}
+	}
+
+	semaphore_wait(compiler_thread_data->early_errors_lock);
+	compiler_thread_data->early_errors_front = 1 - compiler_thread_data->early_errors_front;
+	compiler_thread_data->early_errors_version += 1;
+	semaphore_increment(compiler_thread_data->early_errors_lock, 1);
+}
+
+// Source_Code is shared between compilation-datas and tabs, so only code which isn't used by keep_data or tabs is deleted
+void syntax_editor_destroy_compilation_data_keep_code(Compilation_Data* data, Compilation_Data* keep_data)
+{
+	auto& editor = syntax_editor;
+	for (int i = 0; i < data->compilation_units.size; i++)
+	{
+		Compilation_Unit* unit = data->compilation_units[i];
+		bool code_still_in_use = false;
+		for (int j = 0; j < keep_data->compilation_units.size; j++) 
+		{
+			Compilation_Unit* keep_unit = keep_data->compilation_units[j];
+			if (unit->code == keep_unit->code) {
+				code_still_in_use = true;
+				break;
+			}
+		}
+		for (int j = 0; j < editor.tabs.size && !code_still_in_use; j++) {
+			auto& tab = editor.tabs[j];
+			if (unit->code == tab->code) {
+				code_still_in_use = true;
+				break;
+			}
+		}
+		if (code_still_in_use) {
+			unit->code = nullptr; // So it does not get deleted
+		}
+	}
+	compilation_data_destroy_in_background(data);
+
+	// With one compilation_data alive between compiles, memory should return to the same level after each destroy
+	if (enable_allocation_leak_check && allocation_tracker_is_enabled())
+	{
+		compilation_data_wait_for_background_destroy();
+		static Allocation_Snapshot last_snapshot;
+		static bool last_snapshot_valid = false;
+		if (last_snapshot_valid) {
+			String growth = string_create();
+			SCOPE_EXIT(string_destroy(&growth));
+			if (allocation_tracker_append_growth_to_string(&last_snapshot, &growth)) {
+				logg("Memory growth since last compile (possible leak):\n%s", growth.characters);
+			}
+		}
+		last_snapshot = allocation_tracker_make_snapshot();
+		last_snapshot_valid = true;
+	}
+}
+
 // Checks if there are any new compilation infos, and starts a new compilation cycle if code has changed
 void syntax_editor_synchronize_with_compiler(bool generate_code)
 {
@@ -3502,6 +3575,13 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 	if (compiler_thread_data.work_started)
 	{
 		bool compiler_finished_compile = semaphore_try_wait(compiler_thread_data.compilation_finish_semaphore);
+		if (!compiler_finished_compile && should_compile && !compiler_thread_data.build_code)
+		{
+			// Analysis is outdated, cancel it (Cancellation is checked between workloads). The UI thread doesn't wait here,
+			// the semaphore is polled in the next frames and the new compile starts once the cancelled one has returned
+			cancellation_token_cancel(&compiler_thread_data.cancellation_token);
+		}
+
 		if (compiler_finished_compile) {
 			got_compiler_update = true;
 			compiler_thread_data.work_started = false;
@@ -3512,6 +3592,33 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 		}
 	}
 
+	// Copy errors which the running compile already published
+	if (compiler_thread_data.work_started)
+	{
+		semaphore_wait(compiler_thread_data.early_errors_lock);
+		if (compiler_thread_data.early_errors_version != editor.early_errors_version) {
+			editor.early_errors_version = compiler_thread_data.early_errors_version;
+			auto& front_buffer = compiler_thread_data.early_error_buffers[compiler_thread_data.early_errors_front];
+			dynamic_array_reset(&editor.early_errors);
+			for (int i = 0; i < front_buffer.size; i++) {
+				dynamic_array_push_back(&editor.early_errors, front_buffer[i]);
+			}
+		}
+		semaphore_increment(compiler_thread_data.early_errors_lock, 1);
+	}
+	if (got_compiler_update) {
+		dynamic_array_reset(&editor.early_errors);
+		dynamic_array_reset(&editor.hot_line_counts); // Lines of the profile may not match the new code
+	}
+
+	// Discard results of cancelled compilation
+	if (got_compiler_update && compiler_thread_data.compilation_data->was_cancelled)
+	{
+		syntax_editor_destroy_compilation_data_keep_code(compiler_thread_data.compilation_data, editor.editor_compilation_data);
+		compiler_thread_data.compilation_data = nullptr;
+		got_compiler_update = false;
+	}
+
 	// Early-exit if nothing needs to be done
 	if (!should_compile && !got_compiler_update) {
 		return;
@@ -3528,32 +3635,7 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 
 		editor.editor_compilation_data = updated_data;
 		compiler_thread_data.compilation_data = nullptr;
-
-		// Destroy old data
-		for (int i = 0; i < old_data->compilation_units.size; i++)
-		{
-			Compilation_Unit* old_unit = old_data->compilation_units[i];
-			bool code_still_in_use = false;
-			for (int j = 0; j < updated_data->compilation_units.size; j++) 
-			{
-				Compilation_Unit* updated_unit = updated_data->compilation_units[j];
-				if (old_unit->code == updated_unit->code) {
-					code_still_in_use = true;
-					break;
-				}
-			}
-			for (int j = 0; j < editor.tabs.size && !code_still_in_use; j++) {
-				auto& tab = editor.tabs[j];
-				if (old_unit->code == tab->code) {
-					code_still_in_use = true;
-					break;
-				}
-			}
-			if (code_still_in_use) {
-				old_unit->code = nullptr; // So it does not get deleted
-			}
-		}
-		compilation_data_destroy(old_data);
+		syntax_editor_destroy_compilation_data_keep_code(old_data, updated_data);
 
 		sort_error_indices();
 		dynamic_array_reset(&editor.suggestions);
@@ -3569,6 +3651,7 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 			Editor_Tab& tab = *editor.tabs[i];
 
 			Compilation_Unit* unit = compilation_data_add_compilation_unit_unique(compilation_data, tab.filepath, false, false);
+			unit->open_in_editor = true;
 			auto now = history_get_timestamp(&tab.history);
 			if (unit->code == nullptr) // If this is the first compilation_unit for this file, just copy it over
 			{
@@ -3651,6 +3734,7 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 			Compilation_Unit* new_unit = compilation_data_add_compilation_unit_unique(next_compilation_data, last_unit->filepath, false, false);
 			assert(new_unit->code == nullptr, "must be true as this was just created");
 			new_unit->code = last_unit->code;
+			new_unit->open_in_editor = open_in_editor;
 			if (is_main_unit) {
 				main_compilation_unit = new_unit;
 			}
@@ -3659,7 +3743,32 @@ void syntax_editor_synchronize_with_compiler(bool generate_code)
 		editor.last_compile_main_tab_index = compile_tab_index;
 		editor.last_compile_was_with_code_gen = generate_code;
 
-		// Start work in compile thread
+		// Analyse what the user currently sees first
+		{
+			Editor_Tab* open_tab = editor.tabs[editor.open_tab_index];
+			Workload_Priority_Hint& hint = next_compilation_data->workload_executer->priority_hint;
+			hint.unit = nullptr;
+			for (int i = 0; i < next_compilation_data->compilation_units.size; i++) {
+				Compilation_Unit* unit = next_compilation_data->compilation_units[i];
+				if (string_equals(unit->filepath, open_tab->filepath)) {
+					hint.unit = unit;
+					break;
+				}
+			}
+			hint.visible_line_start = open_tab->cam_start;
+			hint.visible_line_end = open_tab->cam_start + editor.visible_line_count;
+			hint.cursor_line = open_tab->cursor.line;
+			hint.priority_finished_callback = compiler_thread_publish_early_errors;
+			hint.priority_finished_userdata = &compiler_thread_data;
+
+			dynamic_array_reset(&editor.early_errors);
+			string_reset(&editor.early_errors_filepath);
+			string_append_string(&editor.early_errors_filepath, &open_tab->filepath);
+		}
+
+		// Start work in compile thread (Only analysis is cancellable, builds are requested explicitly)
+		cancellation_token_reset(&compiler_thread_data.cancellation_token);
+		next_compilation_data->cancellation_token = generate_code ? nullptr : &compiler_thread_data.cancellation_token;
 		compiler_thread_data.compilation_data = next_compilation_data;
 		compiler_thread_data.compiler_main_unit = main_compilation_unit;
 		assert(main_compilation_unit != nullptr, "");
@@ -4225,13 +4334,13 @@ void syntax_editor_goto_symbol_definition(Symbol* symbol)
 
 	// Switch tab to file with symbol
 	if (symbol->definition_node == nullptr) return;
-	auto unit = ast_node_to_compilation_unit(upcast(symbol->definition_node));
-	if (unit == nullptr) return;
+	auto unit = ast_node_to_compilation_unit(editor.editor_compilation_data, upcast(symbol->definition_node));
 	int index = syntax_editor_add_tab(unit->filepath); // Doesn't add a tab if already open
 	syntax_editor_switch_tab(index);
 
 	Editor_Tab& tab = syntax_editor.open_tab();
-	tab.cursor = code_query_text_index_at_last_synchronize(symbol->definition_node->base.range.start, editor.open_tab_index, true);
+	Text_Index definition_start = ast_node_get_ranges(editor.editor_compilation_data, upcast(symbol->definition_node)).range.start;
+	tab.cursor = code_query_text_index_at_last_synchronize(definition_start, editor.open_tab_index, true);
 	syntax_editor_sanitize_cursor();
 	center_camera_on_cursor_if_cursor_not_visible();
 }
@@ -8787,6 +8896,24 @@ void syntax_editor_update(bool& animations_running)
 			}
 		}
 
+		// Inlining makes stepping and breakpoints in the debugger inexact, so it's only enabled for release builds
+		ui_system_push_label("Release Build (Inlining):", false);
+		prev_value = compiler_optimization_level > 0;
+		new_value = ui_system_push_checkbox(prev_value);
+		if (prev_value != new_value) {
+			syntax_editor.open_tab().requires_recompile = true;
+			compiler_optimization_level = new_value ? 1 : 0;
+		}
+
+		// Profile is collected during compilation (bakes) and execution, so toggling requires a new compilation-data
+		ui_system_push_label("Profile Interpreter (Hot lines):", false);
+		prev_value = enable_bytecode_profiling;
+		new_value = ui_system_push_checkbox(prev_value);
+		if (prev_value != new_value) {
+			syntax_editor.open_tab().requires_recompile = true;
+			enable_bytecode_profiling = new_value;
+		}
+
 		for (int i = 0; i < (int)Toggle_Option::MAX_ENUM_VALUE; i++)
 		{
 			Toggle_Option toggle_option = (Toggle_Option)i;
@@ -9027,6 +9154,23 @@ void syntax_editor_update(bool& animations_running)
 	if (errors.size == 0)
 	{
 		auto exit_code = compiler_execute(editor.editor_compilation_data);
+
+		// Show hot lines of the open tab
+		auto profile = editor.editor_compilation_data->bytecode_profile;
+		auto& open_tab = editor.open_tab();
+		auto unit = tab_to_compilation_unit(&open_tab);
+		dynamic_array_reset(&editor.hot_line_counts);
+		if (profile != nullptr && unit != nullptr) 
+		{
+			bytecode_profile_get_line_counts(profile, editor.editor_compilation_data, unit, &editor.hot_line_counts);
+			string_reset(&editor.hot_lines_filepath);
+			string_append_string(&editor.hot_lines_filepath, &open_tab.filepath);
+			editor.hot_lines_max = 0;
+			for (int i = 0; i < editor.hot_line_counts.size; i++) {
+				editor.hot_lines_max = math_maximum(editor.hot_lines_max, editor.hot_line_counts[i]);
+			}
+		}
+
 		String output = string_create(256);
 		SCOPE_EXIT(string_destroy(&output));
 		exit_code_append_to_string(&output, exit_code);
@@ -9457,8 +9601,8 @@ void syntax_editor_render()
 					}
 
 					if (function_origin_node != nullptr) {
-						unit = ast_node_to_compilation_unit(function_origin_node);
-						upp_line_index = function_origin_node->range.start.line;
+						unit = ast_node_to_compilation_unit(editor.editor_compilation_data, function_origin_node);
+						upp_line_index = ast_node_get_ranges(editor.editor_compilation_data, function_origin_node).range.start.line;
 					}
 				}
 
@@ -9700,6 +9844,10 @@ void syntax_editor_render()
 				highlight_symbol = hover_info.symbol_info->symbol;
 			}
 
+			bool show_early_errors = editor.early_errors.size > 0 && string_equals(editor.early_errors_filepath, tab.filepath) &&
+				!(syntax_editor.get_option_value(Toggle_Option::HIDE_ERRORS_UNTIL_COMPILATION) && !syntax_editor.hide_error_mode_display_errors);
+			bool show_hot_lines = editor.hot_line_counts.size > 0 && editor.hot_lines_max > 0 && string_equals(editor.hot_lines_filepath, tab.filepath);
+
 			for (int i = 0; i < display_lines.size; i += 1)
 			{
 				Display_Line& display_line = display_lines[i];
@@ -9816,6 +9964,39 @@ void syntax_editor_render()
 					}
 				}
 
+				// Hot lines of the last profiled run, colored by share of the hottest line
+				if (show_hot_lines && display_line.line_index < editor.hot_line_counts.size && line->text.size > 0)
+				{
+					i64 count = editor.hot_line_counts[display_line.line_index];
+					double share = (double)count / (double)editor.hot_lines_max;
+					Palette_Color color = Palette_Color::NONE;
+					if (share >= 0.5) {
+						color = Palette_Color::SLIGHT_DARK_RED;
+					}
+					else if (share >= 0.1) {
+						color = Palette_Color::SLIGHT_DARK_AMBER;
+					}
+					else if (count > 0) {
+						color = Palette_Color::GREY2;
+					}
+					if (color != Palette_Color::NONE) {
+						main_area.mark(ivec2(0, i), line->text.size, Mark_Type::BACKGROUND_COLOR, color);
+					}
+				}
+
+				// Errors of the running compile (Afterwards errors are part of the analysis-items)
+				if (show_early_errors)
+				{
+					for (int j = 0; j < editor.early_errors.size; j++)
+					{
+						Text_Range range = editor.early_errors[j];
+						if (range.start.line != display_line.line_index) continue;
+						int end_char = range.end.line == range.start.line ? range.end.character : line->text.size;
+						int length = math_maximum(1, end_char - range.start.character);
+						main_area.mark(ivec2(range.start.character, i), length, Mark_Type::UNDERLINE, Palette_Color::RED);
+					}
+				}
+
 				// Set cursor text-background
 				if (editor.mode == Editor_Mode::NORMAL && !cursor_is_on_fold && cursor.line == display_line.line_index) {
 					main_area.mark(ivec2(cursor.character, i), 1, Mark_Type::BACKGROUND_COLOR, Syntax_Color::CURSOR_BG);
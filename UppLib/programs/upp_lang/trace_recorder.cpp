@@ -0,0 +1,174 @@
+#include "trace_recorder.hpp"
+
+#include "../../win32/timing.hpp"
+#include "../../utility/file_io.hpp"
+#include "../../datastructures/string.hpp"
+#include "compilation_data.hpp"
+#include "semantic_analyser.hpp"
+
+Trace_Recorder* trace_recorder_create(int capacity)
+{
+    Trace_Recorder* recorder = new Trace_Recorder;
+    recorder->events = array_create<Trace_Event>(capacity);
+    recorder->next_index = 0;
+    recorder->count = 0;
+    recorder->dropped_count = 0;
+    recorder->start_time = timer_current_time_in_seconds();
+    return recorder;
+}
+
+void trace_recorder_destroy(Trace_Recorder* recorder)
+{
+    array_destroy(&recorder->events);
+    delete recorder;
+}
+
+void trace_recorder_add_span(Trace_Recorder* recorder, Trace_Event_Type type, void* subject, int value, double start_time, double end_time)
+{
+    Trace_Event& event = recorder->events[recorder->next_index];
+    event.type = type;
+    event.subject = subject;
+    event.value = value;
+    event.start_time = start_time;
+    event.end_time = end_time;
+
+    recorder->next_index = (recorder->next_index + 1) % recorder->events.size;
+    if (recorder->count < recorder->events.size) {
+        recorder->count += 1;
+    }
+    else {
+        recorder->dropped_count += 1;
+    }
+}
+
+static void trace_append_json_escaped(String* string, const char* text)
+{
+    for (const char* c = text; *c != 0; c++)
+    {
+        switch (*c)
+        {
+        case '"': string_append(string, "\\\""); break;
+        case '\\': string_append(string, "\\\\"); break;
+        case '\n': string_append(string, "\\n"); break;
+        case '\t': string_append(string, "\\t"); break;
+        default:
+            if ((unsigned char)*c >= 0x20) {
+                string_append_character(string, *c);
+            }
+        }
+    }
+}
+
+// Thread-ids are only used to group events into separate rows in the viewer
+static int trace_event_type_to_row(Trace_Event_Type type)
+{
+    switch (type)
+    {
+    case Trace_Event_Type::PHASE: return 1;
+    case Trace_Event_Type::PARSE_UNIT: return 2;
+    case Trace_Event_Type::WORKLOAD: return 2;
+    case Trace_Event_Type::C_COMPILATION: return 2;
+    case Trace_Event_Type::DEPENDENCY_WAIT: return 3;
+    case Trace_Event_Type::BAKE_EXECUTION: return 4;
+    default: panic("");
+    }
+    return 0;
+}
+
+static void trace_event_append_name(Trace_Event* event, String* string)
+{
+    switch (event->type)
+    {
+    case Trace_Event_Type::PHASE: {
+        string_append(string, timing_task_to_string((Timing_Task)event->value));
+        break;
+    }
+    case Trace_Event_Type::PARSE_UNIT: {
+        Compilation_Unit* unit = (Compilation_Unit*)event->subject;
+        string_append_formated(string, "Parse %s", unit->filepath.characters);
+        break;
+    }
+    case Trace_Event_Type::WORKLOAD:
+    case Trace_Event_Type::DEPENDENCY_WAIT: {
+        Workload_Base* workload = (Workload_Base*)event->subject;
+        if (event->type == Trace_Event_Type::DEPENDENCY_WAIT) {
+            string_append(string, "Wait ");
+        }
+        if (workload->type == Analysis_Workload_Type::ROOT) {
+            string_append(string, "Root");
+        }
+        else {
+            analysis_workload_append_to_string(workload, string);
+        }
+        break;
+    }
+    case Trace_Event_Type::BAKE_EXECUTION: {
+        Upp_Function* function = (Upp_Function*)event->subject;
+        string_append_formated(string, "Bake %s", function->name->characters);
+        break;
+    }
+    case Trace_Event_Type::C_COMPILATION: {
+        string_append(string, "C-Compilation");
+        break;
+    }
+    default: panic("");
+    }
+}
+
+static const char* trace_event_type_to_category(Trace_Event_Type type)
+{
+    switch (type)
+    {
+    case Trace_Event_Type::PHASE: return "phase";
+    case Trace_Event_Type::PARSE_UNIT: return "parse";
+    case Trace_Event_Type::WORKLOAD: return "workload";
+    case Trace_Event_Type::DEPENDENCY_WAIT: return "wait";
+    case Trace_Event_Type::BAKE_EXECUTION: return "bake";
+    case Trace_Event_Type::C_COMPILATION: return "c_compile";
+    default: panic("");
+    }
+    return "";
+}
+
+bool trace_recorder_write_chrome_trace(Trace_Recorder* recorder, const char* filepath)
+{
+    String json = string_create(recorder->count * 128 + 1024);
+    SCOPE_EXIT(string_destroy(&json));
+    String name = string_create(128);
+    SCOPE_EXIT(string_destroy(&name));
+
+    string_append(&json, "{\"traceEvents\":[\n");
+    const char* row_names[] = { "", "Pipeline", "Workloads", "Dependency waits", "Bake executions" };
+    for (int i = 1; i < 5; i++) {
+        string_append_formated(&json,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", i == 1 ? "" : ",\n", i, row_names[i]
+        );
+    }
+
+    int first_index = recorder->count < recorder->events.size ? 0 : recorder->next_index;
+    for (int i = 0; i < recorder->count; i++)
+    {
+        Trace_Event* event = &recorder->events[(first_index + i) % recorder->events.size];
+        string_reset(&name);
+        trace_event_append_name(event, &name);
+
+        string_append(&json, ",\n{\"name\":\"");
+        trace_append_json_escaped(&json, name.characters);
+        string_append_formated(&json, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+            trace_event_type_to_category(event->type),
+            (event->start_time - recorder->start_time) * 1000000.0,
+            (event->end_time - event->start_time) * 1000000.0,
+            trace_event_type_to_row(event->type)
+        );
+        if (event->type == Trace_Event_Type::WORKLOAD) {
+            string_append_formated(&json, ",\"args\":{\"fiber_switches\":%d}", event->value);
+        }
+        else if (event->type == Trace_Event_Type::BAKE_EXECUTION) {
+            string_append_formated(&json, ",\"args\":{\"instructions\":%d}", event->value);
+        }
+        string_append(&json, "}");
+    }
+    string_append_formated(&json, "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"dropped_events\":%d}}\n", recorder->dropped_count);
+
+    return file_io_write_file(filepath, array_create_static_as_bytes(json.characters, json.size));
+}
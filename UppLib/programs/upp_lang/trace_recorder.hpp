@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../../datastructures/array.hpp"
+
+// Spans of the compiler pipeline, exported as Chrome trace json (chrome://tracing, ui.perfetto.dev)
+enum class Trace_Event_Type
+{
+    PHASE,           // subject: -,                value: Timing_Task
+    PARSE_UNIT,      // subject: Compilation_Unit*
+    WORKLOAD,        // subject: Workload_Base*,   value: fiber switch count
+    DEPENDENCY_WAIT, // subject: Workload_Base*
+    BAKE_EXECUTION,  // subject: Upp_Function*,    value: executed instruction count
+    C_COMPILATION,
+
+    MAX_ENUM_VALUE
+};
+
+struct Trace_Event
+{
+    Trace_Event_Type type;
+    int value;
+    void* subject;
+    double start_time;
+    double end_time;
+};
+
+// Ring buffer, oldest events are overwritten when full
+struct Trace_Recorder
+{
+    Array<Trace_Event> events;
+    int next_index;
+    int count;
+    int dropped_count;
+    double start_time;
+};
+
+Trace_Recorder* trace_recorder_create(int capacity);
+void trace_recorder_destroy(Trace_Recorder* recorder);
+void trace_recorder_add_span(Trace_Recorder* recorder, Trace_Event_Type type, void* subject, int value, double start_time, double end_time);
+// Subjects are formated on export, so this must be called before workloads/functions are destroyed
+bool trace_recorder_write_chrome_trace(Trace_Recorder* recorder, const char* filepath);
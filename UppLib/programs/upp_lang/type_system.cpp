@@ -823,6 +823,7 @@ Datatype datatype_make_simple_base(Datatype_Type type, int size, int alignment)
 
 Datatype_Primitive* type_system_make_primitive(Type_System* type_system, Primitive_Type type, int size)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	Datatype_Primitive* result = arena->allocate<Datatype_Primitive>();
@@ -837,6 +838,7 @@ Datatype_Primitive* type_system_make_primitive(Type_System* type_system, Primiti
 
 Datatype_Builtin* type_system_make_builtin(Type_System* type_system, Builtin_Type builtin_type, int size, int alignment)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	Datatype_Builtin* result = arena->allocate<Datatype_Builtin>();
@@ -851,6 +853,7 @@ Datatype_Builtin* type_system_make_builtin(Type_System* type_system, Builtin_Typ
 
 Datatype_Pattern_Variable* type_system_make_pattern_variable_type(Type_System* type_system, Pattern_Variable* pattern_variable)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	Datatype_Pattern_Variable* result = arena->allocate<Datatype_Pattern_Variable>();
@@ -882,6 +885,7 @@ Datatype_Pattern_Variable* type_system_make_pattern_variable_type(Type_System* t
 
 Datatype_Pointer* type_system_make_pointer(Type_System* type_system, Datatype* child_type)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	Type_Deduplication dedup;
@@ -917,6 +921,7 @@ Datatype_Pointer* type_system_make_pointer(Type_System* type_system, Datatype* c
 Datatype* type_system_make_array(
 	Type_System* type_system, Datatype* element_type, bool count_known, int element_count, Datatype_Pattern_Variable* count_variable_type)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 	assert(!(count_known && element_count <= 0), "Hey");
 
@@ -992,6 +997,7 @@ Datatype* type_system_make_array(
 
 Datatype_Slice* type_system_make_slice(Type_System* type_system, Datatype* element_type)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 	auto& types = type_system->predefined_types;
 	auto& ids = type_system->compilation_data->identifier_pool.predefined_ids;
@@ -1032,6 +1038,7 @@ Datatype_Slice* type_system_make_slice(Type_System* type_system, Datatype* eleme
 
 Datatype_Function_Pointer* type_system_make_function_pointer(Type_System* type_system, Call_Signature* signature)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	Type_Deduplication dedup;
@@ -1099,6 +1106,7 @@ Datatype* type_system_make_type_with_modifiers(Type_System* type_system, Datatyp
 
 Datatype_Struct* type_system_make_struct_empty(Type_System* type_system, String* name, bool is_union, Datatype_Struct* parent, AST::Node* definition_node)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 
 	assert(name != 0, "");
@@ -1300,10 +1308,13 @@ void struct_size_finish_recursive(Type_System* type_system, Datatype_Struct* str
 		// Create empty tag enum
 		Datatype_Enum* tag_type = nullptr;
 		{
-			String name = string_copy(*structure->name);
-			string_append_formated(&name, "_tag");
+			Arena* arena = &type_system->compilation_data->tmp_arena;
+			auto checkpoint = arena->make_checkpoint();
+			SCOPE_EXIT(checkpoint.rewind());
+			String name = string_create(arena, structure->name->size + 5);
+			string_append_string(&name, structure->name);
+			string_append(&name, "_tag");
 			String* tag_enum_name = identifier_pool_add(&type_system->compilation_data->identifier_pool, name);
-			string_destroy(&name);
 			tag_type = type_system_make_enum_empty(type_system, tag_enum_name);
 		}
 
@@ -1412,6 +1423,7 @@ void type_system_finish_struct(Type_System* type_system, Datatype_Struct* struct
 
 Datatype_Enum* type_system_make_enum_empty(Type_System* type_system, String* name, AST::Node* definition_node)
 {
+	ALLOCATION_TAG_SCOPE(Memory_Subsystem::TYPE_SYSTEM);
 	Arena* arena = &type_system->compilation_data->arena;
 	assert(name != 0, "I've decided that all enums must have names, even if you have to generate them");
 
@@ -0,0 +1,215 @@
+#include "allocation_tracker.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "../datastructures/string.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+// Same semantics as the Interlocked functions (Returning the new value)
+#define InterlockedExchange(target, value) __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST)
+#define InterlockedExchange64(target, value) __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST)
+#define InterlockedIncrement64(target) __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST)
+#define InterlockedDecrement64(target) __atomic_sub_fetch(target, 1, __ATOMIC_SEQ_CST)
+#define InterlockedAdd64(target, value) __atomic_add_fetch(target, value, __ATOMIC_SEQ_CST)
+static i64 InterlockedCompareExchange64(volatile i64* target, i64 exchange, i64 comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+#endif
+
+// Replaces global new/delete to count them, each block gets a 16 byte header (size + tag).
+// Off by default so normal builds keep the plain allocator, define ALLOCATION_TRACKER_HOOK_NEW=1 in the build
+// configuration to enable it (cmake -DUPP_HOOK_NEW=ON, or the Memory configuration of UppCli.vcxproj). Otherwise only arena blocks are tracked.
+#ifndef ALLOCATION_TRACKER_HOOK_NEW
+#define ALLOCATION_TRACKER_HOOK_NEW 0
+#endif
+
+struct Allocation_Tracker
+{
+    volatile long enabled;
+    const char* tag_names[ALLOCATION_TRACKER_MAX_TAGS];
+    volatile i64 live_count[ALLOCATION_TRACKER_MAX_TAGS];
+    volatile i64 total_count[ALLOCATION_TRACKER_MAX_TAGS];
+    volatile i64 current_bytes[ALLOCATION_TRACKER_MAX_TAGS];
+    volatile i64 peak_bytes[ALLOCATION_TRACKER_MAX_TAGS];
+};
+
+// Zero-initialized, so this is usable for allocations before main
+static Allocation_Tracker allocation_tracker;
+static thread_local int allocation_tracker_current_tag = 0;
+
+void allocation_tracker_set_enabled(bool enabled) {
+    InterlockedExchange(&allocation_tracker.enabled, enabled ? 1 : 0);
+}
+
+bool allocation_tracker_is_enabled() {
+    return allocation_tracker.enabled != 0;
+}
+
+void allocation_tracker_set_tag_name(int tag, const char* name) {
+    assert(tag >= 0 && tag < ALLOCATION_TRACKER_MAX_TAGS, "");
+    allocation_tracker.tag_names[tag] = name;
+}
+
+int allocation_tracker_set_current_tag(int tag)
+{
+    assert(tag >= 0 && tag < ALLOCATION_TRACKER_MAX_TAGS, "");
+    int previous = allocation_tracker_current_tag;
+    allocation_tracker_current_tag = tag;
+    return previous;
+}
+
+void allocation_tracker_reset_peaks()
+{
+    for (int i = 0; i < ALLOCATION_TRACKER_MAX_TAGS; i++) {
+        InterlockedExchange64(&allocation_tracker.peak_bytes[i], allocation_tracker.current_bytes[i]);
+    }
+}
+
+int allocation_tracker_add(i64 size)
+{
+    auto& tracker = allocation_tracker;
+    if (tracker.enabled == 0) {
+        return ALLOCATION_TAG_UNTRACKED;
+    }
+
+    int tag = allocation_tracker_current_tag;
+    InterlockedIncrement64(&tracker.live_count[tag]);
+    InterlockedIncrement64(&tracker.total_count[tag]);
+    i64 current = InterlockedAdd64(&tracker.current_bytes[tag], size);
+    i64 peak = tracker.peak_bytes[tag];
+    while (current > peak) {
+        i64 previous = InterlockedCompareExchange64(&tracker.peak_bytes[tag], current, peak);
+        if (previous == peak) break;
+        peak = previous;
+    }
+    return tag;
+}
+
+void allocation_tracker_remove(int tag, i64 size)
+{
+    if (tag == ALLOCATION_TAG_UNTRACKED) return;
+    InterlockedDecrement64(&allocation_tracker.live_count[tag]);
+    InterlockedAdd64(&allocation_tracker.current_bytes[tag], -size);
+}
+
+Allocation_Tag_Stats allocation_tracker_get_stats(int tag)
+{
+    assert(tag >= 0 && tag < ALLOCATION_TRACKER_MAX_TAGS, "");
+    auto& tracker = allocation_tracker;
+    Allocation_Tag_Stats stats;
+    stats.live_count = tracker.live_count[tag];
+    stats.total_count = tracker.total_count[tag];
+    stats.current_bytes = tracker.current_bytes[tag];
+    stats.peak_bytes = tracker.peak_bytes[tag];
+    return stats;
+}
+
+Allocation_Snapshot allocation_tracker_make_snapshot()
+{
+    Allocation_Snapshot snapshot;
+    for (int i = 0; i < ALLOCATION_TRACKER_MAX_TAGS; i++) {
+        snapshot.current_bytes[i] = allocation_tracker.current_bytes[i];
+        snapshot.live_count[i] = allocation_tracker.live_count[i];
+    }
+    return snapshot;
+}
+
+static void allocation_tracker_append_tag_name(String* string, int tag)
+{
+    const char* name = allocation_tracker.tag_names[tag];
+    int length = 0;
+    if (name != nullptr) {
+        string_append(string, name);
+        length = (int)strlen(name);
+    }
+    else {
+        string_append(string, "Tag ");
+        string_append_i64(string, tag);
+        length = tag < 10 ? 5 : 6;
+    }
+    string_append_repeated(string, ' ', 14 - length);
+}
+
+void allocation_tracker_append_stats_to_string(String* string)
+{
+    if (!ALLOCATION_TRACKER_HOOK_NEW) {
+        string_append(string, "(new/delete not hooked, only arena blocks are counted, build with ALLOCATION_TRACKER_HOOK_NEW=1 or the Memory configuration)\n");
+    }
+    string_append(string, "subsystem        live allocs   current KB      peak KB   total allocs\n");
+    for (int i = 0; i < ALLOCATION_TRACKER_MAX_TAGS; i++)
+    {
+        Allocation_Tag_Stats stats = allocation_tracker_get_stats(i);
+        if (stats.total_count == 0 && stats.current_bytes == 0) continue;
+        allocation_tracker_append_tag_name(string, i);
+        string_append_formated(string, " %12lld %12lld %12lld %14lld\n",
+            stats.live_count, stats.current_bytes / 1024, stats.peak_bytes / 1024, stats.total_count
+        );
+    }
+}
+
+bool allocation_tracker_append_growth_to_string(Allocation_Snapshot* snapshot, String* string)
+{
+    bool grown = false;
+    for (int i = 0; i < ALLOCATION_TRACKER_MAX_TAGS; i++)
+    {
+        i64 byte_growth = allocation_tracker.current_bytes[i] - snapshot->current_bytes[i];
+        if (byte_growth <= 0) continue;
+        grown = true;
+        allocation_tracker_append_tag_name(string, i);
+        string_append(string, " +");
+        string_append_i64(string, byte_growth);
+        string_append(string, " bytes in ");
+        string_append_i64(string, allocation_tracker.live_count[i] - snapshot->live_count[i]);
+        string_append(string, " allocations\n");
+    }
+    return grown;
+}
+
+
+
+#if ALLOCATION_TRACKER_HOOK_NEW
+struct Allocation_Header
+{
+    i64 size;
+    i64 tag;
+};
+
+void* operator new(size_t size)
+{
+    Allocation_Header* header = (Allocation_Header*)malloc(size + sizeof(Allocation_Header));
+    if (header == nullptr) {
+        throw std::bad_alloc();
+    }
+    header->size = (i64)size;
+    header->tag = allocation_tracker_add((i64)size);
+    return header + 1;
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory == nullptr) return;
+    Allocation_Header* header = ((Allocation_Header*)memory) - 1;
+    allocation_tracker_remove((int)header->tag, header->size);
+    free(header);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* memory) noexcept {
+    operator delete(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t size) noexcept {
+    operator delete(memory);
+}
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "datatypes.hpp"
+#include "utils.hpp"
+
+struct String;
+
+// Opt-in heap allocation statistics, grouped by a per-thread tag (e.g. the compiler subsystem which is currently running).
+// Arena blocks are counted, global new/delete only in builds with ALLOCATION_TRACKER_HOOK_NEW=1. The tag is stored with each allocation, so frees are attributed to the allocating tag.
+#define ALLOCATION_TRACKER_MAX_TAGS 16
+#define ALLOCATION_TAG_UNTRACKED -1
+
+struct Allocation_Tag_Stats
+{
+    i64 live_count;
+    i64 total_count; // Allocations since tracking was enabled
+    i64 current_bytes;
+    i64 peak_bytes;
+};
+
+struct Allocation_Snapshot
+{
+    i64 current_bytes[ALLOCATION_TRACKER_MAX_TAGS];
+    i64 live_count[ALLOCATION_TRACKER_MAX_TAGS];
+};
+
+void allocation_tracker_set_enabled(bool enabled); // Only allocations made while enabled are counted
+bool allocation_tracker_is_enabled();
+void allocation_tracker_set_tag_name(int tag, const char* name);
+int allocation_tracker_set_current_tag(int tag); // Returns the previous tag of this thread
+void allocation_tracker_reset_peaks(); // Peaks restart at the current byte counts
+
+// For allocators which don't go through new/delete, returns the tag which must be passed to allocation_tracker_remove
+int allocation_tracker_add(i64 size);
+void allocation_tracker_remove(int tag, i64 size);
+
+Allocation_Tag_Stats allocation_tracker_get_stats(int tag);
+Allocation_Snapshot allocation_tracker_make_snapshot();
+void allocation_tracker_append_stats_to_string(String* string);
+// Lists tags which hold more memory than in the snapshot, returns true if there were any
+bool allocation_tracker_append_growth_to_string(Allocation_Snapshot* snapshot, String* string);
+
+#define ALLOCATION_TAG_SCOPE(tag) \
+    int STRING_JOIN2(_allocation_tag_, __LINE__) = allocation_tracker_set_current_tag((int)(tag)); \
+    SCOPE_EXIT(allocation_tracker_set_current_tag(STRING_JOIN2(_allocation_tag_, __LINE__)))
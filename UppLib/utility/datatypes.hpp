@@ -22,7 +22,28 @@ typedef uint32 u32;
 typedef uint64 u64;
 
 // This will always be u64, doesnt matter if we compile for 32bit
+#ifdef _WIN32
 typedef u64 uint;
+#else
+// glibc already declares uint as unsigned int in sys/types.h (included by most system headers)
+#include <sys/types.h>
+#define uint u64
+
+// Limits from MSVC's limits.h
+#include <climits>
+#define _I8_MIN INT8_MIN
+#define _I8_MAX INT8_MAX
+#define _I16_MIN INT16_MIN
+#define _I16_MAX INT16_MAX
+#define _I32_MIN INT32_MIN
+#define _I32_MAX INT32_MAX
+#define _I64_MIN INT64_MIN
+#define _I64_MAX INT64_MAX
+#define _UI8_MAX UINT8_MAX
+#define _UI16_MAX UINT16_MAX
+#define _UI32_MAX UINT32_MAX
+#define _UI64_MAX UINT64_MAX
+#endif
 
 typedef float f32;
 typedef double f64;
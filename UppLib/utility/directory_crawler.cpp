@@ -1,13 +1,21 @@
 #include "directory_crawler.hpp"
 
-#include <Windows.h>
+#include <cstring>
 
 #include "../datastructures/string.hpp"
 #include "../datastructures/dynamic_array.hpp"
 #include "../utility/utils.hpp"
-#include "../win32/windows_helper_functions.hpp"
 #include "../utility/file_io.hpp"
 
+#ifdef _WIN32
+#include <Windows.h>
+#include "../win32/windows_helper_functions.hpp"
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
 struct Directory_Crawler {
     String path;
     Dynamic_Array<File_Info> file_infos;
@@ -59,12 +67,18 @@ void directory_crawler_set_path_to_file_dir(Directory_Crawler* crawler, String f
 }
 
 void directory_crawler_set_to_working_directory(Directory_Crawler* crawler) {
+#ifndef _WIN32
+    char buffer[4096];
+    if (getcwd(buffer, sizeof(buffer)) == nullptr) return;
+    directory_crawler_set_path(crawler, string_create_static(buffer));
+#else
     int path_length = GetCurrentDirectory(0, 0);
     String path = string_create(path_length);
     SCOPE_EXIT(string_destroy(&path));
     int written_string_length = GetCurrentDirectory(path.capacity, path.characters);
     string_replace_character(&path, '\\', '/');
     directory_crawler_set_path(crawler, path);
+#endif
 }
 
 String directory_crawler_get_path(Directory_Crawler* crawler) {
@@ -103,6 +117,31 @@ Array<File_Info> directory_crawler_get_content(Directory_Crawler* crawler)
     }
     dynamic_array_reset(&crawler->file_infos);
 
+#ifndef _WIN32
+    DIR* directory = opendir(crawler->path.characters);
+    if (directory == nullptr) {
+        return dynamic_array_as_array(&crawler->file_infos);
+    }
+    String file_path = string_create();
+    SCOPE_EXIT(string_destroy(&file_path));
+    while (dirent* entry = readdir(directory))
+    {
+        string_reset(&file_path);
+        string_append_formated(&file_path, "%s/%s", crawler->path.characters, entry->d_name);
+        struct stat file_stat;
+        if (stat(file_path.characters, &file_stat) != 0) continue;
+
+        File_Info info;
+        info.is_directory = S_ISDIR(file_stat.st_mode);
+        info.size = file_stat.st_size;
+        info.name = string_create(entry->d_name);
+        dynamic_array_push_back(&crawler->file_infos, info);
+    }
+    closedir(directory);
+
+    // readdir doesn't sort like FindFirstFile on NTFS does
+    dynamic_array_sort(&crawler->file_infos, [](const File_Info& a, const File_Info& b) -> bool { return strcmp(a.name.characters, b.name.characters) < 0; });
+#else
     HANDLE search_handle;
     WIN32_FIND_DATA found_file_description;
     {
@@ -130,6 +169,7 @@ Array<File_Info> directory_crawler_get_content(Directory_Crawler* crawler)
         helper_print_last_error();
     }
     FindClose(search_handle);
+#endif
 
     return dynamic_array_as_array(&crawler->file_infos);
 }
@@ -1,16 +1,36 @@
 #include "file_io.hpp"
 
 #include <cstdio>
+#include <cstring>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <cstdlib>
+#include <ctime>
+#include <sys/stat.h>
+#endif
 
 #include "../utility/utils.hpp"
 
+static FILE* file_io_open(const char* filepath, const char* mode)
+{
+#ifdef _WIN32
+    FILE* file;
+    if (fopen_s(&file, filepath, mode) != 0) {
+        return nullptr;
+    }
+    return file;
+#else
+    return fopen(filepath, mode);
+#endif
+}
+
 Optional<u64> file_io_get_file_size(const char* filepath)
 {
     Optional<u64> result;
 
-    FILE* file;
-    if (fopen_s(&file, filepath, "rb") != 0) {
+    FILE* file = file_io_open(filepath, "rb");
+    if (file == nullptr) {
         result.available = false;
         return result;
     }
@@ -32,8 +52,8 @@ Optional<Array<byte>> file_io_load_binary_file(const char* filepath)
     Optional<Array<byte>> result;
     result.available = false;
 
-    FILE* file;
-    if (fopen_s(&file, filepath, "rb") != 0) {
+    FILE* file = file_io_open(filepath, "rb");
+    if (file == nullptr) {
         return result;
     }
     SCOPE_EXIT(fclose(file));
@@ -96,10 +116,20 @@ void file_io_unload_text_file(Optional<String>* file_content)
 void file_io_relative_to_full_path(String* relative_path)
 {
     char buffer[1024];
+#ifdef _WIN32
     int length = GetFullPathNameA(relative_path->characters, 1024, buffer, 0);
     if (length == 0 || length > 1024) {
         return;
     }
+#else
+    char* full_path = realpath(relative_path->characters, nullptr);
+    if (full_path == nullptr || strlen(full_path) >= 1024) {
+        free(full_path);
+        return;
+    }
+    memcpy(buffer, full_path, strlen(full_path) + 1);
+    free(full_path);
+#endif
     string_reset(relative_path);
     string_append(relative_path, buffer);
     string_replace_character(relative_path, '\\', '/');
@@ -107,8 +137,8 @@ void file_io_relative_to_full_path(String* relative_path)
 
 bool file_io_check_if_file_exists(const char* filepath)
 {
-    FILE* file;
-    if (fopen_s(&file, filepath, "r") != 0) {
+    FILE* file = file_io_open(filepath, "r");
+    if (file == nullptr) {
         return false;
     }
     if (file != 0) {
@@ -119,18 +149,33 @@ bool file_io_check_if_file_exists(const char* filepath)
 
 bool file_io_is_directory(const char* filepath) 
 {
+#ifdef _WIN32
     DWORD attributes = GetFileAttributesA(filepath);
     if (attributes == INVALID_FILE_ATTRIBUTES) {
         return false;
     }
     return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    struct stat info;
+    if (stat(filepath, &info) != 0) {
+        return false;
+    }
+    return S_ISDIR(info.st_mode);
+#endif
 }
 
 u64 file_io_get_current_file_time()
 {
+#ifdef _WIN32
     FILETIME time;
     GetSystemTimeAsFileTime(&time);
     return (((u64)time.dwHighDateTime) << 32) | (time.dwLowDateTime);
+#else
+    // Same unit as FILETIME (100ns), only differences between file times are used
+    timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    return (u64)time.tv_sec * 10000000 + (u64)time.tv_nsec / 100;
+#endif
 }
 
 Optional<u64> file_io_get_last_write_access_time(const char* filepath) 
@@ -138,6 +183,15 @@ Optional<u64> file_io_get_last_write_access_time(const char* filepath)
     Optional<u64> result;
     result.available = false;
 
+#ifndef _WIN32
+    struct stat info;
+    if (stat(filepath, &info) != 0) {
+        return result;
+    }
+    result.available = true;
+    result.value = (u64)info.st_mtim.tv_sec * 10000000 + (u64)info.st_mtim.tv_nsec / 100;
+    return result;
+#else
     // Get File Handle
     HANDLE file_handle = CreateFileA(filepath, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
     if (file_handle == INVALID_HANDLE_VALUE) {
@@ -155,12 +209,13 @@ Optional<u64> file_io_get_last_write_access_time(const char* filepath)
     result.value = (((u64)time.dwHighDateTime) << 32) | (time.dwLowDateTime);
 
     return result;
+#endif
 }
 
 bool file_io_write_file(const char* filepath, Array<byte> data)
 {
-    FILE* file;
-    if (fopen_s(&file, filepath, "wb") != 0) {
+    FILE* file = file_io_open(filepath, "wb");
+    if (file == nullptr) {
         return false;
     }
     SCOPE_EXIT(fclose(file));
@@ -172,6 +227,9 @@ bool file_io_write_file(const char* filepath, Array<byte> data)
 static char buffer[256];
 bool file_io_open_file_selection_dialog(String* write_to)
 {
+#ifndef _WIN32
+    return false;
+#else
     // open a file base_name
     OPENFILENAME ofn;
     ZeroMemory(&ofn, sizeof(ofn));
@@ -192,4 +250,5 @@ bool file_io_open_file_selection_dialog(String* write_to)
     string_reset(write_to);
     string_append(write_to, buffer);
     return true;
+#endif
 }
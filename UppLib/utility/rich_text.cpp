@@ -1,10 +1,12 @@
 #include "rich_text.hpp"
 
 #include "../datastructures/allocators.hpp"
+#ifndef UPP_HEADLESS
 #include "../rendering/rendering_core.hpp"
 #include "../rendering/text_renderer.hpp"
 #include "../rendering/renderer_2d.hpp"
 #include "../rendering/font_renderer.hpp"
+#endif
 #include "../utility/character_info.hpp"
 
 // Includes for C varargs
@@ -254,6 +256,8 @@ void Rich_Text_Area::mark(ivec2 pos, int length, Mark_Type type, Syntax_Color co
     mark(pos, length, type, syntax_color_to_palette_color(color));
 }
 
+// Headless builds (upp console driver) don't link the renderer
+#ifndef UPP_HEADLESS
 void Rich_Text_Area::render(ibox2 box, Raster_Font* font, Renderer_2D* renderer_2D, Render_Pass* render_pass)
 {
     String text_buffer = string_create(64);
@@ -389,4 +393,4 @@ void Rich_Text_Area::render(ibox2 box, Raster_Font* font, Renderer_2D* renderer_
     renderer_2D_draw(renderer_2D, render_pass);
     font->add_draw_call(render_pass);
 }
-
+#endif
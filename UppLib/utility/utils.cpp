@@ -4,7 +4,13 @@
 #include <cstdlib>
 #include <cstdarg>
 #include <cstring>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /*
     LOGGER
@@ -16,7 +22,12 @@ static void logger_default_log_function(const char* message) {
 static void logger_default_panic_function(const char* message) {
     printf("\n\nSYSTEM_PANIC %s", message);
     printf("\n\n");
+#ifdef _WIN32
     __debugbreak();
+#else
+    fflush(stdout);
+    raise(SIGTRAP);
+#endif
     // system("pause");
     //exit(-1);
 }
@@ -51,7 +62,10 @@ void logger_log(const char* file_name, int line_number, const char* message_form
     va_list variadic_arguments;
     va_start(variadic_arguments, message_format);
     int prefix_length = snprintf(0, 0, LOGGER_PREFIX_FORMAT, file_name, line_number);
-    int message_length = vsnprintf(0, 0, message_format, variadic_arguments);
+    va_list length_arguments; // va_list can't be consumed twice on every platform
+    va_copy(length_arguments, variadic_arguments);
+    int message_length = vsnprintf(0, 0, message_format, length_arguments);
+    va_end(length_arguments);
 
     // Allocate buffer
     const int required_length = prefix_length + message_length + 1;
@@ -83,7 +97,10 @@ void logger_panic(const char* file_name, int line_number, const char* message_fo
     va_list variadic_arguments;
     va_start(variadic_arguments, message_format);
     int prefix_length = snprintf(0, 0, LOGGER_PREFIX_FORMAT, file_name, line_number);
-    int message_length = vsnprintf(0, 0, message_format, variadic_arguments);
+    va_list length_arguments; // va_list can't be consumed twice on every platform
+    va_copy(length_arguments, variadic_arguments);
+    int message_length = vsnprintf(0, 0, message_format, length_arguments);
+    va_end(length_arguments);
 
     // Allocate buffer
     const int required_length = prefix_length + message_length + 1;
@@ -137,6 +154,11 @@ bool memory_compare(void* memory_a, void* memory_b, u64 compare_size)
 
 bool memory_is_readable(void* destination, u64 read_size)
 {
+#ifndef _WIN32
+    // write fails with EFAULT instead of crashing if the source isn't readable
+    static int null_file = open("/dev/null", O_WRONLY);
+    return write(null_file, destination, read_size) == (ssize_t)read_size;
+#else
     MEMORY_BASIC_INFORMATION mbi = { 0 };
     if (VirtualQuery(destination, &mbi, sizeof(mbi)) != 0)
     {
@@ -147,4 +169,5 @@ bool memory_is_readable(void* destination, u64 read_size)
         return b;
     }
     return false;
+#endif
 }
@@ -5,8 +5,8 @@
 /*
     LOGGING
 */
-#define logg(message_format, ...) logger_log(__FILE__, __LINE__, message_format, __VA_ARGS__)
-#define panic(message_format, ...) logger_panic(__FILE__, __LINE__, message_format, __VA_ARGS__)
+#define logg(message_format, ...) logger_log(__FILE__, __LINE__, message_format, ##__VA_ARGS__)
+#define panic(message_format, ...) logger_panic(__FILE__, __LINE__, message_format, ##__VA_ARGS__)
 
 typedef void(*custom_log_fn)(const char* message);
 typedef void(*custom_panic_fn)(const char* message);
@@ -18,7 +18,7 @@ void logger_panic(const char* file_name, int line_number, const char* message_fo
 /*
     ASSERTIONS
 */
-#define assert(condition, format, ...) assert_function(condition, #condition, __FILE__, __LINE__, format, __VA_ARGS__)
+#define assert(condition, format, ...) assert_function(condition, #condition, __FILE__, __LINE__, format, ##__VA_ARGS__)
 void assert_function(bool condition, const char* condition_as_string, const char* file_name, int line_number, const char* message, ...);
 
 /*
@@ -0,0 +1,357 @@
+#include "fiber.hpp"
+
+#include "../utility/utils.hpp"
+#include "../math/scalars.hpp"
+#include "timing.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FIBER_NATIVE_SWITCH 1
+#elif defined(_WIN32)
+#define FIBER_NATIVE_SWITCH 0 // Falls back to the OS fiber API
+#else
+#error "Fiber context switches are only implemented for x86-64 and Windows"
+#endif
+
+struct Fiber
+{
+    void* stack_pointer; // Saved by fiber_context_switch while the fiber isn't running
+    byte* stack_memory;  // nullptr for thread fibers, the lowest page is the guard page
+    u64 stack_size;
+    fiber_entry_fn entry_fn;
+    void* userdata;
+    void* os_fiber;      // Only used without FIBER_NATIVE_SWITCH
+};
+
+static thread_local Fiber fiber_of_thread;
+static thread_local Fiber* fiber_current = nullptr;
+static thread_local u64 fiber_switch_count = 0;
+
+static void fiber_main(Fiber* fiber)
+{
+    fiber->entry_fn(fiber->userdata);
+    panic("Fiber entry function returned, it must switch to another fiber instead!");
+}
+
+#if FIBER_NATIVE_SWITCH
+extern "C" void fiber_context_switch(void** save_stack_pointer, void* stack_pointer);
+extern "C" void fiber_context_start(); // Calls r12(r13), must only be reached through the initial stack of a fiber
+
+#ifndef _WIN32
+// System V ABI, the Windows version is in fiber_switch_x64.asm
+asm(R"(
+    .text
+    .globl fiber_context_switch
+    .type fiber_context_switch, @function
+fiber_context_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size fiber_context_switch, .-fiber_context_switch
+
+    .globl fiber_context_start
+    .type fiber_context_start, @function
+fiber_context_start:
+    .cfi_startproc
+    .cfi_undefined rip
+    movq %r13, %rdi
+    callq *%r12
+    ud2
+    .cfi_endproc
+    .size fiber_context_start, .-fiber_context_start
+)");
+#endif
+
+// Builds the stack as if fiber_context_switch had been called from the start of fiber_context_start
+static void fiber_prepare_stack(Fiber* fiber)
+{
+    byte* stack_top = fiber->stack_memory + fiber->stack_size;
+    u64* stack = (u64*)stack_top;
+#ifdef _WIN32
+    *--stack = 0; // Padding, fiber_context_start is entered with a 16 byte aligned stack
+    *--stack = 0; // Return address of fiber_context_start, ends stack walks
+    *--stack = (u64)&fiber_context_start; // Return address
+    *--stack = 0; // rbp
+    *--stack = 0; // rbx
+    *--stack = 0; // rdi
+    *--stack = 0; // rsi
+    *--stack = (u64)&fiber_main; // r12
+    *--stack = (u64)fiber;       // r13
+    *--stack = 0; // r14
+    *--stack = 0; // r15
+    *--stack = (u64)stack_top; // StackBase
+    *--stack = (u64)(fiber->stack_memory + FIBER_GUARD_PAGE_SIZE); // StackLimit
+    *--stack = (u64)fiber->stack_memory; // DeallocationStack
+    stack -= 22;  // xmm6-xmm15, mxcsr + x87 control word, padding
+    memory_set_bytes(stack, 22 * sizeof(u64), 0);
+    u32* control_words = (u32*)(stack + 20);
+    control_words[0] = 0x1F80;
+    control_words[1] = 0x027F;
+#else
+    *--stack = (u64)&fiber_context_start; // Return address
+    *--stack = 0; // rbp
+    *--stack = 0; // rbx
+    *--stack = (u64)&fiber_main; // r12
+    *--stack = (u64)fiber;       // r13
+    *--stack = 0; // r14
+    *--stack = 0; // r15
+    *--stack = ((u64)0x037F << 32) | 0x1F80; // mxcsr + x87 control word
+#endif
+    fiber->stack_pointer = stack;
+}
+
+static byte* fiber_stack_allocate(u64 size)
+{
+#ifdef _WIN32
+    byte* memory = (byte*)VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (memory == nullptr) return nullptr;
+    if (VirtualAlloc(memory + FIBER_GUARD_PAGE_SIZE, size - FIBER_GUARD_PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return nullptr;
+    }
+    return memory;
+#else
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    if (mprotect(memory, FIBER_GUARD_PAGE_SIZE, PROT_NONE) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return (byte*)memory;
+#endif
+}
+
+static void fiber_stack_free(byte* memory, u64 size)
+{
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, size);
+#endif
+}
+
+bool fiber_initialize()
+{
+    if (fiber_current != nullptr) return true;
+    memory_set_bytes(&fiber_of_thread, sizeof(Fiber), 0);
+    fiber_current = &fiber_of_thread;
+    return true;
+}
+
+Fiber_Handle fiber_create(fiber_entry_fn entry_fn, void* user_data, u64 stack_size)
+{
+    stack_size = math_round_next_multiple(stack_size, (u64)FIBER_GUARD_PAGE_SIZE) + FIBER_GUARD_PAGE_SIZE;
+    Fiber* fiber = new Fiber;
+    fiber->stack_memory = fiber_stack_allocate(stack_size);
+    if (fiber->stack_memory == nullptr) {
+        panic("Fiber creation failed!");
+    }
+    fiber->stack_size = stack_size;
+
+    Fiber_Handle result;
+    result.fiber = fiber;
+    fiber_reset(result, entry_fn, user_data);
+    return result;
+}
+
+void fiber_reset(Fiber_Handle fiber, fiber_entry_fn entry_fn, void* user_data)
+{
+    assert(fiber.fiber != fiber_current, "Cannot reset the running fiber!");
+    assert(fiber.fiber->stack_memory != nullptr, "Thread fibers cannot be reset");
+    fiber.fiber->entry_fn = entry_fn;
+    fiber.fiber->userdata = user_data;
+#if defined(__SANITIZE_ADDRESS__)
+    // Frames of a discarded task never return, so their poisoned stack variables must be cleared for the next task
+    byte* usable_stack = fiber.fiber->stack_memory + FIBER_GUARD_PAGE_SIZE;
+    __asan_unpoison_memory_region(usable_stack, fiber.fiber->stack_size - FIBER_GUARD_PAGE_SIZE);
+#endif
+    fiber_prepare_stack(fiber.fiber);
+}
+
+void fiber_switch_to(Fiber_Handle fiber)
+{
+    Fiber* from = fiber_current;
+    assert(fiber.fiber != from, "Cannot switch to current fiber!");
+    fiber_current = fiber.fiber;
+    fiber_switch_count += 1;
+    fiber_context_switch(&from->stack_pointer, fiber.fiber->stack_pointer);
+}
+
+void fiber_delete(Fiber_Handle fiber)
+{
+    assert(fiber.fiber != fiber_current, "Cannot delete the running fiber!");
+    assert(fiber.fiber->stack_memory != nullptr, "Thread fibers cannot be deleted");
+    fiber_stack_free(fiber.fiber->stack_memory, fiber.fiber->stack_size);
+    delete fiber.fiber;
+}
+
+#else
+// OS fibers (e.g. 32 bit Windows), a reset recreates the fiber since its stack can't be rewound
+static void CALLBACK fiber_os_entry(void* userdata) {
+    fiber_main((Fiber*)userdata);
+}
+
+bool fiber_initialize()
+{
+    if (fiber_current != nullptr) return true;
+    memory_set_bytes(&fiber_of_thread, sizeof(Fiber), 0);
+    fiber_of_thread.os_fiber = ConvertThreadToFiber(0);
+    if (fiber_of_thread.os_fiber == nullptr) {
+        return false;
+    }
+    fiber_current = &fiber_of_thread;
+    return true;
+}
+
+Fiber_Handle fiber_create(fiber_entry_fn entry_fn, void* user_data, u64 stack_size)
+{
+    Fiber* fiber = new Fiber;
+    memory_set_bytes(fiber, sizeof(Fiber), 0);
+    fiber->stack_size = stack_size;
+    Fiber_Handle result;
+    result.fiber = fiber;
+    fiber_reset(result, entry_fn, user_data);
+    return result;
+}
+
+void fiber_reset(Fiber_Handle fiber, fiber_entry_fn entry_fn, void* user_data)
+{
+    assert(fiber.fiber != fiber_current, "Cannot reset the running fiber!");
+    assert(fiber.fiber != &fiber_of_thread, "Thread fibers cannot be reset");
+    if (fiber.fiber->os_fiber != nullptr) {
+        DeleteFiber(fiber.fiber->os_fiber);
+    }
+    fiber.fiber->entry_fn = entry_fn;
+    fiber.fiber->userdata = user_data;
+    fiber.fiber->os_fiber = CreateFiber((SIZE_T)fiber.fiber->stack_size, fiber_os_entry, fiber.fiber);
+    if (fiber.fiber->os_fiber == nullptr) {
+        panic("Fiber creation failed!");
+    }
+}
+
+void fiber_switch_to(Fiber_Handle fiber)
+{
+    assert(fiber.fiber != fiber_current, "Cannot switch to current fiber!");
+    fiber_current = fiber.fiber;
+    fiber_switch_count += 1;
+    SwitchToFiber(fiber.fiber->os_fiber);
+}
+
+void fiber_delete(Fiber_Handle fiber)
+{
+    assert(fiber.fiber != fiber_current, "Cannot delete the running fiber!");
+    assert(fiber.fiber != &fiber_of_thread, "Thread fibers cannot be deleted");
+    DeleteFiber(fiber.fiber->os_fiber);
+    delete fiber.fiber;
+}
+#endif
+
+Fiber_Handle fiber_get_current() {
+    assert(fiber_current != nullptr, "fiber_initialize wasn't called on this thread");
+    Fiber_Handle result;
+    result.fiber = fiber_current;
+    return result;
+}
+
+u64 fiber_get_switch_count() {
+    return fiber_switch_count;
+}
+
+
+
+static void fiber_benchmark_entry(void* userdata)
+{
+    Fiber_Handle caller = *((Fiber_Handle*)userdata);
+    while (true) {
+        fiber_switch_to(caller);
+    }
+}
+
+double fiber_benchmark_switch(int round_trips)
+{
+    fiber_initialize();
+    u64 switch_count = fiber_switch_count;
+    SCOPE_EXIT(fiber_switch_count = switch_count);
+
+    Fiber_Handle caller = fiber_get_current();
+    Fiber_Handle fiber = fiber_create(fiber_benchmark_entry, &caller, 64 * 1024);
+    SCOPE_EXIT(fiber_delete(fiber));
+    fiber_switch_to(fiber); // Warm up, so the stack pages are touched
+
+    double start_time = timer_current_time_in_seconds();
+    for (int i = 0; i < round_trips; i++) {
+        fiber_switch_to(fiber);
+    }
+    double end_time = timer_current_time_in_seconds();
+    return (end_time - start_time) * 1000000000.0 / (2.0 * math_maximum(1, round_trips));
+}
+
+struct User_Data
+{
+    int fiber_index;
+    Fiber_Handle next_fiber;
+};
+
+void fiber_entry(void* userdata) {
+    User_Data data = *((User_Data*)userdata);
+    logg("Fiber %d printing!\n", data.fiber_index);
+    fiber_switch_to(data.next_fiber);
+    panic("Test fiber should not be resumed");
+}
+
+void test_fibers()
+{
+    if (!fiber_initialize()) {
+        panic("Fiber initializtion failed!");
+    }
+    logg("Fibers successfully initialized");
+
+    Fiber_Handle current = fiber_get_current();
+
+    User_Data fiber1_data;
+    User_Data fiber2_data;
+
+    Fiber_Handle fiber1 = fiber_create(&fiber_entry, &fiber1_data);
+    SCOPE_EXIT(fiber_delete(fiber1));
+    Fiber_Handle fiber2 = fiber_create(&fiber_entry, &fiber2_data);
+    SCOPE_EXIT(fiber_delete(fiber2));
+
+    fiber1_data.fiber_index = 1;
+    fiber1_data.next_fiber = fiber2;
+    fiber2_data.fiber_index = 2;
+    fiber2_data.next_fiber = current;
+
+    logg("Switching to first fiber!");
+    fiber_switch_to(fiber1);
+    logg("Just returned from swich to!");
+    logg("Fiber switch: %3.1fns\n", (float)fiber_benchmark_switch(100000));
+}
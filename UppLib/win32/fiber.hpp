@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../utility/datatypes.hpp"
+
+// Fibers with hand-written x86-64 context switches (Windows x64 ABI in fiber_switch_x64.asm, System V ABI in fiber.cpp),
+// a switch only saves the callee-saved registers of the ABI on the old stack. Other Windows targets (Win32) fall back to the OS fiber API.
+// Stacks have an inaccessible guard page at the bottom and stay allocated until fiber_delete, use fiber_reset to reuse them.
+#define FIBER_DEFAULT_STACK_SIZE (1024 * 1024)
+#define FIBER_GUARD_PAGE_SIZE 4096
+
+struct Fiber;
+struct Fiber_Handle
+{
+    Fiber* fiber;
+};
+
+typedef void (*fiber_entry_fn)(void* userdata);
+
+bool fiber_initialize(); // Creates the fiber of the calling thread, afterwards it can be retrieved with fiber_get_current
+Fiber_Handle fiber_get_current();
+// The entry function must never return, it has to switch to another fiber when it is done
+Fiber_Handle fiber_create(fiber_entry_fn entry_fn, void* user_data, u64 stack_size = FIBER_DEFAULT_STACK_SIZE);
+void fiber_reset(Fiber_Handle fiber, fiber_entry_fn entry_fn, void* user_data); // Discards the suspended state, next switch starts entry_fn
+void fiber_switch_to(Fiber_Handle fiber);
+void fiber_delete(Fiber_Handle fiber); // Must not be the currently running fiber
+
+u64 fiber_get_switch_count(); // Switches made by the calling thread
+double fiber_benchmark_switch(int round_trips); // Returns nanoseconds per switch
+void test_fibers();
@@ -0,0 +1,101 @@
+; Context switch for fiber.cpp (Windows x64 ABI), see fiber_prepare_stack for the initial stack layout.
+; Besides the callee-saved registers, the stack bounds of the thread information block are switched,
+; so that stack probes (__chkstk) and the unwinder accept the fiber stack.
+; Both procedures have unwind info, so debuggers and exception dispatch can walk through a suspended fiber.
+
+.code
+
+; void fiber_context_switch(void** save_stack_pointer (rcx), void* stack_pointer (rdx))
+fiber_context_switch PROC FRAME
+    push rbp
+    .pushreg rbp
+    push rbx
+    .pushreg rbx
+    push rdi
+    .pushreg rdi
+    push rsi
+    .pushreg rsi
+    push r12
+    .pushreg r12
+    push r13
+    .pushreg r13
+    push r14
+    .pushreg r14
+    push r15
+    .pushreg r15
+    mov r10, qword ptr gs:[30h]
+    push qword ptr [r10 + 08h]      ; StackBase
+    .allocstack 8
+    push qword ptr [r10 + 10h]      ; StackLimit
+    .allocstack 8
+    push qword ptr [r10 + 1478h]    ; DeallocationStack
+    .allocstack 8
+    sub rsp, 0B0h
+    .allocstack 0B0h
+    movaps [rsp + 00h], xmm6
+    .savexmm128 xmm6, 00h
+    movaps [rsp + 10h], xmm7
+    .savexmm128 xmm7, 10h
+    movaps [rsp + 20h], xmm8
+    .savexmm128 xmm8, 20h
+    movaps [rsp + 30h], xmm9
+    .savexmm128 xmm9, 30h
+    movaps [rsp + 40h], xmm10
+    .savexmm128 xmm10, 40h
+    movaps [rsp + 50h], xmm11
+    .savexmm128 xmm11, 50h
+    movaps [rsp + 60h], xmm12
+    .savexmm128 xmm12, 60h
+    movaps [rsp + 70h], xmm13
+    .savexmm128 xmm13, 70h
+    movaps [rsp + 80h], xmm14
+    .savexmm128 xmm14, 80h
+    movaps [rsp + 90h], xmm15
+    .savexmm128 xmm15, 90h
+    stmxcsr dword ptr [rsp + 0A0h]
+    fnstcw word ptr [rsp + 0A4h]
+    .endprolog
+
+    mov [rcx], rsp
+    mov rsp, rdx
+
+    ldmxcsr dword ptr [rsp + 0A0h]
+    fldcw word ptr [rsp + 0A4h]
+    movaps xmm6, [rsp + 00h]
+    movaps xmm7, [rsp + 10h]
+    movaps xmm8, [rsp + 20h]
+    movaps xmm9, [rsp + 30h]
+    movaps xmm10, [rsp + 40h]
+    movaps xmm11, [rsp + 50h]
+    movaps xmm12, [rsp + 60h]
+    movaps xmm13, [rsp + 70h]
+    movaps xmm14, [rsp + 80h]
+    movaps xmm15, [rsp + 90h]
+    add rsp, 0B0h
+    mov r10, qword ptr gs:[30h]
+    pop qword ptr [r10 + 1478h]
+    pop qword ptr [r10 + 10h]
+    pop qword ptr [r10 + 08h]
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rsi
+    pop rdi
+    pop rbx
+    pop rbp
+    ret
+fiber_context_switch ENDP
+
+; First 'return' of a new fiber, calls r12(r13) with a 16 byte aligned stack.
+; The zero return address above the entry stack terminates stack walks.
+fiber_context_start PROC FRAME
+    sub rsp, 20h
+    .allocstack 20h
+    .endprolog
+    mov rcx, r13
+    call r12
+    ud2
+fiber_context_start ENDP
+
+END
@@ -1,5 +1,6 @@
 #include "process.hpp"
 
+#ifdef _WIN32
 #include <Windows.h>
 #include "windows_helper_functions.hpp"
 
@@ -165,91 +166,253 @@ void process_result_destroy(Optional<Process_Result>* result)
     }
 }
 
+Optional<Process_Handle> process_start_async(String command)
+{
+    HANDLE handle_stdout_read = 0;
+    HANDLE handle_stdout_write = 0;
+    SECURITY_ATTRIBUTES security_attributes;
+    security_attributes.nLength = sizeof(security_attributes);
+    security_attributes.bInheritHandle = true;
+    security_attributes.lpSecurityDescriptor = NULL;
+    if (!CreatePipe(&handle_stdout_read, &handle_stdout_write, &security_attributes, 0)) {
+        logg("Pipe problem");
+        return optional_make_failure<Process_Handle>();
+    }
+    if (!SetHandleInformation(handle_stdout_read, HANDLE_FLAG_INHERIT, 0)) {
+        logg("Pipe problem");
+        CloseHandle(handle_stdout_read);
+        CloseHandle(handle_stdout_write);
+        return optional_make_failure<Process_Handle>();
+    }
 
-static thread_local bool converted_to_fiber = false;
+    STARTUPINFO start_info;
+    ZeroMemory(&start_info, sizeof(start_info));
+    start_info.cb = sizeof(start_info);
+    start_info.dwFlags |= STARTF_USESTDHANDLES;
+    start_info.hStdError = handle_stdout_write;
+    start_info.hStdOutput = handle_stdout_write;
+    start_info.hStdInput = NULL;
 
-bool fiber_initialize() {
-    if (converted_to_fiber) return true;
-    if (ConvertThreadToFiber(0) == 0) {
+    PROCESS_INFORMATION process_info;
+    ZeroMemory(&process_info, sizeof(process_info));
+    bool success = CreateProcessA(0, command.characters, NULL, NULL, TRUE, 0, 0, 0, &start_info, &process_info);
+    CloseHandle(handle_stdout_write); // Child has it's own copy now
+    if (!success) {
         helper_print_last_error();
-        return false;
+        CloseHandle(handle_stdout_read);
+        return optional_make_failure<Process_Handle>();
     }
-    converted_to_fiber = true;
-    return true;
-}
 
-Fiber_Handle fiber_get_current() {
-    Fiber_Handle result;
-    result.handle = GetCurrentFiber();
-    return result;
+    Process_Handle result;
+    result.process = process_info.hProcess;
+    result.thread = process_info.hThread;
+    result.stdout_read = handle_stdout_read;
+    return optional_make_success(result);
 }
 
-Fiber_Handle fiber_create(fiber_entry_fn entry_fn, void* user_data) {
-    Fiber_Handle result;
-    result.handle = CreateFiber(0, entry_fn, user_data);
-    if (result.handle == 0) {
-        panic("Fiber creation failed!");
+bool process_poll(Process_Handle* handle, String* output, int* exit_code)
+{
+    // Drain pipe, otherwise the child blocks once the pipe buffer is full
+    char buffer[1024];
+    while (true)
+    {
+        DWORD available = 0;
+        if (!PeekNamedPipe(handle->stdout_read, NULL, 0, NULL, &available, NULL) || available == 0) break;
+        DWORD read_bytes = 0;
+        if (!ReadFile(handle->stdout_read, buffer, available < 1024 ? available : 1024, &read_bytes, NULL) || read_bytes == 0) break;
+        string_append_character_array(output, array_create_static(buffer, read_bytes));
+    }
+
+    if (WaitForSingleObject(handle->process, 0) != WAIT_OBJECT_0) {
+        return false;
+    }
+
+    // Read rest of output after exit
+    DWORD read_bytes = 0;
+    while (ReadFile(handle->stdout_read, buffer, 1024, &read_bytes, NULL) && read_bytes != 0) {
+        string_append_character_array(output, array_create_static(buffer, read_bytes));
     }
-    return result;
+
+    DWORD code = 0;
+    if (GetExitCodeProcess(handle->process, &code) == FALSE) {
+        logg("Could not get exit code?\n");
+        code = 1;
+    }
+    *exit_code = (int)code;
+    return true;
 }
 
-void fiber_switch_to(Fiber_Handle fiber) {
-    // Just assert we aren't switching to the current fiber
-    assert(fiber.handle != GetCurrentFiber(), "Cannot switch to current fiber!");
-    SwitchToFiber(fiber.handle);
+void process_kill(Process_Handle* handle)
+{
+    TerminateProcess(handle->process, 1);
+    WaitForSingleObject(handle->process, INFINITE);
 }
 
-void fiber_delete(Fiber_Handle fiber) {
-    DeleteFiber(fiber.handle);
+void process_handle_destroy(Process_Handle* handle)
+{
+    CloseHandle(handle->stdout_read);
+    CloseHandle(handle->process);
+    CloseHandle(handle->thread);
+    handle->stdout_read = 0;
+    handle->process = 0;
+    handle->thread = 0;
 }
 
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
-struct User_Data
+// Commands are run by /bin/sh, stdout and stderr go to output_fd if it isn't -1
+static pid_t process_spawn(String command, int output_fd, int close_in_child)
 {
-    int fiber_index;
-    Fiber_Handle next_fiber;
-};
-
-void fiber_entry(void* userdata) {
-    User_Data data = *((User_Data*)userdata);
-    logg("Fiber %d printing!\n", data.fiber_index);
-    fiber_switch_to(data.next_fiber);
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    if (output_fd != -1) {
+        dup2(output_fd, 1);
+        dup2(output_fd, 2);
+        close(output_fd);
+    }
+    if (close_in_child != -1) {
+        close(close_in_child);
+    }
+    execl("/bin/sh", "sh", "-c", command.characters, (char*)nullptr);
+    _exit(127);
 }
 
-void test_fibers()
+static int process_wait_for_exit_code(pid_t pid, int wait_flags)
 {
-    if (!fiber_initialize()) {
-        panic("Fiber initializtion failed!");
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, wait_flags);
+    } while (result == -1 && errno == EINTR);
+    if (result == 0) return -1;
+    if (result == -1) {
+        logg("Could not get exit code?\n");
+        return 1;
     }
-    logg("Fibers successfully initialized");
-    
-    Fiber_Handle current = fiber_get_current();
-
-    User_Data fiber1_data;
-    User_Data fiber2_data;
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    return 128 + WTERMSIG(status);
+}
 
-    Fiber_Handle fiber1 = fiber_create(&fiber_entry, &fiber1_data);
-    SCOPE_EXIT(fiber_delete(fiber1));
-    Fiber_Handle fiber2 = fiber_create(&fiber_entry, &fiber2_data);
-    SCOPE_EXIT(fiber_delete(fiber2));
+Optional<Process_Result> process_start(String command)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        logg("Pipe problem was detected");
+        return optional_make_failure<Process_Result>();
+    }
+    pid_t pid = process_spawn(command, pipe_fds[1], pipe_fds[0]);
+    close(pipe_fds[1]);
+    if (pid == -1) {
+        close(pipe_fds[0]);
+        return optional_make_failure<Process_Result>();
+    }
 
-    fiber1_data.fiber_index = 1;
-    fiber1_data.next_fiber = fiber2;
-    fiber2_data.fiber_index = 2;
-    fiber2_data.next_fiber = current;
+    // Read from child
+    Process_Result result;
+    result.output = string_create(1024);
+    char buffer[1024];
+    while (true)
+    {
+        ssize_t read_bytes = read(pipe_fds[0], buffer, 1024);
+        if (read_bytes < 0 && errno == EINTR) continue;
+        if (read_bytes <= 0) break;
+        string_append_character_array(&result.output, array_create_static(buffer, (int)read_bytes));
+    }
+    close(pipe_fds[0]);
 
-    logg("Switching to first fiber!");
-    fiber_switch_to(fiber1);
-    logg("Just returned from swich to!");
+    result.exit_code = process_wait_for_exit_code(pid, 0);
+    return optional_make_success(result);
 }
 
+int process_start_no_pipes(String command, bool wait_for_exit)
+{
+    pid_t pid = process_spawn(command, -1, -1);
+    if (pid == -1) {
+        return 1;
+    }
+    if (!wait_for_exit) {
+        return 0;
+    }
+    return process_wait_for_exit_code(pid, 0);
+}
 
+void process_result_destroy(Optional<Process_Result>* result)
+{
+    if (result->available) {
+        string_destroy(&result->value.output);
+    }
+}
 
+// process stores the pid and stdout_read the file descriptor of the pipe
+Optional<Process_Handle> process_start_async(String command)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        logg("Pipe problem");
+        return optional_make_failure<Process_Handle>();
+    }
+    pid_t pid = process_spawn(command, pipe_fds[1], pipe_fds[0]);
+    close(pipe_fds[1]); // Child has it's own copy now
+    if (pid == -1) {
+        close(pipe_fds[0]);
+        return optional_make_failure<Process_Handle>();
+    }
+    fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
 
+    Process_Handle result;
+    result.process = (void*)(i64)pid;
+    result.thread = nullptr;
+    result.stdout_read = (void*)(i64)pipe_fds[0];
+    return optional_make_success(result);
+}
 
+bool process_poll(Process_Handle* handle, String* output, int* exit_code)
+{
+    int fd = (int)(i64)handle->stdout_read;
+    char buffer[1024];
+    auto drain_pipe = [&]() {
+        while (true) {
+            ssize_t read_bytes = read(fd, buffer, 1024);
+            if (read_bytes < 0 && errno == EINTR) continue;
+            if (read_bytes <= 0) break;
+            string_append_character_array(output, array_create_static(buffer, (int)read_bytes));
+        }
+    };
 
+    // Drain pipe, otherwise the child blocks once the pipe buffer is full
+    drain_pipe();
+    int code = process_wait_for_exit_code((pid_t)(i64)handle->process, WNOHANG);
+    if (code == -1) {
+        return false;
+    }
+    handle->process = nullptr;
 
+    // Read rest of output after exit
+    drain_pipe();
+    *exit_code = code;
+    return true;
+}
 
+void process_kill(Process_Handle* handle)
+{
+    if (handle->process == nullptr) return;
+    kill((pid_t)(i64)handle->process, SIGKILL);
+    process_wait_for_exit_code((pid_t)(i64)handle->process, 0);
+    handle->process = nullptr;
+}
 
-
-
+void process_handle_destroy(Process_Handle* handle)
+{
+    close((int)(i64)handle->stdout_read);
+    handle->stdout_read = 0;
+    handle->process = 0;
+    handle->thread = 0;
+}
+#endif
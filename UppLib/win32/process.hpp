@@ -12,26 +12,26 @@ Optional<Process_Result> process_start(String command);
 int process_start_no_pipes(String command, bool wait_for_exit);
 void process_result_destroy(Optional<Process_Result>* result);
 
-struct Thread_Handle
+// Process running in the background, stdout and stderr are captured
+struct Process_Handle
 {
-    unsigned long thread_id;
-    void* handle;
+    void* process;
+    void* thread;
+    void* stdout_read;
 };
 
+Optional<Process_Handle> process_start_async(String command);
+// Appends available output without blocking, returns true once the process has exited (exit_code is only set then)
+bool process_poll(Process_Handle* handle, String* output, int* exit_code);
+void process_kill(Process_Handle* handle);
+void process_handle_destroy(Process_Handle* handle);
 
-struct Fiber_Handle
+struct Thread_Handle
 {
+    unsigned long thread_id;
     void* handle;
 };
 
-typedef void (*fiber_entry_fn)(void* userdata);
-
-bool fiber_initialize(); // Afterwards fiber can be retrieved with fiber_get_current
-Fiber_Handle fiber_get_current();
-Fiber_Handle fiber_create(fiber_entry_fn entry_fn, void* user_data);
-void fiber_switch_to(Fiber_Handle fiber);
-void fiber_delete(Fiber_Handle fiber); // If this is the currently running fiber, the executing thread stops
-void test_fibers();
 
 /*
 typedef unsigned long (*thread_entry_fn)(void*);
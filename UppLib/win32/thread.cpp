@@ -1,8 +1,10 @@
 #include "thread.hpp"
 
-#include <Windows.h>
 #include "../utility/utils.hpp"
 
+#ifdef _WIN32
+#include <Windows.h>
+
 Thread thread_create(thread_start_fn start_fn, void* userdata)
 {
     Thread result;
@@ -67,3 +69,114 @@ bool semaphore_try_wait(Semaphore semaphore) {
 void semaphore_increment(Semaphore semaphore, int count) {
     ReleaseSemaphore(semaphore.handle, count, NULL);
 }
+
+void cancellation_token_reset(Cancellation_Token* token) {
+    InterlockedExchange(&token->value, 0);
+}
+
+void cancellation_token_cancel(Cancellation_Token* token) {
+    InterlockedExchange(&token->value, 1);
+}
+
+bool cancellation_token_is_cancelled(Cancellation_Token* token) {
+    return InterlockedCompareExchange(&token->value, 0, 0) != 0;
+}
+
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+
+struct Posix_Thread
+{
+    pthread_t thread;
+    thread_start_fn start_fn;
+    void* userdata;
+    bool finished;
+};
+
+static void* posix_thread_entry(void* argument)
+{
+    Posix_Thread* thread = (Posix_Thread*)argument;
+    thread->start_fn(thread->userdata);
+    __atomic_store_n(&thread->finished, true, __ATOMIC_RELEASE);
+    return nullptr;
+}
+
+Thread thread_create(thread_start_fn start_fn, void* userdata)
+{
+    Posix_Thread* thread = new Posix_Thread;
+    thread->start_fn = start_fn;
+    thread->userdata = userdata;
+    thread->finished = false;
+    int error = pthread_create(&thread->thread, nullptr, posix_thread_entry, thread);
+    assert(error == 0, "");
+
+    Thread result;
+    result.handle = thread;
+    return result;
+}
+
+bool thread_is_finished(Thread thread) {
+    return __atomic_load_n(&((Posix_Thread*)thread.handle)->finished, __ATOMIC_ACQUIRE);
+}
+
+void wait_for_thread_to_finish(Thread thread) {
+    Posix_Thread* posix_thread = (Posix_Thread*)thread.handle;
+    if (posix_thread->thread != 0) {
+        pthread_join(posix_thread->thread, nullptr);
+        posix_thread->thread = 0;
+    }
+}
+
+void thread_destroy(Thread thread) {
+    Posix_Thread* posix_thread = (Posix_Thread*)thread.handle;
+    if (posix_thread->thread != 0) {
+        pthread_detach(posix_thread->thread);
+    }
+    delete posix_thread;
+}
+
+// max_count is not enforced by posix semaphores
+Semaphore semaphore_create(int initial_count, int max_count)
+{
+    sem_t* semaphore = new sem_t;
+    int error = sem_init(semaphore, 0, initial_count);
+    assert(error == 0, "");
+
+    Semaphore result;
+    result.handle = semaphore;
+    return result;
+}
+
+void semaphore_destroy(Semaphore semaphore) {
+    sem_destroy((sem_t*)semaphore.handle);
+    delete (sem_t*)semaphore.handle;
+}
+
+void semaphore_wait(Semaphore semaphore) {
+    while (sem_wait((sem_t*)semaphore.handle) != 0 && errno == EINTR) {}
+}
+
+bool semaphore_try_wait(Semaphore semaphore) {
+    return sem_trywait((sem_t*)semaphore.handle) == 0;
+}
+
+void semaphore_increment(Semaphore semaphore, int count) {
+    for (int i = 0; i < count; i++) {
+        sem_post((sem_t*)semaphore.handle);
+    }
+}
+
+void cancellation_token_reset(Cancellation_Token* token) {
+    __atomic_store_n(&token->value, 0, __ATOMIC_SEQ_CST);
+}
+
+void cancellation_token_cancel(Cancellation_Token* token) {
+    __atomic_store_n(&token->value, 1, __ATOMIC_SEQ_CST);
+}
+
+bool cancellation_token_is_cancelled(Cancellation_Token* token) {
+    return __atomic_load_n(&token->value, __ATOMIC_SEQ_CST) != 0;
+}
+#endif
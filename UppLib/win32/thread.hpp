@@ -6,7 +6,11 @@ struct Thread {
     void* handle;
 };
 
+#ifdef _WIN32
 typedef unsigned long (__stdcall *thread_start_fn) (void*);
+#else
+typedef unsigned long (*thread_start_fn) (void*);
+#endif
 Thread thread_create(thread_start_fn start_fn, void* userdata);
 bool thread_is_finished(Thread thread);
 void wait_for_thread_to_finish(Thread thread);
@@ -22,3 +26,12 @@ void semaphore_wait(Semaphore semaphore);
 bool semaphore_try_wait(Semaphore semaphore); // Returns true if semaphore was aquired (count decremented)
 void semaphore_increment(Semaphore semaphore, int count);
 
+
+// Flag which is set by one thread and polled by another, e.g. to abort background work
+struct Cancellation_Token {
+    volatile long value;
+};
+
+void cancellation_token_reset(Cancellation_Token* token);
+void cancellation_token_cancel(Cancellation_Token* token);
+bool cancellation_token_is_cancelled(Cancellation_Token* token);
@@ -1,15 +1,23 @@
 #include "timing.hpp"
 
-#include <Windows.h>
+#include <cstdio>
 
 #include "../utility/datatypes.hpp"
 #include "../utility/utils.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
 #include "windows_helper_functions.hpp"
+#else
+#include <x86intrin.h>
+#include <time.h>
+#endif
 
 // Counts per second
 i64 performance_frequency = 1;
 i64 application_start_time = 0;
 
+#ifdef _WIN32
 int timer_initialize() {
     bool res = QueryPerformanceFrequency((LARGE_INTEGER*) &performance_frequency);    
     if (!res) {
@@ -21,6 +29,17 @@ int timer_initialize() {
     return 0;
 }
 
+#else
+int timer_initialize() {
+    // CLOCK_MONOTONIC in nanoseconds
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    performance_frequency = 1000000000;
+    application_start_time = (i64)now.tv_sec * 1000000000 + now.tv_nsec;
+    return 0;
+}
+#endif
+
 int init_hack = timer_initialize();
 
 i64 timer_current_cpu_tick() {
@@ -30,7 +49,13 @@ i64 timer_current_cpu_tick() {
 double timer_current_time_in_seconds()
 {
     i64 now;
+#ifdef _WIN32
     QueryPerformanceCounter((LARGE_INTEGER*)&now);
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    now = (i64)time.tv_sec * 1000000000 + time.tv_nsec;
+#endif
     now = now - application_start_time;
     return (double)now/performance_frequency;
 }
@@ -46,9 +71,16 @@ void timer_sleep_until(double until_in_seconds)
     // we sleep one ms less and do busy waiting for the last ms
     ms -= 1;
     if (ms > 0) {
+#ifdef _WIN32
         timeBeginPeriod(1); 
         Sleep(ms);
         timeEndPeriod(1);
+#else
+        timespec duration;
+        duration.tv_sec = ms / 1000;
+        duration.tv_nsec = (long)(ms % 1000) * 1000000;
+        nanosleep(&duration, nullptr);
+#endif
     }
 
     // Busy wait until time actually passes